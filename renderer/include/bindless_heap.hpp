@@ -0,0 +1,57 @@
+#pragma once
+
+#include "storage/descriptor_set.hpp"
+#include <deque>
+
+namespace wen {
+
+// One descriptor set of large arrays that every pipeline can bind: sampled images, samplers and storage
+// buffers are registered once and referred to by the handle they get, an index into their array, so
+// materials and draws pick their resources in the shader instead of through a set of their own.
+// The set is update-after-bind, resources are added while frames using it are in flight, and a removed
+// handle is only reused once those frames have completed.
+class BindlessHeap final {
+public:
+    BindlessHeap();
+    ~BindlessHeap();
+
+    uint32_t addTexture(std::shared_ptr<Texture> texture);
+    uint32_t addSampler(std::shared_ptr<Sampler> sampler);
+    uint32_t addStorageBuffer(std::shared_ptr<SpecificBuffer> buffer);
+    void removeTexture(uint32_t handle);
+    void removeSampler(uint32_t handle);
+    void removeStorageBuffer(uint32_t handle);
+
+    // called by the renderer once per frame, recycles the handles no frame in flight can read
+    void nextFrame();
+
+    // bound like any other set, `pipeline->setDescriptorSet(manager->bindlessHeap->descriptorSet, n)`
+    std::shared_ptr<DescriptorSet> descriptorSet;
+
+    static constexpr uint32_t textureBinding = 0;
+    static constexpr uint32_t samplerBinding = 1;
+    static constexpr uint32_t storageBufferBinding = 2;
+
+private:
+    struct Handles {
+        uint32_t capacity;
+        uint32_t next = 0;
+        std::vector<uint32_t> free;
+        std::deque<std::pair<uint64_t, uint32_t>> retired; // frame removed, handle
+        // keeps the resources alive while their handles are registered
+        std::vector<std::shared_ptr<void>> refs;
+        uint32_t allocate(const char* name, std::shared_ptr<void> ref);
+        void retire(uint32_t handle, uint64_t frame);
+        void recycle(uint64_t frame);
+    };
+    void write(uint32_t binding, uint32_t handle, const vk::DescriptorImageInfo* image, const vk::DescriptorBufferInfo* buffer);
+
+private:
+    vk::DescriptorPool pool_;
+    Handles textures_;
+    Handles samplers_;
+    Handles storageBuffers_;
+    uint64_t frame_;
+};
+
+} // namespace wen
\ No newline at end of file
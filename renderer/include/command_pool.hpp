@@ -9,6 +9,7 @@ class CommandPool final {
 
 public:
     CommandPool(vk::CommandPoolCreateFlags flags);
+    CommandPool(vk::CommandPoolCreateFlags flags, uint32_t queueFamilyIndex);
     ~CommandPool();
 
     std::vector<vk::CommandBuffer> allocateCommandBuffers(uint32_t count);
@@ -5,6 +5,9 @@
 #include "interface.hpp"
 #include "command_pool.hpp"
 #include "descriptor_pool.hpp"
+#include "upload_manager.hpp"
+#include "frame_allocator.hpp"
+#include "bindless_heap.hpp"
 #include <vulkan/vulkan.hpp>
 #include <vk_mem_alloc.h>
 
@@ -33,8 +36,12 @@ public:
     std::unique_ptr<Device> device;
     std::unique_ptr<Swapchain> swapchain;
     std::unique_ptr<CommandPool> commandPool;
+    std::unique_ptr<CommandPool> computeCommandPool;
     std::unique_ptr<DescriptorPool> descriptorPool;
     VmaAllocator vmaAllocator;
+    std::unique_ptr<UploadManager> uploadManager;
+    std::unique_ptr<FrameAllocator> frameAllocator;
+    std::unique_ptr<BindlessHeap> bindlessHeap;
 
 private:
     void createVkInstance();
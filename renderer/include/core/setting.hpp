@@ -32,8 +32,15 @@ public:
     std::optional<vk::PresentModeKHR> desiredPresentMode = std::nullopt;
     bool vsync = false;
 
+    // no window, surface or swapchain, for offline and compute work
+    bool headless = false;
+
     uint32_t maxFramesInFlight = 2;
     uint32_t currentInFlight = 0;
+    // per frame in flight, of the FrameAllocator
+    uint64_t frameAllocatorSize = 4 * 1024 * 1024;
+    // compiled shaders are kept here between runs, an empty path disables the cache
+    std::string shaderCacheDir = ".shader_cache";
 
     // ImGui
     std::string defaultFont = "";
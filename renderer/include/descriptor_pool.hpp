@@ -1,6 +1,7 @@
 #pragma once
 
 #include <vulkan/vulkan.hpp>
+#include <mutex>
 
 namespace wen {
 
@@ -14,6 +15,7 @@ public:
 
 private:
     vk::DescriptorPool descriptorPool_;
+    std::mutex mutex_; // the pool is externally synchronized, sets may be allocated off the main thread
 };
 
 } // namespace wen
\ No newline at end of file
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <vulkan/vulkan.hpp>
+#include <mutex>
 
 namespace wen {
 
@@ -22,6 +23,13 @@ public:
     vk::Queue computeQueue;
     uint32_t computeQueueFamilyIndex = -1;
 
+    // the compute queue is of a family of its own, resources it shares with graphics are concurrent
+    bool asyncCompute() const { return computeQueueFamilyIndex != graphicsQueueFamilyIndex; }
+    std::vector<uint32_t> sharedQueueFamilyIndices() const;
+
+    // held around every submission, present and waitIdle, the queues may be fed from more than one thread
+    std::mutex queueMutex;
+
 private:
     bool suitable(const vk::PhysicalDevice& device);
 };
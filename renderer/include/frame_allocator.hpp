@@ -0,0 +1,47 @@
+#pragma once
+
+#include "resources/buffer.hpp"
+
+namespace wen {
+
+// Linear allocator for data that lives for one frame: uniforms, push data too large for push constants
+// and staging. Each frame in flight owns a region of one persistently mapped buffer, an allocation bumps
+// an offset into the current region, which is reused as a whole once the frame's fence has signaled.
+// Allocations are made between Renderer::beginRender() and present(), and bound through dynamic uniform
+// or storage buffer descriptors with their offset as the dynamic offset. In-flight UniformBuffers are
+// copied in each time a set they are bound to is bound.
+class FrameAllocator final {
+public:
+    FrameAllocator(uint64_t frameSize);
+    ~FrameAllocator();
+
+    struct Allocation {
+        vk::Buffer buffer;
+        uint32_t offset;
+        void* data;
+    };
+    // aligned for dynamic uniform and storage buffer offsets, or to `alignment` if it is larger
+    Allocation allocate(uint64_t size, uint64_t alignment = 0);
+    template <class Type>
+    Allocation push(const Type& value) {
+        auto allocation = allocate(sizeof(Type));
+        memcpy(allocation.data, &value, sizeof(Type));
+        return allocation;
+    }
+
+    // called by the renderer, after the frame's fence and before the frame is submitted
+    void beginFrame(uint32_t inFlight);
+    void flush();
+
+    vk::Buffer getBuffer() const { return buffer_->buffer; }
+    uint64_t getFrameSize() const { return frameSize_; }
+
+private:
+    std::unique_ptr<Buffer> buffer_;
+    uint64_t frameSize_;
+    uint64_t alignment_;
+    uint64_t begin_;
+    uint64_t offset_;
+};
+
+} // namespace wen
\ No newline at end of file
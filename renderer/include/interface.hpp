@@ -31,10 +31,13 @@ public:
     std::shared_ptr<Renderer> createRenderer(std::shared_ptr<RenderPass> renderPass);
     std::shared_ptr<Shader> createShader(const std::string& filename);
     std::shared_ptr<Shader> compileShader(const std::string& filename, ShaderStage stage);
+    // compiles the shaders in parallel, nullptr for those that failed
+    std::vector<std::shared_ptr<Shader>> compileShaders(const std::vector<std::pair<std::string, ShaderStage>>& shaders);
     std::shared_ptr<GraphicsShaderProgram> createGraphicsShaderProgram();
     std::shared_ptr<GraphicsRenderPipeline> createGraphicsRenderPipeline(std::weak_ptr<Renderer> renderer, std::shared_ptr<GraphicsShaderProgram> shaderProgram, const std::string& subpassName);
     std::shared_ptr<VertexInput> createVertexInput(const std::vector<VertexInputInfo>& infos);
-    std::shared_ptr<VertexBuffer> createVertexBuffer(uint32_t size, uint32_t count, vk::BufferUsageFlags additionalUsage = {});
+    // `hostCopy` for buffers filled piece by piece or rewritten in place, see UploadBuffer
+    std::shared_ptr<VertexBuffer> createVertexBuffer(uint32_t size, uint32_t count, vk::BufferUsageFlags additionalUsage = {}, bool hostCopy = false);
     std::shared_ptr<IndexBuffer> createIndexBuffer(IndexType type, uint32_t count, vk::BufferUsageFlags additionalUsage = {});
     std::shared_ptr<ImGuiLayer> createImGuiLayer(std::shared_ptr<Renderer>& renderer);
     std::shared_ptr<DescriptorSet> createDescriptorSet();
@@ -49,6 +52,8 @@ public:
     std::shared_ptr<RayTracingRenderPipeline> createRayTracingRenderPipeline(std::shared_ptr<RayTracingShaderProgram> shaderProgram);
     std::shared_ptr<AccelerationStructure> createAccelerationStructure();
     std::shared_ptr<RayTracingInstance> createRayTracingInstance();
+    std::shared_ptr<ComputeShaderProgram> createComputeShaderProgram();
+    std::shared_ptr<ComputeRenderPipeline> createComputeRenderPipeline(std::shared_ptr<ComputeShaderProgram> shaderProgram);
     std::shared_ptr<GLTFScene> loadGLTFScene(const std::string& filename, const std::vector<std::string>& attrs = {});
 
 private:
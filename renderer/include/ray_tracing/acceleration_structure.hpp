@@ -28,8 +28,6 @@ public:
     void build(bool is_update, bool allow_update);
 
 private:
-    std::unique_ptr<StorageBuffer> staging_ = {};
-    uint64_t currentStagingSize_ = 0;
     std::unique_ptr<StorageBuffer> scratch_ = {};
     uint64_t currentScratchSize_ = 0;
     std::vector<std::shared_ptr<Model>> models_ = {};
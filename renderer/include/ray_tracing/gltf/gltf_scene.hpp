@@ -10,6 +10,7 @@
 
 namespace wen {
 
+// texture fields hold handles into the bindless heap's textures, -1 for none
 struct GLTFMaterial {
     glm::vec4 baseColorFactor = glm::vec4(1.0f);
     int baseColorTexture = -1;
@@ -36,6 +37,9 @@ public:
     auto& nodesPtr() { return nodesPtr_; }
     auto getMeshes() { return meshes_; }
     auto getMaterialBuffer() { return materialBuffer_; }
+    // bindless heap handles, the materials are read as BINDLESS_BUFFER(GLTFMaterial, ...)[materialBufferHandle]
+    uint32_t getSamplerHandle() const { return samplerHandle_; }
+    uint32_t getMaterialBufferHandle() const { return materialBufferHandle_; }
     auto getAttrBuffer(const std::string& name) { return attrBuffers_.at(name); }
     std::vector<glm::vec3> vertices;
     std::vector<uint32_t> indices;
@@ -55,10 +59,13 @@ private:
     // textures
     std::vector<std::shared_ptr<Texture>> textures_;
     std::shared_ptr<Sampler> sampler_;
+    std::vector<int> imageHandles_; // by glTF image, -1 for images that were not loaded
+    uint32_t samplerHandle_;
 
     // materials
     std::vector<GLTFMaterial> materials_;
     std::shared_ptr<StorageBuffer> materialBuffer_;
+    uint32_t materialBufferHandle_;
 
     // meshes
     std::vector<std::shared_ptr<GLTFMesh>> meshes_;
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "ray_tracing/gltf/gltf_scene.hpp"
+#include <future>
 
 namespace wen {
 
@@ -76,6 +77,8 @@ private:
 
     std::unique_ptr<StorageBuffer> buffer_;
     std::unique_ptr<StorageBuffer> scratch_;
+    // of the upload batch the last build or update was recorded into
+    std::shared_future<void> building_;
 };
 
 } // namespace wen
\ No newline at end of file
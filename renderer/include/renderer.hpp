@@ -7,6 +7,7 @@
 #include "storage/index_buffer.hpp"
 #include "resources/model.hpp"
 #include "ray_tracing/render_pipeline.hpp"
+#include "frame_allocator.hpp"
 
 namespace wen {
 
@@ -39,14 +40,31 @@ public:
     void pushConstants(const std::shared_ptr<GraphicsRenderPipeline>& renderPipeline);
     void bindResources(std::shared_ptr<GraphicsRenderPipeline> renderPipeline);
     void bindResources(std::shared_ptr<RayTracingRenderPipeline> renderPipeline);
+    void bindResources(std::shared_ptr<ComputeRenderPipeline> renderPipeline);
     void bindVertexBuffers(const std::vector<std::shared_ptr<VertexBuffer>>& vertexBuffers, uint32_t firstBinding = 0);
     void bindVertexBuffer(const std::shared_ptr<VertexBuffer>& vertexBuffer, uint32_t binding = 0);
+    // per-frame vertex data, instance attributes for example, made with manager->frameAllocator
+    void bindVertexBuffer(const FrameAllocator::Allocation& allocation, uint32_t binding = 0);
     void bindIndexBuffer(const std::shared_ptr<IndexBuffer>& indexBuffer);
     void draw(uint32_t vertexCount, uint32_t instanceCount, uint32_t firstVertex, uint32_t firstInstance);
     void drawIndexed(uint32_t indexCount, uint32_t instanceCount, uint32_t firstIndex, int32_t vertexOffset, uint32_t firstInstance);
     void drawModel(const std::shared_ptr<Model>& model, uint32_t instanceCount, uint32_t firstInstance);
     void drawMesh(const std::shared_ptr<Mesh>& mesh, uint32_t instanceCount, uint32_t firstInstance);
     void traceRays(const std::shared_ptr<RayTracingRenderPipeline>& renderPipeline, uint32_t width, uint32_t height, uint32_t depth);
+    // outside of a render pass. The shader writes of a dispatch are made visible to the dispatches,
+    // render passes and traces recorded after it, see computeBarrier()
+    void dispatch(uint32_t groupCountX, uint32_t groupCountY, uint32_t groupCountZ);
+    // the group counts are a vk::DispatchIndirectCommand at `offset`, which an earlier dispatch may write
+    void dispatchIndirect(const std::shared_ptr<SpecificBuffer>& buffer, vk::DeviceSize offset = 0);
+    // for consumers the renderer doesn't know of, a copy for instance. Recorded only if a dispatch
+    // wrote since the last barrier towards `stages`
+    void computeBarrier(vk::PipelineStageFlags stages, vk::AccessFlags access);
+
+    // The dispatches in between are recorded for the compute queue, once per frame, and overlap the
+    // graphics work of the frame up to `waitStages`. What they write is read by the next frame's
+    // graphics work as well unless it is kept per frame in flight, like an in-flight UniformBuffer
+    void beginAsyncCompute();
+    void endAsyncCompute(vk::PipelineStageFlags waitStages = vk::PipelineStageFlagBits::eDrawIndirect | vk::PipelineStageFlagBits::eComputeShader);
 
     void nextSubpass();
     void nextSubpass(const std::string& name);
@@ -73,6 +91,18 @@ private:
     std::vector<vk::Fence> inFlightFences_;
     std::vector<std::vector<vk::SubmitInfo>> inFlightSubmitInfos_;
 
+    struct ComputeWrites {
+        bool pending = false;
+        vk::PipelineStageFlags visibleStages;
+    };
+    ComputeWrites computeWrites_;
+    ComputeWrites graphicsComputeWrites_; // of the graphics buffer during async compute
+
+    vk::CommandBuffer graphicsBuffer_;
+    std::vector<vk::CommandBuffer> computeCommandBuffers_;
+    std::vector<vk::Semaphore> computeFinishedSemaphores_;
+    std::optional<vk::PipelineStageFlags> computeWaitStages_; // set when the frame waits on async compute
+
     uint32_t index_;
     uint32_t currentInFlight_;
     uint32_t currentSubpass_;
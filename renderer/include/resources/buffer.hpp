@@ -12,11 +12,17 @@ public:
 
     void* map();
     void unmap();
+    // makes host writes visible to the device when the memory is not host-coherent
+    void flush(uint64_t offset, uint64_t size);
+    // makes device writes visible to the host when the memory is not host-coherent
+    void invalidate(uint64_t offset, uint64_t size);
+    vk::MemoryPropertyFlags memoryProperties() const;
 
 public:
     vk::Buffer buffer;
     uint64_t size;
     void* data;
+    vk::SharingMode sharingMode = vk::SharingMode::eExclusive;
 
 private:
     VmaAllocation allocation_;
@@ -14,6 +14,9 @@ public:
     RenderPipeline() = default;
     virtual ~RenderPipeline();
 
+    // the pipeline, its sets for `inFlight` and its push constants, for command buffers recorded outside a Renderer
+    void bind(vk::CommandBuffer cmdbuf, vk::PipelineBindPoint bindPoint, uint32_t inFlight = 0) const;
+
 protected:
     vk::PipelineShaderStageCreateInfo createShaderStage(vk::ShaderStageFlagBits stage, vk::ShaderModule module, const std::string& entry);
     void createPipelineLayout();
@@ -75,4 +78,16 @@ private:
     std::shared_ptr<VertexInput> vertexInput_;
 };
 
+struct ComputeRenderPipelineOptions {};
+class ComputeRenderPipeline : public RenderPipelineTemplate<ComputeRenderPipeline, ComputeRenderPipelineOptions> {
+public:
+    ComputeRenderPipeline(std::shared_ptr<ComputeShaderProgram> shaderProgram);
+    ~ComputeRenderPipeline() override;
+
+    void compile(const ComputeRenderPipelineOptions& options = {}) override;
+
+private:
+    std::shared_ptr<ComputeShaderProgram> shaderProgram_;
+};
+
 } // namespace wen
\ No newline at end of file
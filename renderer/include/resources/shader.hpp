@@ -9,8 +9,13 @@ class Shader final {
 public:
     Shader(const std::vector<char>& codes);
     Shader(const std::string& filename, const std::string& code, ShaderStage stage);
+    Shader(const std::vector<uint32_t>& spirv);
     ~Shader();
 
+    // GLSL to SPIR-V without creating a module. Empty on failure.
+    // Served from the ShaderCache when the source and its includes are unchanged, thread-safe
+    static std::vector<uint32_t> compile(const std::string& filename, const std::string& code, ShaderStage stage);
+
     std::optional<vk::ShaderModule> module;
 };
 
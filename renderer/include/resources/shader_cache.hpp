@@ -0,0 +1,21 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace wen {
+
+// SPIR-V kept on disk between runs, under settings->shaderCacheDir. An entry is looked up by a hash of
+// what was passed to the compiler: file name, source, stage and options. It lists the headers the
+// compilation included, and its SPIR-V is stored under a hash that also covers their current contents,
+// so editing an include misses the cache like editing the shader does. Safe to use from several threads.
+class ShaderCache final {
+public:
+    static uint64_t key(const std::string& filename, const std::string& code, uint32_t stage, const std::string& options);
+    // empty when there is no entry, or an include changed since it was stored
+    static std::vector<uint32_t> load(uint64_t key);
+    static void store(uint64_t key, const std::vector<std::string>& includes, const std::vector<uint32_t>& spirv);
+};
+
+} // namespace wen
\ No newline at end of file
@@ -6,7 +6,15 @@ namespace wen {
 
 class ShaderIncluder final : public shaderc::CompileOptions::IncluderInterface {
 public:
-    ShaderIncluder(const std::string& filepath);
+    // `includes` collects what the compilation included, "<Name>" for the standard headers and
+    // the path of the others
+    ShaderIncluder(const std::string& filepath, std::vector<std::string>* includes = nullptr);
+
+    // the contents of a standard header, #include <Name>, nullptr if there is none
+    static const std::string* standardHeader(const std::string& name);
+    // the contents of an include file, cached until the file is modified, nullptr if it does not exist
+    static std::shared_ptr<const std::string> readInclude(const std::string& path);
+
     shaderc_include_result* GetInclude(
         const char* requested_source,
         shaderc_include_type type,
@@ -17,6 +25,7 @@ public:
 
 private:
     std::string filepath_;
+    std::vector<std::string>* includes_;
 };
 
 } // namespace wen
\ No newline at end of file
@@ -46,4 +46,23 @@ struct ShaderProgramBindPoint<GraphicsShaderProgram> {
     const static vk::PipelineBindPoint bindPoint = vk::PipelineBindPoint::eGraphics;
 };
 
+class ComputeShaderProgram : public ShaderProgram {
+    friend class ComputeRenderPipeline;
+
+public:
+    ComputeShaderProgram() = default;
+    ~ComputeShaderProgram() override;
+
+public:
+    void setComputeShader(std::shared_ptr<Shader> shader, const std::string& entry = "main");
+
+private:
+    ShaderStage computeShader_;
+};
+
+template <>
+struct ShaderProgramBindPoint<ComputeShaderProgram> {
+    const static vk::PipelineBindPoint bindPoint = vk::PipelineBindPoint::eCompute;
+};
+
 } // namespace wen
\ No newline at end of file
@@ -0,0 +1,51 @@
+#pragma once
+
+#include "resources/buffer.hpp"
+#include "resources/specific_buffer.hpp"
+
+namespace wen {
+
+// A device-local buffer filled from the host. Where that memory is host-visible (resizable BAR, unified
+// memory) a write goes to it directly once no submitted frame or pending copy can still touch the
+// buffer, otherwise it is staged through the upload manager, whose copy waits for those frames.
+// With `hostCopy` writes are compared against a copy of the contents kept on the host, and only the
+// bytes that changed are written, adjacent changes merged into one range. The copy costs as much host
+// memory as the buffer, it pays off for large buffers filled piece by piece or rewritten in place.
+class UploadBuffer : public SpecificBuffer {
+public:
+    UploadBuffer(uint64_t size, vk::BufferUsageFlags usage, bool hostCopy = false);
+    ~UploadBuffer() override;
+
+    // the host copy, ranges written to it are passed to invalidate() before flush(). Only with `hostCopy`
+    void* map();
+    void invalidate(uint64_t offset, uint64_t size);
+    // uploads the invalidated ranges, the whole buffer if none were
+    void flush();
+    void unmap();
+
+    template <class Type>
+    uint32_t upload(const std::vector<Type>& data, uint32_t offset = 0) {
+        upload(data.data(), offset * sizeof(Type), data.size() * sizeof(Type));
+        return offset + data.size();
+    }
+    // written directly or staged by the upload manager, whose copy runs with its next batch
+    void upload(const void* data, uint64_t offset, uint64_t size);
+
+    vk::Buffer getBuffer(uint32_t inFlight = 0) override { return buffer_->buffer; }
+    uint64_t getSize() override { return buffer_->size; }
+    void* getData() override { return buffer_->data; }
+
+private:
+    void write(uint64_t offset, const void* data, uint64_t size);
+
+private:
+    std::unique_ptr<Buffer> buffer_;
+    bool direct_;
+    uint64_t staged_ = 0; // upload manager value of the last staged write
+    // empty without `hostCopy`
+    std::vector<uint8_t> shadow_;
+    // begin to end of the bytes to upload, merged when they touch
+    std::map<uint64_t, uint64_t> dirty_;
+};
+
+} // namespace wen
\ No newline at end of file
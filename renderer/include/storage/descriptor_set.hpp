@@ -28,12 +28,16 @@ class Renderer;
 class DescriptorSet final {
     friend class RenderPipeline;
     friend class Renderer;
+    friend class BindlessHeap;
 
 public:
     DescriptorSet();
     ~DescriptorSet();
 
     DescriptorSet& addDescriptors(const std::vector<DescriptorInfo>& infos);
+    // the bindings may be left unwritten, and written while the sets are in use as long as no pending
+    // command reads the descriptor. The sets are allocated from `pool`, created with eUpdateAfterBind
+    DescriptorSet& setUpdateAfterBind(vk::DescriptorPool pool);
     void createDescriptorSetLayout();
     void allocateDescriptorSets();
     void freeDescriptorSets();
@@ -42,6 +46,7 @@ public:
     void build();
 
 public:
+    // in-flight uniforms go to a single eDynamicUniform binding, the others to eUniform bindings
     void bindUniforms(uint32_t binding, const std::vector<std::shared_ptr<UniformBuffer>>& uniforms);
     void bindUniform(uint32_t binding, std::shared_ptr<UniformBuffer> uniform);
     void bindTextures(uint32_t binding, const std::vector<std::pair<std::shared_ptr<Texture>, std::shared_ptr<Sampler>>>& textures_samplers);
@@ -54,14 +59,23 @@ public:
     void bindStorageImage(uint32_t binding, std::shared_ptr<StorageImage> storageImage);
     void bindAccelerationStructures(uint32_t binding, const std::vector<std::shared_ptr<RayTracingInstance>>& instances);
     void bindAccelerationStructure(uint32_t binding, std::shared_ptr<RayTracingInstance> instance);
+    // a dynamic binding to `range` bytes of the frame allocator, at the offset of an allocation set
+    // with setDynamicOffset() before the pipeline's resources are bound
+    void bindFrameAllocator(uint32_t binding, uint64_t range);
+    void setDynamicOffset(uint32_t binding, uint32_t offset);
 
 private:
     const vk::DescriptorSetLayoutBinding& getLayoutBinding(uint32_t binding);
+    // copies the in-flight uniforms into the frame allocator, then appends every dynamic offset
+    void appendDynamicOffsets(std::vector<uint32_t>& offsets);
 
 private:
     std::vector<vk::DescriptorSetLayoutBinding> layoutBindings_;
     vk::DescriptorSetLayout descriptorLayout_;
     std::vector<vk::DescriptorSet> descriptorSets_;
+    std::map<uint32_t, uint32_t> dynamicOffsets_; // by binding, the order they are bound in
+    std::map<uint32_t, std::shared_ptr<UniformBuffer>> frameUniforms_;
+    std::optional<vk::DescriptorPool> updateAfterBindPool_;
 };
 
 } // namespace wen
\ No newline at end of file
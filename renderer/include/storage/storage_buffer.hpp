@@ -2,6 +2,7 @@
 
 #include "resources/buffer.hpp"
 #include "resources/specific_buffer.hpp"
+#include <future>
 
 namespace wen {
 
@@ -11,7 +12,8 @@ public:
     ~StorageBuffer() override;
 
     void* map();
-    void flush(vk::DeviceSize size, const vk::Buffer& buffer);
+    // copies the first `size` bytes to `buffer` with the next upload batch
+    void flush(vk::DeviceSize size, const Buffer& buffer);
     void unmap();
 
     vk::Buffer getBuffer(uint32_t inFlight = 0) override { return buffer_->buffer; }
@@ -20,6 +22,7 @@ public:
 
 private:
     std::unique_ptr<Buffer> buffer_;
+    std::shared_future<void> pending_;
 };
 
 } // namespace wen
\ No newline at end of file
@@ -8,19 +8,21 @@ namespace wen {
 
 class UniformBuffer : public SpecificBuffer {
 public:
+    // An in-flight buffer is only a host copy, which is copied into the frame allocator each time a set
+    // it is bound to is bound, so it needs a DescriptorType::eDynamicUniform binding. Otherwise it is one
+    // mapped buffer, written while no frame reads it.
     UniformBuffer(uint64_t size, bool inFlight);
     ~UniformBuffer() override;
 
-    vk::Buffer getBuffer(uint32_t inFlight = 0) override { return buffer(inFlight).buffer; }
+    vk::Buffer getBuffer(uint32_t inFlight = 0) override;
     uint64_t getSize() override { return size_; }
-    void* getData() override { return buffer(settings->maxFramesInFlight).data; };
-
-private:
-    Buffer& buffer(uint32_t inFlight);
+    void* getData() override;
+    bool isInFlight() const { return buffer_ == nullptr; }
 
 private:
     uint64_t size_;
-    std::vector<Buffer> buffers_;
+    std::unique_ptr<Buffer> buffer_;
+    std::vector<uint8_t> data_;
 };
 
 } // namespace wen
\ No newline at end of file
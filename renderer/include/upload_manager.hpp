@@ -0,0 +1,123 @@
+#pragma once
+
+#include "command_pool.hpp"
+#include "resources/buffer.hpp"
+#include <vulkan/vulkan.hpp>
+#include <condition_variable>
+#include <deque>
+#include <future>
+#include <mutex>
+#include <thread>
+
+namespace wen {
+
+// Batches uploads instead of draining the queue after every copy. Copies are recorded on the transfer
+// queue, what only the graphics queue can do (blits, final layouts, acceleration structure builds) is
+// recorded to run after them, and flush() submits both, at the latest when the renderer presents.
+// A timeline semaphore orders every later graphics submission after the batch and completes its future.
+// The copies wait for the frames submitted before the batch, which may still read what they overwrite;
+// buffers they write to are shared concurrently with the transfer family, see Buffer.
+class UploadManager final {
+public:
+    UploadManager();
+    ~UploadManager();
+
+    struct Staging {
+        vk::Buffer buffer;
+        vk::DeviceSize offset;
+        void* data;
+    };
+    // host-visible memory of the open batch to copy from, reused once the batch is done
+    Staging stage(vk::DeviceSize size, vk::DeviceSize alignment = 16);
+    // stages `data` and records its copy to `buffer` at `offset`
+    void upload(const Buffer& buffer, vk::DeviceSize offset, const void* data, vk::DeviceSize size);
+    void copy(vk::Buffer src, const Buffer& dst, const vk::BufferCopy& region);
+
+    vk::CommandBuffer transferCommands();
+    // runs after the transfer commands of the batch, once what they wrote belongs to the graphics family
+    vk::CommandBuffer graphicsCommands();
+
+    // hands an image the transfer commands wrote over to the graphics queue family at the end of the
+    // batch, moving it from `oldLayout` to `newLayout` on the way. Images are written once, when created
+    void release(vk::Image image, const vk::ImageSubresourceRange& range, vk::ImageLayout oldLayout, vk::ImageLayout newLayout);
+
+    // kept alive until the batch is done, a buffer replaced while a recorded command still uses it
+    void keep(std::shared_ptr<void> resource);
+    // destroyed once the uploads recorded and the frames submitted so far are done, for resources
+    // dropped while a copy to or from them, or a frame reading them, may still be in flight
+    void retire(std::shared_ptr<void> resource);
+
+    // the timeline value at which the uploads recorded so far are done
+    uint64_t recordedValue() const;
+    // the GPU reached `value` and finished every frame submitted so far, nothing it runs still reads
+    // or writes what the host is about to write
+    bool finished(uint64_t value) const;
+
+    // signalled by every frame the renderer submits, with the value nextFrame() returns for it
+    vk::Semaphore frameTimeline() const { return frames_; }
+    uint64_t nextFrame() { return ++frameValue_; }
+
+    // submits the open batch, ready at once if nothing was recorded
+    std::shared_future<void> flush();
+    // of the open batch, ready after it was flushed and the GPU finished it
+    std::shared_future<void> pending() const { return open_.future; }
+
+private:
+    struct Batch {
+        Batch() : future(promise.get_future().share()) {}
+
+        std::promise<void> promise;
+        std::shared_future<void> future;
+        uint64_t value = 0;
+
+        vk::CommandBuffer transfer = nullptr;
+        vk::CommandBuffer acquire = nullptr;
+        vk::CommandBuffer graphics = nullptr;
+        std::vector<vk::ImageMemoryBarrier> images;
+
+        std::vector<std::unique_ptr<Buffer>> chunks;
+        vk::DeviceSize used = 0;
+        vk::DeviceSize staged = 0;
+        std::vector<std::shared_ptr<void>> resources;
+    };
+
+    vk::CommandBuffer begin(CommandPool& pool, std::vector<vk::CommandBuffer>& free);
+    std::unique_ptr<Buffer> chunk(vk::DeviceSize size);
+    // recycles the batches the GPU finished
+    void collect();
+    // destroys the retired resources the GPU is done with
+    void prune();
+    // completion thread, resolves the futures in submission order
+    void complete();
+
+private:
+    std::unique_ptr<CommandPool> transferPool_;
+    std::unique_ptr<CommandPool> graphicsPool_;
+    std::vector<vk::CommandBuffer> freeTransfer_;
+    std::vector<vk::CommandBuffer> freeGraphics_;
+    std::vector<std::unique_ptr<Buffer>> freeChunks_;
+
+    vk::Semaphore timeline_;
+    uint64_t value_ = 0;
+    vk::Semaphore frames_;
+    uint64_t frameValue_ = 0;
+
+    struct Retired {
+        uint64_t value;      // of timeline_
+        uint64_t frameValue; // of frames_
+        std::shared_ptr<void> resource;
+    };
+    std::deque<Retired> retired_;
+
+    Batch open_;
+    std::deque<Batch> inFlight_;
+    std::shared_future<void> ready_;
+
+    std::mutex mutex_;
+    std::condition_variable condition_;
+    std::deque<std::pair<uint64_t, std::promise<void>>> waiting_;
+    bool stop_ = false;
+    std::thread thread_;
+};
+
+} // namespace wen
\ No newline at end of file
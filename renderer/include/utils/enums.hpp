@@ -250,13 +250,14 @@ enum class ShaderStage : uint32_t {
     eMiss = static_cast<uint32_t>(vk::ShaderStageFlagBits::eMissKHR),
     eClosestHit = static_cast<uint32_t>(vk::ShaderStageFlagBits::eClosestHitKHR),
     eIntersection = static_cast<uint32_t>(vk::ShaderStageFlagBits::eIntersectionKHR),
+    eCompute = static_cast<uint32_t>(vk::ShaderStageFlagBits::eCompute),
 };
 
 using ShaderStages = Flags<ShaderStage>;
 template <>
 struct FlagTraits<ShaderStage> {
     static VULKAN_HPP_CONST_OR_CONSTEXPR bool isBitmask = true;
-    static VULKAN_HPP_CONST_OR_CONSTEXPR ShaderStages allFlags = ShaderStage::eVertex | ShaderStage::eFragment | ShaderStage::eRaygen | ShaderStage::eMiss | ShaderStage::eClosestHit;
+    static VULKAN_HPP_CONST_OR_CONSTEXPR ShaderStages allFlags = ShaderStage::eVertex | ShaderStage::eFragment | ShaderStage::eRaygen | ShaderStage::eMiss | ShaderStage::eClosestHit | ShaderStage::eCompute;
 };
 
 enum class InputRate {
@@ -289,6 +290,10 @@ enum class DescriptorType {
     eStorageBuffer,
     eStorageImage,
     eAccelerationStructure,
+    eDynamicUniform,
+    eDynamicStorageBuffer,
+    eSampledImage,
+    eSampler,
 };
 
 enum class SamplerFilter {
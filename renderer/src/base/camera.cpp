@@ -11,7 +11,7 @@ namespace wen {
 Camera::Camera() {
     data.position = glm::vec3(0.0f, 0.0f, 3.0f);
     direction = glm::vec3(0.0f, 0.0f, -1.0f);
-    uniformBuffer = std::make_shared<UniformBuffer>(sizeof(CameraData), false);
+    uniformBuffer = std::make_shared<UniformBuffer>(sizeof(CameraData), true);
     upload();
 }
 
@@ -0,0 +1,139 @@
+#include "bindless_heap.hpp"
+#include "core/setting.hpp"
+#include "core/logger.hpp"
+#include "manager.hpp"
+
+namespace wen {
+
+BindlessHeap::BindlessHeap() : frame_(0) {
+    vk::PhysicalDeviceVulkan12Properties limits = {};
+    vk::PhysicalDeviceProperties2 properties = {};
+    properties.setPNext(&limits);
+    manager->device->physicalDevice.getProperties2(&properties);
+
+    textures_.capacity = std::min(16384u, limits.maxPerStageDescriptorUpdateAfterBindSampledImages);
+    samplers_.capacity = std::min(256u, limits.maxPerStageDescriptorUpdateAfterBindSamplers);
+    storageBuffers_.capacity = std::min(4096u, limits.maxPerStageDescriptorUpdateAfterBindStorageBuffers);
+    for (auto* handles : {&textures_, &samplers_, &storageBuffers_}) {
+        handles->refs.resize(handles->capacity);
+    }
+
+    std::vector<vk::DescriptorPoolSize> sizes = {
+        {vk::DescriptorType::eSampledImage, textures_.capacity * settings->maxFramesInFlight},
+        {vk::DescriptorType::eSampler, samplers_.capacity * settings->maxFramesInFlight},
+        {vk::DescriptorType::eStorageBuffer, storageBuffers_.capacity * settings->maxFramesInFlight},
+    };
+    vk::DescriptorPoolCreateInfo createInfo = {};
+    createInfo.setPoolSizes(sizes)
+              .setMaxSets(settings->maxFramesInFlight)
+              .setFlags(vk::DescriptorPoolCreateFlagBits::eUpdateAfterBind);
+    pool_ = manager->device->device.createDescriptorPool(createInfo);
+
+    auto stages = ShaderStage::eVertex | ShaderStage::eFragment | ShaderStage::eCompute;
+    if (settings->isEnableRayTracing) {
+        stages |= ShaderStage::eRaygen | ShaderStage::eMiss | ShaderStage::eClosestHit;
+    }
+    descriptorSet = std::make_shared<DescriptorSet>();
+    descriptorSet->addDescriptors({
+        {textureBinding, DescriptorType::eSampledImage, textures_.capacity, stages},
+        {samplerBinding, DescriptorType::eSampler, samplers_.capacity, stages},
+        {storageBufferBinding, DescriptorType::eStorageBuffer, storageBuffers_.capacity, stages},
+    }).setUpdateAfterBind(pool_).build();
+    WEN_DEBUG("Bindless heap: {} textures, {} samplers, {} storage buffers", textures_.capacity, samplers_.capacity, storageBuffers_.capacity)
+}
+
+BindlessHeap::~BindlessHeap() {
+    descriptorSet.reset();
+    manager->device->device.destroyDescriptorPool(pool_);
+}
+
+uint32_t BindlessHeap::Handles::allocate(const char* name, std::shared_ptr<void> ref) {
+    uint32_t handle;
+    if (!free.empty()) {
+        handle = free.back();
+        free.pop_back();
+    } else {
+        WEN_ASSERT(next < capacity, "Bindless heap is out of {} handles ({})", name, capacity)
+        handle = next++;
+    }
+    refs[handle] = std::move(ref);
+    return handle;
+}
+
+void BindlessHeap::Handles::retire(uint32_t handle, uint64_t frame) {
+    retired.push_back({frame, handle});
+}
+
+void BindlessHeap::Handles::recycle(uint64_t frame) {
+    while (!retired.empty() && retired.front().first + settings->maxFramesInFlight <= frame) {
+        auto handle = retired.front().second;
+        refs[handle].reset();
+        free.push_back(handle);
+        retired.pop_front();
+    }
+}
+
+void BindlessHeap::write(uint32_t binding, uint32_t handle, const vk::DescriptorImageInfo* image, const vk::DescriptorBufferInfo* buffer) {
+    auto& layoutBinding = descriptorSet->getLayoutBinding(binding);
+    std::vector<vk::WriteDescriptorSet> writes(descriptorSet->descriptorSets_.size());
+    for (uint32_t i = 0; i < writes.size(); i++) {
+        writes[i].setDstSet(descriptorSet->descriptorSets_[i])
+                 .setDstBinding(binding)
+                 .setDstArrayElement(handle)
+                 .setDescriptorCount(1)
+                 .setDescriptorType(layoutBinding.descriptorType)
+                 .setPImageInfo(image)
+                 .setPBufferInfo(buffer);
+    }
+    manager->device->device.updateDescriptorSets(writes, {});
+}
+
+uint32_t BindlessHeap::addTexture(std::shared_ptr<Texture> texture) {
+    uint32_t handle = textures_.allocate("texture", texture);
+    vk::DescriptorImageInfo info = {};
+    info.setImageLayout(texture->getImageLayout())
+        .setImageView(texture->getImageView());
+    write(textureBinding, handle, &info, nullptr);
+    return handle;
+}
+
+uint32_t BindlessHeap::addSampler(std::shared_ptr<Sampler> sampler) {
+    uint32_t handle = samplers_.allocate("sampler", sampler);
+    vk::DescriptorImageInfo info = {};
+    info.setSampler(sampler->sampler);
+    write(samplerBinding, handle, &info, nullptr);
+    return handle;
+}
+
+uint32_t BindlessHeap::addStorageBuffer(std::shared_ptr<SpecificBuffer> buffer) {
+    uint32_t handle = storageBuffers_.allocate("storage buffer", buffer);
+    vk::DescriptorBufferInfo info = {};
+    info.setBuffer(buffer->getBuffer())
+        .setOffset(0)
+        .setRange(buffer->getSize());
+    write(storageBufferBinding, handle, nullptr, &info);
+    return handle;
+}
+
+// the descriptors are left as they are, partially bound bindings are only read where a shader indexes
+// them, and the resources are kept until no frame in flight can
+void BindlessHeap::removeTexture(uint32_t handle) {
+    textures_.retire(handle, frame_);
+}
+
+void BindlessHeap::removeSampler(uint32_t handle) {
+    samplers_.retire(handle, frame_);
+}
+
+void BindlessHeap::removeStorageBuffer(uint32_t handle) {
+    storageBuffers_.retire(handle, frame_);
+}
+
+void BindlessHeap::nextFrame() {
+    frame_++;
+    for (auto* handles : {&textures_, &samplers_, &storageBuffers_}) {
+        handles->recycle(frame_);
+    }
+}
+
+} // namespace wen
\ No newline at end of file
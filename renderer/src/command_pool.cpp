@@ -1,12 +1,16 @@
 #include "command_pool.hpp"
+#include "core/logger.hpp"
 #include "manager.hpp"
 
 namespace wen {
 
-CommandPool::CommandPool(vk::CommandPoolCreateFlags flags) {
+CommandPool::CommandPool(vk::CommandPoolCreateFlags flags)
+    : CommandPool(flags, manager->device->graphicsQueueFamilyIndex) {}
+
+CommandPool::CommandPool(vk::CommandPoolCreateFlags flags, uint32_t queueFamilyIndex) {
     vk::CommandPoolCreateInfo createInfo = {};
     createInfo.setFlags(flags)
-              .setQueueFamilyIndex(manager->device->graphicsQueueFamilyIndex);
+              .setQueueFamilyIndex(queueFamilyIndex);
     commandPool_ = manager->device->device.createCommandPool(createInfo);
 }
 
@@ -39,10 +43,19 @@ vk::CommandBuffer CommandPool::allocateSingleUse() {
 void CommandPool::freeSingleUse(vk::CommandBuffer cmdbuf) {
     cmdbuf.end();
 
+    // waits for this submission only, not for the frames or uploads in flight on the queue
+    vk::Fence fence = manager->device->device.createFence({});
     vk::SubmitInfo submits = {};
     submits.setCommandBuffers(cmdbuf);
-    manager->device->transferQueue.submit(submits, nullptr);
-    manager->device->transferQueue.waitIdle();
+    {
+        std::lock_guard<std::mutex> lock(manager->device->queueMutex);
+        manager->device->graphicsQueue.submit(submits, fence);
+    }
+    WEN_ASSERT(
+        manager->device->device.waitForFences(fence, true, std::numeric_limits<uint64_t>::max()) == vk::Result::eSuccess,
+        "Failed to wait for fence"
+    )
+    manager->device->device.destroyFence(fence);
     manager->device->device.freeCommandBuffers(commandPool_, cmdbuf);
 }
 
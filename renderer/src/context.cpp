@@ -35,12 +35,20 @@ void Context::initialize() {
         auto vkGetInstanceProcAddr = dl.getProcAddress<PFN_vkGetInstanceProcAddr>("vkGetInstanceProcAddr");
         dispatcher = vk::DispatchLoaderDynamic(vkInstance, vkGetInstanceProcAddr);
     }
-    createSurface();
+    if (!settings->headless) {
+        createSurface();
+    }
     device = std::make_unique<Device>();
-    swapchain = std::make_unique<Swapchain>();
+    if (!settings->headless) {
+        swapchain = std::make_unique<Swapchain>();
+    }
     commandPool = std::make_unique<CommandPool>(vk::CommandPoolCreateFlagBits::eResetCommandBuffer);
+    computeCommandPool = std::make_unique<CommandPool>(vk::CommandPoolCreateFlagBits::eResetCommandBuffer, device->computeQueueFamilyIndex);
     descriptorPool = std::make_unique<DescriptorPool>();
     initVMA();
+    uploadManager = std::make_unique<UploadManager>();
+    frameAllocator = std::make_unique<FrameAllocator>(settings->frameAllocatorSize);
+    bindlessHeap = std::make_unique<BindlessHeap>();
     WEN_INFO("Vulkan Context Initialized!");
 }
 
@@ -56,7 +64,7 @@ void Context::createVkInstance() {
 
     std::map<std::string, bool> requiredExtensions;
     uint32_t glfwExtensionCount = 0;
-    const char** glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
+    const char** glfwExtensions = settings->headless ? nullptr : glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
     for (uint32_t i = 0; i < glfwExtensionCount; i++) {
         requiredExtensions.insert(std::make_pair(std::string(glfwExtensions[i]), false));
     }
@@ -129,18 +137,27 @@ void Context::recreateSwapchain() {
         glfwGetFramebufferSize(glfwWindow, &width, &height);
         glfwWaitEvents();
     }
-    device->device.waitIdle();
+    {
+        std::lock_guard<std::mutex> lock(device->queueMutex);
+        device->device.waitIdle();
+    }
     swapchain.reset();
     swapchain = std::make_unique<Swapchain>();
 }
 
 void Context::destroy() {
+    bindlessHeap.reset();
+    frameAllocator.reset();
+    uploadManager.reset();
     vmaDestroyAllocator(vmaAllocator);
     descriptorPool.reset();
+    computeCommandPool.reset();
     commandPool.reset();
     swapchain.reset();
     device.reset();
-    vkInstance.destroySurfaceKHR(surface);
+    if (surface) {
+        vkInstance.destroySurfaceKHR(surface);
+    }
     vkInstance.destroy();
     WEN_INFO("Vulkan Context Destroyed!");
 }
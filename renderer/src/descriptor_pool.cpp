@@ -5,10 +5,23 @@
 namespace wen {
 
 DescriptorPool::DescriptorPool() {
-    std::vector<vk::DescriptorPoolSize> sizes = {};
+    std::vector<vk::DescriptorPoolSize> sizes = {
+        {vk::DescriptorType::eUniformBuffer, 1024},
+        {vk::DescriptorType::eUniformBufferDynamic, 256},
+        {vk::DescriptorType::eStorageBuffer, 1024},
+        {vk::DescriptorType::eStorageBufferDynamic, 256},
+        {vk::DescriptorType::eCombinedImageSampler, 1024},
+        {vk::DescriptorType::eSampledImage, 256},
+        {vk::DescriptorType::eSampler, 64},
+        {vk::DescriptorType::eStorageImage, 256},
+        {vk::DescriptorType::eInputAttachment, 256},
+    };
+    if (settings->isEnableRayTracing) {
+        sizes.push_back({vk::DescriptorType::eAccelerationStructureKHR, 64});
+    }
     vk::DescriptorPoolCreateInfo createInfo = {};
     createInfo.setPoolSizes(sizes)
-              .setMaxSets(16)
+              .setMaxSets(256)
               .setFlags(vk::DescriptorPoolCreateFlagBits::eFreeDescriptorSet);
     descriptorPool_ = manager->device->device.createDescriptorPool(createInfo);
 }
@@ -24,11 +37,13 @@ std::vector<vk::DescriptorSet> DescriptorPool::allocateDescriptorSets(vk::Descri
     allocateInfo.setDescriptorPool(descriptorPool_)
                 .setDescriptorSetCount(static_cast<uint32_t>(settings->maxFramesInFlight))
                 .setSetLayouts(layouts);
+    std::lock_guard<std::mutex> lock(mutex_);
     descriptorSets = manager->device->device.allocateDescriptorSets(allocateInfo);
     return descriptorSets;
 }
 
 void DescriptorPool::freeDescriptorSets(const std::vector<vk::DescriptorSet>& descriptorSets) {
+    std::lock_guard<std::mutex> lock(mutex_);
     manager->device->device.freeDescriptorSets(descriptorPool_, descriptorSets);
 }
 
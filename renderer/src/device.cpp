@@ -63,14 +63,23 @@ Device::Device() {
                 .setShaderSampledImageArrayNonUniformIndexing(true)
                 .setDescriptorBindingVariableDescriptorCount(true)
                 .setDrawIndirectCount(true)
-                .setSamplerFilterMinmax(true);
+                .setSamplerFilterMinmax(true)
+                .setTimelineSemaphore(true)
+                // the bindless heap
+                .setShaderStorageBufferArrayNonUniformIndexing(true)
+                .setDescriptorBindingPartiallyBound(true)
+                .setDescriptorBindingUpdateUnusedWhilePending(true)
+                .setDescriptorBindingSampledImageUpdateAfterBind(true)
+                .setDescriptorBindingStorageBufferUpdateAfterBind(true);
     deviceCreateInfo.setPNext(&vk12Features);
 
     // extensions
     std::map<std::string, bool> requiredExtensions = {
-        {VK_KHR_SWAPCHAIN_EXTENSION_NAME, false},
         {VK_KHR_BIND_MEMORY_2_EXTENSION_NAME, false},
     };
+    if (!settings->headless) {
+        requiredExtensions.insert(std::make_pair(VK_KHR_SWAPCHAIN_EXTENSION_NAME, false));
+    }
     vk::PhysicalDeviceAccelerationStructureFeaturesKHR accelerationStructureFeatures = {};
     vk::PhysicalDeviceRayTracingPipelineFeaturesKHR rayTracingPipelineFeatures = {};
     vk::PhysicalDeviceRayQueryFeaturesKHR rayQueryFeatures = {};
@@ -147,6 +156,12 @@ Device::Device() {
     presentQueue = device.getQueue(presentQueueFamilyIndex, 0);
     transferQueue = device.getQueue(transferQueueFamilyIndex, 0);
     computeQueue = device.getQueue(computeQueueFamilyIndex, 0);
+    if (asyncCompute()) {
+        WEN_INFO("\tAsync Compute Queue Family: {}", computeQueueFamilyIndex)
+    }
+    if (transferQueueFamilyIndex != graphicsQueueFamilyIndex) {
+        WEN_INFO("\tDedicated Transfer Queue Family: {}", transferQueueFamilyIndex)
+    }
 
     if (settings->isEnableRayTracing) {
         vk::PhysicalDeviceProperties2 properties = {};
@@ -164,11 +179,23 @@ Device::~Device() {
     device.destroy();
 }
 
+std::vector<uint32_t> Device::sharedQueueFamilyIndices() const {
+    if (!asyncCompute()) {
+        return {};
+    }
+    std::vector<uint32_t> families = {graphicsQueueFamilyIndex, computeQueueFamilyIndex};
+    if (transferQueueFamilyIndex != graphicsQueueFamilyIndex) {
+        families.push_back(transferQueueFamilyIndex);
+    }
+    return families;
+}
+
 bool Device::suitable(const vk::PhysicalDevice& device) {
     auto properties = device.getProperties();
     auto features = device.getFeatures();
 
-    if (properties.deviceType != vk::PhysicalDeviceType::eDiscreteGpu) {
+    // headless work also runs on integrated and software devices
+    if (properties.deviceType != vk::PhysicalDeviceType::eDiscreteGpu && !settings->headless) {
         WEN_WARN("Device is not a discrete GPU: {}", properties.deviceName)
         return false;
     }
@@ -200,7 +227,7 @@ bool Device::suitable(const vk::PhysicalDevice& device) {
         if ((queueFamily.queueFlags & (vk::QueueFlagBits::eGraphics |
                                        vk::QueueFlagBits::eTransfer |
                                        vk::QueueFlagBits::eCompute))
-            && (device.getSurfaceSupportKHR(queueFamilyIndex, manager->surface))) {
+            && (settings->headless || device.getSurfaceSupportKHR(queueFamilyIndex, manager->surface))) {
             graphicsQueueFamilyIndex = queueFamilyIndex;
             presentQueueFamilyIndex = queueFamilyIndex;
             transferQueueFamilyIndex = queueFamilyIndex;
@@ -214,6 +241,25 @@ bool Device::suitable(const vk::PhysicalDevice& device) {
         WEN_WARN("Device does not support required queue family: {}", properties.deviceName)
         return false;
     }
+    // a family without graphics runs compute work asynchronously next to the frame
+    queueFamilyIndex = 0;
+    for (auto queueFamily : queueFamilyProperties) {
+        if ((queueFamily.queueFlags & vk::QueueFlagBits::eCompute) && !(queueFamily.queueFlags & vk::QueueFlagBits::eGraphics)) {
+            computeQueueFamilyIndex = queueFamilyIndex;
+            break;
+        }
+        queueFamilyIndex++;
+    }
+    // and a transfer-only family, usually the copy engine, uploads next to it
+    queueFamilyIndex = 0;
+    for (auto queueFamily : queueFamilyProperties) {
+        if ((queueFamily.queueFlags & vk::QueueFlagBits::eTransfer)
+            && !(queueFamily.queueFlags & (vk::QueueFlagBits::eGraphics | vk::QueueFlagBits::eCompute))) {
+            transferQueueFamilyIndex = queueFamilyIndex;
+            break;
+        }
+        queueFamilyIndex++;
+    }
 
     physicalDevice = device;
 
@@ -0,0 +1,57 @@
+#include "frame_allocator.hpp"
+#include "core/setting.hpp"
+#include "core/logger.hpp"
+#include "manager.hpp"
+
+namespace wen {
+
+FrameAllocator::FrameAllocator(uint64_t frameSize) : begin_(0), offset_(0) {
+    auto limits = manager->device->physicalDevice.getProperties().limits;
+    alignment_ = std::max({
+        limits.minUniformBufferOffsetAlignment,
+        limits.minStorageBufferOffsetAlignment,
+        limits.nonCoherentAtomSize,
+        vk::DeviceSize(16)
+    });
+    frameSize_ = (frameSize + alignment_ - 1) / alignment_ * alignment_;
+
+    // device-local where the host can write to it (resizable BAR, unified memory), host memory otherwise
+    buffer_ = std::make_unique<Buffer>(
+        frameSize_ * settings->maxFramesInFlight,
+        vk::BufferUsageFlagBits::eUniformBuffer | vk::BufferUsageFlagBits::eStorageBuffer |
+            vk::BufferUsageFlagBits::eVertexBuffer | vk::BufferUsageFlagBits::eIndexBuffer |
+            vk::BufferUsageFlagBits::eTransferSrc,
+        VMA_MEMORY_USAGE_AUTO_PREFER_DEVICE,
+        VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT | VMA_ALLOCATION_CREATE_DEDICATED_MEMORY_BIT
+    );
+    buffer_->map();
+}
+
+FrameAllocator::~FrameAllocator() {
+    buffer_.reset();
+}
+
+FrameAllocator::Allocation FrameAllocator::allocate(uint64_t size, uint64_t alignment) {
+    alignment = std::max(alignment, alignment_);
+    uint64_t offset = (offset_ + alignment - 1) / alignment * alignment;
+    WEN_ASSERT(offset + size <= frameSize_, "Frame allocator out of memory, {} of {} bytes used", offset_, frameSize_)
+    offset_ = offset + size;
+    return {
+        buffer_->buffer,
+        static_cast<uint32_t>(begin_ + offset),
+        static_cast<uint8_t*>(buffer_->data) + begin_ + offset
+    };
+}
+
+void FrameAllocator::beginFrame(uint32_t inFlight) {
+    begin_ = frameSize_ * inFlight;
+    offset_ = 0;
+}
+
+void FrameAllocator::flush() {
+    if (offset_ > 0) {
+        buffer_->flush(begin_, offset_);
+    }
+}
+
+} // namespace wen
\ No newline at end of file
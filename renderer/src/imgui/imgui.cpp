@@ -121,7 +121,10 @@ void ImGuiLayer::end() {
 }
 
 ImGuiLayer::~ImGuiLayer() {
-    manager->device->device.waitIdle();
+    {
+        std::lock_guard<std::mutex> lock(manager->device->queueMutex);
+        manager->device->device.waitIdle();
+    }
     ImGui_ImplVulkan_Shutdown();
     ImGui_ImplGlfw_Shutdown();
     manager->device->device.destroyDescriptorPool(descriptorPool_);
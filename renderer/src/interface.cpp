@@ -2,6 +2,7 @@
 #include "utils/utils.hpp"
 #include "core/logger.hpp"
 #include "storage/ktx_texture.hpp"
+#include <future>
 
 namespace wen {
 
@@ -35,6 +36,30 @@ std::shared_ptr<Shader> Interface::compileShader(const std::string& filename, Sh
     return std::make_shared<Shader>(filepath, std::string(code.begin(), code.end()), stage);
 }
 
+std::vector<std::shared_ptr<Shader>> Interface::compileShaders(const std::vector<std::pair<std::string, ShaderStage>>& shaders) {
+    std::vector<std::future<std::vector<uint32_t>>> spirvs;
+    spirvs.reserve(shaders.size());
+    for (auto& [filename, stage] : shaders) {
+        std::string filepath = shaderDir_ + filename;
+        spirvs.push_back(std::async(std::launch::async, [filepath, stage]() -> std::vector<uint32_t> {
+            auto code = readFile(filepath);
+            if (code.empty()) {
+                WEN_ERROR("Shader file is empty: {}", filepath)
+                return {};
+            }
+            return Shader::compile(filepath, std::string(code.begin(), code.end()), stage);
+        }));
+    }
+    // modules are created on this thread
+    std::vector<std::shared_ptr<Shader>> results;
+    results.reserve(shaders.size());
+    for (auto& spirv : spirvs) {
+        auto shader = std::make_shared<Shader>(spirv.get());
+        results.push_back(shader->module.has_value() ? std::move(shader) : nullptr);
+    }
+    return results;
+}
+
 std::shared_ptr<GraphicsShaderProgram> Interface::createGraphicsShaderProgram() {
     return std::make_shared<GraphicsShaderProgram>();
 }
@@ -47,8 +72,8 @@ std::shared_ptr<VertexInput> Interface::createVertexInput(const std::vector<Vert
     return std::make_shared<VertexInput>(infos);
 }
 
-std::shared_ptr<VertexBuffer> Interface::createVertexBuffer(uint32_t size, uint32_t count, vk::BufferUsageFlags additionalUsage) {
-    return std::make_shared<VertexBuffer>(size, count, additionalUsage);
+std::shared_ptr<VertexBuffer> Interface::createVertexBuffer(uint32_t size, uint32_t count, vk::BufferUsageFlags additionalUsage, bool hostCopy) {
+    return std::make_shared<VertexBuffer>(size, count, additionalUsage, hostCopy);
 }
 
 std::shared_ptr<IndexBuffer> Interface::createIndexBuffer(IndexType type, uint32_t count, vk::BufferUsageFlags additionalUsage) {
@@ -120,6 +145,14 @@ std::shared_ptr<RayTracingInstance> Interface::createRayTracingInstance() {
     return std::make_shared<RayTracingInstance>();
 }
 
+std::shared_ptr<ComputeShaderProgram> Interface::createComputeShaderProgram() {
+    return std::make_shared<ComputeShaderProgram>();
+}
+
+std::shared_ptr<ComputeRenderPipeline> Interface::createComputeRenderPipeline(std::shared_ptr<ComputeShaderProgram> shaderProgram) {
+    return std::make_shared<ComputeRenderPipeline>(shaderProgram);
+}
+
 std::shared_ptr<GLTFScene> Interface::loadGLTFScene(const std::string& filename, const std::vector<std::string>& attrs) {
     return std::make_shared<GLTFScene>(gltfDir_ + filename, attrs);
 }
@@ -12,7 +12,9 @@ void initialize() {
 }
 
 Context& initializeRenderer() {
-    window = std::make_unique<Window>(settings->windowInfo);
+    if (!settings->headless) {
+        window = std::make_unique<Window>(settings->windowInfo);
+    }
     Context::init();
     Context::instance().initialize();
     return Context::instance();
@@ -6,8 +6,10 @@
 namespace wen {
 
 AccelerationStructure::~AccelerationStructure() {
-    staging_.reset();
-    scratch_.reset();
+    // an update may still be building with it
+    if (scratch_.get() != nullptr) {
+        manager->uploadManager->keep(std::shared_ptr<StorageBuffer>(std::move(scratch_)));
+    }
 }
 
 void AccelerationStructure::addModel(std::shared_ptr<RayTracingModel> model) {
@@ -35,7 +37,7 @@ void AccelerationStructure::build(bool is_update, bool allow_update) {
     std::vector<AccelerationStructureInfo> infos;
     infos.reserve(models_.size() + scenes_.size());
 
-    uint64_t maxStagingSize = currentStagingSize_, maxScratchSize = currentScratchSize_;
+    uint64_t maxScratchSize = currentScratchSize_;
 
     auto mode = is_update ? vk::BuildAccelerationStructureModeKHR::eUpdate
                           : vk::BuildAccelerationStructureModeKHR::eBuild;
@@ -59,8 +61,7 @@ void AccelerationStructure::build(bool is_update, bool allow_update) {
                     // 用于在着色器中获取这个缓冲的地址来访问数据
                     vk::BufferUsageFlagBits::eShaderDeviceAddress,
                 VMA_MEMORY_USAGE_GPU_ONLY,
-                // 为此次分配创建专用的内存
-                VMA_ALLOCATION_CREATE_DEDICATED_MEMORY_BIT
+                0
             );
             model->rayTracingIndexBuffer = std::make_unique<Buffer>(
                 indicesSize,
@@ -68,10 +69,8 @@ void AccelerationStructure::build(bool is_update, bool allow_update) {
                     vk::BufferUsageFlagBits::eAccelerationStructureBuildInputReadOnlyKHR |
                     vk::BufferUsageFlagBits::eShaderDeviceAddress,
                 VMA_MEMORY_USAGE_GPU_ONLY,
-                VMA_ALLOCATION_CREATE_DEDICATED_MEMORY_BIT
+                0
             );
-            maxStagingSize = std::max(maxStagingSize, verticesSize);
-            maxStagingSize = std::max(maxStagingSize, indicesSize);
             model->modelAs = std::make_unique<ModelAccelerationStructure>();
         }
 
@@ -125,7 +124,7 @@ void AccelerationStructure::build(bool is_update, bool allow_update) {
                     vk::BufferUsageFlagBits::eAccelerationStructureBuildInputReadOnlyKHR |
                     vk::BufferUsageFlagBits::eShaderDeviceAddress,
                 VMA_MEMORY_USAGE_GPU_ONLY,
-                VMA_ALLOCATION_CREATE_DEDICATED_MEMORY_BIT
+                0
             );
             scene->rayTracingIndexBuffer = std::make_unique<Buffer>(
                 indicesSize,
@@ -133,10 +132,8 @@ void AccelerationStructure::build(bool is_update, bool allow_update) {
                     vk::BufferUsageFlagBits::eAccelerationStructureBuildInputReadOnlyKHR |
                     vk::BufferUsageFlagBits::eShaderDeviceAddress,
                 VMA_MEMORY_USAGE_GPU_ONLY,
-                VMA_ALLOCATION_CREATE_DEDICATED_MEMORY_BIT
+                0
             );
-            maxStagingSize = std::max(maxStagingSize, verticesSize);
-            maxStagingSize = std::max(maxStagingSize, indicesSize);
         }
 
         scene->build([&](auto* node, auto primitive) {
@@ -176,64 +173,48 @@ void AccelerationStructure::build(bool is_update, bool allow_update) {
         });
     }
 
-    // create staging and scratch buffers if needed.
-    if (maxStagingSize > currentStagingSize_) {
-        staging_.reset();
-        staging_ = std::make_unique<StorageBuffer>(
-            maxStagingSize,
-            // 可以将这个缓冲区的数据复制到其他缓冲区或显存
-            vk::BufferUsageFlagBits::eTransferSrc,
-            VMA_MEMORY_USAGE_CPU_TO_GPU,
-            // 在CPU端对分配的内存进行顺序写入
-            VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT |
-                // 允许使用传输队列执行传输操作
-                VMA_ALLOCATION_CREATE_HOST_ACCESS_ALLOW_TRANSFER_INSTEAD_BIT
-        );
-        currentStagingSize_ = maxStagingSize;
-    }
+    // create scratch buffer if needed, the previous one may still be in use by an update in flight.
+    auto& uploads = manager->uploadManager;
     if (maxScratchSize > currentScratchSize_) {
-        scratch_.reset();
+        if (scratch_.get() != nullptr) {
+            uploads->keep(std::shared_ptr<StorageBuffer>(std::move(scratch_)));
+        }
         scratch_ = std::make_unique<StorageBuffer>(
             maxScratchSize,
             // 存储缓冲区是一种特殊类型的缓冲区，它可以在着色器中被读写
             vk::BufferUsageFlagBits::eShaderDeviceAddress | vk::BufferUsageFlagBits::eStorageBuffer,
             VMA_MEMORY_USAGE_GPU_ONLY,
-            VMA_ALLOCATION_CREATE_DEDICATED_MEMORY_BIT
+            0
         );
         currentScratchSize_ = maxScratchSize;
     }
 
-    // upload data to gpu
+    // upload data to gpu, the copies run ahead of the builds in the same batch
     if (!is_update) {
         for (auto& model : models_) {
-            auto* ptr = static_cast<uint8_t*>(staging_->map());
-
             uint64_t verticesSize = model->vertexCount * sizeof(Vertex);
-            memcpy(ptr, model->vertices().data(), verticesSize);
-            staging_->flush(verticesSize, model->rayTracingVertexBuffer->buffer);
+            uploads->upload(*model->rayTracingVertexBuffer, 0, model->vertices().data(), verticesSize);
 
-            uint64_t indicesSize = 0;
+            uint64_t indicesSize = model->indexCount * sizeof(uint32_t);
+            auto staging = uploads->stage(indicesSize);
+            auto* ptr = static_cast<uint8_t*>(staging.data);
             for (const auto& [name, mesh] : model->meshes()) {
                 uint64_t size = mesh->indices.size() * sizeof(uint32_t);
                 memcpy(ptr, mesh->indices.data(), size);
                 ptr += size;
-                indicesSize += size;
             }
-            staging_->flush(indicesSize, model->rayTracingIndexBuffer->buffer);
+            vk::BufferCopy region = {};
+            region.setSrcOffset(staging.offset)
+                  .setDstOffset(0)
+                  .setSize(indicesSize);
+            uploads->copy(staging.buffer, *model->rayTracingIndexBuffer, region);
         }
         for (auto& scene : scenes_) {
-            auto* ptr = static_cast<uint8_t*>(staging_->map());
-
             uint64_t verticesSize = scene->vertices.size() * sizeof(glm::vec3);
-            memcpy(ptr, scene->vertices.data(), verticesSize);
-            staging_->flush(verticesSize, scene->rayTracingVertexBuffer->buffer);
+            uploads->upload(*scene->rayTracingVertexBuffer, 0, scene->vertices.data(), verticesSize);
 
             uint64_t indicesSize = scene->indices.size() * sizeof(uint32_t);
-            memcpy(ptr, scene->indices.data(), indicesSize);
-            staging_->flush(indicesSize, scene->rayTracingIndexBuffer->buffer);
-        }
-        if (staging_.get() != nullptr) {
-            staging_->unmap();
+            uploads->upload(*scene->rayTracingIndexBuffer, 0, scene->indices.data(), indicesSize);
         }
     }
 
@@ -253,9 +234,9 @@ void AccelerationStructure::build(bool is_update, bool allow_update) {
         batchSize += infos[i].size.accelerationStructureSize;
         // 超过256MB或是最后一个底层加速结构
         if (batchSize > batchLimit || i == infos.size() - 1) {
-            auto cmdbuf = manager->commandPool->allocateSingleUse();
-            cmdbuf.resetQueryPool(queryPool, 0, infos.size());
+            auto cmdbuf = uploads->graphicsCommands();
             if (!is_update) {
+                cmdbuf.resetQueryPool(queryPool, 0, infos.size());
                 uint32_t index = 0;
                 for (auto j : indices) {
                     auto& info = infos[j];
@@ -266,7 +247,7 @@ void AccelerationStructure::build(bool is_update, bool allow_update) {
                         vk::BufferUsageFlagBits::eAccelerationStructureStorageKHR |
                             vk::BufferUsageFlagBits::eShaderDeviceAddress,
                         VMA_MEMORY_USAGE_GPU_ONLY,
-                        VMA_ALLOCATION_CREATE_DEDICATED_MEMORY_BIT
+                        0
                     );
                     vk::AccelerationStructureCreateInfoKHR createInfo = {};
                     createInfo.setType(vk::AccelerationStructureTypeKHR::eBottomLevel)
@@ -301,7 +282,8 @@ void AccelerationStructure::build(bool is_update, bool allow_update) {
                     );
                     index++;
                 }
-                manager->commandPool->freeSingleUse(cmdbuf);
+                // the compacted sizes are needed on the host before going on
+                uploads->flush().wait();
 
                 /*
                     大体上来说，压缩流程如下：
@@ -323,7 +305,7 @@ void AccelerationStructure::build(bool is_update, bool allow_update) {
                 );
                 WEN_ASSERT(res == vk::Result::eSuccess, "Failed to get query pool results.")
                 
-                cmdbuf = manager->commandPool->allocateSingleUse();
+                cmdbuf = uploads->graphicsCommands();
                 index = 0;
                 for (auto j : indices) {
                     auto& info = infos[j];
@@ -334,7 +316,7 @@ void AccelerationStructure::build(bool is_update, bool allow_update) {
                         vk::BufferUsageFlagBits::eAccelerationStructureStorageKHR |
                             vk::BufferUsageFlagBits::eShaderDeviceAddress,
                         VMA_MEMORY_USAGE_GPU_ONLY,
-                        VMA_ALLOCATION_CREATE_DEDICATED_MEMORY_BIT
+                        0
                     );
                     vk::AccelerationStructureCreateInfoKHR createInfo = {};
                     createInfo.setType(vk::AccelerationStructureTypeKHR::eBottomLevel)
@@ -373,7 +355,6 @@ void AccelerationStructure::build(bool is_update, bool allow_update) {
                     );
                 }
             }
-            manager->commandPool->freeSingleUse(cmdbuf);
 
             // 重置
             batchSize = 0;
@@ -382,6 +363,8 @@ void AccelerationStructure::build(bool is_update, bool allow_update) {
     }
 
     if (!is_update) {
+        // the compaction copies still read the uncompacted structures
+        uploads->flush().wait();
         for (auto& info : infos) {
             manager->device->device.destroyAccelerationStructureKHR(info.as, nullptr, manager->dispatcher);
             info.buffer.reset();
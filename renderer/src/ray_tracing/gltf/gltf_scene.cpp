@@ -2,6 +2,7 @@
 #include "storage/ktx_texture.hpp"
 #include "storage/data_texture.hpp"
 #include "core/logger.hpp"
+#include "manager.hpp"
 #include <glm/gtc/type_ptr.hpp>
 
 namespace wen {
@@ -61,6 +62,7 @@ void GLTFScene::loadImages(const tinygltf::Model& model) {
     for (auto& image : model.images) {
         if (image.uri.empty()) {
             WEN_WARN("unsupported image format {}", image.name)
+            imageHandles_.push_back(-1);
             continue;
         }
 
@@ -68,6 +70,7 @@ void GLTFScene::loadImages(const tinygltf::Model& model) {
         if ((pos = image.uri.find_last_of('.')) != std::string::npos) {
             if (image.uri.substr(pos + 1) == "ktx") {
                 textures_.push_back(std::make_shared<KtxTexture>(filepath_ + "/" + image.uri));
+                imageHandles_.push_back(manager->bindlessHeap->addTexture(textures_.back()));
                 continue;
             }
         }
@@ -94,21 +97,30 @@ void GLTFScene::loadImages(const tinygltf::Model& model) {
             WEN_DEBUG("use 4 channel(RGBA) image {} X {}", image.width, image.height)
         }
         textures_.push_back(std::make_shared<DataTexture>(data, image.width, image.height, 0));
+        imageHandles_.push_back(manager->bindlessHeap->addTexture(textures_.back()));
     }
     sampler_ = std::make_shared<Sampler>();
+    samplerHandle_ = manager->bindlessHeap->addSampler(sampler_);
 }
 
 void GLTFScene::loadMaterials(const tinygltf::Model& model) {
+    // glTF texture index to the bindless handle of its image
+    auto handle = [&](int texture) {
+        if (texture < 0 || model.textures[texture].source < 0) {
+            return -1;
+        }
+        return imageHandles_[model.textures[texture].source];
+    };
     for (auto& material : model.materials) {
         auto& mat = materials_.emplace_back();
         mat.baseColorFactor = glm::make_vec4(material.pbrMetallicRoughness.baseColorFactor.data());
-        mat.baseColorTexture = material.pbrMetallicRoughness.baseColorTexture.index;
+        mat.baseColorTexture = handle(material.pbrMetallicRoughness.baseColorTexture.index);
         mat.emissiveFactor = glm::make_vec3(material.emissiveFactor.data());
-        mat.emissiveTexture = material.emissiveTexture.index;
-        mat.normalTexture = material.normalTexture.index;
+        mat.emissiveTexture = handle(material.emissiveTexture.index);
+        mat.normalTexture = handle(material.normalTexture.index);
         mat.metallicFactor = material.pbrMetallicRoughness.metallicFactor;
         mat.roughnessFactor = material.pbrMetallicRoughness.roughnessFactor;
-        mat.metallicRoughnessTexture = material.pbrMetallicRoughness.metallicRoughnessTexture.index;
+        mat.metallicRoughnessTexture = handle(material.pbrMetallicRoughness.metallicRoughnessTexture.index);
     }
     materialBuffer_ = std::make_shared<StorageBuffer>(
         materials_.size() * sizeof(GLTFMaterial),
@@ -119,6 +131,7 @@ void GLTFScene::loadMaterials(const tinygltf::Model& model) {
     auto* ptr = static_cast<uint8_t*>(materialBuffer_->map());
     memcpy(ptr, materials_.data(), materialBuffer_->getSize());
     materialBuffer_->unmap();
+    materialBufferHandle_ = manager->bindlessHeap->addStorageBuffer(materialBuffer_);
 }
 
 void GLTFScene::loadMeshesAndPrimitives(const tinygltf::Model& model, const std::vector<std::string>& attrs) {
@@ -149,6 +162,18 @@ void GLTFScene::loadNodes(const tinygltf::Model& model) {
 }
 
 GLTFScene::~GLTFScene() {
+    // the heap holds on to the resources until the frames in flight are done with them
+    for (auto handle : imageHandles_) {
+        if (handle >= 0) {
+            manager->bindlessHeap->removeTexture(handle);
+        }
+    }
+    if (sampler_) {
+        manager->bindlessHeap->removeSampler(samplerHandle_);
+    }
+    if (materialBuffer_) {
+        manager->bindlessHeap->removeStorageBuffer(materialBufferHandle_);
+    }
     nodes_.clear();
     nodesPtr_.clear();
     attrDatas_.clear();
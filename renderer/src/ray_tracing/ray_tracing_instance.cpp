@@ -8,6 +8,9 @@ namespace wen {
 RayTracingInstance::RayTracingInstance() : instanceCount_(0) {}
 
 RayTracingInstance::~RayTracingInstance() {
+    if (building_.valid()) {
+        building_.wait();
+    }
     instanceBuffer_.reset();
     manager->device->device.destroyAccelerationStructureKHR(tlas, nullptr, manager->dispatcher);
     scratch_.reset();
@@ -98,20 +101,20 @@ void RayTracingInstance::build(bool allow_update) {
         size.accelerationStructureSize,
         vk::BufferUsageFlagBits::eAccelerationStructureStorageKHR | vk::BufferUsageFlagBits::eShaderDeviceAddress,
         VMA_MEMORY_USAGE_GPU_ONLY,
-        VMA_ALLOCATION_CREATE_DEDICATED_MEMORY_BIT
+        0
     );
     createInfo.setType(vk::AccelerationStructureTypeKHR::eTopLevel)
               .setSize(size.accelerationStructureSize)
               .setBuffer(buffer_->getBuffer());
     tlas = manager->device->device.createAccelerationStructureKHR(createInfo, nullptr, manager->dispatcher);
 
-    // 构建顶层加速结构
-    auto cmdbuf = manager->commandPool->allocateSingleUse();
+    // 构建顶层加速结构, 在上传批次中与底层加速结构一同提交
+    auto cmdbuf = manager->uploadManager->graphicsCommands();
     scratch_ = std::make_unique<StorageBuffer>(
         size.buildScratchSize,
         vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eShaderDeviceAddress,
         VMA_MEMORY_USAGE_GPU_ONLY,
-        VMA_ALLOCATION_CREATE_DEDICATED_MEMORY_BIT
+        0
     );
     build.setDstAccelerationStructure(tlas)
          .setScratchData(getBufferAddress(scratch_->getBuffer()));
@@ -121,7 +124,7 @@ void RayTracingInstance::build(bool allow_update) {
          .setFirstVertex(0)
          .setTransformOffset(0);
     cmdbuf.buildAccelerationStructuresKHR(build, &range, manager->dispatcher);
-    manager->commandPool->freeSingleUse(cmdbuf);
+    building_ = manager->uploadManager->pending();
 }
 
 void RayTracingInstance::update(uint32_t id, FunUpdateCallback callback) {
@@ -130,6 +133,9 @@ void RayTracingInstance::update(uint32_t id, FunUpdateCallback callback) {
         return;
     }
 
+    // 上一次构建仍可能在读取实例缓冲区
+    building_.wait();
+
     auto update = [=](uint32_t index, uint32_t begin, uint32_t end) {
         auto* asInstancePtr = static_cast<vk::AccelerationStructureInstanceKHR*>(instanceBuffer_->data);
         asInstancePtr += begin;
@@ -168,14 +174,14 @@ void RayTracingInstance::update(uint32_t id, FunUpdateCallback callback) {
         build, instanceCount_, manager->dispatcher
     );
 
-    auto cmdbuf = manager->commandPool->allocateSingleUse();
+    auto cmdbuf = manager->uploadManager->graphicsCommands();
     if (scratch_->getSize() < size.updateScratchSize) {
-        scratch_.reset();
+        manager->uploadManager->keep(std::shared_ptr<StorageBuffer>(std::move(scratch_)));
         scratch_ = std::make_unique<StorageBuffer>(
             size.updateScratchSize,
             vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eShaderDeviceAddress,
             VMA_MEMORY_USAGE_GPU_ONLY,
-            VMA_ALLOCATION_CREATE_DEDICATED_MEMORY_BIT
+            0
         );
     }
     build.setSrcAccelerationStructure(tlas)
@@ -187,7 +193,7 @@ void RayTracingInstance::update(uint32_t id, FunUpdateCallback callback) {
          .setFirstVertex(0)
          .setTransformOffset(0);
     cmdbuf.buildAccelerationStructuresKHR(build, &range, manager->dispatcher);
-    manager->commandPool->freeSingleUse(cmdbuf);
+    building_ = manager->uploadManager->pending();
 }
 
 InstanceAddress RayTracingInstance::createInstanceAddress(RayTracingModel& model) {
@@ -101,7 +101,7 @@ void RayTracingRenderPipeline::compile(const RayTracingRenderPipelineOptions& op
         raygenRegion_.size + missRegion_.size + hitRegion_.size,
         vk::BufferUsageFlagBits::eShaderDeviceAddress | vk::BufferUsageFlagBits::eShaderBindingTableKHR,
         VMA_MEMORY_USAGE_AUTO,
-        VMA_ALLOCATION_CREATE_DEDICATED_MEMORY_BIT | VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT
+        VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT
     );
     // 获取每组的着色器绑定表
     auto address = getBufferAddress(buffer_->buffer);
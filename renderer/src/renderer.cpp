@@ -29,6 +29,12 @@ Renderer::Renderer(std::shared_ptr<RenderPass> renderPass) {
         inFlightFences_[i] = device.createFence(fence);
         inFlightSubmitInfos_.emplace_back(); 
     }
+
+    computeCommandBuffers_ = manager->computeCommandPool->allocateCommandBuffers(settings->maxFramesInFlight);
+    computeFinishedSemaphores_.resize(settings->maxFramesInFlight);
+    for (uint32_t i = 0; i < settings->maxFramesInFlight; i++) {
+        computeFinishedSemaphores_[i] = device.createSemaphore(semaphore);
+    }
 }
 
 Renderer::~Renderer() {
@@ -38,6 +44,7 @@ Renderer::~Renderer() {
         device.destroySemaphore(imageAvailableSemaphores_[i]);
         device.destroySemaphore(renderFinishedSemaphores_[i]);
         device.destroyFence(inFlightFences_[i]);
+        device.destroySemaphore(computeFinishedSemaphores_[i]);
     }
     framebufferStore.reset();
     renderPass.reset();
@@ -78,6 +85,7 @@ void Renderer::updateRenderPass() {
 }
 
 void Renderer::waitIdle() {
+    std::lock_guard<std::mutex> lock(manager->device->queueMutex);
     manager->device->device.waitIdle();
 }
 
@@ -89,6 +97,9 @@ void Renderer::acquireNextImage() {
         ) == vk::Result::eSuccess,
         "Failed to wait for fence"
     )
+    // what the frame allocated the last time around is no longer read
+    manager->frameAllocator->beginFrame(currentInFlight_);
+    manager->bindlessHeap->nextFrame();
 
     try {
         if (device.acquireNextImageKHR(
@@ -130,6 +141,12 @@ void Renderer::beginRenderPass() {
         .setRenderArea(renderArea)
         .setClearValues(clearValues);
 
+    computeBarrier(
+        vk::PipelineStageFlagBits::eDrawIndirect | vk::PipelineStageFlagBits::eVertexInput |
+        vk::PipelineStageFlagBits::eVertexShader | vk::PipelineStageFlagBits::eFragmentShader,
+        vk::AccessFlagBits::eIndirectCommandRead | vk::AccessFlagBits::eVertexAttributeRead | vk::AccessFlagBits::eIndexRead |
+        vk::AccessFlagBits::eUniformRead | vk::AccessFlagBits::eShaderRead
+    );
     currentBuffer_.beginRenderPass(renderPassBegin, vk::SubpassContents::eInline);
 }
 
@@ -144,6 +161,9 @@ void Renderer::endRenderPass() {
 
 void Renderer::present() {
     currentBuffer_.end();
+    // uploads recorded since the last frame run ahead of it on the graphics queue
+    manager->uploadManager->flush();
+    manager->frameAllocator->flush();
 
     std::vector<vk::Semaphore> waitSemaphores = {
         imageAvailableSemaphores_[currentInFlight_],
@@ -151,13 +171,27 @@ void Renderer::present() {
     std::vector<vk::PipelineStageFlags> waitStages = {
         vk::PipelineStageFlagBits::eColorAttachmentOutput,
     };
+    if (computeWaitStages_.has_value()) {
+        waitSemaphores.push_back(computeFinishedSemaphores_[currentInFlight_]);
+        waitStages.push_back(computeWaitStages_.value());
+        computeWaitStages_.reset();
+    }
+
+    // the frame timeline tells the upload manager when this frame no longer reads what it overwrites
+    std::vector<vk::Semaphore> signalSemaphores = {
+        renderFinishedSemaphores_[currentInFlight_],
+        manager->uploadManager->frameTimeline(),
+    };
+    std::vector<uint64_t> signalValues = {0, manager->uploadManager->nextFrame()};
+    vk::TimelineSemaphoreSubmitInfo timeline = {};
+    timeline.setSignalSemaphoreValues(signalValues);
 
     auto& submits = inFlightSubmitInfos_[currentInFlight_].emplace_back();
     submits.setWaitSemaphores(waitSemaphores)
         .setWaitDstStageMask(waitStages)
         .setCommandBuffers(currentBuffer_)
-        .setSignalSemaphores(renderFinishedSemaphores_[currentInFlight_]);
-    manager->device->graphicsQueue.submit(submits, inFlightFences_[currentInFlight_]);
+        .setSignalSemaphores(signalSemaphores)
+        .setPNext(&timeline);
 
     vk::PresentInfoKHR presentInfo = {};
     presentInfo.setWaitSemaphores(renderFinishedSemaphores_[currentInFlight_])
@@ -165,12 +199,18 @@ void Renderer::present() {
         .setImageIndices(index_)
         .setPResults(nullptr);
 
-    try {
-        auto res = manager->device->presentQueue.presentKHR(presentInfo);
-        if (res == vk::Result::eErrorOutOfDateKHR || res == vk::Result::eSuboptimalKHR) {
-            updateSwapchain();
+    bool outOfDate = false;
+    {
+        std::lock_guard<std::mutex> lock(manager->device->queueMutex);
+        manager->device->graphicsQueue.submit(submits, inFlightFences_[currentInFlight_]);
+        try {
+            auto res = manager->device->presentQueue.presentKHR(presentInfo);
+            outOfDate = res == vk::Result::eErrorOutOfDateKHR || res == vk::Result::eSuboptimalKHR;
+        } catch (vk::OutOfDateKHRError) {
+            outOfDate = true;
         }
-    } catch (vk::OutOfDateKHRError) {
+    }
+    if (outOfDate) {
         updateSwapchain();
     }
 
@@ -192,10 +232,12 @@ void Renderer::bindPipeline(const std::shared_ptr<GraphicsRenderPipeline>& rende
 void Renderer::bindDescriptorSets(const std::shared_ptr<GraphicsRenderPipeline>& renderPipeline) {
     if (!renderPipeline->descriptorSets.empty()) {
         std::vector<vk::DescriptorSet> descriptorSets;
+        std::vector<uint32_t> dynamicOffsets;
         for (auto& descriptorSet : renderPipeline->descriptorSets) {
             descriptorSets.push_back(descriptorSet.value()->descriptorSets_[currentInFlight_]);
+            descriptorSet.value()->appendDynamicOffsets(dynamicOffsets);
         }
-        currentBuffer_.bindDescriptorSets(bindPoint_, renderPipeline->pipelineLayout, 0, descriptorSets, {});
+        currentBuffer_.bindDescriptorSets(bindPoint_, renderPipeline->pipelineLayout, 0, descriptorSets, dynamicOffsets);
     }
 }
 
@@ -213,20 +255,11 @@ void Renderer::bindResources(std::shared_ptr<GraphicsRenderPipeline> renderPipel
 }
 
 void Renderer::bindResources(std::shared_ptr<RayTracingRenderPipeline> renderPipeline) {
-    currentBuffer_.bindPipeline(bindPoint_, renderPipeline->pipeline);
-
-    if (!renderPipeline->descriptorSets.empty()) {
-        std::vector<vk::DescriptorSet> sets;
-        for (auto& descriptorSet : renderPipeline->descriptorSets) {
-            sets.push_back(descriptorSet.value()->descriptorSets_[currentInFlight_]);
-        }
-        currentBuffer_.bindDescriptorSets(bindPoint_, renderPipeline->pipelineLayout, 0, sets, {});
-    }
+    renderPipeline->bind(currentBuffer_, bindPoint_, currentInFlight_);
+}
 
-    if (renderPipeline->pushConstants.has_value()) {
-        auto pushConstants = renderPipeline->pushConstants.value();
-        currentBuffer_.pushConstants(renderPipeline->pipelineLayout, pushConstants->range_.stageFlags, 0, pushConstants->size_, pushConstants->constants_.data());
-    }
+void Renderer::bindResources(std::shared_ptr<ComputeRenderPipeline> renderPipeline) {
+    renderPipeline->bind(currentBuffer_, bindPoint_, currentInFlight_);
 }
 
 void Renderer::bindVertexBuffers(const std::vector<std::shared_ptr<VertexBuffer>>& vertexBuffers, uint32_t firstBinding) {
@@ -243,6 +276,10 @@ void Renderer::bindVertexBuffer(const std::shared_ptr<VertexBuffer>& vertexBuffe
     bindVertexBuffers({vertexBuffer}, binding);
 }
 
+void Renderer::bindVertexBuffer(const FrameAllocator::Allocation& allocation, uint32_t binding) {
+    currentBuffer_.bindVertexBuffers(binding, allocation.buffer, vk::DeviceSize(allocation.offset));
+}
+
 void Renderer::bindIndexBuffer(const std::shared_ptr<IndexBuffer>& indexBuffer) {
     currentBuffer_.bindIndexBuffer(indexBuffer->getBuffer(), 0, indexBuffer->indexType);
 }
@@ -264,6 +301,7 @@ void Renderer::drawMesh(const std::shared_ptr<Mesh>& mesh, uint32_t instanceCoun
 }
 
 void Renderer::traceRays(const std::shared_ptr<RayTracingRenderPipeline>& renderPipeline, uint32_t width, uint32_t height, uint32_t depth) {
+    computeBarrier(vk::PipelineStageFlagBits::eRayTracingShaderKHR, vk::AccessFlagBits::eShaderRead | vk::AccessFlagBits::eUniformRead);
     currentBuffer_.traceRaysKHR(
         renderPipeline->raygenRegion_,
         renderPipeline->missRegion_,
@@ -274,6 +312,70 @@ void Renderer::traceRays(const std::shared_ptr<RayTracingRenderPipeline>& render
     );
 }
 
+void Renderer::dispatch(uint32_t groupCountX, uint32_t groupCountY, uint32_t groupCountZ) {
+    computeBarrier(vk::PipelineStageFlagBits::eComputeShader, vk::AccessFlagBits::eShaderRead | vk::AccessFlagBits::eShaderWrite);
+    currentBuffer_.dispatch(groupCountX, groupCountY, groupCountZ);
+    computeWrites_ = {true, {}};
+}
+
+void Renderer::dispatchIndirect(const std::shared_ptr<SpecificBuffer>& buffer, vk::DeviceSize offset) {
+    computeBarrier(
+        vk::PipelineStageFlagBits::eDrawIndirect | vk::PipelineStageFlagBits::eComputeShader,
+        vk::AccessFlagBits::eIndirectCommandRead | vk::AccessFlagBits::eShaderRead | vk::AccessFlagBits::eShaderWrite
+    );
+    currentBuffer_.dispatchIndirect(buffer->getBuffer(currentInFlight_), offset);
+    computeWrites_ = {true, {}};
+}
+
+void Renderer::computeBarrier(vk::PipelineStageFlags stages, vk::AccessFlags access) {
+    if (!computeWrites_.pending || (computeWrites_.visibleStages & stages) == stages) {
+        return;
+    }
+    // also orders the reads of the earlier dispatches before later writes
+    vk::MemoryBarrier barrier = {};
+    barrier.setSrcAccessMask(vk::AccessFlagBits::eShaderWrite)
+           .setDstAccessMask(access);
+    currentBuffer_.pipelineBarrier(
+        vk::PipelineStageFlagBits::eComputeShader,
+        stages,
+        {},
+        {barrier},
+        {},
+        {}
+    );
+    computeWrites_.visibleStages |= stages;
+}
+
+void Renderer::beginAsyncCompute() {
+    WEN_ASSERT(!computeWaitStages_.has_value(), "Async compute is submitted once per frame")
+    graphicsBuffer_ = currentBuffer_;
+    graphicsComputeWrites_ = computeWrites_;
+    computeWrites_ = {};
+
+    // the frame's fence covers this buffer too, its graphics submission waited for it
+    currentBuffer_ = computeCommandBuffers_[currentInFlight_];
+    currentBuffer_.reset();
+    vk::CommandBufferBeginInfo beginInfo = {};
+    beginInfo.setFlags(vk::CommandBufferUsageFlagBits::eOneTimeSubmit);
+    currentBuffer_.begin(beginInfo);
+}
+
+void Renderer::endAsyncCompute(vk::PipelineStageFlags waitStages) {
+    currentBuffer_.end();
+
+    vk::SubmitInfo submit = {};
+    submit.setCommandBuffers(currentBuffer_)
+          .setSignalSemaphores(computeFinishedSemaphores_[currentInFlight_]);
+    {
+        std::lock_guard<std::mutex> lock(manager->device->queueMutex);
+        manager->device->computeQueue.submit(submit, nullptr);
+    }
+    computeWaitStages_ = waitStages;
+
+    currentBuffer_ = graphicsBuffer_;
+    computeWrites_ = graphicsComputeWrites_;
+}
+
 void Renderer::nextSubpass() {
     currentBuffer_.nextSubpass(vk::SubpassContents::eInline);
     currentSubpass_++;
@@ -3,20 +3,47 @@
 
 namespace wen {
 
+// larger buffers take an allocation of their own unless the caller asked for one, smaller ones are
+// placed in VMA's shared memory blocks
+static constexpr uint64_t dedicatedThreshold = 4 * 1024 * 1024;
+// acceleration structures and their scratch memory need more than the buffer's reported alignment
+static constexpr uint64_t deviceAddressAlignment = 256;
+
 Buffer::Buffer(uint64_t size, vk::BufferUsageFlags usage, VmaMemoryUsage vmaUsage, VmaAllocationCreateFlags vmaFlags)
     : size(size), mapped_(false), data(nullptr) {
     VmaAllocationCreateInfo allocInfo = {};
     allocInfo.usage = vmaUsage;
     allocInfo.flags = vmaFlags;
+    if (size >= dedicatedThreshold) {
+        allocInfo.flags |= VMA_ALLOCATION_CREATE_DEDICATED_MEMORY_BIT;
+    }
 
     vk::BufferCreateInfo createInfo = {};
     createInfo.size = size;
     createInfo.usage = usage;
+    auto& device = manager->device;
+    std::vector<uint32_t> families;
+    // copy destinations as well, a compute queue may be the one copying into them, a readback for instance
+    if (usage & (vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eUniformBuffer |
+                 vk::BufferUsageFlagBits::eIndirectBuffer | vk::BufferUsageFlagBits::eTransferDst)) {
+        families = device->sharedQueueFamilyIndices();
+    }
+    // upload destinations are written by the transfer queue between frames that read them, shared they
+    // need no ownership transfer back to the transfer family before every copy
+    if (families.empty() && (usage & vk::BufferUsageFlagBits::eTransferDst) && device->transferQueueFamilyIndex != device->graphicsQueueFamilyIndex) {
+        families = {device->graphicsQueueFamilyIndex, device->transferQueueFamilyIndex};
+    }
+    if (!families.empty()) {
+        createInfo.setSharingMode(vk::SharingMode::eConcurrent)
+                  .setQueueFamilyIndices(families);
+        sharingMode = vk::SharingMode::eConcurrent;
+    }
 
-    vmaCreateBuffer(
+    vmaCreateBufferWithAlignment(
         manager->vmaAllocator,
         reinterpret_cast<VkBufferCreateInfo*>(&createInfo),
         &allocInfo,
+        usage & vk::BufferUsageFlagBits::eShaderDeviceAddress ? deviceAddressAlignment : 0,
         reinterpret_cast<VkBuffer*>(&buffer),
         &allocation_,
         nullptr
@@ -41,6 +68,20 @@ void Buffer::unmap() {
     mapped_ = false;
 }
 
+void Buffer::flush(uint64_t offset, uint64_t size) {
+    vmaFlushAllocation(manager->vmaAllocator, allocation_, offset, size);
+}
+
+void Buffer::invalidate(uint64_t offset, uint64_t size) {
+    vmaInvalidateAllocation(manager->vmaAllocator, allocation_, offset, size);
+}
+
+vk::MemoryPropertyFlags Buffer::memoryProperties() const {
+    VkMemoryPropertyFlags flags;
+    vmaGetAllocationMemoryProperties(manager->vmaAllocator, allocation_, &flags);
+    return vk::MemoryPropertyFlags(flags);
+}
+
 Buffer::~Buffer() {
     unmap();
     vmaDestroyBuffer(manager->vmaAllocator, buffer, allocation_);
@@ -26,6 +26,11 @@ Image::Image(
               .setUsage(usage)
               .setSamples(samples)
               .setInitialLayout(vk::ImageLayout::eUndefined);
+    auto families = manager->device->sharedQueueFamilyIndices();
+    if (!families.empty() && (usage & vk::ImageUsageFlagBits::eStorage)) {
+        createInfo.setSharingMode(vk::SharingMode::eConcurrent)
+                  .setQueueFamilyIndices(families);
+    }
 
     vmaCreateImage(
         manager->vmaAllocator,
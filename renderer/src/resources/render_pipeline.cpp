@@ -41,6 +41,25 @@ void RenderPipeline::createPipelineLayout() {
     pipelineLayout = manager->device->device.createPipelineLayout(info);
 }
 
+void RenderPipeline::bind(vk::CommandBuffer cmdbuf, vk::PipelineBindPoint bindPoint, uint32_t inFlight) const {
+    cmdbuf.bindPipeline(bindPoint, pipeline);
+
+    if (!descriptorSets.empty()) {
+        std::vector<vk::DescriptorSet> sets;
+        std::vector<uint32_t> dynamicOffsets;
+        for (auto& descriptorSet : descriptorSets) {
+            sets.push_back(descriptorSet.value()->descriptorSets_[inFlight]);
+            descriptorSet.value()->appendDynamicOffsets(dynamicOffsets);
+        }
+        cmdbuf.bindDescriptorSets(bindPoint, pipelineLayout, 0, sets, dynamicOffsets);
+    }
+
+    if (pushConstants.has_value()) {
+        auto& constants = pushConstants.value();
+        cmdbuf.pushConstants(pipelineLayout, constants->range_.stageFlags, 0, constants->size_, constants->constants_.data());
+    }
+}
+
 RenderPipeline::~RenderPipeline() {
     manager->device->device.destroyPipeline(pipeline);
     manager->device->device.destroyPipelineLayout(pipelineLayout);
@@ -172,4 +191,30 @@ void GraphicsRenderPipeline::compile(const GraphicsRenderPipelineOptions& option
     pipeline = manager->device->device.createGraphicsPipeline(nullptr, info).value;
 } 
 
+ComputeRenderPipeline::ComputeRenderPipeline(std::shared_ptr<ComputeShaderProgram> shaderProgram) {
+    shaderProgram_ = shaderProgram;
+}
+
+ComputeRenderPipeline::~ComputeRenderPipeline() {
+    shaderProgram_.reset();
+}
+
+void ComputeRenderPipeline::compile(const ComputeRenderPipelineOptions& options) {
+    createPipelineLayout();
+
+    vk::ComputePipelineCreateInfo info = {};
+    info.setStage(
+            createShaderStage(
+                vk::ShaderStageFlagBits::eCompute,
+                shaderProgram_->computeShader_.shader->module.value(),
+                shaderProgram_->computeShader_.entry
+            )
+        )
+        .setLayout(pipelineLayout)
+        .setBasePipelineHandle(nullptr)
+        .setBasePipelineIndex(0);
+
+    pipeline = manager->device->device.createComputePipeline(nullptr, info).value;
+}
+
 } // namespace wen
\ No newline at end of file
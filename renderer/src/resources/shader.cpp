@@ -1,6 +1,7 @@
 #include "resources/shader.hpp"
 #include "core/logger.hpp"
 #include "resources/shader_includer.hpp"
+#include "resources/shader_cache.hpp"
 #include "manager.hpp"
 
 namespace wen {
@@ -12,7 +13,21 @@ Shader::Shader(const std::vector<char>& codes) {
     module = manager->device->device.createShaderModule(info);
 }
 
-Shader::Shader(const std::string& filename, const std::string& code, ShaderStage stage) {
+Shader::Shader(const std::string& filename, const std::string& code, ShaderStage stage)
+    : Shader(compile(filename, code, stage)) {}
+
+Shader::Shader(const std::vector<uint32_t>& spirv) {
+    if (spirv.empty()) {
+        return;
+    }
+
+    vk::ShaderModuleCreateInfo info = {};
+    info.setCodeSize(spirv.size() * sizeof(uint32_t))
+        .setPCode(reinterpret_cast<const uint32_t*>(spirv.data()));
+    module = manager->device->device.createShaderModule(info);
+}
+
+std::vector<uint32_t> Shader::compile(const std::string& filename, const std::string& code, ShaderStage stage) {
     shaderc_shader_kind kind;
     switch (stage) {
         case ShaderStage::eVertex: kind = shaderc_glsl_vertex_shader; break;
@@ -21,25 +36,32 @@ Shader::Shader(const std::string& filename, const std::string& code, ShaderStage
         case ShaderStage::eMiss: kind = shaderc_glsl_miss_shader; break;
         case ShaderStage::eClosestHit: kind = shaderc_glsl_closesthit_shader; break;
         case ShaderStage::eIntersection: kind = shaderc_glsl_intersection_shader; break;
+        case ShaderStage::eCompute: kind = shaderc_glsl_compute_shader; break;
+    }
+
+    // everything below that changes the output is part of the cache key
+    std::string optionsKey = settings->isEnableRayTracing ? "spirv1.6" : "spirv-default";
+    auto key = ShaderCache::key(filename, code, static_cast<uint32_t>(stage), optionsKey);
+    auto cached = ShaderCache::load(key);
+    if (!cached.empty()) {
+        return cached;
     }
 
+    std::vector<std::string> includes;
     shaderc::Compiler compiler;
     shaderc::CompileOptions options;
-    options.SetIncluder(std::make_unique<ShaderIncluder>(filename));
+    options.SetIncluder(std::make_unique<ShaderIncluder>(filename, &includes));
     if (settings->isEnableRayTracing) {
         options.SetTargetSpirv(shaderc_spirv_version_1_6);
     }
     auto result = compiler.CompileGlslToSpv(code, kind, filename.c_str(), options);
     if (result.GetCompilationStatus() != shaderc_compilation_status_success) {
         WEN_ERROR("Shader compilation failed: {}", result.GetErrorMessage());
-        return;
+        return {};
     }
-
     std::vector<uint32_t> spirv(result.cbegin(), result.cend());
-    vk::ShaderModuleCreateInfo info = {};
-    info.setCodeSize(spirv.size() * sizeof(uint32_t))
-        .setPCode(reinterpret_cast<const uint32_t*>(spirv.data()));
-    module = manager->device->device.createShaderModule(info);
+    ShaderCache::store(key, includes, spirv);
+    return spirv;
 }
 
 Shader::~Shader() {
@@ -0,0 +1,138 @@
+#include "resources/shader_cache.hpp"
+#include "resources/shader_includer.hpp"
+#include "core/setting.hpp"
+#include "core/logger.hpp"
+#include <filesystem>
+#include <atomic>
+
+namespace wen {
+
+// FNV-1a, every part is hashed with its length so that they can not run into each other
+static uint64_t hash(uint64_t seed, const void* data, size_t size) {
+    auto* bytes = static_cast<const uint8_t*>(data);
+    for (size_t i = 0; i < size; i++) {
+        seed = (seed ^ bytes[i]) * 0x100000001b3ull;
+    }
+    return seed;
+}
+
+static uint64_t hash(uint64_t seed, const std::string& str) {
+    uint64_t size = str.size();
+    return hash(hash(seed, &size, sizeof(size)), str.data(), str.size());
+}
+
+static std::string entryPath(uint64_t key, const char* extension) {
+    char name[17];
+    snprintf(name, sizeof(name), "%016llx", static_cast<unsigned long long>(key));
+    return settings->shaderCacheDir + "/" + name + extension;
+}
+
+// the key of the SPIR-V: the entry's key and what its includes contain now, nullopt if one is gone
+static std::optional<uint64_t> contentKey(uint64_t key, const std::vector<std::string>& includes) {
+    for (auto& include : includes) {
+        key = hash(key, include);
+        if (include.front() == '<') {
+            auto* header = ShaderIncluder::standardHeader(include.substr(1, include.size() - 2));
+            if (header == nullptr) {
+                return std::nullopt;
+            }
+            key = hash(key, *header);
+        } else {
+            auto file = ShaderIncluder::readInclude(include);
+            if (file == nullptr) {
+                return std::nullopt;
+            }
+            key = hash(key, *file);
+        }
+    }
+    return key;
+}
+
+// written to a temporary file first, a reader never sees half of it
+static void writeFile(const std::string& path, const void* data, size_t size) {
+    static std::atomic<uint64_t> counter = 0;
+    auto temporary = path + ".tmp" + std::to_string(counter++);
+    {
+        std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+        if (!file.is_open()) {
+            return;
+        }
+        file.write(static_cast<const char*>(data), size);
+    }
+    std::error_code ec;
+    std::filesystem::rename(temporary, path, ec);
+    if (ec) {
+        std::filesystem::remove(temporary, ec);
+    }
+}
+
+uint64_t ShaderCache::key(const std::string& filename, const std::string& code, uint32_t stage, const std::string& options) {
+    uint64_t key = 0xcbf29ce484222325ull;
+    key = hash(key, filename);
+    key = hash(key, code);
+    key = hash(key, &stage, sizeof(stage));
+    return hash(key, options);
+}
+
+std::vector<uint32_t> ShaderCache::load(uint64_t key) {
+    if (settings->shaderCacheDir.empty()) {
+        return {};
+    }
+    std::ifstream entry(entryPath(key, ".deps"));
+    if (!entry.is_open()) {
+        return {};
+    }
+    std::vector<std::string> includes;
+    std::string line;
+    while (std::getline(entry, line)) {
+        if (!line.empty()) {
+            includes.push_back(line);
+        }
+    }
+    auto spirvKey = contentKey(key, includes);
+    if (!spirvKey.has_value()) {
+        return {};
+    }
+
+    std::ifstream file(entryPath(spirvKey.value(), ".spv"), std::ios::ate | std::ios::binary);
+    if (!file.is_open()) {
+        return {};
+    }
+    size_t size = static_cast<size_t>(file.tellg());
+    if (size == 0 || size % sizeof(uint32_t) != 0) {
+        return {};
+    }
+    std::vector<uint32_t> spirv(size / sizeof(uint32_t));
+    file.seekg(0);
+    file.read(reinterpret_cast<char*>(spirv.data()), size);
+    if (!file || spirv[0] != 0x07230203) { // SPIR-V magic number
+        return {};
+    }
+    return spirv;
+}
+
+void ShaderCache::store(uint64_t key, const std::vector<std::string>& includes, const std::vector<uint32_t>& spirv) {
+    if (settings->shaderCacheDir.empty()) {
+        return;
+    }
+    auto spirvKey = contentKey(key, includes);
+    if (!spirvKey.has_value()) {
+        return;
+    }
+    std::error_code ec;
+    std::filesystem::create_directories(settings->shaderCacheDir, ec);
+    if (ec) {
+        WEN_WARN("Failed to create shader cache directory \"{}\": {}", settings->shaderCacheDir, ec.message())
+        return;
+    }
+
+    // the SPIR-V first, an entry is never written before what it points to
+    writeFile(entryPath(spirvKey.value(), ".spv"), spirv.data(), spirv.size() * sizeof(uint32_t));
+    std::string deps;
+    for (auto& include : includes) {
+        deps += include + "\n";
+    }
+    writeFile(entryPath(key, ".deps"), deps.data(), deps.size());
+}
+
+} // namespace wen
\ No newline at end of file
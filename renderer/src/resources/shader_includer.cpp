@@ -1,9 +1,11 @@
 #include "resources/shader_includer.hpp"
 #include "utils/utils.hpp"
+#include <filesystem>
+#include <mutex>
 
 namespace wen {
 
-ShaderIncluder::ShaderIncluder(const std::string& filepath) {
+ShaderIncluder::ShaderIncluder(const std::string& filepath, std::vector<std::string>* includes) : includes_(includes) {
     if (filepath.find('/') == std::string::npos) {
         filepath_ = "./";
     } else {
@@ -11,6 +13,93 @@ ShaderIncluder::ShaderIncluder(const std::string& filepath) {
     }
 }
 
+const std::string* ShaderIncluder::standardHeader(const std::string& name) {
+    static const std::map<std::string, std::string> headers = {
+        {
+            "RayTracing",
+            "#extension GL_EXT_shader_explicit_arithmetic_types_int64 : enable\n"
+            "\n"
+            "struct InstanceAddress {\n"
+            "    uint64_t vertexBufferAddress;\n"
+            "    uint64_t indexBufferAddress;\n"
+            "};\n"
+            "\n"
+            "struct Vertex {\n"
+            "    vec3 position;\n"
+            "    vec3 normal;\n"
+            "    vec3 color;\n"
+            "};\n"
+            "\n"
+            "struct Index {\n"
+            "    uint i0; \n"
+            "    uint i1; \n"
+            "    uint i2; \n"
+            "};\n"
+            "\n"
+            "struct GLTFPrimitiveData {"
+            "    uint firstIndex;\n"
+            "    uint firstVertex;\n"
+            "    uint materialIndex;\n"
+            "};\n"
+            "\n"
+            "struct GLTFMaterial {\n"
+            "    vec4 baseColorFactor;\n"
+            "    int baseColorTexture;\n"
+            "    vec3 emissiveFactor;\n"
+            "    int emissiveTexture;\n"
+            "    int normalTexture;\n"
+            "    float metallicFactor;\n"
+            "    float roughnessFactor;\n"
+            "    int metallicRoughnessTexture;\n"
+            "};\n"
+        },
+        {
+            // matches the layout of BindlessHeap, set BINDLESS_SET before the include to bind it elsewhere
+            "Bindless",
+            "#extension GL_EXT_nonuniform_qualifier : enable\n"
+            "\n"
+            "#ifndef BINDLESS_SET\n"
+            "#define BINDLESS_SET 1\n"
+            "#endif\n"
+            "\n"
+            "layout(set = BINDLESS_SET, binding = 0) uniform texture2D textures[];\n"
+            "layout(set = BINDLESS_SET, binding = 1) uniform sampler samplers[];\n"
+            "layout(set = BINDLESS_SET, binding = 2) readonly buffer BindlessWords { uint words[]; } buffers[];\n"
+            "\n"
+            "// another view of the storage buffers, e.g. BINDLESS_BUFFER(GLTFMaterial, materials);\n"
+            "// then materials[handle].data[i]\n"
+            "#define BINDLESS_BUFFER(Type, name) \\\n"
+            "    layout(set = BINDLESS_SET, binding = 2) readonly buffer name##Block { Type data[]; } name[]\n"
+            "\n"
+            "vec4 bindlessTexture(uint textureHandle, uint samplerHandle, vec2 uv) {\n"
+            "    return texture(sampler2D(textures[nonuniformEXT(textureHandle)], samplers[nonuniformEXT(samplerHandle)]), uv);\n"
+            "}\n"
+        },
+    };
+    auto it = headers.find(name);
+    return it == headers.end() ? nullptr : &it->second;
+}
+
+std::shared_ptr<const std::string> ShaderIncluder::readInclude(const std::string& path) {
+    // shared by every compilation, reread once the file has been written to
+    static std::mutex mutex;
+    static std::map<std::string, std::pair<std::filesystem::file_time_type, std::shared_ptr<const std::string>>> files;
+
+    std::error_code ec;
+    auto time = std::filesystem::last_write_time(path, ec);
+    if (ec) {
+        return nullptr;
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = files.find(path);
+    if (it == files.end() || it->second.first != time) {
+        auto data = readFile(path);
+        auto contents = std::make_shared<const std::string>(data.begin(), data.end());
+        it = files.insert_or_assign(path, std::make_pair(time, std::move(contents))).first;
+    }
+    return it->second.second;
+}
+
 shaderc_include_result* ShaderIncluder::GetInclude(
     const char* requested_source,
     shaderc_include_type type,
@@ -18,54 +107,28 @@ shaderc_include_result* ShaderIncluder::GetInclude(
     size_t include_depth
 ) {
     auto result = new shaderc_include_result();
-    std::string* contents;
+    std::string* contents = nullptr;
+    std::string name;
     if (type == shaderc_include_type_standard) {
-        if (strcmp(requested_source, "RayTracing") == 0) {
-            result->source_name = "RayTracing";
-            contents = new std::string(
-                "#extension GL_EXT_shader_explicit_arithmetic_types_int64 : enable\n"
-                "\n"
-                "struct InstanceAddress {\n"
-                "    uint64_t vertexBufferAddress;\n"
-                "    uint64_t indexBufferAddress;\n"
-                "};\n"
-                "\n"
-                "struct Vertex {\n"
-                "    vec3 position;\n"
-                "    vec3 normal;\n"
-                "    vec3 color;\n"
-                "};\n"
-                "\n"
-                "struct Index {\n"
-                "    uint i0; \n"
-                "    uint i1; \n"
-                "    uint i2; \n"
-                "};\n"
-                "\n"
-                "struct GLTFPrimitiveData {"
-                "    uint firstIndex;\n"
-                "    uint firstVertex;\n"
-                "    uint materialIndex;\n"
-                "};\n"
-                "\n"
-                "struct GLTFMaterial {\n"
-                "    vec4 baseColorFactor;\n"
-                "    int baseColorTexture;\n"
-                "    vec3 emissiveFactor;\n"
-                "    int emissiveTexture;\n"
-                "    int normalTexture;\n"
-                "    float metallicFactor;\n"
-                "    float roughnessFactor;\n"
-                "    int metallicRoughnessTexture;\n"
-                "};\n"
-            );
+        if (auto* header = standardHeader(requested_source)) {
+            name = std::string("<") + requested_source + ">";
+            contents = new std::string(*header);
         }
+    } else if (auto file = readInclude(filepath_ + requested_source)) {
+        name = filepath_ + requested_source;
+        contents = new std::string(*file);
+    }
+
+    if (contents == nullptr) {
+        // an empty source name tells shaderc the include failed, the contents are the error message
+        result->source_name = "";
+        contents = new std::string(std::string("cannot find include \"") + requested_source + "\"");
     } else {
         result->source_name = requested_source;
-        auto data = readFile(filepath_ + std::string(requested_source));
-        contents = new std::string(data.begin(), data.end());
+        if (includes_ != nullptr) {
+            includes_->push_back(name);
+        }
     }
-
     result->source_name_length = strlen(result->source_name);
     result->content = contents->c_str();
     result->content_length = contents->size();
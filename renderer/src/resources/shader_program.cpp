@@ -17,4 +17,13 @@ GraphicsShaderProgram::~GraphicsShaderProgram() {
     fragmentShader_.shader.reset();
 }
 
+void ComputeShaderProgram::setComputeShader(std::shared_ptr<Shader> shader, const std::string& entry) {
+    computeShader_.shader = std::dynamic_pointer_cast<Shader>(shader);
+    computeShader_.entry = entry;
+}
+
+ComputeShaderProgram::~ComputeShaderProgram() {
+    computeShader_.shader.reset();
+}
+
 } // namespace wen
\ No newline at end of file
@@ -0,0 +1,104 @@
+#include "resources/upload_buffer.hpp"
+#include "core/logger.hpp"
+#include "manager.hpp"
+
+namespace wen {
+
+// writes are compared in blocks of this size, a run of changed blocks is uploaded as one range
+static constexpr uint64_t blockSize = 256;
+
+UploadBuffer::UploadBuffer(uint64_t size, vk::BufferUsageFlags usage, bool hostCopy) {
+    // VMA picks device-local memory the host can write to when there is some, device-local memory to copy to otherwise
+    buffer_ = std::make_unique<Buffer>(
+        size,
+        usage | vk::BufferUsageFlagBits::eTransferDst,
+        VMA_MEMORY_USAGE_AUTO_PREFER_DEVICE,
+        VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT | VMA_ALLOCATION_CREATE_HOST_ACCESS_ALLOW_TRANSFER_INSTEAD_BIT
+    );
+    direct_ = static_cast<bool>(buffer_->memoryProperties() & vk::MemoryPropertyFlagBits::eHostVisible);
+    if (direct_) {
+        buffer_->map();
+    }
+
+    // the device starts out matching the zeroed host copy
+    if (hostCopy) {
+        shadow_.resize(size, 0);
+        if (direct_) {
+            memset(buffer_->data, 0, size);
+            buffer_->flush(0, size);
+        } else {
+            manager->uploadManager->transferCommands().fillBuffer(buffer_->buffer, 0, VK_WHOLE_SIZE, 0);
+            staged_ = manager->uploadManager->recordedValue();
+        }
+    }
+}
+
+UploadBuffer::~UploadBuffer() {
+    manager->uploadManager->retire(std::shared_ptr<Buffer>(std::move(buffer_)));
+}
+
+void* UploadBuffer::map() {
+    WEN_ASSERT(!shadow_.empty(), "Upload buffer has no host copy to map")
+    return shadow_.data();
+}
+
+void UploadBuffer::invalidate(uint64_t offset, uint64_t size) {
+    uint64_t begin = offset, end = offset + size;
+    auto it = dirty_.upper_bound(begin);
+    if (it != dirty_.begin() && std::prev(it)->second >= begin) {
+        it = std::prev(it);
+    }
+    while (it != dirty_.end() && it->first <= end) {
+        begin = std::min(begin, it->first);
+        end = std::max(end, it->second);
+        it = dirty_.erase(it);
+    }
+    dirty_[begin] = end;
+}
+
+void UploadBuffer::flush() {
+    if (dirty_.empty()) {
+        dirty_[0] = shadow_.size();
+    }
+    for (auto [begin, end] : dirty_) {
+        write(begin, shadow_.data() + begin, end - begin);
+    }
+    dirty_.clear();
+}
+
+void UploadBuffer::unmap() {}
+
+void UploadBuffer::upload(const void* data, uint64_t offset, uint64_t size) {
+    WEN_ASSERT(offset + size <= buffer_->size, "Upload out of the buffer range")
+    if (shadow_.empty()) {
+        write(offset, data, size);
+        return;
+    }
+
+    auto* src = static_cast<const uint8_t*>(data);
+    auto* dst = shadow_.data() + offset;
+    for (uint64_t i = 0; i < size; i += blockSize) {
+        uint64_t length = std::min(blockSize, size - i);
+        if (memcmp(dst + i, src + i, length) != 0) {
+            memcpy(dst + i, src + i, length);
+            invalidate(offset + i, length);
+        }
+    }
+    if (!dirty_.empty()) {
+        flush();
+    }
+}
+
+void UploadBuffer::write(uint64_t offset, const void* data, uint64_t size) {
+    auto& uploads = *manager->uploadManager;
+    // a staged copy still pending would land after a direct write and undo it
+    if (direct_ && uploads.finished(staged_)) {
+        memcpy(static_cast<uint8_t*>(buffer_->data) + offset, data, size);
+        buffer_->flush(offset, size);
+        return;
+    }
+    uploads.upload(*buffer_, offset, data, size);
+    staged_ = uploads.recordedValue();
+}
+
+} // namespace wen
\ No newline at end of file
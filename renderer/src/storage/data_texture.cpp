@@ -5,9 +5,9 @@
 
 namespace wen {
 
-static void copyBufferToImage(vk::Buffer buffer, vk::Image image, uint32_t width, uint32_t height) {
+static void copyBufferToImage(vk::CommandBuffer cmdbuf, vk::Buffer buffer, vk::DeviceSize offset, vk::Image image, uint32_t width, uint32_t height) {
     vk::BufferImageCopy copy = {};
-    copy.setBufferOffset(0)
+    copy.setBufferOffset(offset)
         .setBufferRowLength(0)
         .setBufferImageHeight(0)
         .setImageSubresource({
@@ -19,14 +19,12 @@ static void copyBufferToImage(vk::Buffer buffer, vk::Image image, uint32_t width
         .setImageOffset({0, 0, 0})
         .setImageExtent({width, height, 1});
 
-    auto cmdbuf = manager->commandPool->allocateSingleUse();
     cmdbuf.copyBufferToImage(
         buffer,
         image,
         vk::ImageLayout::eTransferDstOptimal,
         {copy}
     );
-    manager->commandPool->freeSingleUse(cmdbuf);
 }
 
 static void generateMipmaps(vk::Image image, vk::Format format, uint32_t width, uint32_t height, uint32_t mipLevels) {
@@ -36,7 +34,8 @@ static void generateMipmaps(vk::Image image, vk::Format format, uint32_t width,
         return;
     }
 
-    auto cmdbuf = manager->commandPool->allocateSingleUse();
+    // blits need the graphics queue, they run once the copy was handed over to it
+    auto cmdbuf = manager->uploadManager->graphicsCommands();
     vk::ImageMemoryBarrier barrier = {};
     barrier.setImage(image)
            .setSrcQueueFamilyIndex(vk::QueueFamilyIgnored)
@@ -121,19 +120,13 @@ static void generateMipmaps(vk::Image image, vk::Format format, uint32_t width,
         {},
         {barrier}
     );
-    manager->commandPool->freeSingleUse(cmdbuf);
 }
 
 DataTexture::DataTexture(const uint8_t* data, uint32_t width, uint32_t height, uint32_t mipLevels) {
     uint32_t size = width * height * 4;
-    Buffer stagingBuffer(
-        size,
-        vk::BufferUsageFlagBits::eTransferSrc,
-        VMA_MEMORY_USAGE_CPU_TO_GPU,
-        VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT | VMA_ALLOCATION_CREATE_HOST_ACCESS_ALLOW_TRANSFER_INSTEAD_BIT
-    );
-    memcpy(stagingBuffer.map(), data, size);
-    stagingBuffer.unmap();
+    auto& uploads = manager->uploadManager;
+    auto staging = uploads->stage(size);
+    memcpy(staging.data, data, size);
 
     if (mipLevels == 0) {
         mipLevels = static_cast<uint32_t>(std::floor(std::log2(std::max(width, height))) + 1);
@@ -150,24 +143,33 @@ DataTexture::DataTexture(const uint8_t* data, uint32_t width, uint32_t height, u
         mipLevels
     );
 
-    transitionImageLayout(
-        image_->image,
-        vk::ImageAspectFlagBits::eColor,
-        mipLevels,
-        {
-            vk::ImageLayout::eUndefined,
-            vk::AccessFlagBits::eNone,
-            vk::PipelineStageFlagBits::eTopOfPipe
-        },
-        {
-            vk::ImageLayout::eTransferDstOptimal,
-            vk::AccessFlagBits::eTransferWrite,
-            vk::PipelineStageFlagBits::eTransfer
-        }
+    vk::ImageSubresourceRange range = {vk::ImageAspectFlagBits::eColor, 0, mipLevels, 0, 1};
+    vk::ImageMemoryBarrier barrier = {};
+    barrier.setOldLayout(vk::ImageLayout::eUndefined)
+           .setSrcAccessMask(vk::AccessFlagBits::eNone)
+           .setNewLayout(vk::ImageLayout::eTransferDstOptimal)
+           .setDstAccessMask(vk::AccessFlagBits::eTransferWrite)
+           .setImage(image_->image)
+           .setSubresourceRange(range)
+           .setSrcQueueFamilyIndex(vk::QueueFamilyIgnored)
+           .setDstQueueFamilyIndex(vk::QueueFamilyIgnored);
+    auto cmdbuf = uploads->transferCommands();
+    cmdbuf.pipelineBarrier(
+        vk::PipelineStageFlagBits::eTopOfPipe,
+        vk::PipelineStageFlagBits::eTransfer,
+        vk::DependencyFlagBits::eByRegion,
+        {},
+        {},
+        {barrier}
     );
+    copyBufferToImage(cmdbuf, staging.buffer, staging.offset, image_->image, width, height);
 
-    copyBufferToImage(stagingBuffer.buffer, image_->image, width, height);
-    generateMipmaps(image_->image, vk::Format::eR8G8B8A8Srgb, width, height, mipLevels);
+    if (mipLevels == 1) {
+        uploads->release(image_->image, range, vk::ImageLayout::eTransferDstOptimal, vk::ImageLayout::eShaderReadOnlyOptimal);
+    } else {
+        uploads->release(image_->image, range, vk::ImageLayout::eTransferDstOptimal, vk::ImageLayout::eTransferDstOptimal);
+        generateMipmaps(image_->image, vk::Format::eR8G8B8A8Srgb, width, height, mipLevels);
+    }
 
     imageView_ = createImageView(image_->image, vk::Format::eR8G8B8A8Srgb, vk::ImageAspectFlagBits::eColor, mipLevels);
 }
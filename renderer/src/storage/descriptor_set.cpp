@@ -29,18 +29,49 @@ DescriptorSet& DescriptorSet::addDescriptors(const std::vector<DescriptorInfo>&
     return *this;
 }
 
+DescriptorSet& DescriptorSet::setUpdateAfterBind(vk::DescriptorPool pool) {
+    updateAfterBindPool_ = pool;
+    return *this;
+}
+
 void DescriptorSet::createDescriptorSetLayout() {
     vk::DescriptorSetLayoutCreateInfo createInfo = {};
     createInfo.setBindings(layoutBindings_);
+    std::vector<vk::DescriptorBindingFlags> flags(
+        layoutBindings_.size(),
+        vk::DescriptorBindingFlagBits::ePartiallyBound |
+            vk::DescriptorBindingFlagBits::eUpdateAfterBind |
+            vk::DescriptorBindingFlagBits::eUpdateUnusedWhilePending
+    );
+    vk::DescriptorSetLayoutBindingFlagsCreateInfo bindingFlags = {};
+    bindingFlags.setBindingFlags(flags);
+    if (updateAfterBindPool_.has_value()) {
+        createInfo.setFlags(vk::DescriptorSetLayoutCreateFlagBits::eUpdateAfterBindPool)
+                  .setPNext(&bindingFlags);
+    }
     descriptorLayout_ = manager->device->device.createDescriptorSetLayout(createInfo);
 }
 
 void DescriptorSet::allocateDescriptorSets() {
-    descriptorSets_ = manager->descriptorPool->allocateDescriptorSets(descriptorLayout_);
+    if (!updateAfterBindPool_.has_value()) {
+        descriptorSets_ = manager->descriptorPool->allocateDescriptorSets(descriptorLayout_);
+        return;
+    }
+    std::vector<vk::DescriptorSetLayout> layouts(settings->maxFramesInFlight, descriptorLayout_);
+    vk::DescriptorSetAllocateInfo allocateInfo = {};
+    allocateInfo.setDescriptorPool(updateAfterBindPool_.value())
+                .setSetLayouts(layouts);
+    descriptorSets_ = manager->device->device.allocateDescriptorSets(allocateInfo);
 }
 
 void DescriptorSet::freeDescriptorSets() {
-    manager->descriptorPool->freeDescriptorSets(descriptorSets_);
+    if (descriptorSets_.empty()) {
+        return;
+    }
+    // sets of an update-after-bind pool go with it
+    if (!updateAfterBindPool_.has_value()) {
+        manager->descriptorPool->freeDescriptorSets(descriptorSets_);
+    }
     descriptorSets_.clear();
 }
 
@@ -65,11 +96,27 @@ const vk::DescriptorSetLayoutBinding& DescriptorSet::getLayoutBinding(uint32_t b
 
 void DescriptorSet::bindUniforms(uint32_t binding, const std::vector<std::shared_ptr<UniformBuffer>>& uniforms) {
     auto layoutBinding = getLayoutBinding(binding);
+    if (layoutBinding.descriptorType == vk::DescriptorType::eUniformBufferDynamic) {
+        assert(uniforms.size() == 1);
+        if (!uniforms[0]->isInFlight()) {
+            WEN_ERROR("binding {} is dynamic, the uniform buffer must be in flight!", binding);
+            return;
+        }
+        bindFrameAllocator(binding, uniforms[0]->getSize());
+        frameUniforms_[binding] = uniforms[0];
+        return;
+    }
     if (layoutBinding.descriptorType != vk::DescriptorType::eUniformBuffer) {
         WEN_ERROR("binding {} is not uniform buffer!", binding);
         return;
     }
     assert(layoutBinding.descriptorCount == uniforms.size());
+    for (const auto& uniform : uniforms) {
+        if (uniform->isInFlight()) {
+            WEN_ERROR("binding {} is not dynamic, an in flight uniform buffer needs eDynamicUniform!", binding);
+            return;
+        }
+    }
     for (uint32_t i = 0; i < settings->maxFramesInFlight; i++) {
         std::vector<vk::DescriptorBufferInfo> infos(layoutBinding.descriptorCount);
         for (uint32_t j = 0; j < layoutBinding.descriptorCount; j++) {
@@ -232,4 +279,44 @@ void DescriptorSet::bindAccelerationStructure(uint32_t binding, std::shared_ptr<
     bindAccelerationStructures(binding, {instance});
 }
 
+void DescriptorSet::bindFrameAllocator(uint32_t binding, uint64_t range) {
+    auto layoutBinding = getLayoutBinding(binding);
+    if ((layoutBinding.descriptorType != vk::DescriptorType::eUniformBufferDynamic) &&
+        (layoutBinding.descriptorType != vk::DescriptorType::eStorageBufferDynamic)) {
+        WEN_ERROR("binding {} is not a dynamic buffer descriptor!", binding);
+        return;
+    }
+    assert(layoutBinding.descriptorCount == 1);
+    for (uint32_t i = 0; i < settings->maxFramesInFlight; i++) {
+        vk::DescriptorBufferInfo info = {};
+        info.setBuffer(manager->frameAllocator->getBuffer())
+            .setOffset(0)
+            .setRange(range);
+        vk::WriteDescriptorSet write = {};
+        write.setDstSet(descriptorSets_[i])
+             .setDstBinding(layoutBinding.binding)
+             .setDstArrayElement(0)
+             .setDescriptorType(layoutBinding.descriptorType)
+             .setBufferInfo(info);
+        manager->device->device.updateDescriptorSets({write}, {});
+    }
+    dynamicOffsets_[binding] = 0;
+    frameUniforms_.erase(binding);
+}
+
+void DescriptorSet::setDynamicOffset(uint32_t binding, uint32_t offset) {
+    dynamicOffsets_[binding] = offset;
+}
+
+void DescriptorSet::appendDynamicOffsets(std::vector<uint32_t>& offsets) {
+    for (auto& [binding, uniform] : frameUniforms_) {
+        auto allocation = manager->frameAllocator->allocate(uniform->getSize());
+        memcpy(allocation.data, uniform->getData(), uniform->getSize());
+        dynamicOffsets_[binding] = allocation.offset;
+    }
+    for (auto [binding, offset] : dynamicOffsets_) {
+        offsets.push_back(offset);
+    }
+}
+
 } // namespace wen
\ No newline at end of file
@@ -17,7 +17,8 @@ KtxTexture::KtxTexture(const std::string& filename) {
         &deviceInfo,
         manager->device->physicalDevice,
         manager->device->device,
-        manager->device->transferQueue,
+        // the command pool belongs to the graphics family, which the transfer queue may not be of
+        manager->device->graphicsQueue,
         manager->commandPool->commandPool_,
         nullptr
     );
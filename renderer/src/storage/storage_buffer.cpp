@@ -8,17 +8,19 @@ StorageBuffer::StorageBuffer(uint64_t size, vk::BufferUsageFlags usage, VmaMemor
 }
 
 void* StorageBuffer::map() {
+    if (pending_.valid()) {
+        pending_.wait();
+    }
     return buffer_->map();
 }
 
-void StorageBuffer::flush(vk::DeviceSize size, const vk::Buffer& buffer) {
-    auto cmdbuf = manager->commandPool->allocateSingleUse();
+void StorageBuffer::flush(vk::DeviceSize size, const Buffer& buffer) {
     vk::BufferCopy regions = {};
     regions.setSize(size)
            .setSrcOffset(0)
            .setDstOffset(0);
-    cmdbuf.copyBuffer(buffer_->buffer, buffer, regions);
-    manager->commandPool->freeSingleUse(cmdbuf);
+    manager->uploadManager->copy(buffer_->buffer, buffer, regions);
+    pending_ = manager->uploadManager->pending();
 }
 
 void StorageBuffer::unmap() {
@@ -26,7 +28,8 @@ void StorageBuffer::unmap() {
 }
 
 StorageBuffer::~StorageBuffer() {
-    buffer_.reset();
+    // a copy from it may still be in flight
+    manager->uploadManager->retire(std::shared_ptr<Buffer>(std::move(buffer_)));
 }
 
 } // namespace wen
\ No newline at end of file
@@ -1,26 +1,33 @@
 #include "storage/uniform_buffer.hpp"
+#include "manager.hpp"
 
 namespace wen {
 
 UniformBuffer::UniformBuffer(uint64_t size, bool inFlight) {
     size_ = size;
-    for (uint32_t i = 0; i < (inFlight ? settings->maxFramesInFlight : 1); i++) {
-        buffers_.emplace_back(
-            size,
-            vk::BufferUsageFlagBits::eUniformBuffer,
-            VMA_MEMORY_USAGE_AUTO_PREFER_HOST,
-            VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT
-        );
-        buffers_.back().map();
+    if (inFlight) {
+        data_.resize(size);
+        return;
     }
+    buffer_ = std::make_unique<Buffer>(
+        size,
+        vk::BufferUsageFlagBits::eUniformBuffer,
+        VMA_MEMORY_USAGE_AUTO_PREFER_HOST,
+        VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT
+    );
+    buffer_->map();
 }
 
 UniformBuffer::~UniformBuffer() {
-    buffers_.clear();
+    buffer_.reset();
 }
 
-Buffer& UniformBuffer::buffer(uint32_t inFlight) {
-    return buffers_[inFlight % buffers_.size()];
+vk::Buffer UniformBuffer::getBuffer(uint32_t inFlight) {
+    return buffer_ ? buffer_->buffer : manager->frameAllocator->getBuffer();
+}
+
+void* UniformBuffer::getData() {
+    return buffer_ ? buffer_->data : data_.data();
 }
 
 } // namespace wen
\ No newline at end of file
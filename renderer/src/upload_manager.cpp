@@ -0,0 +1,345 @@
+#include "upload_manager.hpp"
+#include "core/logger.hpp"
+#include "manager.hpp"
+
+namespace wen {
+
+// staging memory is handed out in chunks of this size, larger requests get a chunk of their own
+static constexpr vk::DeviceSize chunkSize = 16 * 1024 * 1024;
+static constexpr size_t maxFreeChunks = 8;
+// a batch staging more than this is submitted before it grows further, loading a large scene
+// doesn't hold all of it in staging memory at once
+static constexpr vk::DeviceSize batchLimit = 256 * 1024 * 1024;
+
+UploadManager::UploadManager() {
+    auto& device = manager->device;
+    transferPool_ = std::make_unique<CommandPool>(vk::CommandPoolCreateFlagBits::eResetCommandBuffer, device->transferQueueFamilyIndex);
+    graphicsPool_ = std::make_unique<CommandPool>(vk::CommandPoolCreateFlagBits::eResetCommandBuffer, device->graphicsQueueFamilyIndex);
+
+    vk::SemaphoreTypeCreateInfo type = {};
+    type.setSemaphoreType(vk::SemaphoreType::eTimeline)
+        .setInitialValue(0);
+    vk::SemaphoreCreateInfo info = {};
+    info.setPNext(&type);
+    timeline_ = device->device.createSemaphore(info);
+    frames_ = device->device.createSemaphore(info);
+
+    std::promise<void> ready;
+    ready_ = ready.get_future().share();
+    ready.set_value();
+
+    thread_ = std::thread(&UploadManager::complete, this);
+}
+
+UploadManager::~UploadManager() {
+    flush();
+    std::array<vk::Semaphore, 2> semaphores = {timeline_, frames_};
+    std::array<uint64_t, 2> values = {value_, frameValue_};
+    vk::SemaphoreWaitInfo wait = {};
+    wait.setSemaphores(semaphores)
+        .setValues(values);
+    WEN_ASSERT(
+        manager->device->device.waitSemaphores(wait, std::numeric_limits<uint64_t>::max()) == vk::Result::eSuccess,
+        "Failed to wait for uploads"
+    )
+    collect();
+    // what the last batch kept or had retired goes now, the GPU is done with all of it
+    open_ = Batch();
+    retired_.clear();
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    condition_.notify_one();
+    thread_.join();
+
+    freeChunks_.clear();
+    freeTransfer_.clear();
+    freeGraphics_.clear();
+    transferPool_.reset();
+    graphicsPool_.reset();
+    manager->device->device.destroySemaphore(timeline_);
+    manager->device->device.destroySemaphore(frames_);
+}
+
+UploadManager::Staging UploadManager::stage(vk::DeviceSize size, vk::DeviceSize alignment) {
+    if (open_.staged + size > batchLimit && open_.staged > 0) {
+        flush();
+    }
+
+    vk::DeviceSize offset = (open_.used + alignment - 1) / alignment * alignment;
+    if (open_.chunks.empty() || offset + size > open_.chunks.back()->size) {
+        open_.chunks.push_back(chunk(size));
+        offset = 0;
+    }
+    open_.used = offset + size;
+    open_.staged += size;
+
+    auto& chunk = *open_.chunks.back();
+    return {chunk.buffer, offset, static_cast<uint8_t*>(chunk.map()) + offset};
+}
+
+void UploadManager::upload(const Buffer& buffer, vk::DeviceSize offset, const void* data, vk::DeviceSize size) {
+    if (size == 0) {
+        return;
+    }
+    auto staging = stage(size);
+    memcpy(staging.data, data, size);
+    vk::BufferCopy region = {};
+    region.setSrcOffset(staging.offset)
+          .setDstOffset(offset)
+          .setSize(size);
+    copy(staging.buffer, buffer, region);
+}
+
+void UploadManager::copy(vk::Buffer src, const Buffer& dst, const vk::BufferCopy& region) {
+    transferCommands().copyBuffer(src, dst.buffer, region);
+}
+
+vk::CommandBuffer UploadManager::transferCommands() {
+    if (!open_.transfer) {
+        open_.transfer = begin(*transferPool_, freeTransfer_);
+    }
+    return open_.transfer;
+}
+
+vk::CommandBuffer UploadManager::graphicsCommands() {
+    if (!open_.graphics) {
+        open_.graphics = begin(*graphicsPool_, freeGraphics_);
+    }
+    return open_.graphics;
+}
+
+void UploadManager::release(vk::Image image, const vk::ImageSubresourceRange& range, vk::ImageLayout oldLayout, vk::ImageLayout newLayout) {
+    open_.images.emplace_back()
+        .setImage(image)
+        .setSubresourceRange(range)
+        .setOldLayout(oldLayout)
+        .setNewLayout(newLayout);
+}
+
+void UploadManager::keep(std::shared_ptr<void> resource) {
+    open_.resources.push_back(std::move(resource));
+}
+
+void UploadManager::retire(std::shared_ptr<void> resource) {
+    retired_.push_back({recordedValue(), frameValue_, std::move(resource)});
+    prune();
+}
+
+uint64_t UploadManager::recordedValue() const {
+    // flush() signals the value of a batch two past the last one
+    bool recorded = open_.transfer || open_.graphics || !open_.images.empty();
+    return recorded ? value_ + 2 : value_;
+}
+
+bool UploadManager::finished(uint64_t value) const {
+    auto& device = manager->device->device;
+    return device.getSemaphoreCounterValue(timeline_) >= value && device.getSemaphoreCounterValue(frames_) >= frameValue_;
+}
+
+std::shared_future<void> UploadManager::flush() {
+    collect();
+    if (!open_.transfer && !open_.graphics && open_.images.empty()) {
+        return ready_;
+    }
+
+    Batch batch = std::move(open_);
+    open_ = Batch();
+    auto& device = manager->device;
+    uint32_t transferFamily = device->transferQueueFamilyIndex;
+    uint32_t graphicsFamily = device->graphicsQueueFamilyIndex;
+    bool ownership = transferFamily != graphicsFamily;
+
+    // a release on the transfer queue and a matching acquire on the graphics queue, one family only
+    // needs the layout transition. Buffers are concurrent and need neither
+    for (auto& image : batch.images) {
+        image.setSrcAccessMask(vk::AccessFlagBits::eTransferWrite)
+             .setSrcQueueFamilyIndex(ownership ? transferFamily : vk::QueueFamilyIgnored)
+             .setDstQueueFamilyIndex(ownership ? graphicsFamily : vk::QueueFamilyIgnored);
+    }
+    if (ownership && !batch.images.empty()) {
+        if (!batch.transfer) {
+            batch.transfer = begin(*transferPool_, freeTransfer_);
+        }
+        batch.transfer.pipelineBarrier(
+            vk::PipelineStageFlagBits::eTransfer,
+            vk::PipelineStageFlagBits::eBottomOfPipe,
+            {},
+            {},
+            {},
+            batch.images
+        );
+    }
+
+    // the global barrier also orders the graphics submissions before and after the batch around it
+    vk::MemoryBarrier memory = {};
+    memory.setSrcAccessMask(vk::AccessFlagBits::eMemoryWrite)
+          .setDstAccessMask(vk::AccessFlagBits::eMemoryRead | vk::AccessFlagBits::eMemoryWrite);
+    for (auto& image : batch.images) {
+        image.setSrcAccessMask(ownership ? vk::AccessFlags{} : vk::AccessFlags{vk::AccessFlagBits::eTransferWrite})
+             .setDstAccessMask(vk::AccessFlagBits::eMemoryRead | vk::AccessFlagBits::eMemoryWrite);
+    }
+    batch.acquire = begin(*graphicsPool_, freeGraphics_);
+    batch.acquire.pipelineBarrier(
+        vk::PipelineStageFlagBits::eAllCommands,
+        vk::PipelineStageFlagBits::eAllCommands,
+        {},
+        memory,
+        {},
+        batch.images
+    );
+    batch.acquire.end();
+
+    std::vector<vk::CommandBuffer> graphics = {batch.acquire};
+    if (batch.graphics) {
+        batch.graphics.pipelineBarrier(
+            vk::PipelineStageFlagBits::eAllCommands,
+            vk::PipelineStageFlagBits::eAllCommands,
+            {},
+            memory,
+            {},
+            {}
+        );
+        batch.graphics.end();
+        graphics.push_back(batch.graphics);
+    }
+
+    // the copies wait for the previous batch and for the frames submitted so far, either may still read
+    // what they overwrite. Which frames read which destination isn't tracked, the last one covers all
+    uint64_t previousValue = value_;
+    uint64_t transferValue = ++value_;
+    std::array<vk::Semaphore, 2> transferWaits = {timeline_, frames_};
+    std::array<uint64_t, 2> transferWaitValues = {previousValue, frameValue_};
+    std::array<vk::PipelineStageFlags, 2> transferStages = {vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eTransfer};
+    vk::TimelineSemaphoreSubmitInfo transferTimeline = {};
+    transferTimeline.setWaitSemaphoreValues(transferWaitValues)
+                    .setSignalSemaphoreValues(transferValue);
+    vk::SubmitInfo transferSubmit = {};
+    transferSubmit.setWaitSemaphores(transferWaits)
+                  .setWaitDstStageMask(transferStages)
+                  .setSignalSemaphores(timeline_)
+                  .setPNext(&transferTimeline);
+    if (batch.transfer) {
+        batch.transfer.end();
+        transferSubmit.setCommandBuffers(batch.transfer);
+    }
+    std::unique_lock<std::mutex> lock(device->queueMutex);
+    device->transferQueue.submit(transferSubmit, nullptr);
+
+    batch.value = ++value_;
+    vk::PipelineStageFlags waitStage = vk::PipelineStageFlagBits::eAllCommands;
+    vk::TimelineSemaphoreSubmitInfo graphicsTimeline = {};
+    graphicsTimeline.setWaitSemaphoreValues(transferValue)
+                    .setSignalSemaphoreValues(batch.value);
+    vk::SubmitInfo graphicsSubmit = {};
+    graphicsSubmit.setWaitSemaphores(timeline_)
+                  .setWaitDstStageMask(waitStage)
+                  .setCommandBuffers(graphics)
+                  .setSignalSemaphores(timeline_)
+                  .setPNext(&graphicsTimeline);
+    device->graphicsQueue.submit(graphicsSubmit, nullptr);
+    lock.unlock();
+
+    auto future = batch.future;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        waiting_.emplace_back(batch.value, std::move(batch.promise));
+    }
+    condition_.notify_one();
+    inFlight_.push_back(std::move(batch));
+    return future;
+}
+
+vk::CommandBuffer UploadManager::begin(CommandPool& pool, std::vector<vk::CommandBuffer>& free) {
+    vk::CommandBuffer cmdbuf;
+    if (free.empty()) {
+        cmdbuf = pool.allocateCommandBuffers(1)[0];
+    } else {
+        cmdbuf = free.back();
+        free.pop_back();
+        cmdbuf.reset();
+    }
+    vk::CommandBufferBeginInfo beginInfo = {};
+    beginInfo.setFlags(vk::CommandBufferUsageFlagBits::eOneTimeSubmit);
+    cmdbuf.begin(beginInfo);
+    return cmdbuf;
+}
+
+std::unique_ptr<Buffer> UploadManager::chunk(vk::DeviceSize size) {
+    if (size <= chunkSize && !freeChunks_.empty()) {
+        auto chunk = std::move(freeChunks_.back());
+        freeChunks_.pop_back();
+        return chunk;
+    }
+    if (size <= chunkSize) {
+        collect();
+        if (!freeChunks_.empty()) {
+            return chunk(size);
+        }
+    }
+    return std::make_unique<Buffer>(
+        std::max(size, chunkSize),
+        vk::BufferUsageFlagBits::eTransferSrc,
+        VMA_MEMORY_USAGE_CPU_TO_GPU,
+        VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT
+    );
+}
+
+void UploadManager::collect() {
+    prune();
+    uint64_t done = manager->device->device.getSemaphoreCounterValue(timeline_);
+    while (!inFlight_.empty() && inFlight_.front().value <= done) {
+        auto& batch = inFlight_.front();
+        if (batch.transfer) {
+            freeTransfer_.push_back(batch.transfer);
+        }
+        freeGraphics_.push_back(batch.acquire);
+        if (batch.graphics) {
+            freeGraphics_.push_back(batch.graphics);
+        }
+        for (auto& chunk : batch.chunks) {
+            if (chunk->size == chunkSize && freeChunks_.size() < maxFreeChunks) {
+                freeChunks_.push_back(std::move(chunk));
+            }
+        }
+        inFlight_.pop_front();
+    }
+}
+
+void UploadManager::prune() {
+    uint64_t done = manager->device->device.getSemaphoreCounterValue(timeline_);
+    uint64_t framesDone = manager->device->device.getSemaphoreCounterValue(frames_);
+    while (!retired_.empty() && retired_.front().value <= done && retired_.front().frameValue <= framesDone) {
+        // destroyed after it left the list, a resource may retire others on the way
+        auto resource = std::move(retired_.front().resource);
+        retired_.pop_front();
+    }
+}
+
+void UploadManager::complete() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+        condition_.wait(lock, [this]() { return stop_ || !waiting_.empty(); });
+        if (waiting_.empty()) {
+            return;
+        }
+        auto [value, promise] = std::move(waiting_.front());
+        waiting_.pop_front();
+        lock.unlock();
+
+        vk::SemaphoreWaitInfo wait = {};
+        wait.setSemaphores(timeline_)
+            .setValues(value);
+        WEN_ASSERT(
+            manager->device->device.waitSemaphores(wait, std::numeric_limits<uint64_t>::max()) == vk::Result::eSuccess,
+            "Failed to wait for uploads"
+        )
+        promise.set_value();
+
+        lock.lock();
+    }
+}
+
+} // namespace wen
\ No newline at end of file
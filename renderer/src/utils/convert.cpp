@@ -181,6 +181,10 @@ vk::DescriptorType convert<vk::DescriptorType>(DescriptorType type) {
         case DescriptorType::eStorageBuffer: return vk::DescriptorType::eStorageBuffer;
         case DescriptorType::eStorageImage: return vk::DescriptorType::eStorageImage;
         case DescriptorType::eAccelerationStructure: return vk::DescriptorType::eAccelerationStructureKHR;
+        case DescriptorType::eDynamicUniform: return vk::DescriptorType::eUniformBufferDynamic;
+        case DescriptorType::eDynamicStorageBuffer: return vk::DescriptorType::eStorageBufferDynamic;
+        case DescriptorType::eSampledImage: return vk::DescriptorType::eSampledImage;
+        case DescriptorType::eSampler: return vk::DescriptorType::eSampler;
     }
 }
 
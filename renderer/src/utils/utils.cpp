@@ -76,8 +76,8 @@ void transitionImageLayout(vk::Image image, vk::ImageAspectFlagBits aspect, uint
            .setSrcQueueFamilyIndex(vk::QueueFamilyIgnored)
            .setDstQueueFamilyIndex(vk::QueueFamilyIgnored);
 
-    auto cmdbuf = manager->commandPool->allocateSingleUse();
-    cmdbuf.pipelineBarrier(
+    // recorded into the upload batch, which runs ahead of the next frame
+    manager->uploadManager->graphicsCommands().pipelineBarrier(
         src.stage,
         dst.stage,
         vk::DependencyFlagBits::eByRegion,
@@ -85,7 +85,6 @@ void transitionImageLayout(vk::Image image, vk::ImageAspectFlagBits aspect, uint
         {},
         {barrier}
     );
-    manager->commandPool->freeSingleUse(cmdbuf);
 }
 
 vk::Format findSupportedFormat(const std::vector<vk::Format>& candidates, vk::ImageTiling tiling, vk::FormatFeatureFlags features) {
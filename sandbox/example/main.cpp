@@ -110,7 +110,7 @@ int main() {
 
         auto descriptorSet = interface->createDescriptorSet();
         descriptorSet->addDescriptors({
-            {0, wen::DescriptorType::eUniform, wen::ShaderStage::eVertex}, // camera
+            {0, wen::DescriptorType::eDynamicUniform, wen::ShaderStage::eVertex}, // camera
             {1, wen::DescriptorType::eTexture, wen::ShaderStage::eFragment} // texture
         }).build();
 
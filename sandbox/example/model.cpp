@@ -68,7 +68,7 @@ int main() {
 
         auto descriptorSet = interface->createDescriptorSet();
         descriptorSet->addDescriptors({
-            {0, wen::DescriptorType::eUniform, wen::ShaderStage::eVertex}, // camera
+            {0, wen::DescriptorType::eDynamicUniform, wen::ShaderStage::eVertex}, // camera
         }).build();
 
         auto renderPipeline = interface->createGraphicsRenderPipeline(renderer, shaderProgram, "main subpass");
@@ -15,9 +15,9 @@ public:
     Application();
     ~Application();
 
-    template<typename T>
-    void pushLayer() {
-        layers_.emplace_back(std::make_shared<T>());
+    template<typename T, typename... Args>
+    void pushLayer(Args&&... args) {
+        layers_.emplace_back(std::make_shared<T>(std::forward<Args>(args)...));
     }
 
     void init();
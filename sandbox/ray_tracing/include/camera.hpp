@@ -8,6 +8,7 @@ public:
 
     bool update(float ts);
     void resize(uint32_t width, uint32_t height);
+    void set(const glm::vec3& position, const glm::vec3& direction);
 
     glm::mat4 view{1.0f};
     glm::mat4 projection{1.0f};
@@ -0,0 +1,166 @@
+#pragma once
+
+#include "hittable/flat_bvh.hpp"
+
+class Material;
+class Texture;
+class PDF;
+
+// The scene graph authored through Hittable/Material/Texture compiled into type-sorted arrays
+// addressed by integer handles. Intersection and shading dispatch with a switch over the type
+// tag into templated kernels, types the compiler does not know fall back to their virtuals.
+
+enum class PrimitiveType : uint32_t { Sphere, Quad, Instance, Medium, Virtual };
+enum class MaterialType : uint32_t { Lambertian, Metal, Dielectric, DiffuseLight, Isotropic, Conductor, RoughDielectric, Virtual };
+enum class TextureType : uint32_t { Solid, Chessboard, Image, Noise, Virtual };
+enum class Lobe : uint32_t { None, Cosine, Sphere, Microfacet, Virtual };
+
+constexpr uint32_t invalidHandle = UINT32_MAX;
+
+struct PrimitiveRef {
+    PrimitiveType type;
+    uint32_t index;
+};
+
+struct CompiledSphere {
+    glm::vec3 center;
+    float radius;
+    glm::vec3 velocity; // zero for static spheres
+    uint32_t material;
+};
+
+struct CompiledQuad {
+    glm::vec3 Q;
+    float D;
+    glm::vec3 u;
+    float area;
+    glm::vec3 v;
+    uint32_t material;
+    glm::vec3 normal;
+    glm::vec3 w;
+};
+
+// translation after a rotation about y, the child is a BVH of its own
+struct CompiledInstance {
+    glm::vec3 offset;
+    float sinTheta;
+    float cosTheta;
+    uint32_t bvh;
+};
+
+struct CompiledMedium {
+    uint32_t boundary; // BVH
+    float negInvDensity;
+    uint32_t material;
+};
+
+struct CompiledBVH {
+    std::vector<FlatNode> nodes;
+    std::vector<PrimitiveRef> refs;
+};
+
+struct CompiledMaterial {
+    MaterialType type;
+    uint32_t texture;
+    glm::vec3 albedo;
+    float parameter; // roughness for metals, index of refraction for dielectrics
+    float roughness; // of the microfacet materials
+    const Material* source;
+};
+
+struct CompiledTexture {
+    TextureType type;
+    glm::vec3 color;
+    float scale;
+    uint32_t odd, even;
+    const Texture* source;
+};
+
+struct SurfaceHit {
+    float t;
+    glm::vec3 point;
+    glm::vec3 normal;
+    bool inside;
+    float u, v;
+    uint32_t material;        // invalidHandle when only `source` is known, both unset without a material
+    const Material* source;
+};
+
+struct CompiledScatter {
+    glm::vec3 attenuation;
+    Lobe lobe;
+    Ray rayOut;
+    glm::vec3 wo;             // towards where the ray came from
+    float alpha, eta;         // Lobe::Microfacet, see MicrofacetBSDF
+    glm::vec3 f0;
+    std::shared_ptr<PDF> pdf; // only for Lobe::Virtual
+};
+
+class CompiledScene {
+public:
+    CompiledScene(const std::shared_ptr<HittableList>& world, const std::shared_ptr<HittableList>& lights);
+
+    bool hit(const Ray& ray, Interval t, SurfaceHit& hit) const;
+    // mirrors refits of the world's dynamic BVHs: their nodes, primitive order and the spheres
+    // and instances that moved, the rest of the compiled scene is left as it is. True if anything changed
+    bool refresh();
+
+    glm::vec3 emitted(const SurfaceHit& hit) const;
+    bool scatter(const Ray& rayIn, const SurfaceHit& hit, CompiledScatter& scatter) const;
+    float pdf(const SurfaceHit& hit, const glm::vec3& direction) const;
+    // f * cos towards `direction` of the lobe scatter() picked
+    glm::vec3 evaluate(const SurfaceHit& hit, const CompiledScatter& scatter, const glm::vec3& direction) const;
+    glm::vec3 texture(uint32_t index, float u, float v, const glm::vec3& point) const;
+
+    static glm::vec3 sample(const CompiledScatter& scatter, const glm::vec3& normal);
+    static float value(const CompiledScatter& scatter, const glm::vec3& normal, const glm::vec3& direction);
+
+    bool hasLights() const { return hasLights_; }
+    glm::vec3 sampleLight(const glm::vec3& origin) const;
+    float lightPdf(const glm::vec3& origin, const glm::vec3& direction) const;
+
+    const std::shared_ptr<HittableList>& world() const { return world_; }
+    const std::shared_ptr<HittableList>& lights() const { return lights_; }
+
+    size_t primitives() const { return spheres_.size() + quads_.size() + virtuals_.size(); }
+    size_t materials() const { return materials_.size(); }
+    size_t textures() const { return textures_.size(); }
+    size_t virtuals() const { return virtuals_.size(); }
+
+private:
+    friend class SceneCompiler;
+    friend struct GPUScene;
+
+    template<PrimitiveType Type>
+    bool intersect(uint32_t index, const Ray& ray, Interval t, SurfaceHit& hit) const;
+    bool hit(uint32_t bvh, const Ray& ray, Interval t, SurfaceHit& hit) const;
+
+private:
+    std::vector<CompiledBVH> bvhs_;
+    std::vector<CompiledSphere> spheres_;
+    std::vector<CompiledQuad> quads_;
+    std::vector<CompiledInstance> instances_;
+    std::vector<CompiledMedium> media_;
+    std::vector<std::shared_ptr<Hittable>> virtuals_;
+
+    // refittable BVHs of the world, traversed next to BVH 0 with refs in the order of their primitives
+    struct DynamicBVH {
+        const FlatBVH* source;
+        uint32_t bvh;
+        uint64_t revision;
+    };
+    std::vector<DynamicBVH> dynamic_;
+    std::unordered_map<const Hittable*, PrimitiveRef> dynamicRefs_;
+
+    std::vector<CompiledMaterial> materials_;
+    std::vector<CompiledTexture> textures_;
+    std::unordered_map<const Material*, uint32_t> materialHandles_;
+
+    // the authored graph stays alive, compiled entries point back into it
+    std::shared_ptr<HittableList> world_;
+    std::shared_ptr<HittableList> lights_;
+
+    bool hasLights_ = false;
+    std::vector<uint32_t> lightQuads_;
+    std::vector<std::shared_ptr<Hittable>> virtualLights_;
+};
\ No newline at end of file
@@ -0,0 +1,78 @@
+#pragma once
+
+#include "gpu/gpu_scene.hpp"
+#include "camera.hpp"
+#include <vulkan/vulkan.hpp>
+
+namespace wen {
+class CommandPool;
+class DescriptorSet;
+class ComputeRenderPipeline;
+class StorageBuffer;
+class UniformBuffer;
+class Buffer;
+} // namespace wen
+
+// Runs resources/shaders/path_tracer.comp as a wen ComputeRenderPipeline on the compute queue of
+// wen's context, so it needs wen::initializeRenderer() first, with settings->headless outside the
+// viewport. Every pass is traced, copied back and waited for, the caller accumulates the result
+// like a CPU pass. Safe to drive from the render thread, submissions go through the device's queue lock.
+class ComputeTracer {
+public:
+    ComputeTracer();
+    ~ComputeTracer();
+
+    ComputeTracer(const ComputeTracer&) = delete;
+    ComputeTracer& operator=(const ComputeTracer&) = delete;
+
+    bool valid() const { return pipeline_ != nullptr; }
+    const std::string& deviceName() const { return deviceName_; }
+
+    void upload(const GPUScene& scene);
+
+    struct Pass {
+        uint32_t width = 0, height = 0;
+        uint32_t sqrtSpp = 1;
+        uint32_t samples = 1;       // each traced sample is weighted 1 / samples, as on the CPU
+        uint32_t seed = 0;
+        uint32_t index = 0;         // the pass within the seed's sequence
+        uint32_t maxDepth = 50;
+        glm::vec3 background{0.0f};
+    };
+    // `radiance` receives width * height pixels, rows from the bottom, false if the pass failed
+    bool trace(const Camera& camera, const Pass& pass, glm::vec4* radiance);
+
+    // of the last trace(), GPU time without the copy back
+    float kernelTime() const { return kernelTime_; }
+
+private:
+    // device-local, filled through a staging buffer
+    std::shared_ptr<wen::StorageBuffer> createStorageBuffer(const void* data, vk::DeviceSize size);
+
+    void resize(uint32_t width, uint32_t height);
+    void submit(const std::function<void(vk::CommandBuffer)>& record);
+
+private:
+    std::string deviceName_;
+    float timestampPeriod_ = 0.0f; // nanoseconds per tick, 0 without compute timestamps
+
+    std::unique_ptr<wen::CommandPool> commandPool_;
+    vk::CommandBuffer commandBuffer_ = nullptr;
+    vk::Fence fence_ = nullptr;
+    vk::QueryPool queryPool_ = nullptr;
+
+    std::shared_ptr<wen::DescriptorSet> descriptorSet_;
+    std::shared_ptr<wen::ComputeRenderPipeline> pipeline_;
+
+    // bindings 1 - 8 of the kernel, 0 is the radiance and 9 the frame uniform
+    std::array<std::shared_ptr<wen::StorageBuffer>, 8> scene_;
+    uint32_t root_ = invalidHandle;
+    uint32_t lightCount_ = 0;
+
+    std::shared_ptr<wen::StorageBuffer> radiance_;
+    std::unique_ptr<wen::Buffer> readback_;
+    std::shared_ptr<wen::UniformBuffer> frame_;
+    uint32_t width_ = 0, height_ = 0;
+
+    float kernelTime_ = 0.0f;
+};
\ No newline at end of file
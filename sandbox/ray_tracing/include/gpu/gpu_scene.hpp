@@ -0,0 +1,78 @@
+#pragma once
+
+#include "compiled/compiled_scene.hpp"
+
+// The arrays of a CompiledScene in the std430 layout of resources/shaders/path_tracer.comp. All BVHs
+// share one node and one reference array, child and leaf offsets are absolute. The kernel covers
+// spheres, quads, instances and the Lambertian, Metal, Dielectric and DiffuseLight materials, media
+// and virtual primitives are left out and other materials and textures are approximated.
+
+struct GPUSphere {
+    glm::vec3 center;
+    float radius;
+    glm::vec3 velocity;
+    uint32_t material;
+};
+
+struct GPUQuad {
+    glm::vec3 Q;
+    float D;
+    glm::vec3 u;
+    float area;
+    glm::vec3 v;
+    uint32_t material;
+    glm::vec3 normal;
+    float pad0;
+    glm::vec3 w;
+    float pad1;
+};
+
+struct GPUInstance {
+    glm::vec3 offset;
+    float sinTheta;
+    float cosTheta;
+    uint32_t root;     // first node of the child BVH, invalidHandle when it is empty
+    uint32_t pad0, pad1;
+};
+
+struct GPUMaterial {
+    uint32_t type;     // MaterialType, only those the kernel implements
+    uint32_t texture;
+    float parameter;
+    float roughness;
+    glm::vec3 albedo;
+    float pad1;
+};
+
+struct GPUTexture {
+    uint32_t type;     // TextureType::Solid or TextureType::Chessboard
+    float scale;
+    uint32_t odd, even;
+    glm::vec3 color;
+    float pad;
+};
+
+struct GPUScene {
+    // the kernel has no environment map, with `environment` it traces the background colour in its place
+    explicit GPUScene(const CompiledScene& scene, bool environment = false);
+
+    // a reference is its PrimitiveType in the top bits and the index below
+    static constexpr uint32_t typeShift = 28;
+    static constexpr uint32_t indexMask = (1u << typeShift) - 1;
+
+    uint32_t root = invalidHandle; // of the world BVH
+    std::vector<FlatNode> nodes;
+    std::vector<uint32_t> refs;
+    std::vector<GPUSphere> spheres;
+    std::vector<GPUQuad> quads;
+    std::vector<GPUInstance> instances;
+    std::vector<GPUMaterial> materials;
+    std::vector<GPUTexture> textures;
+    std::vector<uint32_t> lights;  // quads sampled for next-event estimation
+
+    // what the kernel could not take over as it is
+    uint32_t skipped = 0;      // media and virtual primitives, virtual lights, the environment
+    uint32_t approximated = 0; // materials and textures replaced by a diffuse colour
+
+    size_t memory() const;
+};
\ No newline at end of file
@@ -0,0 +1,109 @@
+#pragma once
+
+#include "resources/aabb.hpp"
+#include <atomic>
+
+// Practical path guiding (Müller et al. 2017): a binary spatial tree whose leaves hold
+// directional quadtrees over the cylindrical mapping of the unit sphere.
+class DTree {
+public:
+    struct Node {
+        Node() = default;
+        Node(const Node& other);
+        Node& operator=(const Node& other);
+
+        float sum(int i) const { return sums[i].load(std::memory_order_relaxed); }
+        float total() const { return sum(0) + sum(1) + sum(2) + sum(3); }
+        bool leaf(int i) const { return children[i] == 0; }
+
+        std::atomic<float> sums[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+        uint32_t children[4] = {0, 0, 0, 0};
+    };
+
+    DTree();
+
+    void record(const glm::vec3& direction, float radiance);
+    float pdf(const glm::vec3& direction) const;
+    glm::vec3 sample() const;
+
+    void refine(const DTree& previous, float threshold, int maxDepth, size_t maxNodes);
+
+    bool valid() const { return nodes_[0].total() > 0.0f; }
+    size_t size() const { return nodes_.size(); }
+    size_t memory() const { return nodes_.capacity() * sizeof(Node); }
+
+    void write(std::ostream& out) const;
+    bool read(std::istream& in);
+
+    static glm::vec2 toCanonical(const glm::vec3& direction);
+    static glm::vec3 toDirection(const glm::vec2& p);
+
+private:
+    std::vector<Node> nodes_;
+};
+
+class DTreeWrapper {
+public:
+    DTreeWrapper() = default;
+    DTreeWrapper(const DTreeWrapper& other);
+
+    void record(const glm::vec3& direction, float radiance);
+    void refine(float threshold, int maxDepth, size_t maxNodes);
+
+    size_t memory() const { return sampling.memory() + building.memory(); }
+
+    void write(std::ostream& out) const;
+    bool read(std::istream& in);
+
+    DTree sampling;
+    DTree building;
+    std::atomic<uint32_t> samples = 0;
+};
+
+struct GuidingSettings {
+    float spatialThreshold = 12000.0f;
+    float directionalThreshold = 0.01f;
+    int maxDirectionalDepth = 20;
+    size_t maxDirectionalNodes = 4096;
+    size_t maxMemory = 256u << 20;
+    float fraction = 0.5f;
+};
+
+class SDTree {
+public:
+    explicit SDTree(const AABB& aabb);
+
+    DTreeWrapper& lookup(const glm::vec3& point);
+    const DTreeWrapper& lookup(const glm::vec3& point) const;
+    void record(const glm::vec3& point, const glm::vec3& direction, float radiance);
+
+    // called between iterations, never concurrently with record/lookup
+    void refine(uint32_t iteration);
+
+    size_t leaves() const { return wrappers_.size(); }
+    size_t memory() const;
+
+    // binary snapshot for checkpoints, same rules as refine()
+    void write(std::ostream& out) const;
+    bool read(std::istream& in);
+
+    GuidingSettings settings;
+
+private:
+    struct Node {
+        uint32_t children[2] = {0, 0};
+        uint32_t wrapper = 0;
+        uint8_t axis = 0;
+
+        bool leaf() const { return children[0] == 0; }
+    };
+
+    uint32_t leafIndex(const glm::vec3& point) const;
+    void subdivide(uint32_t index);
+
+private:
+    glm::vec3 min_;
+    glm::vec3 extent_;
+    std::vector<Node> nodes_;
+    std::vector<std::unique_ptr<DTreeWrapper>> wrappers_;
+};
\ No newline at end of file
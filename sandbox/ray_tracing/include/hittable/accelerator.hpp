@@ -0,0 +1,28 @@
+#pragma once
+
+#include "hittable/hittable.hpp"
+
+// Acceleration structures are Hittables over a HittableList, this picks one by name. The compiled
+// scene flattens the BVH family into its own FlatBVH, grids and kd-trees stay whole and are
+// traversed through their virtual hit().
+enum class Accelerator : uint32_t { BVH, FlatBVH, LBVH, PackedBVH, CompressedBVH, Grid, KDTree, Count };
+
+// summed over every structure built for a scene
+struct BuildStats {
+    float seconds = 0.0f;
+    size_t bytes = 0;
+    uint32_t structures = 0;
+};
+
+const char* acceleratorName(Accelerator accelerator);
+bool parseAccelerator(const std::string& name, Accelerator& accelerator);
+
+std::shared_ptr<Hittable> accelerate(const std::shared_ptr<HittableList>& list, Accelerator accelerator,
+                                     BuildStats* stats = nullptr);
+
+// spatial subdivisions (grid, kd-tree) only bin boxes that are finite and non-empty on every axis,
+// the others are tested against every ray
+bool bounded(const AABB& box);
+// the part [enter, exit] of `t` inside the box [min, max], false if the ray misses it
+bool clip(const Ray& ray, const glm::vec3& invDirection, const glm::vec3& min, const glm::vec3& max,
+          const Interval& t, float& enter, float& exit);
\ No newline at end of file
@@ -13,6 +13,9 @@ public:
     std::shared_ptr<Hittable> right;
 
 private:
+    BVH() = default;
+    void build(std::vector<std::shared_ptr<Hittable>>& objects, size_t start, size_t end);
+
     static bool compare(const std::shared_ptr<Hittable>& a, const std::shared_ptr<Hittable>& b, int index);
     static bool x(const std::shared_ptr<Hittable>& a, const std::shared_ptr<Hittable>& b);
     static bool y(const std::shared_ptr<Hittable>& a, const std::shared_ptr<Hittable>& b);
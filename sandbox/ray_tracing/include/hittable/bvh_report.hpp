@@ -0,0 +1,32 @@
+#pragma once
+
+#include "hittable/flat_bvh.hpp"
+
+class BVH;
+class PackedBVH;
+class CompressedBVH;
+
+// layout statistics of a built hierarchy, areas are relative to the root box so costs
+// are the expected work of a ray that hits the root
+struct BVHReport {
+    size_t nodes = 0;
+    size_t leaves = 0;
+    size_t primitives = 0;
+    uint32_t maxDepth = 0;
+
+    float sahCost = 0.0f;         // traversal and intersection cost both 1
+    float overlap = 0.0f;         // mean area(left & right) / area(parent) over interior nodes
+    float overlapCost = 0.0f;     // sum of area(left & right), a ray in it has to descend both children
+    float meanLeafSize = 0.0f;
+
+    std::vector<uint32_t> depths;    // leaves per depth
+    std::vector<uint32_t> leafSizes; // leaves per primitive count
+
+    static BVHReport build(const BVH& bvh);
+    static BVHReport build(const FlatBVH& bvh);
+    static BVHReport build(const PackedBVH& bvh);
+    // over the decoded boxes, which are the quantised ones the traversal tests
+    static BVHReport build(const CompressedBVH& bvh);
+
+    std::string summary() const;
+};
\ No newline at end of file
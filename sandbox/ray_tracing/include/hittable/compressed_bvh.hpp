@@ -0,0 +1,31 @@
+#pragma once
+
+#include "hittable/flat_bvh.hpp"
+
+// 24-byte node of a FlatBVH with the bounds of both children quantised to 8 bits on a grid of
+// power-of-two steps anchored at the decoded minimum of this node, only the root box is stored in floats
+struct CompressedNode {
+    uint8_t min[2][3];
+    uint8_t max[2][3];
+    uint32_t offset;     // leaf: first primitive, interior: second child
+    uint16_t count;      // 0 for interior nodes
+    int8_t exponent[3];  // grid step of the children is 2^exponent per axis
+    uint8_t padding;
+};
+
+class CompressedBVH : public Hittable {
+public:
+    CompressedBVH(const std::shared_ptr<HittableList>& list, uint32_t leafSize = 4);
+    CompressedBVH(const FlatBVH& bvh);
+
+    bool hit(const Ray& ray, Interval t, HitRecord& hitRecord) const override;
+
+    size_t memory() const;
+
+    std::vector<CompressedNode> nodes;
+    std::vector<std::shared_ptr<Hittable>> primitives;
+    glm::vec3 min, max;
+
+private:
+    void compress(const std::vector<FlatNode>& flat, uint32_t index, const glm::vec3& min);
+};
\ No newline at end of file
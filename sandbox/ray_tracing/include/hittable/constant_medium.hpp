@@ -2,7 +2,7 @@
 
 #include "hittable/hittable.hpp"
 #include "resources/material.hpp"
-#include "resources/texture.hpp"
+#include "resources/textures.hpp"
 
 class ConstantMedium : public Hittable {
 public:
@@ -11,6 +11,10 @@ public:
 
     bool hit(const Ray& ray, Interval t, HitRecord& hitRecoed) const override;
 
+    const std::shared_ptr<Hittable>& boundary() const { return boundary_; }
+    const std::shared_ptr<Material>& phase() const { return phase_; }
+    float negInvDensity() const { return negInvDensity_; }
+
 private:
     std::shared_ptr<Hittable> boundary_;
     std::shared_ptr<Material> phase_;
@@ -0,0 +1,115 @@
+#pragma once
+
+#include "hittable/hittable.hpp"
+#include "tools/counters.hpp"
+
+// 32-byte node of a depth-first linearised BVH, the first child directly follows its parent
+struct FlatNode {
+    glm::vec3 min;
+    uint32_t offset; // leaf: first primitive, interior: second child
+    glm::vec3 max;
+    uint16_t count;  // 0 for interior nodes
+    uint16_t axis;
+
+    bool intersect(const glm::vec3& origin, const glm::vec3& invDirection, Interval t) const {
+        glm::vec3 t0 = (min - origin) * invDirection;
+        glm::vec3 t1 = (max - origin) * invDirection;
+        glm::vec3 near = glm::min(t0, t1);
+        glm::vec3 far = glm::max(t0, t1);
+        t.min = glm::max(t.min, glm::max(near.x, glm::max(near.y, near.z)));
+        t.max = glm::min(t.max, glm::min(far.x, glm::min(far.y, far.z)));
+        return t.min <= t.max;
+    }
+};
+
+class FlatBVH : public Hittable {
+public:
+    // SAH gives the faster tree, Morton (LBVH) the faster build. Both run on the rendering thread pool
+    enum class Build { SAH, Morton };
+
+    FlatBVH(const std::shared_ptr<HittableList>& list, uint32_t leafSize = 4, Build method = Build::SAH);
+
+    bool hit(const Ray& ray, Interval t, HitRecord& hitRecord) const override;
+
+    size_t memory() const;
+
+    // `order` receives the primitive permutation referenced by the leaves
+    static std::vector<FlatNode> build(const std::vector<AABB>& boxes, std::vector<uint32_t>& order, uint32_t leafSize,
+                                       Build method = Build::SAH);
+
+    // `leaf(primitive, t)` returns whether it hit and shrinks t.max accordingly
+    template<typename Leaf>
+    static bool traverse(const std::vector<FlatNode>& nodes, const Ray& ray, Interval t, Leaf&& leaf) {
+        return traverse(nodes.data(), ray, t, std::forward<Leaf>(leaf));
+    }
+    // nodes that are not in a vector, e.g. read in place from a mapped file
+    template<typename Leaf>
+    static bool traverse(const FlatNode* nodes, const Ray& ray, Interval t, Leaf&& leaf) {
+        glm::vec3 invDirection = 1.0f / ray.direction;
+        uint32_t stack[64];
+        int top = 0;
+        uint32_t index = 0;
+        uint32_t visited = 0;
+        bool hitted = false;
+
+        while (true) {
+            const auto& node = nodes[index];
+            visited++;
+            if (node.intersect(ray.origin, invDirection, t)) {
+                if (node.count > 0) {
+                    for (uint32_t i = node.offset; i < node.offset + node.count; i++) {
+                        hitted |= leaf(i, t);
+                    }
+                } else {
+                    bool reversed = ray.direction[node.axis] < 0.0f;
+                    stack[top++] = reversed ? index + 1 : node.offset;
+                    index = reversed ? node.offset : index + 1;
+                    continue;
+                }
+            }
+            if (top == 0) {
+                break;
+            }
+            index = stack[--top];
+        }
+
+        Counters::add(Counter::BoxTests, visited);
+        return hitted;
+    }
+
+    // dynamic scenes flag every primitive whose aabb changed and call refit() before the next frame,
+    // only the flagged leaves and their ancestors are refitted
+    enum class Refit { None, Refitted, PartialRebuild, Rebuild };
+    void update(uint32_t primitive);
+    void update(const Hittable* primitive);
+    Refit refit();
+    void rebuild();
+
+    // SAH cost of the tree relative to the tree as last built
+    float degradation() const { return cost_.empty() || built_[0] <= 0.0f ? 1.0f : cost_[0] / built_[0]; }
+    // bumped by every refit and rebuild that changed the nodes
+    uint64_t revision() const { return revision_; }
+
+    std::vector<FlatNode> nodes;
+    std::vector<std::shared_ptr<Hittable>> primitives;
+
+    Build method = Build::SAH;      // also used by rebuilds after a refit
+    bool dynamic = false;           // compiled scenes mirror its nodes on refresh() instead of recompiling
+    float partialThreshold = 1.2f;  // degradation of a subtree that rebuilds it
+    float rebuildThreshold = 1.5f;  // degradation of the whole tree that rebuilds everything
+
+private:
+    void link();
+    void recompute(uint32_t index);
+    void rebuild(uint32_t index);
+
+private:
+    uint32_t leafSize_;
+    std::vector<uint32_t> parents_;
+    std::vector<uint32_t> leafOf_;      // primitive -> leaf
+    std::vector<float> cost_, built_;   // subtree SAH cost now and when it was built, not normalised
+    std::vector<uint8_t> dirty_;
+    std::vector<uint32_t> dirtyNodes_;
+    std::unordered_map<const Hittable*, uint32_t> indices_;
+    uint64_t revision_ = 0;
+};
\ No newline at end of file
@@ -0,0 +1,32 @@
+#pragma once
+
+#include "hittable/hittable.hpp"
+
+// Uniform grid for dense, evenly spread primitives such as particle clouds. About `density` cells
+// per primitive, each cell lists the primitives overlapping it and rays walk the cells front to back
+// with a 3D DDA, so the cost barely depends on how the primitives are clustered in the tree sense.
+class Grid : public Hittable {
+public:
+    Grid(const std::shared_ptr<HittableList>& list, float density = 4.0f);
+
+    bool hit(const Ray& ray, Interval t, HitRecord& hitRecord) const override;
+
+    size_t memory() const;
+    glm::ivec3 resolution() const { return resolution_; }
+
+    std::vector<std::shared_ptr<Hittable>> primitives;
+
+private:
+    glm::ivec3 cell(const glm::vec3& point) const;
+
+private:
+    static constexpr int maxResolution = 512;
+    static constexpr size_t maxCells = size_t(1) << 24;
+
+    glm::vec3 min_{0.0f}, max_{0.0f};
+    glm::vec3 cellSize_{1.0f};
+    glm::ivec3 resolution_{1};
+    std::vector<uint32_t> offsets_;  // entries of cell i are [offsets_[i], offsets_[i + 1])
+    std::vector<uint32_t> entries_;  // primitive indices
+    std::vector<uint32_t> unbounded_; // empty or infinite boxes, tested by every ray
+};
\ No newline at end of file
@@ -10,9 +10,22 @@ class Hittable {
 public:
     virtual ~Hittable() = default;
     virtual bool hit(const Ray& ray, Interval t, HitRecord& hitRecord) const = 0;
+    // closest hits of many rays at once, a ray already marked in `hitted` only takes hits before its
+    // record's t. Geometry that pays per visit, like streamed chunks, groups the rays by what they visit
+    virtual void hitBatch(const std::vector<Ray>& rays, Interval t, std::vector<HitRecord>& hitRecords, std::vector<uint8_t>& hitted) const {
+        HitRecord temp;
+        for (size_t i = 0; i < rays.size(); i++) {
+            if (hit(rays[i], Interval(t.min, hitted[i] ? hitRecords[i].t : t.max), temp)) {
+                hitRecords[i] = temp;
+                hitted[i] = 1;
+            }
+        }
+    }
     AABB aabb = AABB::empty;
     virtual float pdfValue(const glm::vec3& origin, const glm::vec3& direction) const { return 0.0f;}
     virtual glm::vec3 random(const glm::vec3& origin) const { return glm::vec3(1.0f, 0.0f, 0.0f); }
+    virtual float surfaceArea() const { return 0.0f; }
+    virtual glm::vec3 randomPoint(glm::vec3& normal) const { return glm::vec3(0.0f); }
 };
 
 class HittableList : public Hittable {
@@ -36,6 +49,12 @@ public:
         return hitted;
     }
 
+    void hitBatch(const std::vector<Ray>& rays, Interval t, std::vector<HitRecord>& hitRecords, std::vector<uint8_t>& hitted) const override {
+        for (const auto& hittable : hittables) {
+            hittable->hitBatch(rays, t, hitRecords, hitted);
+        }
+    }
+
     float pdfValue(const glm::vec3& origin, const glm::vec3& direction) const override {
         float weight = 1.0f / hittables.size();
         float sum = 0.0f;
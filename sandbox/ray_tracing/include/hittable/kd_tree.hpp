@@ -0,0 +1,44 @@
+#pragma once
+
+#include "hittable/hittable.hpp"
+
+// 12-byte node of a depth-first kd-tree, the child below the plane directly follows its parent
+struct KDNode {
+    float split;
+    uint32_t axis : 2;    // 3 for leaves
+    uint32_t offset : 30; // leaf: first entry in `indices`, interior: child above the plane
+    uint32_t count;       // leaf primitive count
+};
+
+// SAH kd-tree. Planes are chosen with a binned sweep over the clipped primitive bounds and
+// primitives straddling a plane are referenced from both sides, so traversal visits the leaves
+// strictly front to back and stops at the first leaf that contains a hit.
+class KDTree : public Hittable {
+public:
+    KDTree(const std::shared_ptr<HittableList>& list, uint32_t leafSize = 2);
+
+    bool hit(const Ray& ray, Interval t, HitRecord& hitRecord) const override;
+
+    size_t memory() const;
+
+    std::vector<KDNode> nodes;
+    std::vector<uint32_t> indices;
+    std::vector<std::shared_ptr<Hittable>> primitives;
+
+private:
+    void build(const AABB& bounds, std::vector<uint32_t>& items, const std::vector<AABB>& boxes, uint32_t depth);
+    void leaf(const std::vector<uint32_t>& items);
+
+private:
+    static constexpr uint32_t bins = 32;
+    static constexpr float traversalCost = 1.0f;
+    static constexpr float intersectionCost = 1.5f;
+    static constexpr float emptyBonus = 0.2f;
+    // traversal pushes at most one far child per level, so the depth limit sizes its stack
+    static constexpr uint32_t depthLimit = 64;
+
+    uint32_t leafSize_;
+    uint32_t maxDepth_ = 0;
+    AABB bounds_ = AABB::empty; // of the bounded primitives, the root of the tree
+    std::vector<uint32_t> unbounded_;
+};
\ No newline at end of file
@@ -0,0 +1,56 @@
+#pragma once
+
+#include "hittable/flat_bvh.hpp"
+
+class Material;
+class Sphere;
+class Quad;
+
+// static spheres as structure of arrays, only what the intersection test reads is kept hot
+struct PackedSpheres {
+    std::vector<float> x, y, z, radius;
+    std::vector<std::shared_ptr<Material>> materials;
+
+    void add(const Sphere& sphere);
+    // index of the closest sphere in [begin, end) inside `t`, UINT32_MAX if none was hit
+    uint32_t closest(uint32_t begin, uint32_t end, const Ray& ray, Interval t, float& tHit) const;
+    void record(uint32_t index, const Ray& ray, float t, HitRecord& hitRecord) const;
+    // the arrays run past the last sphere so a block can always be loaded whole
+    void pad();
+    uint32_t size() const { return materials.size(); }
+};
+
+struct PackedQuads {
+    std::vector<float> qx, qy, qz, ux, uy, uz, vx, vy, vz, nx, ny, nz, d, wx, wy, wz;
+    std::vector<std::shared_ptr<Material>> materials;
+
+    void add(const Quad& quad);
+    uint32_t closest(uint32_t begin, uint32_t end, const Ray& ray, Interval t, float& tHit) const;
+    void record(uint32_t index, const Ray& ray, float t, HitRecord& hitRecord) const;
+    void pad();
+    uint32_t size() const { return materials.size(); }
+};
+
+// a leaf owns a contiguous run in every primitive array
+struct PackedLeaf {
+    uint32_t sphereBegin, sphereEnd;
+    uint32_t quadBegin, quadEnd;
+    uint32_t otherBegin, otherEnd;
+};
+
+// BVH whose leaves test runs of spheres and quads a block of SIMD lanes at a time (tools/simd.hpp),
+// moving spheres and everything else still go through Hittable::hit
+class PackedBVH : public Hittable {
+public:
+    PackedBVH(const std::shared_ptr<HittableList>& list, uint32_t leafSize = 8);
+
+    bool hit(const Ray& ray, Interval t, HitRecord& hitRecord) const override;
+
+    size_t memory() const;
+
+    std::vector<FlatNode> nodes;
+    std::vector<PackedLeaf> leaves;
+    PackedSpheres spheres;
+    PackedQuads quads;
+    std::vector<std::shared_ptr<Hittable>> others;
+};
\ No newline at end of file
@@ -9,6 +9,8 @@ public:
     bool hit(const Ray& ray, Interval t, HitRecord& hitRecord) const override;
     float pdfValue(const glm::vec3& origin, const glm::vec3& direction) const override; 
     glm::vec3 random(const glm::vec3& origin) const override;
+    float surfaceArea() const override;
+    glm::vec3 randomPoint(glm::vec3& normal) const override;
 
     glm::vec3 Q, u, v;
     std::shared_ptr<Material> material;
@@ -10,6 +10,13 @@ public:
     bool hit(const Ray& ray, Interval t, HitRecord& hitRecord) const override;
     float pdfValue(const glm::vec3& origin, const glm::vec3& direction) const override; 
     glm::vec3 random(const glm::vec3& origin) const override;
+    float surfaceArea() const override;
+    glm::vec3 randomPoint(glm::vec3& normal) const override;
+
+    static void uv(const glm::vec3& point, float& u, float& v);
+
+    // keeps the motion of a moving sphere and updates aabb, the owning BVH still has to be refitted
+    void moveTo(const glm::vec3& position);
 
     bool moving;
     glm::vec3 position;
@@ -18,6 +25,5 @@ public:
     std::shared_ptr<Material> material;
 
 private:
-    static void uv(const glm::vec3& point, float& u, float& v);
     static glm::vec3 random_(float radius, float distance2);
 };
\ No newline at end of file
@@ -8,6 +8,10 @@ public:
 
     bool hit(const Ray& ray, Interval t, HitRecord& hitRecord) const override;
 
+    const std::shared_ptr<Hittable>& hittable() const { return hittable_; }
+    const glm::vec3& offset() const { return offset_; }
+    void setOffset(const glm::vec3& offset);
+
 private:
     std::shared_ptr<Hittable> hittable_;
     glm::vec3 offset_;
@@ -19,6 +23,10 @@ public:
 
     bool hit(const Ray& ray, Interval t, HitRecord& hitRecord) const override;
 
+    const std::shared_ptr<Hittable>& hittable() const { return hittable_; }
+    float sinTheta() const { return sinTheta_; }
+    float cosTheta() const { return cosTheta_; }
+
 private:
     std::shared_ptr<Hittable> hittable_;
     float sinTheta_;
@@ -0,0 +1,43 @@
+#pragma once
+
+#include "hittable/hittable.hpp"
+
+struct Photon {
+    glm::vec3 position;
+    glm::vec3 normal;
+    glm::vec3 power;
+};
+
+// Caustic photons (L S+ D) in a hashed grid with cell size 2r, so a gather touches exactly
+// 2x2x2 cells. Photons are sorted by cell and stored as SoA, a gather tests the photons of a cell
+// in SIMD lanes (tools/simd.hpp).
+class PhotonMap {
+public:
+    PhotonMap() = default;
+
+    void emit(const HittableList& world, const HittableList& lights, uint32_t count, int depth);
+    void build(float radius);
+
+    glm::vec3 estimate(const glm::vec3& point, const glm::vec3& normal) const;
+
+    size_t size() const { return begin_.empty() ? 0 : begin_.back(); }
+    float radius() const { return radius_; }
+
+private:
+    void trace(const HittableList& world, Ray ray, glm::vec3 power, int depth, std::vector<Photon>& photons) const;
+    uint32_t hash(const glm::ivec3& cell) const;
+    glm::ivec3 cell(const glm::vec3& point) const;
+
+private:
+    std::vector<Photon> photons_;
+
+    float radius_ = 1.0f;
+    float cellSize_ = 2.0f;
+    uint32_t mask_ = 0;
+    std::vector<uint32_t> begin_;
+
+    // padded by a lane width less one, so the lanes past the last photon still load
+    std::vector<float> x_, y_, z_;
+    std::vector<float> nx_, ny_, nz_;
+    std::vector<float> r_, g_, b_;
+};
\ No newline at end of file
@@ -2,11 +2,48 @@
 
 #include "camera.hpp"
 #include "application.hpp"
-#include "renderer.hpp"
+#include "render_thread.hpp"
+#include "streaming/streamed_geometry.hpp"
+#include "hittable/bvh_report.hpp"
+#include "hittable/accelerator.hpp"
+
+class Sphere;
+class Translate;
+
+// command line options, see main.cpp
+struct Options {
+    int scene = 4;
+    std::string resume;      // checkpoint to continue from
+    std::string environment; // HDR image lighting the scene instead of its background colour
+    Accelerator accelerator = Accelerator::PackedBVH; // for the large primitive lists of scenes 1, 3 and 5
+
+    // headless renders write `frames` passes to `output` without opening a window
+    bool headless = false;
+    int frames = 64;
+    uint32_t width = 800, height = 450;
+    Region crop;        // pixels of the written image, rows from its top edge
+    std::string output = "image.png";
+    bool gpu = false;   // passes on the compute kernel, see gpu/compute_tracer.hpp
+    // renders the same passes on the CPU and the GPU, reports both and writes <output>_cpu / _gpu
+    bool compare = false;
+
+    // times every accelerator on every built-in scene instead of rendering
+    bool benchmark = false;
+};
+
+// built-in scenes 1 - 5, with the camera and the settings they are meant to be seen with. `stats`
+// sums the builds of the scene's acceleration structures
+void buildScene(int index, Scene& scene, Camera& camera, RenderSettings& settings,
+                Accelerator accelerator = Accelerator::PackedBVH, BuildStats* stats = nullptr);
+
+// all return the process exit code
+int renderHeadless(const Options& options);
+int compareDevices(const Options& options);
+int runBenchmark(const Options& options);
 
 class RayTracing : public Layer {
 public:
-    RayTracing();
+    explicit RayTracing(const Options& options = {});
     ~RayTracing() override;
 
     void update(float ts) override;
@@ -15,10 +52,79 @@ public:
     void setCamera(const glm::vec3& position, const glm::vec3& direction);
 
 private:
-    Renderer renderer_;
+    // state of the dynamic world as last published by the render thread
+    struct DynamicStatus {
+        bool dynamic = false;
+        std::vector<glm::vec3> offsets;
+        FlatBVH::Build method = FlatBVH::Build::SAH;
+        FlatBVH::Refit lastRefit = FlatBVH::Refit::None;
+        float refitTime = 0.0f;
+        float degradation = 1.0f;
+    };
+
+    // region drawn or followed on the viewport, sent as the crop or the priority region
+    enum class RegionMode { Off, Priority, Crop };
+    void selectRegion(const Image& image);
+
+    // sends the UI camera and settings to the render thread
+    void sync();
 
+    // render thread
+    void makeDynamic();
+    void animate(float time);
+    void refit();
+    void publishStatus();
+    DynamicStatus dynamicStatus();
+
+    void saveCheckpoint();
+    void resume(const std::string& filename);
+
+private:
+    // the renderer and the scene are used by the render thread once it runs, the UI goes through submit()
+    Renderer renderer_;
     Camera camera_;
     Scene scene_;
+    RenderThread renderThread_;
+    RenderSettings settings_;
+    bool moved_ = false;
+
+    std::shared_ptr<Environment> environment_; // as last loaded, read-only outside commands
+    std::future<std::shared_ptr<Environment>> loading_;
+    float environmentIntensity_ = 1.0f;
+    char environmentFile_[1024] = "sandbox/ray_tracing/resources/textures/sky.hdr";
+
+    RegionMode regionMode_ = RegionMode::Off;
+    Region region_;
+    bool followCursor_ = false;
+    int cursorRadius_ = 32;
+    bool dragging_ = false;
+    glm::ivec2 dragStart_{0};
+
+    std::shared_ptr<StreamedGeometry> streamed_;
+    std::future<std::shared_ptr<StreamedGeometry>> streaming_;
+    int streamingBudget_ = 64;
+    std::vector<std::pair<std::string, BVHReport>> reports_;
+    std::future<std::vector<std::pair<std::string, BVHReport>>> reporting_;
+
+    std::shared_ptr<FlatBVH> dynamic_;
+    std::vector<std::pair<std::shared_ptr<Sphere>, glm::vec3>> animated_;
+    std::vector<std::shared_ptr<Translate>> instances_;
+    FlatBVH::Refit lastRefit_ = FlatBVH::Refit::None;
+    float refitTime_ = 0.0f;
+    std::mutex statusMutex_;
+    DynamicStatus status_;
+    bool animate_ = false;
+    float time_ = 0.0f;
+    std::atomic<bool> animating_ = false; // an animation step is queued, further ones are skipped
+
+    CheckpointWriter checkpointWriter_;
+    std::future<Checkpoint> snapshot_;
+    std::string snapshotFile_;
+    bool checkpointing_ = false;
+    int checkpointMinutes_ = 10;
+    std::chrono::steady_clock::time_point lastCheckpoint_ = std::chrono::steady_clock::now();
+    std::string resume_; // applied once the viewport has its size
+    char checkpoint_[1024] = "render.ckpt";
 
     uint32_t width_ = 0;
     uint32_t height_ = 0;
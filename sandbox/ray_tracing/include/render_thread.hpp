@@ -0,0 +1,97 @@
+#pragma once
+
+#include "image.hpp"
+#include "renderer.hpp"
+#include <condition_variable>
+#include <future>
+#include <thread>
+
+// what the UI shows about a finished pass, published together with its pixels
+struct Frame {
+    uint32_t width = 0;
+    uint32_t height = 0;
+    std::vector<uint32_t> pixels;
+
+    int index = 1;
+    uint32_t stride = 1;
+    float aovScale = 0.0f;
+    CounterValues counters;
+    float time = 0.0f;
+
+    bool guiding = false;
+    uint32_t guidingIteration = 0;
+    size_t guidingLeaves = 0;
+    size_t guidingMemory = 0;
+
+    size_t photons = 0;
+    float photonRadius = 0.0f;
+
+    bool compiled = false;
+    size_t primitives = 0, virtuals = 0, materials = 0, textures = 0;
+
+    std::string gpuDevice;    // empty until the first GPU pass, or without a compute device
+    float gpuKernelTime = 0.0f;
+};
+
+// Runs the passes of a Renderer back to back on a thread of its own. The UI thread only sends the
+// latest view and settings, queues commands and uploads the newest finished frame, it never waits
+// for a pass. The renderer and the scene belong to the render thread once start() is called, the
+// UI reaches them only through submit().
+class RenderThread {
+public:
+    RenderThread(Renderer& renderer, const Scene& scene, const Camera& camera);
+    ~RenderThread();
+
+    void start();
+    void stop();
+
+    // picked up by the next pass, `moved` keeps reprojectable history instead of restarting
+    void update(const Camera& camera, const RenderSettings& settings, uint32_t width, uint32_t height, bool moved);
+
+    // runs on the render thread before the next pass, in submission order
+    template<typename F>
+    auto submit(F&& function) -> std::future<decltype(function())> {
+        using Result = decltype(function());
+        auto task = std::make_shared<std::packaged_task<Result()>>(std::forward<F>(function));
+        auto future = task->get_future();
+        {
+            std::lock_guard lock(mutex_);
+            commands_.emplace_back([task] { (*task)(); });
+        }
+        wake_.notify_one();
+        return future;
+    }
+
+    // UI thread: uploads the newest finished frame if there is one
+    bool present();
+
+    std::shared_ptr<Image> image() const { return image_; }
+    const Frame& frame() const { return front_; }
+
+private:
+    void run();
+    void publish();
+
+private:
+    Renderer& renderer_;
+    const Scene& scene_;
+    Camera camera_;            // render thread copy, the UI keeps moving its own
+
+    std::thread thread_;
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    bool running_ = false;
+
+    // written by the UI, taken by the render thread before every pass
+    std::vector<std::function<void()>> commands_;
+    Camera view_;
+    RenderSettings settings_;
+    uint32_t width_ = 0, height_ = 0;
+    bool moved_ = false;
+
+    // the render thread fills back_ and swaps it with ready_, present() swaps ready_ with front_
+    Frame back_, ready_, front_;
+    bool published_ = false;
+
+    std::shared_ptr<Image> image_ = nullptr;
+};
\ No newline at end of file
@@ -1,49 +1,205 @@
 #pragma once
 
-#include "image.hpp"
 #include "camera.hpp"
 #include "hittable/hittable.hpp"
+#include "guiding/sd_tree.hpp"
+#include "photon/photon_map.hpp"
+#include "compiled/compiled_scene.hpp"
+#include "tools/counters.hpp"
+#include "tools/checkpoint.hpp"
+#include "resources/environment.hpp"
+
+class ComputeTracer;
 
 struct Scene {
     std::shared_ptr<HittableList> world;
     std::shared_ptr<HittableList> lights;
+    std::shared_ptr<Environment> environment; // replaces the background colour
+};
+
+// debug outputs shown in false colour instead of the beauty image, per-pixel means over the accumulated samples
+enum class AOV { Beauty, Nodes, Primitives, Bounces, Time };
+
+// pixels [x0, x1) x [y0, y1), rows counted from the bottom like the image data
+struct Region {
+    uint32_t x0 = 0, y0 = 0, x1 = 0, y1 = 0;
+
+    bool empty() const { return x1 <= x0 || y1 <= y0; }
+    bool contains(uint32_t x, uint32_t y) const { return x >= x0 && x < x1 && y >= y0 && y < y1; }
+    size_t area() const { return empty() ? 0 : (size_t)(x1 - x0) * (y1 - y0); }
+    Region clip(const Region& bounds) const {
+        return {glm::max(x0, bounds.x0), glm::max(y0, bounds.y0), glm::min(x1, bounds.x1), glm::min(y1, bounds.y1)};
+    }
+};
+
+// the tunables of a Renderer, the UI edits a copy that the render thread applies between passes
+struct RenderSettings {
+    int samples = 1;
+    glm::vec3 background = glm::vec3(0.0f);
+    bool accumulate = true;
+    bool guiding = false;
+    bool photonMapping = false;
+    int photons = 200000;
+    float photonRadius = 0.0f;
+    bool compiled = true;
+    AOV aov = AOV::Beauty;
+    bool reprojection = true;
+    int historyLimit = 16;           // frames a reprojected pixel may carry into the new view
+    float depthTolerance = 0.01f;    // plane distance between the two hits, relative to the view distance
+    float normalTolerance = 0.9f;    // smallest cosine between the two normals
+    bool interactive = true;         // reduced resolution while the camera moves
+    float targetFPS = 30.0f;
+    Region crop;                     // only these pixels are traced, the others keep their last value
+    Region priority;                 // traced every pass, the rest of the image converges in the background
+    float priorityShare = 0.9f;      // of the pixels traced per pass, the part inside the priority region
+    bool gpu = false;                // beauty passes of the compiled scene on the compute kernel, see gpu/compute_tracer.hpp
+    uint32_t seed = 0;               // of the per-pixel sequences, hashed with the frame index and the pixel
 };
 
-class Renderer {
+// CPU unless `gpu` is set, the finished pixels are in data() after render() and are uploaded by the caller
+class Renderer : public RenderSettings {
 public:
-    Renderer() = default;
-    ~Renderer() = default;
+    Renderer();
+    ~Renderer();
 
     void resize(uint32_t width, uint32_t height);
     void render(const Camera& camera, const Scene& scene);
 
-    std::shared_ptr<Image> image() const { return image_; }
+    uint32_t width() const { return width_; }
+    uint32_t height() const { return height_; }
     uint32_t* data() const { return data_; }
 
     int index() const { return index_; }
-    bool& accumulated() { return accumulated_; }
-    void reset() { index_ = 1; }
+    void reset() { index_ = 1; reproject_ = false; previewValid_ = false; }
+    // after a camera move: history that reprojects onto the same surface is kept, the rest starts over
+    void cameraMoved() { index_ = 1; reproject_ = true; moving_ = true; }
+
+    // pixels per traced sample along each axis of the last frame, 1 at full resolution
+    uint32_t previewStride() const { return stride_; }
+
+    const SDTree* sdTree() const { return sdTree_.get(); }
+    uint32_t guidingIteration() const { return guidingIteration_; }
+    void resetGuiding() { sdTree_.reset(); }
+
+    const PhotonMap& photonMap() const { return photonMap_; }
+    const CompiledScene* compiledScene() const { return compiledScene_.get(); }
+    // created by the first GPU pass, nullptr before
+    const ComputeTracer* computeTracer() const { return computeTracer_.get(); }
+
+    // false-colour `aov` into `pixels` (RGBA8), returns the value mapped to the top of the scale
+    float resolve(AOV aov, uint32_t* pixels) const;
+    float aovScale() const { return aovScale_; }
+
+    // snapshot of the progressive state between frames, resume() continues from one of the same size
+    Checkpoint checkpoint() const;
+    bool resume(const Checkpoint& checkpoint);
+
+    // counter totals of the last frame and its wall time in seconds
+    const CounterValues& frameCounters() const { return frameCounters_; }
+    float frameTime() const { return frameTime_; }
 
 public: 
-    int samples = 1;
     int sqrt_spp = 1;
-    glm::vec3 background = glm::vec3(0.0f);
 
 private:
+    // caustic: a diffuse vertex followed only by specular bounces, covered by the photon map
+    enum class PathState { Camera, Diffuse, Caustic };
+    static constexpr int maxDepth = 50;
+    static constexpr uint32_t maxStride = 16;
+
+    void renderPixel(uint32_t x, uint32_t y);
     Ray pixel(uint32_t x, uint32_t y, int si, int sj);
-    glm::vec3 traceRay(const Ray& ray, int depth);
+    glm::vec3 traceRay(const Ray& ray);
+    Ray primary(glm::vec2 coord, float time) const;
+    glm::vec3 miss(const Ray& ray) const;
+
+    // one integrator over two hit-record sources: the authored graph through virtual calls and
+    // the compiled scene through its kernels, both vertices answer the same questions
+    struct GraphVertex;
+    struct CompiledVertex;
+    template<typename Vertex>
+    glm::vec3 trace(const Ray& ray, int depth, PathState state);
+
+    // next-event strategy: the scene's lights and the environment, half each when both exist
+    bool hasLights() const;
+    glm::vec3 sampleLights(const glm::vec3& origin) const;
+    float lightsPdf(const glm::vec3& origin, const glm::vec3& direction) const;
+    float pixelCentre() const;
+    void emitPhotons(const Scene& scene);
+
+    // first hit through the centre of a pixel, a miss keeps the ray direction in `point`
+    struct Surface {
+        glm::vec3 point;
+        bool hit;
+        glm::vec3 normal;
+    };
+    void traceSurfaces();
+    void reproject();
+
+    // traces the pass on the compute kernel, false when it can't and the CPU has to
+    bool traceGPU();
+
+    void schedule();
+    bool scheduled(uint32_t x, uint32_t y) const {
+        return interval_ == 1 || priority_.contains(x, y) || y % interval_ == phase_;
+    }
+
+    bool preview(bool moving);
+    void upscale(uint32_t stride);
 
 private:
     const Camera* camera_;
     const Scene* scene_;
 
-    std::shared_ptr<Image> image_ = nullptr;
+    uint32_t width_ = 0;
+    uint32_t height_ = 0;
     uint32_t* data_ = nullptr;
 
     glm::vec4* accumulation_ = nullptr;
-    bool accumulated_ = true;
+    glm::vec4* statistics_ = nullptr; // nodes, primitives, bounces, microseconds
+    float* history_ = nullptr;        // frames accumulated per pixel
+    float aovScale_ = 0.0f;
+
+    CounterValues frameCounters_;
+    float frameTime_ = 0.0f;
     uint32_t index_ = 1;
 
+    // surfaces of the current and the previous camera, the history is reprojected through scratch buffers
+    Surface* surfaces_ = nullptr;
+    Surface* previousSurfaces_ = nullptr;
+    glm::vec4* reprojected_ = nullptr;
+    float* reprojectedHistory_ = nullptr;
+    glm::mat4 viewProjection_{1.0f};
+    bool surfacesValid_ = false;
+    bool reproject_ = false;
+
+    glm::vec3* preview_ = nullptr;   // radiance of the traced pixels of the preview grid
+    uint32_t stride_ = 1;
+    float strideEstimate_ = 1.0f;
+    bool previewValid_ = false;      // the coarser grid shows the current scene and can be refined
+    bool moving_ = false;
+
+    // pixels traced this pass: region_, of which rows outside priority_ take turns in `interval_` sets
+    Region region_;
+    Region priority_;
+    uint32_t interval_ = 1;
+    uint32_t phase_ = 0;
+
     std::vector<uint32_t> horizontal_;
     std::vector<uint32_t> vertical_;
+
+    std::unique_ptr<SDTree> sdTree_ = nullptr;
+    uint32_t guidingIteration_ = 0;
+    uint32_t guidingPasses_ = 0;
+
+    PhotonMap photonMap_;
+    bool caustics_ = false;
+    float photonRadius2_ = 0.0f;
+
+    std::unique_ptr<CompiledScene> compiledScene_ = nullptr;
+
+    std::unique_ptr<ComputeTracer> computeTracer_;
+    std::vector<glm::vec4> gpuRadiance_;
+    bool gpuSceneValid_ = false;     // the compute tracer holds the current compiled scene
+    const Environment* gpuEnvironment_ = nullptr; // replaced by the background in the uploaded scene
 };
\ No newline at end of file
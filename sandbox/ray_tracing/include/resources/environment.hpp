@@ -0,0 +1,38 @@
+#pragma once
+
+#include "tools/alias_table.hpp"
+#include <glm/glm.hpp>
+
+// Equirectangular HDR image lighting every ray that leaves the scene. Directions are sampled in
+// proportion to luminance times sin(theta), a marginal table picks the row and a conditional
+// table per row the column, so a small bright sun is found at a fraction of the samples.
+class Environment {
+public:
+    Environment(const std::string& filename, float intensity = 1.0f);
+
+    bool valid() const { return !pixels_.empty(); }
+    const std::string& filename() const { return filename_; }
+
+    glm::vec3 radiance(const glm::vec3& direction) const;
+
+    // solid angle density of sample()
+    glm::vec3 sample() const;
+    float pdf(const glm::vec3& direction) const;
+
+    size_t memory() const;
+
+public:
+    float intensity = 1.0f;
+
+private:
+    uint32_t pixel(const glm::vec3& direction) const;
+
+private:
+    std::string filename_;
+    int width_ = 0, height_ = 0;
+    std::vector<glm::vec3> pixels_; // top row first
+    std::vector<float> weights_;    // luminance times sin(theta) of every pixel, normalised
+
+    AliasTable rows_;
+    std::vector<AliasTable> columns_;
+};
\ No newline at end of file
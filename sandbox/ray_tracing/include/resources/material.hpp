@@ -5,6 +5,7 @@
 #include "tools/random.hpp"
 #include "resources/textures.hpp"
 #include "resources/pdf.hpp"
+#include "tools/counters.hpp"
 #include <glm/ext/scalar_constants.hpp>
 
 class ScatterRecord {
@@ -12,6 +13,7 @@ public:
     glm::vec3 attenuation;
     std::shared_ptr<PDF> pdf;
     Ray rayOut;
+    float lightFraction = 0.5f; // of the directions drawn towards the lights instead of from pdf
 };
 
 class Material {
@@ -20,6 +22,12 @@ public:
     virtual bool scatter(const Ray& rayIn, const HitRecord& hitRecord, ScatterRecord& scatterRecord) const = 0;
     virtual glm::vec3 emitted(const HitRecord& hitRecord) const = 0;
     virtual float pdf(const HitRecord& hitRecord, const Ray& rayOut) const = 0;
+
+    // f * cos towards `rayOut`, what the mixture estimators weight the incoming light with. Lobes
+    // that depend on the incoming direction override it, for the others it factors into these two
+    virtual glm::vec3 evaluate(const Ray& rayIn, const HitRecord& hitRecord, const ScatterRecord& scatterRecord, const Ray& rayOut) const {
+        return scatterRecord.attenuation * pdf(hitRecord, rayOut);
+    }
 };
 
 class Lambertian : public Material {
@@ -29,6 +37,7 @@ public:
 
     bool scatter(const Ray& rayIn, const HitRecord& hitRecord, ScatterRecord& scatterRecord) const override {
         scatterRecord.attenuation = albedo->value(hitRecord.u, hitRecord.v, hitRecord.point);
+        Counters::add(Counter::Allocations);
         scatterRecord.pdf = std::make_shared<CosinePDF>(hitRecord.normal);
 
         auto direction = hitRecord.normal + Random::UnitSphere();
@@ -114,6 +123,80 @@ public:
     }
 };
 
+// GGX reflection tinted by the Schlick Fresnel term of `albedo`, sampled through the visible normals
+class Conductor : public Material {
+public:
+    Conductor(const glm::vec3& albedo, float roughness) : albedo(albedo), roughness(roughness) {}
+
+    bool scatter(const Ray& rayIn, const HitRecord& hitRecord, ScatterRecord& scatterRecord) const override {
+        MicrofacetBSDF bsdf = this->bsdf(rayIn, hitRecord);
+        Counters::add(Counter::Allocations);
+        scatterRecord.pdf = std::make_shared<MicrofacetPDF>(bsdf);
+        scatterRecord.lightFraction = MicrofacetBSDF::lightFraction(GGX::alpha(roughness));
+        glm::vec3 direction = bsdf.sample(scatterRecord.attenuation);
+        scatterRecord.rayOut = Ray(hitRecord.point, direction, rayIn.time);
+        return true;
+    }
+
+    glm::vec3 emitted(const HitRecord& hitRecord) const override {
+        return glm::vec3(0.0f);
+    }
+
+    // needs the incoming direction, see evaluate()
+    float pdf(const HitRecord& hitRecord, const Ray& rayOut) const override {
+        return 0.0f;
+    }
+
+    glm::vec3 evaluate(const Ray& rayIn, const HitRecord& hitRecord, const ScatterRecord& scatterRecord, const Ray& rayOut) const override {
+        return bsdf(rayIn, hitRecord).evaluate(rayOut.direction);
+    }
+
+    MicrofacetBSDF bsdf(const Ray& rayIn, const HitRecord& hitRecord) const {
+        return MicrofacetBSDF(hitRecord.normal, -glm::normalize(rayIn.direction), GGX::alpha(roughness), 0.0f, albedo);
+    }
+
+    glm::vec3 albedo;
+    float roughness;
+};
+
+// frosted glass, GGX reflection and transmission picked by the Fresnel term of the sampled microfacet
+class RoughDielectric : public Material {
+public:
+    RoughDielectric(float ir, float roughness) : ir(ir), roughness(roughness) {}
+
+    bool scatter(const Ray& rayIn, const HitRecord& hitRecord, ScatterRecord& scatterRecord) const override {
+        MicrofacetBSDF bsdf = this->bsdf(rayIn, hitRecord);
+        Counters::add(Counter::Allocations);
+        scatterRecord.pdf = std::make_shared<MicrofacetPDF>(bsdf);
+        scatterRecord.lightFraction = MicrofacetBSDF::lightFraction(GGX::alpha(roughness));
+        glm::vec3 direction = bsdf.sample(scatterRecord.attenuation);
+        scatterRecord.rayOut = Ray(hitRecord.point, direction, rayIn.time);
+        return true;
+    }
+
+    glm::vec3 emitted(const HitRecord& hitRecord) const override {
+        return glm::vec3(0.0f);
+    }
+
+    // needs the incoming direction, see evaluate()
+    float pdf(const HitRecord& hitRecord, const Ray& rayOut) const override {
+        return 0.0f;
+    }
+
+    glm::vec3 evaluate(const Ray& rayIn, const HitRecord& hitRecord, const ScatterRecord& scatterRecord, const Ray& rayOut) const override {
+        return bsdf(rayIn, hitRecord).evaluate(rayOut.direction);
+    }
+
+    // entering from the front face the far side is the glass
+    MicrofacetBSDF bsdf(const Ray& rayIn, const HitRecord& hitRecord) const {
+        float eta = hitRecord.inside ? ir : 1.0f / ir;
+        return MicrofacetBSDF(hitRecord.normal, -glm::normalize(rayIn.direction), GGX::alpha(roughness), eta);
+    }
+
+    float ir;
+    float roughness;
+};
+
 class DiffuseLight : public Material {
 public:
     DiffuseLight(const glm::vec3& emit) : emit(std::make_shared<SolidColor>(emit)) {}
@@ -144,6 +227,7 @@ public:
 
     bool scatter(const Ray& rayIn, const HitRecord& hitRecord, ScatterRecord& scatterRecord) const override {
         scatterRecord.attenuation = albedo->value(hitRecord.u, hitRecord.v, hitRecord.point);
+        Counters::add(Counter::Allocations);
         scatterRecord.pdf = std::make_shared<SpherePDF>();
 
         auto dircetion = Random::UnitSphere();
@@ -0,0 +1,57 @@
+#pragma once
+
+#include "tools/onb.hpp"
+
+// Trowbridge-Reitz (GGX) normal distribution around `normal` with the separable Smith masking term.
+// Directions point away from the surface, `alpha` is the squared perceptual roughness.
+class GGX {
+public:
+    GGX(const glm::vec3& normal, float alpha);
+
+    float D(const glm::vec3& m) const;
+    float G1(const glm::vec3& v) const;
+
+    // a microfacet normal by its projected area as seen from `wo` [Heitz 2018]
+    glm::vec3 sampleVisible(const glm::vec3& wo) const;
+    // density of sampleVisible() over microfacet normals
+    float visiblePdf(const glm::vec3& wo, const glm::vec3& m) const;
+
+    // below this the lobe turns into a spike too narrow for single precision
+    static float alpha(float roughness) { return glm::max(roughness * roughness, 1e-3f); }
+
+private:
+    ONB uvw_;
+    float alpha_;
+};
+
+// Reflection off a rough conductor, or reflection and transmission through a rough dielectric
+// interface when `eta` is set. `normal` faces `wo`, `eta` is the index of refraction on the far side
+// over the one on wo's side, 0 for a conductor whose normal-incidence reflectance is `f0`.
+class MicrofacetBSDF {
+public:
+    MicrofacetBSDF(const glm::vec3& normal, const glm::vec3& wo, float alpha, float eta, const glm::vec3& f0 = glm::vec3(1.0f));
+
+    // through a visible normal, zero when that microfacet scatters to the wrong side of the surface
+    glm::vec3 sample() const;
+    // a sample with its weight f * |cos| / pdf, the normal and a zero weight when it failed
+    glm::vec3 sample(glm::vec3& weight) const;
+    float pdf(const glm::vec3& wi) const;
+    // f * |cos| towards `wi`. Transmitted radiance is not scaled by eta^2, like Dielectric
+    glm::vec3 evaluate(const glm::vec3& wi) const;
+
+    static float fresnel(float cosTheta, float eta);
+    // the share of light samples mixed in next to the lobe, the sharper it is the less they agree
+    static float lightFraction(float alpha) { return 0.5f * glm::min(1.0f, 2.0f * alpha); }
+
+private:
+    bool conductor() const { return eta_ <= 0.0f; }
+    // the microfacet normal that scatters wo into wi, false if none on the visible side does
+    bool half(const glm::vec3& wi, glm::vec3& m) const;
+
+private:
+    GGX ggx_;
+    glm::vec3 normal_;
+    glm::vec3 wo_;
+    float eta_;
+    glm::vec3 f0_;
+};
\ No newline at end of file
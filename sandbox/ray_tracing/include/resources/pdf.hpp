@@ -2,6 +2,7 @@
 
 #include "hittable/hittable.hpp"
 #include "tools/onb.hpp"
+#include "resources/microfacet.hpp"
 
 class PDF {
 public:
@@ -32,6 +33,18 @@ public:
     glm::vec3 generate() const override;
 };
 
+// generate() is zero when the sampled microfacet sends the ray to the wrong side
+class MicrofacetPDF : public PDF {
+public:
+    MicrofacetPDF(const MicrofacetBSDF& bsdf);
+
+    float value(const glm::vec3& direction) const override;
+    glm::vec3 generate() const override;
+
+private:
+    MicrofacetBSDF bsdf_;
+};
+
 class HittablePDF : public PDF {
 public:
     HittablePDF(const std::shared_ptr<Hittable>& hittable, const glm::vec3& origin);
@@ -46,11 +59,24 @@ private:
 
 class MixturePDF : public PDF {
 public:
-    MixturePDF(std::shared_ptr<PDF> p0, std::shared_ptr<PDF> p1);
+    MixturePDF(std::shared_ptr<PDF> p0, std::shared_ptr<PDF> p1, float weight = 0.5f);
 
     float value(const glm::vec3& direction) const override;
     glm::vec3 generate() const override;
 
 private:
     std::shared_ptr<PDF> p_[2];
+    float weight_;
+};
+
+class DTree;
+class GuidingPDF : public PDF {
+public:
+    GuidingPDF(const DTree& tree);
+
+    float value(const glm::vec3& direction) const override;
+    glm::vec3 generate() const override;
+
+private:
+    const DTree& tree_;
 };
\ No newline at end of file
@@ -15,6 +15,8 @@ public:
 
     [[nodiscard]] glm::vec3 value(float u, float v, const glm::vec3& hitPoint) const override;
 
+    const glm::vec3& color() const { return color_; }
+
 private:
     glm::vec3 color_;
 };
@@ -26,6 +28,10 @@ public:
 
     [[nodiscard]] glm::vec3 value(float u, float v, const glm::vec3& hitPoint) const override;
 
+    float scale() const { return scale_; }
+    const std::shared_ptr<Texture>& odd() const { return odd_; }
+    const std::shared_ptr<Texture>& even() const { return even_; }
+
 private:
     float scale_;
     std::shared_ptr<Texture> odd_;
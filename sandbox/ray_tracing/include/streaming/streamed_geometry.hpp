@@ -0,0 +1,99 @@
+#pragma once
+
+#include "hittable/flat_bvh.hpp"
+#include <atomic>
+#include <mutex>
+
+class Material;
+
+// primitives as laid out on disk, chunks only hold POD and are intersected in place from the mapped file
+struct PrimitiveRecord {
+    enum Type : uint32_t { Sphere = 0, Quad = 1 };
+
+    uint32_t type;
+    uint32_t material;
+    // sphere: position, direction, radius, moving
+    // quad: Q, u, v, normal, D, w, so the plane does not have to be rebuilt per ray
+    float data[16];
+};
+
+struct ChunkEntry {
+    uint64_t offset;
+    uint32_t nodeCount;
+    uint32_t primitiveCount;
+    glm::vec3 min;
+    glm::vec3 max;
+};
+
+struct StreamingStats {
+    size_t residentBytes;
+    size_t residentChunks;
+    size_t chunks;
+    uint64_t pageIns;
+    uint64_t pageOuts;
+    uint64_t lookups;
+    uint64_t hits;
+
+    float hitRate() const { return lookups > 0 ? (float)hits / (float)lookups : 1.0f; }
+};
+
+// Out-of-core geometry: spatial chunks with their own BVHs live in a file that is memory mapped, a
+// top-level BVH over the chunk bounds finds the chunks a ray crosses and their nodes and primitives are
+// intersected where they are mapped. An LRU over the chunks keeps the resident set under `budget`, pages
+// are prefetched when a chunk becomes resident and released when it is evicted, no lock is held while
+// the pages are read.
+class StreamedGeometry : public Hittable {
+public:
+    StreamedGeometry(const std::string& filename, const std::vector<std::shared_ptr<Material>>& materials, size_t budget);
+    ~StreamedGeometry() override;
+
+    bool hit(const Ray& ray, Interval t, HitRecord& hitRecord) const override;
+    // the rays are queued per chunk they cross and sorted by chunk, each chunk is acquired once for the
+    // whole batch and its rays are traced while it is resident
+    void hitBatch(const std::vector<Ray>& rays, Interval t, std::vector<HitRecord>& hitRecords, std::vector<uint8_t>& hitted) const override;
+
+    StreamingStats stats() const;
+
+    // moves every sphere and quad reachable through lists and BVHs of `world` into `filename`
+    // and replaces `world` by the in-core remainder plus the streamed geometry
+    static std::shared_ptr<StreamedGeometry> stream(std::shared_ptr<HittableList>& world, const std::string& filename,
+                                                    size_t budget, uint32_t chunkPrimitives = 4096);
+
+    size_t budget;
+
+private:
+    struct Chunk {
+        const FlatNode* nodes;
+        const PrimitiveRecord* primitives;
+    };
+
+    Chunk acquire(uint32_t index) const;
+    void evict(uint32_t keep) const;
+    bool map(const std::string& filename);
+    void advise(uint32_t index, bool resident) const;
+    bool hit(const Chunk& chunk, const Ray& ray, Interval& t, HitRecord& hitRecord) const;
+
+private:
+    std::string filename_;
+    std::vector<ChunkEntry> entries_;
+    std::vector<FlatNode> topLevel_;
+    std::vector<std::shared_ptr<Material>> materials_;
+
+    const uint8_t* mapped_ = nullptr;
+    size_t mappedSize_ = 0;
+#ifdef _WIN32
+    void* file_ = nullptr;
+    void* mapping_ = nullptr;
+#endif
+
+    // only guards the LRU scan, page faults happen outside of it
+    mutable std::mutex mutex_;
+    mutable std::unique_ptr<std::atomic<bool>[]> resident_;
+    mutable std::unique_ptr<std::atomic<uint64_t>[]> lastUse_;
+    mutable std::atomic<uint64_t> clock_ = 0;
+    mutable std::atomic<size_t> residentBytes_ = 0;
+    mutable std::atomic<uint64_t> pageIns_ = 0;
+    mutable std::atomic<uint64_t> pageOuts_ = 0;
+    mutable std::atomic<uint64_t> lookups_ = 0;
+    mutable std::atomic<uint64_t> hits_ = 0;
+};
\ No newline at end of file
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+// Vose's alias method, constant time sampling of a discrete distribution
+class AliasTable {
+public:
+    AliasTable() = default;
+    // all-zero weights give the uniform distribution
+    explicit AliasTable(const std::vector<float>& weights);
+
+    // an index drawn in proportion to its weight, `u` in [0, 1)
+    uint32_t sample(float u) const;
+
+    float probability(uint32_t index) const { return probabilities_[index]; }
+    float total() const { return total_; }
+    size_t size() const { return bins_.size(); }
+    size_t memory() const { return bins_.capacity() * sizeof(Bin) + probabilities_.capacity() * sizeof(float); }
+
+private:
+    struct Bin {
+        float threshold; // the bin keeps its own index below it, above it takes `alias`
+        uint32_t alias;
+    };
+
+    std::vector<Bin> bins_;
+    std::vector<float> probabilities_;
+    float total_ = 0.0f;
+};
\ No newline at end of file
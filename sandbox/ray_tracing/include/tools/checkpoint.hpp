@@ -0,0 +1,50 @@
+#pragma once
+
+#include <future>
+#include <glm/glm.hpp>
+
+// Everything a progressive render needs to carry on: the per-pixel sums and frame counts, the
+// frame index and the state of the adaptive techniques. Every pixel reseeds its sampler from the
+// seed, the frame index and its position, so those two resume the random sequences as well.
+struct Checkpoint {
+    uint32_t width = 0;
+    uint32_t height = 0;
+    uint32_t index = 1;
+    uint32_t seed = 0;
+    int samples = 1;
+    glm::vec3 position = glm::vec3(0.0f);
+    glm::vec3 direction = glm::vec3(0.0f, 0.0f, 1.0f);
+
+    std::vector<glm::vec4> accumulation;
+    std::vector<glm::vec4> statistics;
+    std::vector<float> history;
+
+    float photonRadius2 = 0.0f;
+    uint32_t guidingIteration = 0;
+    uint32_t guidingPasses = 0;
+    std::string guiding; // serialised SD-tree, empty without guiding
+
+    size_t bytes() const;
+
+    // written to a temporary next to `filename` and renamed, a crash never leaves a torn file
+    bool write(const std::string& filename) const;
+    // false for a file of another version or whose size does not match its header
+    bool read(const std::string& filename);
+};
+
+// writes checkpoints on a background thread so rendering never waits for the disk
+class CheckpointWriter {
+public:
+    ~CheckpointWriter();
+
+    // false while the previous checkpoint is still being written, the new one is dropped
+    bool save(Checkpoint checkpoint, const std::string& filename);
+    bool busy() const;
+
+    // result of the last finished write
+    bool succeeded();
+
+private:
+    std::future<bool> pending_;
+    bool succeeded_ = true;
+};
\ No newline at end of file
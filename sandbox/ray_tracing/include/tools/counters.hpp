@@ -0,0 +1,57 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <string>
+
+enum class Counter : uint32_t {
+    CameraRays,
+    BounceRays,
+    ShadowRays,          // light pdf evaluations, each intersects the light list
+    PhotonRays,
+    BoxTests,
+    PrimitiveTests,
+    MaterialEvaluations, // scatter calls
+    Allocations,         // tracer heap allocations: BVH nodes, scatter pdfs, streamed chunks paged in
+    Count
+};
+
+// a plain copy of counter values that can be subtracted and written out
+struct CounterValues {
+    std::array<uint64_t, (size_t)Counter::Count> values = {};
+
+    uint64_t operator[](Counter counter) const { return values[(size_t)counter]; }
+    CounterValues operator-(const CounterValues& other) const;
+
+    std::string json() const;
+};
+
+// hot-path event counts in one cache line per thread. Only the owning thread writes its slot,
+// with relaxed loads and stores that compile to plain adds, other threads may read it at any time
+class Counters {
+public:
+    static void add(Counter counter, uint64_t n = 1) {
+        auto& value = local().values_[(size_t)counter];
+        value.store(value.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+    }
+
+    static CounterValues thread();
+    static CounterValues total();
+    static const char* name(Counter counter);
+
+private:
+    // takes a slot for the thread's lifetime and hands it back on exit
+    struct Slot {
+        Slot();
+        ~Slot();
+        Counters* counters;
+    };
+
+    static Counters& local() {
+        thread_local Slot slot;
+        return *slot.counters;
+    }
+
+private:
+    alignas(64) std::array<std::atomic<uint64_t>, (size_t)Counter::Count> values_ = {};
+};
\ No newline at end of file
@@ -2,12 +2,12 @@
 
 #include <glm/glm.hpp>
 
-const float infinity = std::numeric_limits<float>::infinity();
+constexpr float infinity = std::numeric_limits<float>::infinity();
 
 class Interval {
 public:
-    Interval() : min(+infinity), max(-infinity) {}
-    Interval(float min, float max) : min(min), max(max) {}
+    constexpr Interval() : min(+infinity), max(-infinity) {}
+    constexpr Interval(float min, float max) : min(min), max(max) {}
     Interval(const Interval& a, const Interval& b) : min(glm::min(a.min, b.min)), max(glm::max(a.max, b.max)) {}
 
     float size() const { return max - min; }
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <vector>
+
+// scoped timing zones kept in per-thread buffers while recording is on, exported in the
+// Chrome trace event format (chrome://tracing, ui.perfetto.dev)
+class Profiler {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    static void record(bool enabled) { recording_.store(enabled, std::memory_order_relaxed); }
+    static bool recording() { return recording_.load(std::memory_order_relaxed); }
+
+    static void zone(const char* name, Clock::time_point begin, Clock::time_point end);
+    // not thread-safe against zones being recorded, call it between frames
+    static bool save(const std::string& filename);
+    static void clear();
+    static size_t events();
+
+private:
+    static std::atomic<bool> recording_;
+};
+
+class ProfileZone {
+public:
+    // `name` must outlive the profile, string literals are expected
+    explicit ProfileZone(const char* name) : name_(Profiler::recording() ? name : nullptr) {
+        if (name_) {
+            begin_ = Profiler::Clock::now();
+        }
+    }
+
+    ~ProfileZone() {
+        if (name_) {
+            Profiler::zone(name_, begin_, Profiler::Clock::now());
+        }
+    }
+
+    ProfileZone(const ProfileZone&) = delete;
+    ProfileZone& operator=(const ProfileZone&) = delete;
+
+private:
+    const char* name_;
+    Profiler::Clock::time_point begin_;
+};
+
+#define PROFILE_CONCAT_(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_(a, b)
+#define PROFILE_ZONE(name) ProfileZone PROFILE_CONCAT(profileZone, __LINE__)(name)
\ No newline at end of file
@@ -3,24 +3,39 @@
 #include <random>
 #include <glm/glm.hpp>
 
+// The compute kernel's generator, each value is the PCG hash of the last, so a pixel seeded the same
+// way on both devices draws the same numbers in the same order.
 class Random {
 public:
     static void Init() {
-        randomEngine.seed(std::random_device()());
+        state = std::random_device()();
+    }
+
+    // restarts this thread's sequence, with Hash() a pixel gets the same samples whenever it is traced again
+    static void Seed(uint32_t seed) {
+        state = seed;
+    }
+
+    // the PCG hash the compute kernel seeds its per-pixel sequences with
+    static uint32_t Hash(uint32_t v) {
+        uint32_t state = v * 747796405u + 2891336453u;
+        uint32_t word = ((state >> ((state >> 28u) + 4u)) ^ state) * 277803737u;
+        return (word >> 22u) ^ word;
     }
 
     static uint32_t UInt() {
-        return distribution(randomEngine);
+        state = Hash(state);
+        return state;
     }
 
     // [min, max]
     static uint32_t UInt(uint32_t min, uint32_t max) {
-        return min + (distribution(randomEngine) % (max - min + 1));
+        return min + (UInt() % (max - min + 1));
     }
 
-    // (0, 1)
+    // [0, 1), the top 24 bits as in the kernel's random()
     static float Float() {
-        return (float)distribution(randomEngine) / (float)std::numeric_limits<uint32_t>::max();
+        return (float)(UInt() >> 8) * (1.0f / 16777216.0f);
     }
 
     // [min, max)
@@ -39,12 +54,12 @@ public:
     static glm::vec3 UnitSphere() {
         while (true) {
             auto unit = glm::vec3(2.0f * Float() - 1.0f, 2.0f * Float() - 1.0f, 2.0f * Float() - 1.0f);
-            if (glm::dot(unit, unit) < 1) {
+            float length2 = glm::dot(unit, unit);
+            if (length2 < 1.0f && length2 > 1e-12f) {
                 return glm::normalize(unit);
             }
         }
     }
 
-    static thread_local std::mt19937 randomEngine;
-    static std::uniform_int_distribution<std::mt19937::result_type> distribution;
+    static thread_local uint32_t state;
 };
\ No newline at end of file
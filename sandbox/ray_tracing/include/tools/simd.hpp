@@ -0,0 +1,85 @@
+#pragma once
+
+#include <cstdint>
+#include <cmath>
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SIMD_SSE2
+#include <emmintrin.h>
+#endif
+
+// The few float lane operations the packed leaf tests need: 8 lanes with AVX (RAY_TRACING_AVX2 in
+// CMake), 4 with SSE2, which every x86-64 target has, and a single scalar lane everywhere else.
+namespace simd {
+
+#if defined(__AVX__)
+
+constexpr uint32_t width = 8;
+struct Float { __m256 v; };
+struct Mask { __m256 v; };
+
+inline Float load(const float* p) { return {_mm256_loadu_ps(p)}; }
+inline Float broadcast(float f) { return {_mm256_set1_ps(f)}; }
+inline Float index() { return {_mm256_setr_ps(0.0f, 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f)}; }
+inline void store(float* p, Float a) { _mm256_storeu_ps(p, a.v); }
+inline Float operator+(Float a, Float b) { return {_mm256_add_ps(a.v, b.v)}; }
+inline Float operator-(Float a, Float b) { return {_mm256_sub_ps(a.v, b.v)}; }
+inline Float operator*(Float a, Float b) { return {_mm256_mul_ps(a.v, b.v)}; }
+inline Float operator/(Float a, Float b) { return {_mm256_div_ps(a.v, b.v)}; }
+inline Float sqrt(Float a) { return {_mm256_sqrt_ps(a.v)}; }
+inline Float max(Float a, Float b) { return {_mm256_max_ps(a.v, b.v)}; }
+inline Float abs(Float a) { return {_mm256_andnot_ps(_mm256_set1_ps(-0.0f), a.v)}; }
+inline Mask operator<(Float a, Float b) { return {_mm256_cmp_ps(a.v, b.v, _CMP_LT_OQ)}; }
+inline Mask operator<=(Float a, Float b) { return {_mm256_cmp_ps(a.v, b.v, _CMP_LE_OQ)}; }
+inline Mask operator&(Mask a, Mask b) { return {_mm256_and_ps(a.v, b.v)}; }
+inline Float select(Mask m, Float a, Float b) { return {_mm256_blendv_ps(b.v, a.v, m.v)}; }
+
+#elif defined(SIMD_SSE2)
+
+constexpr uint32_t width = 4;
+struct Float { __m128 v; };
+struct Mask { __m128 v; };
+
+inline Float load(const float* p) { return {_mm_loadu_ps(p)}; }
+inline Float broadcast(float f) { return {_mm_set1_ps(f)}; }
+inline Float index() { return {_mm_setr_ps(0.0f, 1.0f, 2.0f, 3.0f)}; }
+inline void store(float* p, Float a) { _mm_storeu_ps(p, a.v); }
+inline Float operator+(Float a, Float b) { return {_mm_add_ps(a.v, b.v)}; }
+inline Float operator-(Float a, Float b) { return {_mm_sub_ps(a.v, b.v)}; }
+inline Float operator*(Float a, Float b) { return {_mm_mul_ps(a.v, b.v)}; }
+inline Float operator/(Float a, Float b) { return {_mm_div_ps(a.v, b.v)}; }
+inline Float sqrt(Float a) { return {_mm_sqrt_ps(a.v)}; }
+inline Float max(Float a, Float b) { return {_mm_max_ps(a.v, b.v)}; }
+inline Float abs(Float a) { return {_mm_andnot_ps(_mm_set1_ps(-0.0f), a.v)}; }
+inline Mask operator<(Float a, Float b) { return {_mm_cmplt_ps(a.v, b.v)}; }
+inline Mask operator<=(Float a, Float b) { return {_mm_cmple_ps(a.v, b.v)}; }
+inline Mask operator&(Mask a, Mask b) { return {_mm_and_ps(a.v, b.v)}; }
+inline Float select(Mask m, Float a, Float b) { return {_mm_or_ps(_mm_and_ps(m.v, a.v), _mm_andnot_ps(m.v, b.v))}; }
+
+#else
+
+constexpr uint32_t width = 1;
+struct Float { float v; };
+struct Mask { bool v; };
+
+inline Float load(const float* p) { return {*p}; }
+inline Float broadcast(float f) { return {f}; }
+inline Float index() { return {0.0f}; }
+inline void store(float* p, Float a) { *p = a.v; }
+inline Float operator+(Float a, Float b) { return {a.v + b.v}; }
+inline Float operator-(Float a, Float b) { return {a.v - b.v}; }
+inline Float operator*(Float a, Float b) { return {a.v * b.v}; }
+inline Float operator/(Float a, Float b) { return {a.v / b.v}; }
+inline Float sqrt(Float a) { return {std::sqrt(a.v)}; }
+inline Float max(Float a, Float b) { return {a.v > b.v ? a.v : b.v}; }
+inline Float abs(Float a) { return {std::fabs(a.v)}; }
+inline Mask operator<(Float a, Float b) { return {a.v < b.v}; }
+inline Mask operator<=(Float a, Float b) { return {a.v <= b.v}; }
+inline Mask operator&(Mask a, Mask b) { return {a.v && b.v}; }
+inline Float select(Mask m, Float a, Float b) { return m.v ? a : b; }
+
+#endif
+
+} // namespace simd
\ No newline at end of file
@@ -0,0 +1,110 @@
+#include "ray_tracing.hpp"
+#include <execution>
+#include <filesystem>
+#include <numeric>
+
+namespace {
+
+struct Result {
+    int scene;
+    Accelerator accelerator;
+    BuildStats build;
+    float primary = 0.0f, secondary = 0.0f;    // Mrays/s
+    float boxTests = 0.0f, primitiveTests = 0.0f; // per ray, over both passes
+};
+
+// one ray per pixel through its centre, the same mapping as Renderer::primary
+Ray cameraRay(const Camera& camera, uint32_t x, uint32_t y, uint32_t width, uint32_t height) {
+    glm::vec2 coord = glm::vec2(x + 0.5f, y + 0.5f) / glm::vec2(width, height) * 2.0f - 1.0f;
+    glm::vec4 target = glm::inverse(camera.projection) * glm::vec4(coord.x, coord.y, 1.0f, 1.0f);
+    glm::vec3 direction(glm::inverse(camera.view) * glm::vec4(glm::normalize(glm::vec3(target) / target.w), 0.0f));
+    return Ray(camera.position, direction, 0.0f);
+}
+
+// traces `rays` on the rendering pool one row per task, returns the seconds it took
+float trace(const Hittable& world, const std::vector<Ray>& rays, uint32_t width, std::vector<HitRecord>& hits,
+            std::vector<uint8_t>& hitted) {
+    std::vector<uint32_t> rows(rays.size() / width);
+    std::iota(rows.begin(), rows.end(), 0);
+    auto begin = std::chrono::steady_clock::now();
+    std::for_each(std::execution::par, rows.begin(), rows.end(), [&](uint32_t y) {
+        for (uint32_t i = y * width; i < (y + 1) * width; i++) {
+            hitted[i] = world.hit(rays[i], Interval(0.001f, infinity), hits[i]);
+        }
+    });
+    return std::chrono::duration<float>(std::chrono::steady_clock::now() - begin).count();
+}
+
+Result measure(int index, Accelerator accelerator, uint32_t width, uint32_t height) {
+    Result result{index, accelerator};
+
+    Scene scene;
+    Camera camera(45.0f, 0.1f, 100.0f);
+    RenderSettings settings;
+    buildScene(index, scene, camera, settings, accelerator, &result.build);
+    // the top level too, so the plain-list scenes are measured with the backend as well
+    auto world = accelerate(scene.world, accelerator, &result.build);
+    camera.resize(width, height);
+
+    size_t count = (size_t)width * height;
+    std::vector<Ray> rays(count);
+    std::vector<HitRecord> hits(count);
+    std::vector<uint8_t> hitted(count);
+    for (uint32_t y = 0; y < height; y++) {
+        for (uint32_t x = 0; x < width; x++) {
+            rays[y * width + x] = cameraRay(camera, x, y, width, height);
+        }
+    }
+
+    CounterValues before = Counters::total();
+    float seconds = trace(*world, rays, width, hits, hitted);
+    result.primary = count / seconds * 1e-6f;
+
+    // diffuse bounces from the primary hits are the incoherent rays, misses keep their camera ray
+    for (size_t i = 0; i < count; i++) {
+        if (hitted[i]) {
+            glm::vec3 direction = hits[i].normal + Random::UnitSphere();
+            rays[i] = Ray(hits[i].point, glm::length(direction) > 1e-4f ? direction : hits[i].normal, 0.0f);
+        }
+    }
+    seconds = trace(*world, rays, width, hits, hitted);
+    result.secondary = count / seconds * 1e-6f;
+
+    CounterValues counters = Counters::total() - before;
+    result.boxTests = counters[Counter::BoxTests] / (2.0f * count);
+    result.primitiveTests = counters[Counter::PrimitiveTests] / (2.0f * count);
+    return result;
+}
+
+} // namespace
+
+// every backend on every built-in scene, written next to the other profiles
+int runBenchmark(const Options& options) {
+    std::vector<Result> results;
+    for (int scene = 1; scene <= 5; scene++) {
+        for (uint32_t i = 0; i < (uint32_t)Accelerator::Count; i++) {
+            auto result = measure(scene, (Accelerator)i, options.width, options.height);
+            WEN_INFO("scene {} {:>10}: build {:8.2f} ms {:9.1f} KiB, primary {:6.2f} Mrays/s, secondary {:6.2f} Mrays/s, "
+                     "{:6.1f} boxes {:6.1f} primitives per ray",
+                     scene, acceleratorName(result.accelerator), result.build.seconds * 1000.0f,
+                     result.build.bytes / 1024.0f, result.primary, result.secondary, result.boxTests, result.primitiveTests)
+            results.push_back(result);
+        }
+    }
+
+    auto filename = "sandbox/ray_tracing/resources/profile/accelerators.csv";
+    std::filesystem::create_directories(std::filesystem::path(filename).parent_path());
+    std::ofstream file(filename, std::ios::trunc);
+    if (!file.is_open()) {
+        WEN_ERROR("Failed to write {}", filename)
+        return 1;
+    }
+    file << "scene,accelerator,structures,build_ms,bytes,primary_mrays,secondary_mrays,box_tests,primitive_tests\n";
+    for (const auto& result : results) {
+        file << result.scene << "," << acceleratorName(result.accelerator) << "," << result.build.structures << ","
+             << result.build.seconds * 1000.0f << "," << result.build.bytes << "," << result.primary << ","
+             << result.secondary << "," << result.boxTests << "," << result.primitiveTests << "\n";
+    }
+    WEN_INFO("Accelerator benchmark written to {}", filename)
+    return 0;
+}
\ No newline at end of file
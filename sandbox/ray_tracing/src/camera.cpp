@@ -78,6 +78,12 @@ bool Camera::update(float ts) {
     return moved;
 }
 
+void Camera::set(const glm::vec3& position, const glm::vec3& direction) {
+    this->position = position;
+    this->direction = direction;
+    view = glm::lookAt(position, position + direction, glm::vec3(0.0f, 1.0f, 0.0f));
+}
+
 void Camera::resize(uint32_t width, uint32_t height) {
     if (width_ == width && height_ == height) {
         return;
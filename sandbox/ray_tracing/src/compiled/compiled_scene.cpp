@@ -0,0 +1,759 @@
+#include "compiled/compiled_scene.hpp"
+#include "hittable/bvh.hpp"
+#include "hittable/packed_bvh.hpp"
+#include "hittable/compressed_bvh.hpp"
+#include "hittable/sphere.hpp"
+#include "hittable/quad.hpp"
+#include "hittable/transform.hpp"
+#include "hittable/constant_medium.hpp"
+#include "resources/material.hpp"
+
+namespace {
+
+HitRecord record(const SurfaceHit& hit) {
+    HitRecord hitRecord;
+    hitRecord.t = hit.t;
+    hitRecord.point = hit.point;
+    hitRecord.normal = hit.normal;
+    hitRecord.inside = hit.inside;
+    hitRecord.u = hit.u;
+    hitRecord.v = hit.v;
+    return hitRecord;
+}
+
+void setNormal(SurfaceHit& hit, const Ray& ray, const glm::vec3& outward) {
+    hit.inside = glm::dot(ray.direction, outward) < 0;
+    hit.normal = hit.inside ? outward : -outward;
+}
+
+MicrofacetBSDF microfacet(const CompiledScatter& scatter, const glm::vec3& normal) {
+    return MicrofacetBSDF(normal, scatter.wo, scatter.alpha, scatter.eta, scatter.f0);
+}
+
+template<MaterialType Type>
+using MaterialTag = std::integral_constant<MaterialType, Type>;
+
+template<typename F>
+decltype(auto) dispatch(MaterialType type, F&& f) {
+    switch (type) {
+        case MaterialType::Lambertian: return f(MaterialTag<MaterialType::Lambertian>());
+        case MaterialType::Metal: return f(MaterialTag<MaterialType::Metal>());
+        case MaterialType::Dielectric: return f(MaterialTag<MaterialType::Dielectric>());
+        case MaterialType::DiffuseLight: return f(MaterialTag<MaterialType::DiffuseLight>());
+        case MaterialType::Isotropic: return f(MaterialTag<MaterialType::Isotropic>());
+        case MaterialType::Conductor: return f(MaterialTag<MaterialType::Conductor>());
+        case MaterialType::RoughDielectric: return f(MaterialTag<MaterialType::RoughDielectric>());
+        default: return f(MaterialTag<MaterialType::Virtual>());
+    }
+}
+
+// one kernel per material, mirroring the virtual implementations in resources/material.hpp
+struct KernelDefaults {
+    static glm::vec3 emitted(const CompiledScene&, const CompiledMaterial&, const SurfaceHit&) { return glm::vec3(0.0f); }
+    static float pdf(const CompiledMaterial&, const SurfaceHit&, const glm::vec3&) { return 0.0f; }
+};
+
+template<MaterialType Type>
+struct Kernel;
+
+template<>
+struct Kernel<MaterialType::Lambertian> : KernelDefaults {
+    static bool scatter(const CompiledScene& scene, const CompiledMaterial& material, const Ray& rayIn, const SurfaceHit& hit, CompiledScatter& scatter) {
+        scatter.attenuation = scene.texture(material.texture, hit.u, hit.v, hit.point);
+        scatter.lobe = Lobe::Cosine;
+        scatter.rayOut = Ray(hit.point, hit.normal + Random::UnitSphere(), rayIn.time);
+        return true;
+    }
+
+    static float pdf(const CompiledMaterial&, const SurfaceHit& hit, const glm::vec3& direction) {
+        return glm::max(0.0f, glm::dot(hit.normal, direction) / glm::pi<float>());
+    }
+};
+
+template<>
+struct Kernel<MaterialType::Metal> : KernelDefaults {
+    static bool scatter(const CompiledScene&, const CompiledMaterial& material, const Ray& rayIn, const SurfaceHit& hit, CompiledScatter& scatter) {
+        scatter.attenuation = material.albedo;
+        scatter.lobe = Lobe::None;
+        glm::vec3 reflected = glm::reflect(glm::normalize(rayIn.direction), hit.normal);
+        glm::vec3 direction = reflected + material.parameter * Random::UnitSphere();
+        scatter.rayOut = Ray(hit.point, glm::normalize(direction), rayIn.time);
+        return true;
+    }
+};
+
+template<>
+struct Kernel<MaterialType::Dielectric> : KernelDefaults {
+    static bool scatter(const CompiledScene&, const CompiledMaterial& material, const Ray& rayIn, const SurfaceHit& hit, CompiledScatter& scatter) {
+        scatter.attenuation = glm::vec3(1.0f);
+        scatter.lobe = Lobe::None;
+
+        float ir = material.parameter;
+        float refractionRatio = hit.inside ? (1.0f / ir) : ir;
+        glm::vec3 unitDirection = glm::normalize(rayIn.direction);
+        float cosTheta = glm::min(glm::dot(-unitDirection, hit.normal), 1.0f);
+        float sinTheta = glm::sqrt(1.0f - cosTheta * cosTheta);
+
+        glm::vec3 direction;
+        if (refractionRatio * sinTheta > 1.0f || Dielectric::reflectance(cosTheta, refractionRatio) > Random::Float()) {
+            direction = glm::reflect(unitDirection, hit.normal);
+        } else {
+            direction = glm::refract(unitDirection, hit.normal, refractionRatio);
+        }
+
+        scatter.rayOut = Ray(hit.point, direction, rayIn.time);
+        return true;
+    }
+};
+
+template<>
+struct Kernel<MaterialType::DiffuseLight> : KernelDefaults {
+    static glm::vec3 emitted(const CompiledScene& scene, const CompiledMaterial& material, const SurfaceHit& hit) {
+        if (!hit.inside) {
+            return glm::vec3(0.0f);
+        }
+        return scene.texture(material.texture, hit.u, hit.v, hit.point);
+    }
+
+    static bool scatter(const CompiledScene&, const CompiledMaterial&, const Ray&, const SurfaceHit&, CompiledScatter&) {
+        return false;
+    }
+};
+
+template<>
+struct Kernel<MaterialType::Isotropic> : KernelDefaults {
+    static bool scatter(const CompiledScene& scene, const CompiledMaterial& material, const Ray& rayIn, const SurfaceHit& hit, CompiledScatter& scatter) {
+        scatter.attenuation = scene.texture(material.texture, hit.u, hit.v, hit.point);
+        scatter.lobe = Lobe::Sphere;
+        scatter.rayOut = Ray(hit.point, Random::UnitSphere(), rayIn.time);
+        return true;
+    }
+
+    static float pdf(const CompiledMaterial&, const SurfaceHit&, const glm::vec3&) {
+        return 1.0f / (4.0f * glm::pi<float>());
+    }
+};
+
+template<>
+struct Kernel<MaterialType::Conductor> : KernelDefaults {
+    static bool scatter(const CompiledScene&, const CompiledMaterial& material, const Ray& rayIn, const SurfaceHit& hit, CompiledScatter& scatter) {
+        scatter.lobe = Lobe::Microfacet;
+        scatter.alpha = GGX::alpha(material.roughness);
+        scatter.eta = 0.0f;
+        scatter.f0 = material.albedo;
+        glm::vec3 direction = microfacet(scatter, hit.normal).sample(scatter.attenuation);
+        scatter.rayOut = Ray(hit.point, direction, rayIn.time);
+        return true;
+    }
+};
+
+template<>
+struct Kernel<MaterialType::RoughDielectric> : KernelDefaults {
+    static bool scatter(const CompiledScene&, const CompiledMaterial& material, const Ray& rayIn, const SurfaceHit& hit, CompiledScatter& scatter) {
+        scatter.lobe = Lobe::Microfacet;
+        scatter.alpha = GGX::alpha(material.roughness);
+        scatter.eta = hit.inside ? material.parameter : 1.0f / material.parameter;
+        scatter.f0 = glm::vec3(1.0f);
+        glm::vec3 direction = microfacet(scatter, hit.normal).sample(scatter.attenuation);
+        scatter.rayOut = Ray(hit.point, direction, rayIn.time);
+        return true;
+    }
+};
+
+template<>
+struct Kernel<MaterialType::Virtual> {
+    static glm::vec3 emitted(const CompiledScene&, const CompiledMaterial& material, const SurfaceHit& hit) {
+        return material.source->emitted(record(hit));
+    }
+
+    static bool scatter(const CompiledScene&, const CompiledMaterial& material, const Ray& rayIn, const SurfaceHit& hit, CompiledScatter& scatter) {
+        ScatterRecord scatterRecord;
+        if (!material.source->scatter(rayIn, record(hit), scatterRecord)) {
+            return false;
+        }
+        scatter.attenuation = scatterRecord.attenuation;
+        scatter.lobe = scatterRecord.pdf ? Lobe::Virtual : Lobe::None;
+        scatter.rayOut = scatterRecord.rayOut;
+        scatter.pdf = std::move(scatterRecord.pdf);
+        return true;
+    }
+
+    static float pdf(const CompiledMaterial& material, const SurfaceHit& hit, const glm::vec3& direction) {
+        return material.source->pdf(record(hit), Ray(hit.point, direction));
+    }
+};
+
+} // namespace
+
+// Translates the authored graph, groups become BVHs over typed references
+class SceneCompiler {
+public:
+    explicit SceneCompiler(CompiledScene& scene) : scene_(scene) {}
+
+    // the slot is taken before flattening so the world compiled first is always BVH 0
+    uint32_t group(const std::shared_ptr<Hittable>& hittable) {
+        uint32_t index = scene_.bvhs_.size();
+        scene_.bvhs_.emplace_back();
+
+        std::vector<PrimitiveRef> refs;
+        std::vector<AABB> boxes;
+        depth_++;
+        flatten(hittable, refs, boxes);
+        depth_--;
+
+        CompiledBVH bvh;
+        std::vector<uint32_t> order;
+        bvh.nodes = FlatBVH::build(boxes, order, 4);
+        bvh.refs.reserve(order.size());
+        for (uint32_t i : order) {
+            bvh.refs.push_back(refs[i]);
+        }
+
+        scene_.bvhs_[index] = std::move(bvh);
+        return index;
+    }
+
+    uint32_t sphere(const glm::vec3& center, float radius, const glm::vec3& velocity, const std::shared_ptr<Material>& material) {
+        scene_.spheres_.push_back({center, radius, velocity, this->material(material)});
+        return scene_.spheres_.size() - 1;
+    }
+
+    uint32_t quad(const glm::vec3& Q, const glm::vec3& u, const glm::vec3& v, const std::shared_ptr<Material>& material) {
+        glm::vec3 n = glm::cross(u, v);
+        CompiledQuad quad;
+        quad.Q = Q;
+        quad.u = u;
+        quad.v = v;
+        quad.normal = glm::normalize(n);
+        quad.D = glm::dot(quad.normal, Q);
+        quad.w = n / glm::dot(n, n);
+        quad.area = glm::length(n);
+        quad.material = this->material(material);
+        scene_.quads_.push_back(quad);
+        return scene_.quads_.size() - 1;
+    }
+
+    // a light quad may carry no material, it only takes part in light sampling and stays without a handle
+    uint32_t material(const std::shared_ptr<Material>& material) {
+        if (!material) {
+            return invalidHandle;
+        }
+
+        auto it = scene_.materialHandles_.find(material.get());
+        if (it != scene_.materialHandles_.end()) {
+            return it->second;
+        }
+
+        CompiledMaterial compiled = {MaterialType::Virtual, invalidHandle, glm::vec3(0.0f), 0.0f, 0.0f, material.get()};
+        if (auto lambertian = std::dynamic_pointer_cast<Lambertian>(material)) {
+            compiled.type = MaterialType::Lambertian;
+            compiled.texture = texture(lambertian->albedo);
+        } else if (auto metal = std::dynamic_pointer_cast<Metal>(material)) {
+            compiled.type = MaterialType::Metal;
+            compiled.albedo = metal->albedo;
+            compiled.parameter = metal->roughness;
+        } else if (auto dielectric = std::dynamic_pointer_cast<Dielectric>(material)) {
+            compiled.type = MaterialType::Dielectric;
+            compiled.parameter = dielectric->ir;
+        } else if (auto conductor = std::dynamic_pointer_cast<Conductor>(material)) {
+            compiled.type = MaterialType::Conductor;
+            compiled.albedo = conductor->albedo;
+            compiled.roughness = conductor->roughness;
+        } else if (auto dielectric = std::dynamic_pointer_cast<RoughDielectric>(material)) {
+            compiled.type = MaterialType::RoughDielectric;
+            compiled.parameter = dielectric->ir;
+            compiled.roughness = dielectric->roughness;
+        } else if (auto light = std::dynamic_pointer_cast<DiffuseLight>(material)) {
+            compiled.type = MaterialType::DiffuseLight;
+            compiled.texture = texture(light->emit);
+        } else if (auto isotropic = std::dynamic_pointer_cast<Isotropic>(material)) {
+            compiled.type = MaterialType::Isotropic;
+            compiled.texture = texture(isotropic->albedo);
+        }
+
+        scene_.materials_.push_back(compiled);
+        uint32_t handle = scene_.materials_.size() - 1;
+        scene_.materialHandles_[material.get()] = handle;
+        return handle;
+    }
+
+    uint32_t texture(const std::shared_ptr<Texture>& texture) {
+        auto it = textureHandles_.find(texture.get());
+        if (it != textureHandles_.end()) {
+            return it->second;
+        }
+
+        CompiledTexture compiled = {TextureType::Virtual, glm::vec3(0.0f), 0.0f, invalidHandle, invalidHandle, texture.get()};
+        if (auto solid = std::dynamic_pointer_cast<SolidColor>(texture)) {
+            compiled.type = TextureType::Solid;
+            compiled.color = solid->color();
+        } else if (auto chessboard = std::dynamic_pointer_cast<ChessboardTexture>(texture)) {
+            compiled.type = TextureType::Chessboard;
+            compiled.scale = chessboard->scale();
+            compiled.odd = this->texture(chessboard->odd());
+            compiled.even = this->texture(chessboard->even());
+        } else if (std::dynamic_pointer_cast<ImageTexture>(texture)) {
+            compiled.type = TextureType::Image;
+        } else if (std::dynamic_pointer_cast<NoiseTexture>(texture)) {
+            compiled.type = TextureType::Noise;
+        }
+
+        scene_.textures_.push_back(compiled);
+        uint32_t handle = scene_.textures_.size() - 1;
+        textureHandles_[texture.get()] = handle;
+        return handle;
+    }
+
+private:
+    // the nodes are taken as they are, so every primitive has to compile to exactly one reference
+    void dynamic(const FlatBVH& flat) {
+        uint32_t index = scene_.bvhs_.size();
+        scene_.bvhs_.emplace_back();
+
+        CompiledBVH bvh;
+        bvh.nodes = flat.nodes;
+        bvh.refs.reserve(flat.primitives.size());
+        depth_++;
+        for (const auto& primitive : flat.primitives) {
+            std::vector<PrimitiveRef> refs;
+            std::vector<AABB> boxes;
+            flatten(primitive, refs, boxes);
+            if (refs.size() != 1) {
+                scene_.virtuals_.push_back(primitive);
+                refs.assign(1, {PrimitiveType::Virtual, uint32_t(scene_.virtuals_.size() - 1)});
+            }
+            bvh.refs.push_back(refs[0]);
+            scene_.dynamicRefs_[primitive.get()] = refs[0];
+        }
+        depth_--;
+
+        scene_.bvhs_[index] = std::move(bvh);
+        scene_.dynamic_.push_back({&flat, index, flat.revision()});
+    }
+
+    void flatten(const std::shared_ptr<Hittable>& hittable, std::vector<PrimitiveRef>& refs, std::vector<AABB>& boxes) {
+        auto add = [&](PrimitiveType type, uint32_t index, const AABB& aabb) {
+            refs.push_back({type, index});
+            boxes.push_back(aabb);
+        };
+
+        if (auto list = std::dynamic_pointer_cast<HittableList>(hittable)) {
+            for (const auto& child : list->hittables) {
+                flatten(child, refs, boxes);
+            }
+        } else if (auto bvh = std::dynamic_pointer_cast<BVH>(hittable)) {
+            flatten(bvh->left, refs, boxes);
+            if (bvh->right != bvh->left) {
+                flatten(bvh->right, refs, boxes);
+            }
+        } else if (auto flat = std::dynamic_pointer_cast<FlatBVH>(hittable); flat && flat->dynamic) {
+            // refits change its bounds, in the world it is tested next to BVH 0 instead of inside it,
+            // below an instance the bounds compiled now are kept
+            if (depth_ == 1) {
+                dynamic(*flat);
+            } else {
+                scene_.virtuals_.push_back(hittable);
+                add(PrimitiveType::Virtual, scene_.virtuals_.size() - 1, hittable->aabb);
+            }
+        } else if (auto flat = std::dynamic_pointer_cast<FlatBVH>(hittable)) {
+            for (const auto& primitive : flat->primitives) {
+                flatten(primitive, refs, boxes);
+            }
+        } else if (auto compressed = std::dynamic_pointer_cast<CompressedBVH>(hittable)) {
+            for (const auto& primitive : compressed->primitives) {
+                flatten(primitive, refs, boxes);
+            }
+        } else if (auto packed = std::dynamic_pointer_cast<PackedBVH>(hittable)) {
+            const auto& s = packed->spheres;
+            for (uint32_t i = 0; i < s.size(); i++) {
+                glm::vec3 center(s.x[i], s.y[i], s.z[i]);
+                uint32_t index = sphere(center, s.radius[i], glm::vec3(0.0f), s.materials[i]);
+                add(PrimitiveType::Sphere, index, AABB(center - glm::vec3(s.radius[i]), center + glm::vec3(s.radius[i])));
+            }
+            const auto& q = packed->quads;
+            for (uint32_t i = 0; i < q.size(); i++) {
+                glm::vec3 Q(q.qx[i], q.qy[i], q.qz[i]), u(q.ux[i], q.uy[i], q.uz[i]), v(q.vx[i], q.vy[i], q.vz[i]);
+                uint32_t index = quad(Q, u, v, q.materials[i]);
+                add(PrimitiveType::Quad, index, AABB(AABB(Q, Q + u + v), AABB(Q + u, Q + v)));
+            }
+            for (const auto& other : packed->others) {
+                flatten(other, refs, boxes);
+            }
+        } else if (auto s = std::dynamic_pointer_cast<Sphere>(hittable)) {
+            add(PrimitiveType::Sphere, sphere(s->position, s->radius, s->moving ? s->direction : glm::vec3(0.0f), s->material), s->aabb);
+        } else if (auto q = std::dynamic_pointer_cast<Quad>(hittable)) {
+            add(PrimitiveType::Quad, quad(q->Q, q->u, q->v, q->material), q->aabb);
+        } else if (auto translate = std::dynamic_pointer_cast<Translate>(hittable)) {
+            CompiledInstance instance = {translate->offset(), 0.0f, 1.0f, 0};
+            auto child = translate->hittable();
+            if (auto rotate = std::dynamic_pointer_cast<Rotate>(child)) {
+                instance.sinTheta = rotate->sinTheta();
+                instance.cosTheta = rotate->cosTheta();
+                child = rotate->hittable();
+            }
+            instance.bvh = group(child);
+            scene_.instances_.push_back(instance);
+            add(PrimitiveType::Instance, scene_.instances_.size() - 1, translate->aabb);
+        } else if (auto rotate = std::dynamic_pointer_cast<Rotate>(hittable)) {
+            CompiledInstance instance = {glm::vec3(0.0f), rotate->sinTheta(), rotate->cosTheta(), group(rotate->hittable())};
+            scene_.instances_.push_back(instance);
+            add(PrimitiveType::Instance, scene_.instances_.size() - 1, rotate->aabb);
+        } else if (auto medium = std::dynamic_pointer_cast<ConstantMedium>(hittable)) {
+            // ConstantMedium leaves its own box empty, the boundary bounds it
+            CompiledMedium compiled = {group(medium->boundary()), medium->negInvDensity(), material(medium->phase())};
+            scene_.media_.push_back(compiled);
+            add(PrimitiveType::Medium, scene_.media_.size() - 1, medium->boundary()->aabb);
+        } else {
+            scene_.virtuals_.push_back(hittable);
+            add(PrimitiveType::Virtual, scene_.virtuals_.size() - 1, hittable->aabb);
+        }
+    }
+
+private:
+    CompiledScene& scene_;
+    std::unordered_map<const Texture*, uint32_t> textureHandles_;
+    uint32_t depth_ = 0;
+};
+
+CompiledScene::CompiledScene(const std::shared_ptr<HittableList>& world, const std::shared_ptr<HittableList>& lights)
+    : world_(world), lights_(lights) {
+    SceneCompiler compiler(*this);
+    compiler.group(world);
+
+    hasLights_ = lights != nullptr;
+    if (lights) {
+        for (const auto& light : lights->hittables) {
+            if (auto quad = std::dynamic_pointer_cast<Quad>(light)) {
+                lightQuads_.push_back(compiler.quad(quad->Q, quad->u, quad->v, quad->material));
+            } else {
+                virtualLights_.push_back(light);
+            }
+        }
+    }
+}
+
+template<>
+bool CompiledScene::intersect<PrimitiveType::Sphere>(uint32_t index, const Ray& ray, Interval t, SurfaceHit& hit) const {
+    const auto& sphere = spheres_[index];
+    Counters::add(Counter::PrimitiveTests);
+    glm::vec3 center = sphere.center + sphere.velocity * ray.time;
+    glm::vec3 origin = center - ray.origin;
+
+    float a = glm::dot(ray.direction, ray.direction);
+    float h = glm::dot(ray.direction, origin);
+    float c = glm::dot(origin, origin) - sphere.radius * sphere.radius;
+
+    float discriminant = h * h - a * c;
+    if (discriminant < 0.0f) {
+        return false;
+    }
+
+    float sqrtd = glm::sqrt(discriminant);
+    float root = (h - sqrtd) / a;
+    if (!t.inside(root)) {
+        root = (h + sqrtd) / a;
+        if (!t.inside(root)) {
+            return false;
+        }
+    }
+
+    hit.t = root;
+    hit.point = ray.hitPoint(root);
+    glm::vec3 normal = (hit.point - center) / sphere.radius;
+    setNormal(hit, ray, normal);
+    hit.material = sphere.material;
+    Sphere::uv(normal, hit.u, hit.v);
+    return true;
+}
+
+template<>
+bool CompiledScene::intersect<PrimitiveType::Quad>(uint32_t index, const Ray& ray, Interval t, SurfaceHit& hit) const {
+    const auto& quad = quads_[index];
+    Counters::add(Counter::PrimitiveTests);
+    float denominator = glm::dot(quad.normal, ray.direction);
+    if (glm::abs(denominator) < 1e-8) {
+        return false;
+    }
+
+    float root = (quad.D - glm::dot(quad.normal, ray.origin)) / denominator;
+    if (!t.contains(root)) {
+        return false;
+    }
+
+    glm::vec3 point = ray.hitPoint(root);
+    glm::vec3 p = point - quad.Q;
+    float alpha = glm::dot(quad.w, glm::cross(p, quad.v));
+    float beta = glm::dot(quad.w, glm::cross(quad.u, p));
+    if (alpha < 0.0f || 1.0f < alpha || beta < 0.0f || 1.0f < beta) {
+        return false;
+    }
+
+    hit.t = root;
+    hit.point = point;
+    hit.u = alpha;
+    hit.v = beta;
+    setNormal(hit, ray, quad.normal);
+    hit.material = quad.material;
+    return true;
+}
+
+template<>
+bool CompiledScene::intersect<PrimitiveType::Instance>(uint32_t index, const Ray& ray, Interval t, SurfaceHit& hit) const {
+    const auto& instance = instances_[index];
+    float s = instance.sinTheta, c = instance.cosTheta;
+
+    glm::vec3 origin = ray.origin - instance.offset;
+    glm::vec3 direction = ray.direction;
+    Ray local(glm::vec3(c * origin.x - s * origin.z, origin.y, s * origin.x + c * origin.z),
+              glm::vec3(c * direction.x - s * direction.z, direction.y, s * direction.x + c * direction.z), ray.time);
+    if (!this->hit(instance.bvh, local, t, hit)) {
+        return false;
+    }
+
+    glm::vec3 p = hit.point, n = hit.normal;
+    hit.point = glm::vec3(c * p.x + s * p.z, p.y, -s * p.x + c * p.z) + instance.offset;
+    hit.normal = glm::vec3(c * n.x + s * n.z, n.y, -s * n.x + c * n.z);
+    return true;
+}
+
+template<>
+bool CompiledScene::intersect<PrimitiveType::Medium>(uint32_t index, const Ray& ray, Interval t, SurfaceHit& hit) const {
+    const auto& medium = media_[index];
+    SurfaceHit enter, exit;
+    if (!this->hit(medium.boundary, ray, Interval::universe, enter)) {
+        return false;
+    }
+    if (!this->hit(medium.boundary, ray, Interval(enter.t + 0.0001f, infinity), exit)) {
+        return false;
+    }
+
+    float t0 = glm::max(enter.t, t.min);
+    float t1 = glm::min(exit.t, t.max);
+    if (t0 >= t1) {
+        return false;
+    }
+    t0 = glm::max(t0, 0.0f);
+
+    float rayLength = glm::length(ray.direction);
+    float distanceInsideBoundary = (t1 - t0) * rayLength;
+    float hitDistance = medium.negInvDensity * std::log(Random::Float());
+    if (hitDistance > distanceInsideBoundary) {
+        return false;
+    }
+
+    hit.t = t0 + hitDistance / rayLength;
+    hit.point = ray.hitPoint(hit.t);
+    hit.normal = glm::vec3(1.0f, 0.0f, 0.0f);
+    hit.inside = true;
+    hit.u = hit.v = 0.0f;
+    hit.material = medium.material;
+    return true;
+}
+
+template<>
+bool CompiledScene::intersect<PrimitiveType::Virtual>(uint32_t index, const Ray& ray, Interval t, SurfaceHit& hit) const {
+    HitRecord hitRecord;
+    if (!virtuals_[index]->hit(ray, t, hitRecord)) {
+        return false;
+    }
+
+    hit.t = hitRecord.t;
+    hit.point = hitRecord.point;
+    hit.normal = hitRecord.normal;
+    hit.inside = hitRecord.inside;
+    hit.u = hitRecord.u;
+    hit.v = hitRecord.v;
+    auto it = materialHandles_.find(hitRecord.material.get());
+    hit.material = it != materialHandles_.end() ? it->second : invalidHandle;
+    hit.source = hitRecord.material.get();
+    return true;
+}
+
+bool CompiledScene::hit(uint32_t bvh, const Ray& ray, Interval t, SurfaceHit& hit) const {
+    const auto& tree = bvhs_[bvh];
+    if (tree.refs.empty()) {
+        return false;
+    }
+    return FlatBVH::traverse(tree.nodes, ray, t, [&](uint32_t i, Interval& range) {
+        const auto& ref = tree.refs[i];
+        bool hitted = false;
+        switch (ref.type) {
+            case PrimitiveType::Sphere: hitted = intersect<PrimitiveType::Sphere>(ref.index, ray, range, hit); break;
+            case PrimitiveType::Quad: hitted = intersect<PrimitiveType::Quad>(ref.index, ray, range, hit); break;
+            case PrimitiveType::Instance: hitted = intersect<PrimitiveType::Instance>(ref.index, ray, range, hit); break;
+            case PrimitiveType::Medium: hitted = intersect<PrimitiveType::Medium>(ref.index, ray, range, hit); break;
+            case PrimitiveType::Virtual: hitted = intersect<PrimitiveType::Virtual>(ref.index, ray, range, hit); break;
+        }
+        if (hitted) {
+            range.max = hit.t;
+        }
+        return hitted;
+    });
+}
+
+bool CompiledScene::hit(const Ray& ray, Interval t, SurfaceHit& hit) const {
+    hit.source = nullptr;
+    bool hitted = this->hit(0, ray, t, hit);
+    if (hitted) {
+        t.max = hit.t;
+    }
+    for (const auto& dynamic : dynamic_) {
+        if (this->hit(dynamic.bvh, ray, t, hit)) {
+            t.max = hit.t;
+            hitted = true;
+        }
+    }
+    return hitted;
+}
+
+bool CompiledScene::refresh() {
+    bool changed = false;
+    for (auto& dynamic : dynamic_) {
+        const FlatBVH& source = *dynamic.source;
+        if (dynamic.revision == source.revision()) {
+            continue;
+        }
+        dynamic.revision = source.revision();
+        changed = true;
+
+        // rebuilds reorder the primitives, refits only move them
+        auto& bvh = bvhs_[dynamic.bvh];
+        bvh.nodes = source.nodes;
+        for (size_t i = 0; i < source.primitives.size(); i++) {
+            const Hittable* primitive = source.primitives[i].get();
+            PrimitiveRef ref = dynamicRefs_.at(primitive);
+            bvh.refs[i] = ref;
+            if (auto sphere = dynamic_cast<const Sphere*>(primitive); sphere && ref.type == PrimitiveType::Sphere) {
+                spheres_[ref.index].center = sphere->position;
+                spheres_[ref.index].velocity = sphere->moving ? sphere->direction : glm::vec3(0.0f);
+            } else if (auto translate = dynamic_cast<const Translate*>(primitive); translate && ref.type == PrimitiveType::Instance) {
+                instances_[ref.index].offset = translate->offset();
+            }
+        }
+    }
+    return changed;
+}
+
+glm::vec3 CompiledScene::emitted(const SurfaceHit& hit) const {
+    if (hit.material == invalidHandle) {
+        return hit.source ? hit.source->emitted(record(hit)) : glm::vec3(0.0f);
+    }
+    const auto& material = materials_[hit.material];
+    return dispatch(material.type, [&](auto type) {
+        return Kernel<decltype(type)::value>::emitted(*this, material, hit);
+    });
+}
+
+bool CompiledScene::scatter(const Ray& rayIn, const SurfaceHit& hit, CompiledScatter& scatter) const {
+    scatter.wo = -glm::normalize(rayIn.direction);
+    if (hit.material == invalidHandle) {
+        if (!hit.source) {
+            return false;
+        }
+        CompiledMaterial material = {MaterialType::Virtual, invalidHandle, glm::vec3(0.0f), 0.0f, 0.0f, hit.source};
+        return Kernel<MaterialType::Virtual>::scatter(*this, material, rayIn, hit, scatter);
+    }
+    const auto& material = materials_[hit.material];
+    return dispatch(material.type, [&](auto type) {
+        return Kernel<decltype(type)::value>::scatter(*this, material, rayIn, hit, scatter);
+    });
+}
+
+float CompiledScene::pdf(const SurfaceHit& hit, const glm::vec3& direction) const {
+    if (hit.material == invalidHandle) {
+        return hit.source ? hit.source->pdf(record(hit), Ray(hit.point, direction)) : 0.0f;
+    }
+    const auto& material = materials_[hit.material];
+    return dispatch(material.type, [&](auto type) {
+        return Kernel<decltype(type)::value>::pdf(material, hit, direction);
+    });
+}
+
+glm::vec3 CompiledScene::evaluate(const SurfaceHit& hit, const CompiledScatter& scatter, const glm::vec3& direction) const {
+    switch (scatter.lobe) {
+        case Lobe::Microfacet:
+            return microfacet(scatter, hit.normal).evaluate(direction);
+        case Lobe::Virtual: {
+            const Material* source = hit.material == invalidHandle ? hit.source : materials_[hit.material].source;
+            ScatterRecord scatterRecord = {scatter.attenuation, scatter.pdf, scatter.rayOut};
+            return source->evaluate(Ray(hit.point, -scatter.wo), record(hit), scatterRecord, Ray(hit.point, direction));
+        }
+        default:
+            return scatter.attenuation * pdf(hit, direction);
+    }
+}
+
+glm::vec3 CompiledScene::texture(uint32_t index, float u, float v, const glm::vec3& point) const {
+    // chessboards only pick another handle, so nested textures resolve in a loop
+    while (true) {
+        const auto& texture = textures_[index];
+        switch (texture.type) {
+            case TextureType::Solid:
+                return texture.color;
+            case TextureType::Chessboard: {
+                glm::ivec3 cell = glm::ivec3(glm::floor(1.0f / texture.scale * point));
+                index = (cell.x + cell.y + cell.z) % 2 == 0 ? texture.even : texture.odd;
+                continue;
+            }
+            case TextureType::Image:
+                return static_cast<const ImageTexture*>(texture.source)->ImageTexture::value(u, v, point);
+            case TextureType::Noise:
+                return static_cast<const NoiseTexture*>(texture.source)->NoiseTexture::value(u, v, point);
+            case TextureType::Virtual:
+                return texture.source->value(u, v, point);
+        }
+    }
+}
+
+glm::vec3 CompiledScene::sample(const CompiledScatter& scatter, const glm::vec3& normal) {
+    switch (scatter.lobe) {
+        case Lobe::Cosine: return CosinePDF(normal).generate();
+        case Lobe::Sphere: return SpherePDF().generate();
+        case Lobe::Microfacet: return microfacet(scatter, normal).sample();
+        case Lobe::Virtual: return scatter.pdf->generate();
+        default: return normal;
+    }
+}
+
+float CompiledScene::value(const CompiledScatter& scatter, const glm::vec3& normal, const glm::vec3& direction) {
+    switch (scatter.lobe) {
+        case Lobe::Cosine: return CosinePDF(normal).value(direction);
+        case Lobe::Sphere: return SpherePDF().value(direction);
+        case Lobe::Microfacet: return microfacet(scatter, normal).pdf(direction);
+        case Lobe::Virtual: return scatter.pdf->value(direction);
+        default: return 0.0f;
+    }
+}
+
+glm::vec3 CompiledScene::sampleLight(const glm::vec3& origin) const {
+    uint32_t count = lightQuads_.size() + virtualLights_.size();
+    uint32_t index = Random::UInt(0, count - 1);
+    if (index < lightQuads_.size()) {
+        const auto& quad = quads_[lightQuads_[index]];
+        return quad.Q + quad.u * Random::Float() + quad.v * Random::Float() - origin;
+    }
+    return virtualLights_[index - lightQuads_.size()]->random(origin);
+}
+
+float CompiledScene::lightPdf(const glm::vec3& origin, const glm::vec3& direction) const {
+    Counters::add(Counter::ShadowRays);
+    uint32_t count = lightQuads_.size() + virtualLights_.size();
+    if (count == 0) {
+        return 0.0f;
+    }
+
+    float sum = 0.0f;
+    for (uint32_t index : lightQuads_) {
+        SurfaceHit hit;
+        if (!intersect<PrimitiveType::Quad>(index, Ray(origin, direction), Interval(0.001f, infinity), hit)) {
+            continue;
+        }
+        float distance2 = hit.t * hit.t * glm::dot(direction, direction);
+        float cosTheta = glm::abs(glm::dot(direction, hit.normal)) / glm::length(direction);
+        sum += distance2 / (cosTheta * quads_[index].area);
+    }
+    for (const auto& light : virtualLights_) {
+        sum += light->pdfValue(origin, direction);
+    }
+    return sum / (float)count;
+}
\ No newline at end of file
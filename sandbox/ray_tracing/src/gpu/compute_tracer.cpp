@@ -0,0 +1,243 @@
+#include "gpu/compute_tracer.hpp"
+#include <wen.hpp>
+#include <interface.hpp>
+#include <command_pool.hpp>
+
+namespace {
+
+const char* resources = "sandbox/ray_tracing/resources";
+constexpr uint32_t groupSize = 8;
+
+// std140 block `Frame` of the kernel
+struct FrameUniform {
+    glm::mat4 inverseProjection;
+    glm::mat4 inverseView;
+    glm::vec4 position;
+    glm::vec4 background;
+    uint32_t width, height, sqrtSpp, samples;
+    uint32_t seed, index, maxDepth, root;
+    uint32_t lightCount, pad0, pad1, pad2;
+};
+
+} // namespace
+
+ComputeTracer::ComputeTracer() {
+    if (!wen::manager) {
+        WEN_ERROR("Compute tracer unavailable: the renderer is not initialized")
+        return;
+    }
+    auto& device = *wen::manager->device;
+    auto properties = device.physicalDevice.getProperties();
+    auto family = device.physicalDevice.getQueueFamilyProperties()[device.computeQueueFamilyIndex];
+    deviceName_ = properties.deviceName.data();
+    timestampPeriod_ = family.timestampValidBits > 0 ? properties.limits.timestampPeriod : 0.0f;
+
+    commandPool_ = std::make_unique<wen::CommandPool>(vk::CommandPoolCreateFlagBits::eResetCommandBuffer, device.computeQueueFamilyIndex);
+    commandBuffer_ = commandPool_->allocateCommandBuffers(1)[0];
+    fence_ = device.device.createFence({});
+    if (timestampPeriod_ > 0.0f) {
+        vk::QueryPoolCreateInfo queryInfo = {};
+        queryInfo.setQueryType(vk::QueryType::eTimestamp)
+            .setQueryCount(2);
+        queryPool_ = device.device.createQueryPool(queryInfo);
+    }
+
+    wen::Interface factory(resources);
+    auto shader = factory.compileShader("path_tracer.comp", wen::ShaderStage::eCompute);
+    if (!shader || !shader->module.has_value()) {
+        WEN_ERROR("Compute tracer unavailable: path_tracer.comp did not compile")
+        return;
+    }
+
+    std::vector<wen::DescriptorInfo> infos;
+    for (uint32_t i = 0; i < scene_.size() + 1; i++) {
+        infos.emplace_back(i, wen::DescriptorType::eStorageBuffer, wen::ShaderStage::eCompute);
+    }
+    infos.emplace_back(scene_.size() + 1, wen::DescriptorType::eUniform, wen::ShaderStage::eCompute);
+    descriptorSet_ = factory.createDescriptorSet();
+    descriptorSet_->addDescriptors(infos).build();
+
+    frame_ = factory.createUniformBuffer(sizeof(FrameUniform));
+    descriptorSet_->bindUniform(scene_.size() + 1, frame_);
+
+    auto program = factory.createComputeShaderProgram();
+    program->setComputeShader(shader);
+    pipeline_ = factory.createComputeRenderPipeline(program);
+    pipeline_->setDescriptorSet(descriptorSet_).compile();
+    WEN_INFO("Compute tracer on {}", deviceName_)
+}
+
+ComputeTracer::~ComputeTracer() {
+    if (!wen::manager) {
+        return;
+    }
+    auto& device = *wen::manager->device;
+    pipeline_.reset();
+    descriptorSet_.reset();
+    for (auto& buffer : scene_) {
+        buffer.reset();
+    }
+    radiance_.reset();
+    readback_.reset();
+    frame_.reset();
+    if (queryPool_) {
+        device.device.destroyQueryPool(queryPool_);
+    }
+    device.device.destroyFence(fence_);
+    commandPool_.reset();
+}
+
+std::shared_ptr<wen::StorageBuffer> ComputeTracer::createStorageBuffer(const void* data, vk::DeviceSize size) {
+    auto buffer = std::make_shared<wen::StorageBuffer>(glm::max(size, (vk::DeviceSize)16), vk::BufferUsageFlagBits::eTransferDst,
+                                                       VMA_MEMORY_USAGE_AUTO_PREFER_DEVICE, 0);
+    if (size == 0) {
+        return buffer;
+    }
+
+    // staged here rather than through the upload manager, which belongs to the main thread
+    wen::Buffer staging(size, vk::BufferUsageFlagBits::eTransferSrc, VMA_MEMORY_USAGE_AUTO_PREFER_HOST,
+                        VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT);
+    memcpy(staging.map(), data, size);
+    staging.flush(0, size);
+    submit([&](vk::CommandBuffer cmdbuf) {
+        vk::BufferCopy region = {};
+        region.setSize(size);
+        cmdbuf.copyBuffer(staging.buffer, buffer->getBuffer(), region);
+    });
+    return buffer;
+}
+
+void ComputeTracer::submit(const std::function<void(vk::CommandBuffer)>& record) {
+    auto& device = *wen::manager->device;
+    commandBuffer_.reset();
+    vk::CommandBufferBeginInfo beginInfo = {};
+    beginInfo.setFlags(vk::CommandBufferUsageFlagBits::eOneTimeSubmit);
+    commandBuffer_.begin(beginInfo);
+    record(commandBuffer_);
+    commandBuffer_.end();
+
+    vk::SubmitInfo submitInfo = {};
+    submitInfo.setCommandBuffers(commandBuffer_);
+    {
+        std::lock_guard<std::mutex> lock(device.queueMutex);
+        device.computeQueue.submit(submitInfo, fence_);
+    }
+    auto result = device.device.waitForFences(fence_, true, UINT64_MAX);
+    if (result != vk::Result::eSuccess) {
+        WEN_ERROR("Failed to wait for the compute fence")
+    }
+    device.device.resetFences(fence_);
+}
+
+void ComputeTracer::upload(const GPUScene& scene) {
+    if (!valid()) {
+        return;
+    }
+    // every submission is waited for, nothing in flight still reads the old buffers
+    auto bytes = [](const auto& values) { return (vk::DeviceSize)(values.size() * sizeof(values[0])); };
+    scene_[0] = createStorageBuffer(scene.nodes.data(), bytes(scene.nodes));
+    scene_[1] = createStorageBuffer(scene.refs.data(), bytes(scene.refs));
+    scene_[2] = createStorageBuffer(scene.spheres.data(), bytes(scene.spheres));
+    scene_[3] = createStorageBuffer(scene.quads.data(), bytes(scene.quads));
+    scene_[4] = createStorageBuffer(scene.instances.data(), bytes(scene.instances));
+    scene_[5] = createStorageBuffer(scene.materials.data(), bytes(scene.materials));
+    scene_[6] = createStorageBuffer(scene.textures.data(), bytes(scene.textures));
+    scene_[7] = createStorageBuffer(scene.lights.data(), bytes(scene.lights));
+    for (uint32_t i = 0; i < scene_.size(); i++) {
+        descriptorSet_->bindStorageBuffer(i + 1, scene_[i]);
+    }
+    root_ = scene.root;
+    lightCount_ = scene.lights.size();
+}
+
+void ComputeTracer::resize(uint32_t width, uint32_t height) {
+    if (width_ == width && height_ == height && radiance_) {
+        return;
+    }
+    width_ = width;
+    height_ = height;
+    vk::DeviceSize size = (vk::DeviceSize)width * height * sizeof(glm::vec4);
+    radiance_ = std::make_shared<wen::StorageBuffer>(size, vk::BufferUsageFlagBits::eTransferSrc, VMA_MEMORY_USAGE_AUTO_PREFER_DEVICE, 0);
+    readback_ = std::make_unique<wen::Buffer>(size, vk::BufferUsageFlagBits::eTransferDst, VMA_MEMORY_USAGE_AUTO_PREFER_HOST,
+                                              VMA_ALLOCATION_CREATE_HOST_ACCESS_RANDOM_BIT);
+    readback_->map();
+    descriptorSet_->bindStorageBuffer(0, radiance_);
+}
+
+bool ComputeTracer::trace(const Camera& camera, const Pass& pass, glm::vec4* radiance) {
+    if (!valid() || !scene_[0] || pass.width == 0 || pass.height == 0) {
+        return false;
+    }
+    try {
+        resize(pass.width, pass.height);
+
+        FrameUniform frame = {};
+        frame.inverseProjection = glm::inverse(camera.projection);
+        frame.inverseView = glm::inverse(camera.view);
+        frame.position = glm::vec4(camera.position, 1.0f);
+        frame.background = glm::vec4(pass.background, 0.0f);
+        frame.width = pass.width;
+        frame.height = pass.height;
+        frame.sqrtSpp = pass.sqrtSpp;
+        frame.samples = pass.samples;
+        frame.seed = pass.seed;
+        frame.index = pass.index;
+        frame.maxDepth = pass.maxDepth;
+        frame.root = root_;
+        frame.lightCount = lightCount_;
+        memcpy(frame_->getData(), &frame, sizeof(FrameUniform));
+
+        vk::DeviceSize size = (vk::DeviceSize)pass.width * pass.height * sizeof(glm::vec4);
+        submit([&](vk::CommandBuffer cmdbuf) {
+            if (queryPool_) {
+                cmdbuf.resetQueryPool(queryPool_, 0, 2);
+                cmdbuf.writeTimestamp(vk::PipelineStageFlagBits::eTopOfPipe, queryPool_, 0);
+            }
+            pipeline_->bind(cmdbuf, vk::PipelineBindPoint::eCompute);
+            cmdbuf.dispatch((pass.width + groupSize - 1) / groupSize, (pass.height + groupSize - 1) / groupSize, 1);
+            if (queryPool_) {
+                cmdbuf.writeTimestamp(vk::PipelineStageFlagBits::eBottomOfPipe, queryPool_, 1);
+            }
+
+            vk::BufferMemoryBarrier barrier = {};
+            barrier.setSrcAccessMask(vk::AccessFlagBits::eShaderWrite)
+                .setDstAccessMask(vk::AccessFlagBits::eTransferRead)
+                .setSrcQueueFamilyIndex(vk::QueueFamilyIgnored)
+                .setDstQueueFamilyIndex(vk::QueueFamilyIgnored)
+                .setBuffer(radiance_->getBuffer())
+                .setOffset(0)
+                .setSize(size);
+            cmdbuf.pipelineBarrier(vk::PipelineStageFlagBits::eComputeShader, vk::PipelineStageFlagBits::eTransfer, {}, {}, barrier, {});
+
+            vk::BufferCopy region = {};
+            region.setSize(size);
+            cmdbuf.copyBuffer(radiance_->getBuffer(), readback_->buffer, region);
+
+            vk::BufferMemoryBarrier host = {};
+            host.setSrcAccessMask(vk::AccessFlagBits::eTransferWrite)
+                .setDstAccessMask(vk::AccessFlagBits::eHostRead)
+                .setSrcQueueFamilyIndex(vk::QueueFamilyIgnored)
+                .setDstQueueFamilyIndex(vk::QueueFamilyIgnored)
+                .setBuffer(readback_->buffer)
+                .setOffset(0)
+                .setSize(size);
+            cmdbuf.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eHost, {}, {}, host, {});
+        });
+
+        if (queryPool_) {
+            uint64_t timestamps[2] = {};
+            auto result = wen::manager->device->device.getQueryPoolResults(queryPool_, 0, 2, sizeof(timestamps), timestamps, sizeof(uint64_t),
+                                                                          vk::QueryResultFlagBits::e64 | vk::QueryResultFlagBits::eWait);
+            if (result == vk::Result::eSuccess) {
+                kernelTime_ = (float)((timestamps[1] - timestamps[0]) * (double)timestampPeriod_ * 1e-9);
+            }
+        }
+
+        readback_->invalidate(0, size);
+        memcpy(radiance, readback_->data, size);
+        return true;
+    } catch (const vk::SystemError& error) {
+        WEN_ERROR("Compute pass failed: {}", error.what())
+        return false;
+    }
+}
\ No newline at end of file
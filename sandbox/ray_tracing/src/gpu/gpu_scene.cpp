@@ -0,0 +1,89 @@
+#include "gpu/gpu_scene.hpp"
+#include "resources/textures.hpp"
+
+static_assert(sizeof(FlatNode) == 32, "nodes are uploaded as they are");
+static_assert(sizeof(GPUSphere) == 32 && sizeof(GPUQuad) == 80 && sizeof(GPUInstance) == 32);
+static_assert(sizeof(GPUMaterial) == 32 && sizeof(GPUTexture) == 32);
+
+namespace {
+
+// mean over a grid of texture coordinates, points spread over a few units for solid textures
+glm::vec3 average(const Texture& texture) {
+    constexpr int n = 16;
+    glm::vec3 sum(0.0f);
+    for (int i = 0; i < n; i++) {
+        for (int j = 0; j < n; j++) {
+            float u = (i + 0.5f) / n, v = (j + 0.5f) / n;
+            sum += texture.value(u, v, glm::vec3(u, v, 0.5f) * 8.0f);
+        }
+    }
+    return sum / (float)(n * n);
+}
+
+} // namespace
+
+GPUScene::GPUScene(const CompiledScene& scene, bool environment) {
+    // every BVH is appended whole, its offsets become absolute
+    std::vector<uint32_t> roots;
+    for (const auto& bvh : scene.bvhs_) {
+        uint32_t firstNode = nodes.size(), firstRef = refs.size();
+        roots.push_back(bvh.refs.empty() ? invalidHandle : firstNode);
+        for (FlatNode node : bvh.nodes) {
+            node.offset += node.count > 0 ? firstRef : firstNode;
+            nodes.push_back(node);
+        }
+        for (const auto& ref : bvh.refs) {
+            PrimitiveType type = ref.type;
+            if (type == PrimitiveType::Medium || type == PrimitiveType::Virtual) {
+                skipped++;
+            }
+            refs.push_back((uint32_t)type << typeShift | (ref.index & indexMask));
+        }
+    }
+    root = roots.empty() ? invalidHandle : roots[0];
+    skipped += scene.dynamic_.size();
+
+    for (const auto& sphere : scene.spheres_) {
+        spheres.push_back({sphere.center, sphere.radius, sphere.velocity, sphere.material});
+    }
+    for (const auto& quad : scene.quads_) {
+        quads.push_back({quad.Q, quad.D, quad.u, quad.area, quad.v, quad.material, quad.normal, 0.0f, quad.w, 0.0f});
+    }
+    for (const auto& instance : scene.instances_) {
+        instances.push_back({instance.offset, instance.sinTheta, instance.cosTheta, roots[instance.bvh], 0, 0});
+    }
+
+    for (const auto& texture : scene.textures_) {
+        GPUTexture gpu = {(uint32_t)TextureType::Solid, texture.scale, texture.odd, texture.even, texture.color, 0.0f};
+        if (texture.type == TextureType::Chessboard) {
+            gpu.type = (uint32_t)TextureType::Chessboard;
+        } else if (texture.type != TextureType::Solid) {
+            gpu.color = average(*texture.source);
+            approximated++;
+        }
+        textures.push_back(gpu);
+    }
+
+    for (const auto& material : scene.materials_) {
+        GPUMaterial gpu = {(uint32_t)material.type, material.texture, material.parameter, material.roughness, material.albedo, 0.0f};
+        if (material.type == MaterialType::Isotropic || material.type == MaterialType::Virtual) {
+            // a diffuse stand-in with a texture of its own
+            gpu.type = (uint32_t)MaterialType::Lambertian;
+            gpu.texture = textures.size();
+            glm::vec3 color = material.type == MaterialType::Isotropic ? textures[material.texture].color : glm::vec3(0.5f);
+            textures.push_back({(uint32_t)TextureType::Solid, 0.0f, 0, 0, color, 0.0f});
+            approximated++;
+        }
+        materials.push_back(gpu);
+    }
+
+    lights = scene.lightQuads_;
+    skipped += scene.virtualLights_.size();
+    skipped += environment ? 1 : 0;
+}
+
+size_t GPUScene::memory() const {
+    return nodes.size() * sizeof(FlatNode) + refs.size() * sizeof(uint32_t) + spheres.size() * sizeof(GPUSphere) +
+           quads.size() * sizeof(GPUQuad) + instances.size() * sizeof(GPUInstance) +
+           materials.size() * sizeof(GPUMaterial) + textures.size() * sizeof(GPUTexture) + lights.size() * sizeof(uint32_t);
+}
\ No newline at end of file
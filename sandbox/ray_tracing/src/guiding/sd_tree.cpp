@@ -0,0 +1,350 @@
+#include "guiding/sd_tree.hpp"
+#include "tools/random.hpp"
+#include <glm/ext/scalar_constants.hpp>
+
+static void atomicAdd(std::atomic<float>& target, float value) {
+    float current = target.load(std::memory_order_relaxed);
+    while (!target.compare_exchange_weak(current, current + value, std::memory_order_relaxed)) {}
+}
+
+static int childIndex(glm::vec2& p) {
+    int index = 0;
+    if (p.x >= 0.5f) {
+        index |= 1;
+        p.x -= 0.5f;
+    }
+    if (p.y >= 0.5f) {
+        index |= 2;
+        p.y -= 0.5f;
+    }
+    p *= 2.0f;
+    return index;
+}
+
+// DTree
+DTree::Node::Node(const Node& other) {
+    *this = other;
+}
+
+DTree::Node& DTree::Node::operator=(const Node& other) {
+    for (int i = 0; i < 4; i++) {
+        sums[i].store(other.sum(i), std::memory_order_relaxed);
+        children[i] = other.children[i];
+    }
+    return *this;
+}
+
+DTree::DTree() {
+    nodes_.emplace_back();
+}
+
+glm::vec2 DTree::toCanonical(const glm::vec3& direction) {
+    float cosTheta = glm::clamp(direction.z, -1.0f, 1.0f);
+    float phi = std::atan2(direction.y, direction.x);
+    if (phi < 0.0f) {
+        phi += 2.0f * glm::pi<float>();
+    }
+    return glm::clamp(glm::vec2((cosTheta + 1.0f) * 0.5f, phi / (2.0f * glm::pi<float>())), 0.0f, 0.99999f);
+}
+
+glm::vec3 DTree::toDirection(const glm::vec2& p) {
+    float cosTheta = 2.0f * p.x - 1.0f;
+    float phi = 2.0f * glm::pi<float>() * p.y;
+    float sinTheta = glm::sqrt(glm::max(0.0f, 1.0f - cosTheta * cosTheta));
+    return glm::vec3(sinTheta * glm::cos(phi), sinTheta * glm::sin(phi), cosTheta);
+}
+
+void DTree::record(const glm::vec3& direction, float radiance) {
+    glm::vec2 p = toCanonical(direction);
+    uint32_t index = 0;
+    while (true) {
+        auto& node = nodes_[index];
+        int child = childIndex(p);
+        atomicAdd(node.sums[child], radiance);
+        if (node.leaf(child)) {
+            break;
+        }
+        index = node.children[child];
+    }
+}
+
+float DTree::pdf(const glm::vec3& direction) const {
+    if (!valid()) {
+        return 1.0f / (4.0f * glm::pi<float>());
+    }
+
+    glm::vec2 p = toCanonical(direction);
+    float factor = 1.0f;
+    uint32_t index = 0;
+    while (true) {
+        const auto& node = nodes_[index];
+        int child = childIndex(p);
+        float total = node.total();
+        if (total <= 0.0f) {
+            return 0.0f;
+        }
+        factor *= 4.0f * node.sum(child) / total;
+        if (node.leaf(child) || factor == 0.0f) {
+            break;
+        }
+        index = node.children[child];
+    }
+    return factor / (4.0f * glm::pi<float>());
+}
+
+glm::vec3 DTree::sample() const {
+    if (!valid()) {
+        return Random::UnitSphere();
+    }
+
+    glm::vec2 origin(0.0f);
+    float size = 1.0f;
+    uint32_t index = 0;
+    while (true) {
+        const auto& node = nodes_[index];
+        float total = node.total();
+        float r = Random::Float() * total;
+        int child = 0;
+        for (; child < 3; child++) {
+            float sum = node.sum(child);
+            if (r < sum) {
+                break;
+            }
+            r -= sum;
+        }
+
+        size *= 0.5f;
+        origin += glm::vec2(child & 1, child >> 1) * size;
+        if (node.leaf(child)) {
+            break;
+        }
+        index = node.children[child];
+    }
+
+    return toDirection(origin + glm::vec2(Random::Float(), Random::Float()) * size);
+}
+
+void DTree::refine(const DTree& previous, float threshold, int maxDepth, size_t maxNodes) {
+    struct Entry {
+        uint32_t node;
+        uint32_t previous;
+        bool inherited;
+        float energy;
+        int depth;
+    };
+
+    nodes_.clear();
+    nodes_.emplace_back();
+
+    float total = previous.nodes_[0].total();
+    if (total <= 0.0f) {
+        return;
+    }
+
+    std::vector<Entry> stack = {{0, 0, false, total, 1}};
+    while (!stack.empty()) {
+        Entry entry = stack.back();
+        stack.pop_back();
+
+        for (int i = 0; i < 4; i++) {
+            const auto& parent = previous.nodes_[entry.previous];
+            bool inherited = entry.inherited || parent.leaf(i);
+            float energy = entry.inherited ? entry.energy * 0.25f : parent.sum(i);
+            if (entry.depth >= maxDepth || energy / total <= threshold || nodes_.size() >= maxNodes) {
+                continue;
+            }
+
+            uint32_t child = nodes_.size();
+            nodes_.emplace_back();
+            nodes_[entry.node].children[i] = child;
+            stack.push_back({child, inherited ? entry.previous : parent.children[i], inherited, energy, entry.depth + 1});
+        }
+    }
+}
+
+void DTree::write(std::ostream& out) const {
+    uint32_t count = nodes_.size();
+    out.write(reinterpret_cast<const char*>(&count), sizeof(count));
+    for (const auto& node : nodes_) {
+        float sums[4] = {node.sum(0), node.sum(1), node.sum(2), node.sum(3)};
+        out.write(reinterpret_cast<const char*>(sums), sizeof(sums));
+        out.write(reinterpret_cast<const char*>(node.children), sizeof(node.children));
+    }
+}
+
+bool DTree::read(std::istream& in) {
+    uint32_t count = 0;
+    in.read(reinterpret_cast<char*>(&count), sizeof(count));
+    if (!in || count == 0) {
+        return false;
+    }
+    nodes_.assign(count, Node());
+    for (auto& node : nodes_) {
+        float sums[4];
+        in.read(reinterpret_cast<char*>(sums), sizeof(sums));
+        in.read(reinterpret_cast<char*>(node.children), sizeof(node.children));
+        for (int i = 0; i < 4; i++) {
+            node.sums[i].store(sums[i], std::memory_order_relaxed);
+        }
+    }
+    return bool(in);
+}
+
+// DTreeWrapper
+DTreeWrapper::DTreeWrapper(const DTreeWrapper& other)
+    : sampling(other.sampling), building(other.building), samples(other.samples.load()) {}
+
+void DTreeWrapper::record(const glm::vec3& direction, float radiance) {
+    if (!(radiance > 0.0f) || glm::isinf(radiance)) {
+        return;
+    }
+    building.record(direction, radiance);
+    samples.fetch_add(1, std::memory_order_relaxed);
+}
+
+void DTreeWrapper::refine(float threshold, int maxDepth, size_t maxNodes) {
+    sampling = building;
+    building.refine(sampling, threshold, maxDepth, maxNodes);
+    samples = 0;
+}
+
+void DTreeWrapper::write(std::ostream& out) const {
+    sampling.write(out);
+    building.write(out);
+    uint32_t count = samples.load();
+    out.write(reinterpret_cast<const char*>(&count), sizeof(count));
+}
+
+bool DTreeWrapper::read(std::istream& in) {
+    uint32_t count = 0;
+    bool valid = sampling.read(in) && building.read(in);
+    in.read(reinterpret_cast<char*>(&count), sizeof(count));
+    samples = count;
+    return valid && bool(in);
+}
+
+// SDTree
+SDTree::SDTree(const AABB& aabb) {
+    min_ = glm::vec3(aabb.x.min, aabb.y.min, aabb.z.min);
+    extent_ = glm::vec3(aabb.x.size(), aabb.y.size(), aabb.z.size());
+    float size = glm::max(extent_.x, glm::max(extent_.y, extent_.z));
+    extent_ = glm::max(extent_, glm::vec3(size * 1e-3f));
+    nodes_.emplace_back();
+    wrappers_.push_back(std::make_unique<DTreeWrapper>());
+}
+
+uint32_t SDTree::leafIndex(const glm::vec3& point) const {
+    glm::vec3 p = glm::clamp((point - min_) / extent_, 0.0f, 0.99999f);
+    uint32_t index = 0;
+    while (!nodes_[index].leaf()) {
+        const auto& node = nodes_[index];
+        int side = p[node.axis] >= 0.5f ? 1 : 0;
+        p[node.axis] = p[node.axis] * 2.0f - side;
+        index = node.children[side];
+    }
+    return index;
+}
+
+DTreeWrapper& SDTree::lookup(const glm::vec3& point) {
+    return *wrappers_[nodes_[leafIndex(point)].wrapper];
+}
+
+const DTreeWrapper& SDTree::lookup(const glm::vec3& point) const {
+    return *wrappers_[nodes_[leafIndex(point)].wrapper];
+}
+
+void SDTree::record(const glm::vec3& point, const glm::vec3& direction, float radiance) {
+    lookup(point).record(direction, radiance);
+}
+
+void SDTree::subdivide(uint32_t index) {
+    uint32_t first = nodes_.size();
+    uint8_t axis = (nodes_[index].axis + 1) % 3;
+    uint32_t wrapper = nodes_[index].wrapper;
+
+    Node left, right;
+    left.axis = right.axis = axis;
+    left.wrapper = wrapper;
+    right.wrapper = wrappers_.size();
+    wrappers_.push_back(std::make_unique<DTreeWrapper>(*wrappers_[wrapper]));
+
+    nodes_.push_back(left);
+    nodes_.push_back(right);
+    nodes_[index].children[0] = first;
+    nodes_[index].children[1] = first + 1;
+}
+
+void SDTree::refine(uint32_t iteration) {
+    float threshold = settings.spatialThreshold * glm::sqrt(float(1u << glm::min(iteration, 30u)));
+
+    // memory() visits every wrapper, so the budget is tracked by what each split adds
+    size_t bytes = memory();
+    std::vector<uint32_t> stack = {0};
+    while (!stack.empty()) {
+        uint32_t index = stack.back();
+        stack.pop_back();
+
+        if (nodes_[index].leaf()) {
+            auto& wrapper = *wrappers_[nodes_[index].wrapper];
+            if (wrapper.samples < threshold || bytes >= settings.maxMemory) {
+                continue;
+            }
+            // both halves inherit half of the samples and may split again
+            wrapper.samples = wrapper.samples / 2;
+            subdivide(index);
+            bytes += 2 * sizeof(Node) + sizeof(DTreeWrapper) + wrappers_.back()->memory();
+        }
+
+        stack.push_back(nodes_[index].children[0]);
+        stack.push_back(nodes_[index].children[1]);
+    }
+
+    for (auto& wrapper : wrappers_) {
+        wrapper->refine(settings.directionalThreshold, settings.maxDirectionalDepth, settings.maxDirectionalNodes);
+    }
+}
+
+size_t SDTree::memory() const {
+    size_t bytes = nodes_.capacity() * sizeof(Node);
+    for (const auto& wrapper : wrappers_) {
+        bytes += sizeof(DTreeWrapper) + wrapper->memory();
+    }
+    return bytes;
+}
+
+void SDTree::write(std::ostream& out) const {
+    out.write(reinterpret_cast<const char*>(&min_), sizeof(min_));
+    out.write(reinterpret_cast<const char*>(&extent_), sizeof(extent_));
+    uint32_t nodes = nodes_.size();
+    uint32_t wrappers = wrappers_.size();
+    out.write(reinterpret_cast<const char*>(&nodes), sizeof(nodes));
+    out.write(reinterpret_cast<const char*>(nodes_.data()), nodes * sizeof(Node));
+    out.write(reinterpret_cast<const char*>(&wrappers), sizeof(wrappers));
+    for (const auto& wrapper : wrappers_) {
+        wrapper->write(out);
+    }
+}
+
+bool SDTree::read(std::istream& in) {
+    uint32_t nodes = 0, wrappers = 0;
+    in.read(reinterpret_cast<char*>(&min_), sizeof(min_));
+    in.read(reinterpret_cast<char*>(&extent_), sizeof(extent_));
+    in.read(reinterpret_cast<char*>(&nodes), sizeof(nodes));
+    if (!in || nodes == 0) {
+        return false;
+    }
+    nodes_.resize(nodes);
+    in.read(reinterpret_cast<char*>(nodes_.data()), nodes * sizeof(Node));
+    in.read(reinterpret_cast<char*>(&wrappers), sizeof(wrappers));
+    if (!in || wrappers == 0) {
+        return false;
+    }
+    wrappers_.clear();
+    for (uint32_t i = 0; i < wrappers; i++) {
+        wrappers_.push_back(std::make_unique<DTreeWrapper>());
+        if (!wrappers_.back()->read(in)) {
+            return false;
+        }
+    }
+    return true;
+}
\ No newline at end of file
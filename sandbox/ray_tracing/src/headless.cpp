@@ -0,0 +1,146 @@
+#include "ray_tracing.hpp"
+#include "gpu/compute_tracer.hpp"
+#include "stb_image_write.h"
+#include <filesystem>
+
+namespace {
+
+// the written image is flipped, the renderer counts rows from the bottom
+bool writeImage(const std::string& filename, uint32_t width, uint32_t height, const uint32_t* pixels) {
+    std::filesystem::path path(filename);
+    if (path.has_parent_path()) {
+        std::filesystem::create_directories(path.parent_path());
+    }
+    stbi_flip_vertically_on_write(true);
+    if (!stbi_write_png(filename.c_str(), width, height, 4, pixels, 0)) {
+        WEN_ERROR("Failed to write {}", filename)
+        return false;
+    }
+    return true;
+}
+
+std::string suffixed(const std::string& filename, const std::string& suffix) {
+    std::filesystem::path path(filename);
+    return (path.parent_path() / (path.stem().string() + suffix + path.extension().string())).string();
+}
+
+} // namespace
+
+// the viewport's Renderer driven pass by pass on the calling thread, a crop re-renders a patch of a
+// resumed checkpoint and leaves the rest of the frame as it was
+int renderHeadless(const Options& options) {
+    Renderer renderer;
+    Camera camera(45.0f, 0.1f, 100.0f);
+    Scene scene;
+    buildScene(options.scene, scene, camera, renderer, options.accelerator);
+    if (!options.environment.empty()) {
+        scene.environment = std::make_shared<Environment>(options.environment);
+        if (!scene.environment->valid()) {
+            return 1;
+        }
+    }
+    renderer.interactive = false;
+    renderer.gpu = options.gpu;
+
+    uint32_t width = options.width, height = options.height;
+    Checkpoint checkpoint;
+    if (!options.resume.empty()) {
+        if (!checkpoint.read(options.resume)) {
+            WEN_ERROR("Failed to read checkpoint {}", options.resume)
+            return 1;
+        }
+        width = checkpoint.width;
+        height = checkpoint.height;
+        camera.set(checkpoint.position, checkpoint.direction);
+    }
+    camera.resize(width, height);
+    renderer.resize(width, height);
+    if (!options.resume.empty() && !renderer.resume(checkpoint)) {
+        WEN_ERROR("Failed to resume {}", options.resume)
+        return 1;
+    }
+
+    // crop rows are given top down in the written image
+    if (!options.crop.empty()) {
+        uint32_t y0 = glm::min(options.crop.y0, height), y1 = glm::min(options.crop.y1, height);
+        renderer.crop = Region{options.crop.x0, height - y1, options.crop.x1, height - y0};
+    }
+
+    auto begin = std::chrono::steady_clock::now();
+    for (int i = 0; i < options.frames; i++) {
+        renderer.render(camera, scene);
+    }
+    float seconds = std::chrono::duration<float>(std::chrono::steady_clock::now() - begin).count();
+
+    if (!writeImage(options.output, width, height, renderer.data())) {
+        return 1;
+    }
+    WEN_INFO("{} passes of {}x{} in {:.2f} s, written to {}", options.frames, width, height, seconds, options.output)
+    return 0;
+}
+
+// The CPU and the compute kernel on the same scene, camera and pass count. Both seed every pixel
+// and pass from the same hash and draw from the same generator, so the camera samples and the first
+// decisions along each path match and the error left is where the integrators part: the report is
+// that error next to the time each took.
+int compareDevices(const Options& options) {
+    Camera camera(45.0f, 0.1f, 100.0f);
+    Scene scene;
+    Renderer cpu, gpu;
+    buildScene(options.scene, scene, camera, cpu, options.accelerator);
+    static_cast<RenderSettings&>(gpu) = cpu;
+    cpu.interactive = gpu.interactive = false;
+    cpu.gpu = false;
+    gpu.gpu = true;
+
+    uint32_t width = options.width, height = options.height;
+    camera.resize(width, height);
+    cpu.resize(width, height);
+    gpu.resize(width, height);
+
+    auto run = [&](Renderer& renderer) {
+        float kernel = 0.0f;
+        auto begin = std::chrono::steady_clock::now();
+        for (int i = 0; i < options.frames; i++) {
+            renderer.render(camera, scene);
+            if (renderer.computeTracer()) {
+                kernel += renderer.computeTracer()->kernelTime();
+            }
+        }
+        float seconds = std::chrono::duration<float>(std::chrono::steady_clock::now() - begin).count();
+        return std::make_pair(seconds, kernel);
+    };
+    auto [gpuSeconds, kernelSeconds] = run(gpu);
+    if (!gpu.computeTracer() || !gpu.computeTracer()->valid()) {
+        WEN_ERROR("No compute device, nothing to compare")
+        return 1;
+    }
+    float cpuSeconds = run(cpu).first;
+
+    // on the displayed values, gamma 2 and 8 bits as written
+    size_t count = (size_t)width * height;
+    double squared = 0.0, difference = 0.0;
+    for (size_t i = 0; i < count; i++) {
+        for (uint32_t channel = 0; channel < 3; channel++) {
+            double a = (cpu.data()[i] >> (8 * channel) & 0xff) / 255.0;
+            double b = (gpu.data()[i] >> (8 * channel) & 0xff) / 255.0;
+            squared += (a - b) * (a - b);
+            difference += b - a;
+        }
+    }
+    double rmse = glm::sqrt(squared / (3.0 * count));
+    difference /= 3.0 * count;
+
+    double samples = (double)count * cpu.sqrt_spp * cpu.sqrt_spp * options.frames * 1e-6;
+    WEN_INFO("CPU: {} passes of {}x{} in {:.2f} s, {:.2f} Msamples/s", options.frames, width, height, cpuSeconds,
+             samples / cpuSeconds)
+    WEN_INFO("GPU ({}): {:.2f} s, {:.2f} Msamples/s, {:.2f} s in the kernel", gpu.computeTracer()->deviceName(),
+             gpuSeconds, samples / gpuSeconds, kernelSeconds)
+    WEN_INFO("GPU against CPU: RMSE {:.4f}, mean difference {:+.4f}", rmse, difference)
+
+    if (!writeImage(suffixed(options.output, "_cpu"), width, height, cpu.data()) ||
+        !writeImage(suffixed(options.output, "_gpu"), width, height, gpu.data())) {
+        return 1;
+    }
+    return 0;
+}
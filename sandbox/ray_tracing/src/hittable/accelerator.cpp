@@ -0,0 +1,110 @@
+#include "hittable/accelerator.hpp"
+#include "hittable/bvh.hpp"
+#include "hittable/flat_bvh.hpp"
+#include "hittable/packed_bvh.hpp"
+#include "hittable/compressed_bvh.hpp"
+#include "hittable/grid.hpp"
+#include "hittable/kd_tree.hpp"
+#include <chrono>
+
+namespace {
+
+const char* names[] = {"bvh", "flat", "lbvh", "packed", "compressed", "grid", "kdtree"};
+
+size_t memory(const Hittable& hittable) {
+    if (auto bvh = dynamic_cast<const BVH*>(&hittable)) {
+        size_t bytes = sizeof(BVH);
+        bytes += bvh->left ? memory(*bvh->left) : 0;
+        bytes += bvh->right && bvh->right != bvh->left ? memory(*bvh->right) : 0;
+        return bytes;
+    }
+    return 0;
+}
+
+} // namespace
+
+const char* acceleratorName(Accelerator accelerator) {
+    return names[(uint32_t)accelerator];
+}
+
+bool parseAccelerator(const std::string& name, Accelerator& accelerator) {
+    for (uint32_t i = 0; i < (uint32_t)Accelerator::Count; i++) {
+        if (name == names[i]) {
+            accelerator = (Accelerator)i;
+            return true;
+        }
+    }
+    return false;
+}
+
+std::shared_ptr<Hittable> accelerate(const std::shared_ptr<HittableList>& list, Accelerator accelerator, BuildStats* stats) {
+    auto begin = std::chrono::steady_clock::now();
+    std::shared_ptr<Hittable> result;
+    size_t bytes = 0;
+    switch (accelerator) {
+        case Accelerator::BVH: {
+            result = std::make_shared<BVH>(list);
+            bytes = memory(*result);
+            break;
+        }
+        case Accelerator::FlatBVH:
+        case Accelerator::LBVH: {
+            auto method = accelerator == Accelerator::LBVH ? FlatBVH::Build::Morton : FlatBVH::Build::SAH;
+            auto bvh = std::make_shared<FlatBVH>(list, 4, method);
+            bytes = bvh->memory();
+            result = bvh;
+            break;
+        }
+        case Accelerator::PackedBVH: {
+            auto bvh = std::make_shared<PackedBVH>(list);
+            bytes = bvh->memory();
+            result = bvh;
+            break;
+        }
+        case Accelerator::CompressedBVH: {
+            auto bvh = std::make_shared<CompressedBVH>(list);
+            bytes = bvh->memory();
+            result = bvh;
+            break;
+        }
+        case Accelerator::Grid: {
+            auto grid = std::make_shared<Grid>(list);
+            bytes = grid->memory();
+            result = grid;
+            break;
+        }
+        case Accelerator::KDTree:
+        default: {
+            auto tree = std::make_shared<KDTree>(list);
+            bytes = tree->memory();
+            result = tree;
+            break;
+        }
+    }
+    if (stats) {
+        stats->seconds += std::chrono::duration<float>(std::chrono::steady_clock::now() - begin).count();
+        stats->bytes += bytes;
+        stats->structures++;
+    }
+    return result;
+}
+
+bool bounded(const AABB& box) {
+    for (int axis = 0; axis < 3; axis++) {
+        const auto& interval = box.axis(axis);
+        if (!(interval.min <= interval.max) || std::isinf(interval.min) || std::isinf(interval.max)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool clip(const Ray& ray, const glm::vec3& invDirection, const glm::vec3& min, const glm::vec3& max,
+          const Interval& t, float& enter, float& exit) {
+    glm::vec3 t0 = (min - ray.origin) * invDirection;
+    glm::vec3 t1 = (max - ray.origin) * invDirection;
+    glm::vec3 near = glm::min(t0, t1), far = glm::max(t0, t1);
+    enter = glm::max(t.min, glm::max(near.x, glm::max(near.y, near.z)));
+    exit = glm::min(t.max, glm::min(far.x, glm::min(far.y, far.z)));
+    return enter <= exit;
+}
\ No newline at end of file
@@ -1,15 +1,31 @@
 #include "hittable/bvh.hpp"
+#include "tools/counters.hpp"
+#include <execution>
+
+namespace {
+
+// subtrees with more objects than this build their two halves concurrently
+constexpr size_t parallelSize = 1 << 12;
+
+} // namespace
 
 BVH::BVH(const std::vector<std::shared_ptr<Hittable>>& src, size_t start, size_t end) {
+    std::vector<std::shared_ptr<Hittable>> objects(src.begin() + start, src.begin() + end);
+    build(objects, 0, objects.size());
+}
+
+BVH::BVH(const std::shared_ptr<HittableList>& list) : BVH(list->hittables, 0, list->hittables.size()) {}
+
+// partitions `objects` in place, the halves touch disjoint ranges and can be built by different threads
+void BVH::build(std::vector<std::shared_ptr<Hittable>>& objects, size_t start, size_t end) {
     aabb = AABB::empty;
     for (size_t i = start; i < end; i++) {
-        aabb = AABB(aabb, src[i]->aabb);
+        aabb = AABB(aabb, objects[i]->aabb);
     }
 
     int axis = aabb.longestAxis();
     auto comparator = (axis == 0) ? x : (axis == 1) ? y : z;
 
-    auto objects = src;
     size_t size = end - start;
     if (size == 1) {
         left = right = objects[start];
@@ -22,16 +38,29 @@ BVH::BVH(const std::vector<std::shared_ptr<Hittable>>& src, size_t start, size_t
             right = objects[start];
         }
     } else {
-        std::sort(objects.begin() + start, objects.begin() + end, comparator);
         size_t mid = start + size / 2;
-        left = std::make_shared<BVH>(objects, start, mid);
-        right = std::make_shared<BVH>(objects, mid, end);
+        std::nth_element(objects.begin() + start, objects.begin() + mid, objects.begin() + end, comparator);
+
+        std::shared_ptr<BVH> children[2] = {std::shared_ptr<BVH>(new BVH()), std::shared_ptr<BVH>(new BVH())};
+        Counters::add(Counter::Allocations, 2);
+        size_t bounds[3] = {start, mid, end};
+        auto build = [&](int half) {
+            children[half]->build(objects, bounds[half], bounds[half + 1]);
+        };
+        if (size > parallelSize) {
+            int halves[2] = {0, 1};
+            std::for_each(std::execution::par, std::begin(halves), std::end(halves), build);
+        } else {
+            build(0);
+            build(1);
+        }
+        left = children[0];
+        right = children[1];
     }
 }
 
-BVH::BVH(const std::shared_ptr<HittableList>& list) : BVH(list->hittables, 0, list->hittables.size()) {}
-
 bool BVH::hit(const Ray& ray, Interval t, HitRecord& hitRecoed) const {
+    Counters::add(Counter::BoxTests);
     if (!aabb.hit(ray, t)) {
         return false;
     }
@@ -0,0 +1,196 @@
+#include "hittable/bvh_report.hpp"
+#include "hittable/bvh.hpp"
+#include "hittable/packed_bvh.hpp"
+#include "hittable/compressed_bvh.hpp"
+#include <sstream>
+
+namespace {
+
+struct Box {
+    glm::vec3 min, max;
+};
+
+Box box(const AABB& aabb) {
+    return {{aabb.x.min, aabb.y.min, aabb.z.min}, {aabb.x.max, aabb.y.max, aabb.z.max}};
+}
+
+Box box(const FlatNode& node) {
+    return {node.min, node.max};
+}
+
+float area(const Box& box) {
+    glm::vec3 d = glm::max(box.max - box.min, glm::vec3(0.0f));
+    return 2.0f * (d.x * d.y + d.y * d.z + d.z * d.x);
+}
+
+class Collector {
+public:
+    Collector(BVHReport& report, const Box& root) : report_(report) {
+        float a = area(root);
+        rootArea_ = a > 0.0f ? a : 1.0f;
+    }
+
+    void interior(const Box& node, const Box& left, const Box& right) {
+        report_.nodes++;
+        report_.sahCost += area(node) / rootArea_;
+
+        Box shared = {glm::max(left.min, right.min), glm::min(left.max, right.max)};
+        float sharedArea = glm::all(glm::lessThanEqual(shared.min, shared.max)) ? area(shared) : 0.0f;
+        float parentArea = area(node);
+        overlap_ += parentArea > 0.0f ? sharedArea / parentArea : 0.0f;
+        report_.overlapCost += sharedArea / rootArea_;
+        interiors_++;
+    }
+
+    void leaf(const Box& node, uint32_t count, uint32_t depth) {
+        report_.nodes++;
+        report_.leaves++;
+        report_.primitives += count;
+        report_.sahCost += area(node) / rootArea_ * (float)count;
+        report_.maxDepth = glm::max(report_.maxDepth, depth);
+
+        if (report_.depths.size() <= depth) {
+            report_.depths.resize(depth + 1, 0);
+        }
+        report_.depths[depth]++;
+        if (report_.leafSizes.size() <= count) {
+            report_.leafSizes.resize(count + 1, 0);
+        }
+        report_.leafSizes[count]++;
+    }
+
+    void finish() {
+        report_.overlap = interiors_ > 0 ? overlap_ / (float)interiors_ : 0.0f;
+        report_.meanLeafSize = report_.leaves > 0 ? (float)report_.primitives / (float)report_.leaves : 0.0f;
+    }
+
+private:
+    BVHReport& report_;
+    float rootArea_;
+    float overlap_ = 0.0f;
+    size_t interiors_ = 0;
+};
+
+// a BVH node whose children are not BVHs is a leaf holding one or two primitives
+void walk(const BVH& bvh, uint32_t depth, Collector& collector) {
+    auto left = dynamic_cast<const BVH*>(bvh.left.get());
+    auto right = dynamic_cast<const BVH*>(bvh.right.get());
+    if (!left && !right) {
+        collector.leaf(box(bvh.aabb), bvh.left == bvh.right ? 1 : 2, depth);
+        return;
+    }
+
+    collector.interior(box(bvh.aabb), box(bvh.left->aabb), box(bvh.right->aabb));
+    for (auto [child, hittable] : {std::make_pair(left, bvh.left.get()), std::make_pair(right, bvh.right.get())}) {
+        if (child) {
+            walk(*child, depth + 1, collector);
+        } else {
+            collector.leaf(box(hittable->aabb), 1, depth + 1);
+        }
+    }
+}
+
+template<typename Count>
+void walk(const std::vector<FlatNode>& nodes, uint32_t index, uint32_t depth, Collector& collector, Count&& count) {
+    const auto& node = nodes[index];
+    if (node.count > 0) {
+        collector.leaf(box(node), count(node), depth);
+        return;
+    }
+
+    collector.interior(box(node), box(nodes[index + 1]), box(nodes[node.offset]));
+    walk(nodes, index + 1, depth + 1, collector, count);
+    walk(nodes, node.offset, depth + 1, collector, count);
+}
+
+// child boxes are decoded from the grid of their parent, whose minimum is that of `node`
+void walk(const CompressedBVH& bvh, uint32_t index, const Box& node, uint32_t depth, Collector& collector) {
+    const auto& compressed = bvh.nodes[index];
+    if (compressed.count > 0) {
+        collector.leaf(node, compressed.count, depth);
+        return;
+    }
+
+    glm::vec3 step;
+    for (int axis = 0; axis < 3; axis++) {
+        step[axis] = std::ldexp(1.0f, compressed.exponent[axis]);
+    }
+    Box children[2];
+    for (int i = 0; i < 2; i++) {
+        const uint8_t* min = compressed.min[i];
+        const uint8_t* max = compressed.max[i];
+        children[i] = {node.min + glm::vec3(min[0], min[1], min[2]) * step, node.min + glm::vec3(max[0], max[1], max[2]) * step};
+    }
+
+    collector.interior(node, children[0], children[1]);
+    walk(bvh, index + 1, children[0], depth + 1, collector);
+    walk(bvh, compressed.offset, children[1], depth + 1, collector);
+}
+
+template<typename Count>
+BVHReport report(const std::vector<FlatNode>& nodes, Count&& count) {
+    BVHReport report;
+    if (nodes.empty()) {
+        return report;
+    }
+
+    Collector collector(report, box(nodes[0]));
+    walk(nodes, 0, 0, collector, count);
+    collector.finish();
+    return report;
+}
+
+} // namespace
+
+BVHReport BVHReport::build(const BVH& bvh) {
+    BVHReport report;
+    Collector collector(report, box(bvh.aabb));
+    walk(bvh, 0, collector);
+    collector.finish();
+    return report;
+}
+
+BVHReport BVHReport::build(const FlatBVH& bvh) {
+    return report(bvh.nodes, [](const FlatNode& node) { return (uint32_t)node.count; });
+}
+
+BVHReport BVHReport::build(const PackedBVH& bvh) {
+    return report(bvh.nodes, [&](const FlatNode& node) {
+        const auto& leaf = bvh.leaves[node.offset];
+        return (leaf.sphereEnd - leaf.sphereBegin) + (leaf.quadEnd - leaf.quadBegin) + (leaf.otherEnd - leaf.otherBegin);
+    });
+}
+
+BVHReport BVHReport::build(const CompressedBVH& bvh) {
+    BVHReport report;
+    if (bvh.nodes.empty()) {
+        return report;
+    }
+
+    Box root = {bvh.min, bvh.max};
+    Collector collector(report, root);
+    walk(bvh, 0, root, 0, collector);
+    collector.finish();
+    return report;
+}
+
+std::string BVHReport::summary() const {
+    std::ostringstream out;
+    out << "nodes: " << nodes << ", leaves: " << leaves << ", primitives: " << primitives << "\n";
+    out << "SAH cost: " << sahCost << ", overlap: " << overlap * 100.0f << "% (cost " << overlapCost << ")\n";
+    out << "max depth: " << maxDepth << ", mean leaf size: " << meanLeafSize << "\n";
+    out << "depth histogram:";
+    for (size_t i = 0; i < depths.size(); i++) {
+        if (depths[i] > 0) {
+            out << " " << i << ":" << depths[i];
+        }
+    }
+    out << "\nleaf size histogram:";
+    for (size_t i = 0; i < leafSizes.size(); i++) {
+        if (leafSizes[i] > 0) {
+            out << " " << i << ":" << leafSizes[i];
+        }
+    }
+    out << "\n";
+    return out.str();
+}
\ No newline at end of file
@@ -0,0 +1,162 @@
+#include "hittable/compressed_bvh.hpp"
+#include "tools/counters.hpp"
+#include <cstring>
+
+namespace {
+
+float pow2(int exponent) {
+    uint32_t bits = uint32_t(exponent + 127) << 23;
+    float value;
+    std::memcpy(&value, &bits, sizeof(float));
+    return value;
+}
+
+glm::vec3 scale(const int8_t exponent[3]) {
+    return glm::vec3(pow2(exponent[0]), pow2(exponent[1]), pow2(exponent[2]));
+}
+
+// the encoder checks containment against bounds pushed out by one ulp, so the box decoded while
+// tracing stays conservative even if the compiler contracts this into an fma at one site only
+glm::vec3 decode(const glm::vec3& min, const glm::vec3& scale, const uint8_t q[3]) {
+    return min + glm::vec3(q[0], q[1], q[2]) * scale;
+}
+
+bool intersect(const glm::vec3& min, const glm::vec3& max, const glm::vec3& origin, const glm::vec3& invDirection,
+               const Interval& t, float& near) {
+    glm::vec3 t0 = (min - origin) * invDirection;
+    glm::vec3 t1 = (max - origin) * invDirection;
+    glm::vec3 n = glm::min(t0, t1);
+    glm::vec3 f = glm::max(t0, t1);
+    near = glm::max(t.min, glm::max(n.x, glm::max(n.y, n.z)));
+    float far = glm::min(t.max, glm::min(f.x, glm::min(f.y, f.z)));
+    return near <= far;
+}
+
+} // namespace
+
+CompressedBVH::CompressedBVH(const std::shared_ptr<HittableList>& list, uint32_t leafSize)
+    : CompressedBVH(FlatBVH(list, leafSize)) {}
+
+CompressedBVH::CompressedBVH(const FlatBVH& bvh) : primitives(bvh.primitives) {
+    nodes.resize(bvh.nodes.size());
+    min = bvh.nodes[0].min;
+    max = bvh.nodes[0].max;
+    compress(bvh.nodes, 0, min);
+    aabb = bvh.aabb;
+}
+
+// `min` is the decoded minimum the traversal will see for this node, it never exceeds the exact one
+void CompressedBVH::compress(const std::vector<FlatNode>& flat, uint32_t index, const glm::vec3& min) {
+    const auto& source = flat[index];
+    auto& node = nodes[index];
+    node.offset = source.offset;
+    node.count = source.count;
+    node.padding = 0;
+    if (source.count > 0) {
+        std::memset(node.min, 0, sizeof(node.min));
+        std::memset(node.max, 0, sizeof(node.max));
+        std::fill(std::begin(node.exponent), std::end(node.exponent), -126);
+        return;
+    }
+
+    // smallest power-of-two step whose 255th grid line still reaches the node maximum
+    for (int axis = 0; axis < 3; axis++) {
+        float extent = source.max[axis] - min[axis];
+        int exponent = extent > 0.0f ? glm::clamp((int)std::ceil(std::log2(extent / 255.0f)), -126, 127) : -126;
+        float reach = std::nextafter(source.max[axis], infinity);
+        while (exponent < 127 && min[axis] + 255.0f * pow2(exponent) < reach) {
+            exponent++;
+        }
+        node.exponent[axis] = exponent;
+    }
+
+    glm::vec3 step = scale(node.exponent);
+    uint32_t children[2] = {index + 1, source.offset};
+    glm::vec3 childMin[2];
+    for (int i = 0; i < 2; i++) {
+        const auto& child = flat[children[i]];
+        for (int axis = 0; axis < 3; axis++) {
+            float lower = std::nextafter(child.min[axis], -infinity);
+            float upper = std::nextafter(child.max[axis], infinity);
+            int lo = glm::clamp((int)std::floor((child.min[axis] - min[axis]) / step[axis]), 0, 255);
+            int hi = glm::clamp((int)std::ceil((child.max[axis] - min[axis]) / step[axis]), 0, 255);
+            while (lo > 0 && min[axis] + lo * step[axis] > lower) {
+                lo--;
+            }
+            while (hi < 255 && min[axis] + hi * step[axis] < upper) {
+                hi++;
+            }
+            node.min[i][axis] = lo;
+            node.max[i][axis] = hi;
+        }
+        childMin[i] = decode(min, step, node.min[i]);
+    }
+
+    compress(flat, children[0], childMin[0]);
+    compress(flat, children[1], childMin[1]);
+}
+
+bool CompressedBVH::hit(const Ray& ray, Interval t, HitRecord& hitRecord) const {
+    struct Entry {
+        uint32_t index;
+        float near;
+        glm::vec3 min;
+    };
+
+    glm::vec3 invDirection = 1.0f / ray.direction;
+    float near;
+    Counters::add(Counter::BoxTests);
+    if (!intersect(min, max, ray.origin, invDirection, t, near)) {
+        return false;
+    }
+
+    Entry stack[64];
+    int top = 0;
+    Entry current = {0, near, min};
+    bool hitted = false;
+
+    while (true) {
+        const auto& node = nodes[current.index];
+        if (node.count > 0) {
+            for (uint32_t i = node.offset; i < node.offset + node.count; i++) {
+                if (primitives[i]->hit(ray, t, hitRecord)) {
+                    t.max = hitRecord.t;
+                    hitted = true;
+                }
+            }
+        } else {
+            glm::vec3 step = scale(node.exponent);
+            Entry children[2] = {{current.index + 1}, {node.offset}};
+            Counters::add(Counter::BoxTests, 2);
+            bool hits[2];
+            for (int i = 0; i < 2; i++) {
+                children[i].min = decode(current.min, step, node.min[i]);
+                glm::vec3 max = decode(current.min, step, node.max[i]);
+                hits[i] = intersect(children[i].min, max, ray.origin, invDirection, t, children[i].near);
+            }
+
+            if (hits[0] && hits[1]) {
+                bool swap = children[1].near < children[0].near;
+                stack[top++] = children[swap ? 0 : 1];
+                current = children[swap ? 1 : 0];
+                continue;
+            }
+            if (hits[0] || hits[1]) {
+                current = children[hits[0] ? 0 : 1];
+                continue;
+            }
+        }
+
+        // entries pushed before a closer hit was found may be culled now
+        do {
+            if (top == 0) {
+                return hitted;
+            }
+            current = stack[--top];
+        } while (current.near > t.max);
+    }
+}
+
+size_t CompressedBVH::memory() const {
+    return nodes.capacity() * sizeof(CompressedNode) + primitives.capacity() * sizeof(std::shared_ptr<Hittable>);
+}
\ No newline at end of file
@@ -0,0 +1,702 @@
+#include "hittable/flat_bvh.hpp"
+#include "tools/profiler.hpp"
+#include <numeric>
+#include <execution>
+
+namespace {
+
+constexpr uint32_t none = UINT32_MAX;
+
+// nodes holding more primitives than `taskSize` are split one at a time with their primitives
+// processed in parallel, the subtrees below are built concurrently
+constexpr uint32_t taskSize = 1 << 14;
+constexpr uint32_t chunkSize = 1 << 13;
+
+struct Bounds {
+    glm::vec3 min = glm::vec3(infinity);
+    glm::vec3 max = glm::vec3(-infinity);
+
+    void grow(const glm::vec3& p) {
+        min = glm::min(min, p);
+        max = glm::max(max, p);
+    }
+
+    void grow(const Bounds& b) {
+        min = glm::min(min, b.min);
+        max = glm::max(max, b.max);
+    }
+
+    float area() const {
+        glm::vec3 d = glm::max(max - min, glm::vec3(0.0f));
+        return 2.0f * (d.x * d.y + d.y * d.z + d.z * d.x);
+    }
+};
+
+Bounds bounds(const AABB& aabb) {
+    return {glm::vec3(aabb.x.min, aabb.y.min, aabb.z.min), glm::vec3(aabb.x.max, aabb.y.max, aabb.z.max)};
+}
+
+uint32_t chunks(uint32_t count) {
+    return std::max(1u, (count + chunkSize - 1) / chunkSize);
+}
+
+// calls `f(first, last, chunk)` for [begin, end) cut into chunks, on the pool the renderer traces with
+template<typename F>
+void parallelChunks(uint32_t begin, uint32_t end, F&& f) {
+    if (end - begin <= chunkSize) {
+        f(begin, end, 0u);
+        return;
+    }
+    std::vector<uint32_t> indices(chunks(end - begin));
+    std::iota(indices.begin(), indices.end(), 0);
+    std::for_each(std::execution::par, indices.begin(), indices.end(), [&](uint32_t chunk) {
+        uint32_t first = begin + chunk * chunkSize;
+        f(first, std::min(first + chunkSize, end), chunk);
+    });
+}
+
+// Top-down construction shared by the builders. Nodes above `taskSize` primitives are split through
+// `Builder::partition` into a small tree of their own, then every subtree below is built by
+// `Builder::build` as an independent task and the results are spliced in depth-first order.
+template<typename Builder>
+class TaskTree {
+public:
+    explicit TaskTree(const Builder& builder) : builder_(builder) {}
+
+    std::vector<FlatNode> build(uint32_t count) {
+        std::vector<FlatNode> nodes;
+        nodes.reserve(std::max<size_t>(1, 2 * (size_t)count));
+        if (count <= taskSize) {
+            builder_.build(nodes, 0, count, 0);
+            return nodes;
+        }
+
+        top(0, count, 0);
+        std::for_each(std::execution::par, tasks_.begin(), tasks_.end(), [&](Task& task) {
+            task.nodes.reserve(2 * (task.end - task.begin));
+            builder_.build(task.nodes, task.begin, task.end, task.depth);
+        });
+        emit(0, nodes);
+        return nodes;
+    }
+
+private:
+    struct TopNode {
+        uint32_t second;
+        uint32_t task;
+        uint16_t axis;
+    };
+
+    struct Task {
+        uint32_t begin, end;
+        int depth;
+        std::vector<FlatNode> nodes; // interior offsets relative to the subtree
+    };
+
+    uint32_t top(uint32_t begin, uint32_t end, int depth) {
+        uint32_t index = top_.size();
+        top_.push_back({none, none, 0});
+        if (end - begin <= taskSize) {
+            top_[index].task = tasks_.size();
+            tasks_.push_back({begin, end, depth, {}});
+            return index;
+        }
+
+        auto [mid, axis] = builder_.partition(begin, end, depth);
+        top(begin, mid, depth + 1);
+        uint32_t second = top(mid, end, depth + 1);
+        top_[index].second = second;
+        top_[index].axis = axis;
+        return index;
+    }
+
+    uint32_t emit(uint32_t index, std::vector<FlatNode>& nodes) const {
+        uint32_t at = nodes.size();
+        const auto& node = top_[index];
+        if (node.task != none) {
+            for (FlatNode child : tasks_[node.task].nodes) {
+                child.offset += child.count > 0 ? 0 : at;
+                nodes.push_back(child);
+            }
+            return at;
+        }
+
+        nodes.emplace_back();
+        emit(index + 1, nodes);
+        uint32_t second = emit(node.second, nodes);
+        nodes[at].min = glm::min(nodes[at + 1].min, nodes[second].min);
+        nodes[at].max = glm::max(nodes[at + 1].max, nodes[second].max);
+        nodes[at].offset = second;
+        nodes[at].count = 0;
+        nodes[at].axis = node.axis;
+        return at;
+    }
+
+private:
+    const Builder& builder_;
+    std::vector<TopNode> top_;
+    std::vector<Task> tasks_;
+};
+
+// binned SAH, parallel binning and partitioning at the top levels
+class SAHBuilder {
+public:
+    static constexpr int binCount = 16;
+    static constexpr int maxSAHDepth = 32;
+
+    SAHBuilder(const std::vector<AABB>& boxes, std::vector<uint32_t>& order, uint32_t leafSize)
+        : order_(order), leafSize_(leafSize) {
+        boxes_.resize(boxes.size());
+        centroids_.resize(boxes.size());
+        parallelChunks(0, boxes.size(), [&](uint32_t first, uint32_t last, uint32_t) {
+            for (uint32_t i = first; i < last; i++) {
+                boxes_[i] = bounds(boxes[i]);
+                centroids_[i] = (boxes_[i].min + boxes_[i].max) * 0.5f;
+            }
+        });
+        order_.resize(boxes.size());
+        std::iota(order_.begin(), order_.end(), 0);
+    }
+
+    std::vector<FlatNode> build() const {
+        return TaskTree<SAHBuilder>(*this).build(order_.size());
+    }
+
+    // splits a node too large for one task, `mid` is always strictly inside the range
+    std::pair<uint32_t, uint16_t> partition(uint32_t begin, uint32_t end, int depth) const {
+        std::vector<std::pair<Bounds, Bounds>> partial(chunks(end - begin));
+        parallelChunks(begin, end, [&](uint32_t first, uint32_t last, uint32_t chunk) {
+            auto& [box, centroid] = partial[chunk];
+            for (uint32_t i = first; i < last; i++) {
+                box.grow(boxes_[order_[i]]);
+                centroid.grow(centroids_[order_[i]]);
+            }
+        });
+        Bounds box, centroid;
+        for (const auto& [b, c] : partial) {
+            box.grow(b);
+            centroid.grow(c);
+        }
+
+        int axis = longestAxis(centroid);
+        uint32_t mid = begin;
+        if (centroid.max[axis] > centroid.min[axis] && depth < maxSAHDepth) {
+            mid = split(begin, end, axis, centroid, box, end - begin, true);
+        }
+        if (mid == begin || mid == end) {
+            mid = median(begin, end, axis, true);
+        }
+        return {mid, (uint16_t)axis};
+    }
+
+    uint32_t build(std::vector<FlatNode>& nodes, uint32_t begin, uint32_t end, int depth) const {
+        uint32_t index = nodes.size();
+        nodes.emplace_back();
+
+        Bounds box, centroid;
+        for (uint32_t i = begin; i < end; i++) {
+            box.grow(boxes_[order_[i]]);
+            centroid.grow(centroids_[order_[i]]);
+        }
+        nodes[index].min = box.min;
+        nodes[index].max = box.max;
+
+        uint32_t count = end - begin;
+        int axis = longestAxis(centroid);
+        if (count <= leafSize_) {
+            return leaf(nodes, index, begin, count);
+        }
+
+        uint32_t mid = begin + count / 2;
+        if (centroid.max[axis] - centroid.min[axis] > 0.0f) {
+            mid = depth < maxSAHDepth ? split(begin, end, axis, centroid, box, count, false) : begin;
+        }
+        if (mid == end) {
+            return leaf(nodes, index, begin, count);
+        }
+        if (mid == begin) {
+            mid = median(begin, end, axis, false);
+        }
+
+        build(nodes, begin, mid, depth + 1);
+        uint32_t second = build(nodes, mid, end, depth + 1);
+        nodes[index].offset = second;
+        nodes[index].count = 0;
+        nodes[index].axis = axis;
+        return index;
+    }
+
+private:
+    struct Bins {
+        Bounds bounds[binCount];
+        uint32_t counts[binCount] = {};
+    };
+
+    static int longestAxis(const Bounds& centroid) {
+        glm::vec3 extent = centroid.max - centroid.min;
+        return extent.x > extent.y ? (extent.x > extent.z ? 0 : 2) : (extent.y > extent.z ? 1 : 2);
+    }
+
+    uint32_t median(uint32_t begin, uint32_t end, int axis, bool parallel) const {
+        uint32_t mid = begin + (end - begin) / 2;
+        auto first = order_.begin() + begin, nth = order_.begin() + mid, last = order_.begin() + end;
+        auto less = [&](uint32_t a, uint32_t b) {
+            return centroids_[a][axis] < centroids_[b][axis];
+        };
+        if (parallel) {
+            std::nth_element(std::execution::par, first, nth, last, less);
+        } else {
+            std::nth_element(first, nth, last, less);
+        }
+        return mid;
+    }
+
+    // returns `end` when a leaf is cheaper, `begin` when binning failed to separate the primitives
+    uint32_t split(uint32_t begin, uint32_t end, int axis, const Bounds& centroid, const Bounds& box, uint32_t count, bool parallel) const {
+        float scale = binCount / (centroid.max[axis] - centroid.min[axis]);
+        auto binOf = [&](uint32_t primitive) {
+            int bin = int((centroids_[primitive][axis] - centroid.min[axis]) * scale);
+            return glm::clamp(bin, 0, binCount - 1);
+        };
+        auto fill = [&](Bins& bins, uint32_t first, uint32_t last) {
+            for (uint32_t i = first; i < last; i++) {
+                int bin = binOf(order_[i]);
+                bins.bounds[bin].grow(boxes_[order_[i]]);
+                bins.counts[bin]++;
+            }
+        };
+
+        Bins bins;
+        if (parallel) {
+            std::vector<Bins> partial(chunks(count));
+            parallelChunks(begin, end, [&](uint32_t first, uint32_t last, uint32_t chunk) {
+                fill(partial[chunk], first, last);
+            });
+            for (const auto& other : partial) {
+                for (int i = 0; i < binCount; i++) {
+                    bins.bounds[i].grow(other.bounds[i]);
+                    bins.counts[i] += other.counts[i];
+                }
+            }
+        } else {
+            fill(bins, begin, end);
+        }
+
+        float rightArea[binCount];
+        uint32_t rightCount[binCount];
+        Bounds right;
+        uint32_t n = 0;
+        for (int i = binCount - 1; i > 0; i--) {
+            right.grow(bins.bounds[i]);
+            n += bins.counts[i];
+            rightArea[i] = right.area();
+            rightCount[i] = n;
+        }
+
+        Bounds left;
+        n = 0;
+        float bestCost = infinity;
+        int best = -1;
+        for (int i = 0; i < binCount - 1; i++) {
+            left.grow(bins.bounds[i]);
+            n += bins.counts[i];
+            if (n == 0 || rightCount[i + 1] == 0) {
+                continue;
+            }
+            float cost = left.area() * n + rightArea[i + 1] * rightCount[i + 1];
+            if (cost < bestCost) {
+                bestCost = cost;
+                best = i;
+            }
+        }
+
+        if (best < 0) {
+            return begin;
+        }
+
+        // traversal step cost of 1 against an intersection cost of 1 per primitive
+        float leafCost = (float)count;
+        float splitCost = 1.0f + bestCost / box.area();
+        if (splitCost >= leafCost && count <= 4 * leafSize_) {
+            return end;
+        }
+
+        auto first = order_.begin() + begin, last = order_.begin() + end;
+        auto inLeft = [&](uint32_t primitive) {
+            return binOf(primitive) <= best;
+        };
+        auto it = parallel ? std::partition(std::execution::par, first, last, inLeft) : std::partition(first, last, inLeft);
+        return uint32_t(it - order_.begin());
+    }
+
+    uint32_t leaf(std::vector<FlatNode>& nodes, uint32_t index, uint32_t begin, uint32_t count) const {
+        nodes[index].offset = begin;
+        nodes[index].count = count;
+        nodes[index].axis = 0;
+        return index;
+    }
+
+private:
+    std::vector<Bounds> boxes_;
+    std::vector<glm::vec3> centroids_;
+    std::vector<uint32_t>& order_;
+    uint32_t leafSize_;
+};
+
+// spreads the low 10 bits of v so that two zero bits follow each of them
+uint32_t expandBits(uint32_t v) {
+    v = (v * 0x00010001u) & 0xFF0000FFu;
+    v = (v * 0x00000101u) & 0x0F00F00Fu;
+    v = (v * 0x00000011u) & 0xC30C30C3u;
+    v = (v * 0x00000005u) & 0x49249249u;
+    return v;
+}
+
+int highestBit(uint32_t v) {
+    int bit = 0;
+    while (v >>= 1) {
+        bit++;
+    }
+    return bit;
+}
+
+// LBVH: primitives sorted along a 30-bit Morton curve through their centroids, every node splits
+// its range where the highest differing bit flips. Builds far faster than SAH at some traversal cost.
+class MortonBuilder {
+public:
+    MortonBuilder(const std::vector<AABB>& boxes, std::vector<uint32_t>& order, uint32_t leafSize)
+        : order_(order), leafSize_(leafSize) {
+        uint32_t count = boxes.size();
+        boxes_.resize(count);
+        std::vector<Bounds> partial(chunks(count));
+        parallelChunks(0, count, [&](uint32_t first, uint32_t last, uint32_t chunk) {
+            for (uint32_t i = first; i < last; i++) {
+                boxes_[i] = bounds(boxes[i]);
+                partial[chunk].grow((boxes_[i].min + boxes_[i].max) * 0.5f);
+            }
+        });
+        Bounds centroid;
+        for (const auto& b : partial) {
+            centroid.grow(b);
+        }
+        glm::vec3 scale(0.0f);
+        for (int axis = 0; axis < 3; axis++) {
+            float extent = centroid.max[axis] - centroid.min[axis];
+            scale[axis] = extent > 0.0f ? 1023.0f / extent : 0.0f;
+        }
+
+        // code in the high half, index in the low half, so equal codes keep a deterministic order
+        std::vector<uint64_t> keys(count);
+        parallelChunks(0, count, [&](uint32_t first, uint32_t last, uint32_t) {
+            for (uint32_t i = first; i < last; i++) {
+                glm::uvec3 cell = glm::uvec3(glm::clamp(((boxes_[i].min + boxes_[i].max) * 0.5f - centroid.min) * scale, 0.0f, 1023.0f));
+                uint32_t code = expandBits(cell.x) << 2 | expandBits(cell.y) << 1 | expandBits(cell.z);
+                keys[i] = (uint64_t)code << 32 | i;
+            }
+        });
+        if (count > taskSize) {
+            std::sort(std::execution::par, keys.begin(), keys.end());
+        } else {
+            std::sort(keys.begin(), keys.end());
+        }
+
+        order_.resize(count);
+        codes_.resize(count);
+        parallelChunks(0, count, [&](uint32_t first, uint32_t last, uint32_t) {
+            for (uint32_t i = first; i < last; i++) {
+                order_[i] = uint32_t(keys[i]);
+                codes_[i] = uint32_t(keys[i] >> 32);
+            }
+        });
+    }
+
+    std::vector<FlatNode> build() const {
+        return TaskTree<MortonBuilder>(*this).build(order_.size());
+    }
+
+    // x, y and z occupy bits 3k + 2, 3k + 1 and 3k of the code
+    std::pair<uint32_t, uint16_t> partition(uint32_t begin, uint32_t end, int) const {
+        uint32_t difference = codes_[begin] ^ codes_[end - 1];
+        if (difference == 0) {
+            return {begin + (end - begin) / 2, 0};
+        }
+        int bit = highestBit(difference);
+        auto it = std::partition_point(codes_.begin() + begin, codes_.begin() + end, [&](uint32_t code) {
+            return ((code >> bit) & 1u) == 0;
+        });
+        return {uint32_t(it - codes_.begin()), uint16_t(2 - bit % 3)};
+    }
+
+    uint32_t build(std::vector<FlatNode>& nodes, uint32_t begin, uint32_t end, int depth) const {
+        uint32_t index = nodes.size();
+        nodes.emplace_back();
+
+        uint32_t count = end - begin;
+        if (count <= leafSize_) {
+            Bounds box;
+            for (uint32_t i = begin; i < end; i++) {
+                box.grow(boxes_[order_[i]]);
+            }
+            nodes[index].min = box.min;
+            nodes[index].max = box.max;
+            nodes[index].offset = begin;
+            nodes[index].count = count;
+            nodes[index].axis = 0;
+            return index;
+        }
+
+        auto [mid, axis] = partition(begin, end, depth);
+        build(nodes, begin, mid, depth + 1);
+        uint32_t second = build(nodes, mid, end, depth + 1);
+        nodes[index].min = glm::min(nodes[index + 1].min, nodes[second].min);
+        nodes[index].max = glm::max(nodes[index + 1].max, nodes[second].max);
+        nodes[index].offset = second;
+        nodes[index].count = 0;
+        nodes[index].axis = axis;
+        return index;
+    }
+
+private:
+    std::vector<Bounds> boxes_;
+    std::vector<uint32_t> codes_; // sorted, parallel to order_
+    std::vector<uint32_t>& order_;
+    uint32_t leafSize_;
+};
+
+} // namespace
+
+std::vector<FlatNode> FlatBVH::build(const std::vector<AABB>& boxes, std::vector<uint32_t>& order, uint32_t leafSize, Build method) {
+    // the node array is the build's one allocation
+    Counters::add(Counter::Allocations);
+    if (method == Build::Morton) {
+        PROFILE_ZONE("build LBVH");
+        return MortonBuilder(boxes, order, leafSize).build();
+    }
+    PROFILE_ZONE("build BVH");
+    return SAHBuilder(boxes, order, leafSize).build();
+}
+
+FlatBVH::FlatBVH(const std::shared_ptr<HittableList>& list, uint32_t leafSize, Build method)
+    : method(method), leafSize_(leafSize) {
+    std::vector<AABB> boxes;
+    boxes.reserve(list->hittables.size());
+    for (const auto& hittable : list->hittables) {
+        boxes.push_back(hittable->aabb);
+    }
+
+    std::vector<uint32_t> order;
+    nodes = build(boxes, order, leafSize, method);
+
+    primitives.reserve(order.size());
+    for (uint32_t i : order) {
+        primitives.push_back(list->hittables[i]);
+    }
+    aabb = list->aabb;
+
+    link();
+    built_ = cost_;
+}
+
+bool FlatBVH::hit(const Ray& ray, Interval t, HitRecord& hitRecord) const {
+    return traverse(nodes, ray, t, [&](uint32_t i, Interval& range) {
+        if (!primitives[i]->hit(ray, range, hitRecord)) {
+            return false;
+        }
+        range.max = hitRecord.t;
+        return true;
+    });
+}
+
+void FlatBVH::update(uint32_t primitive) {
+    // ancestors of a dirty node are dirty already, the walk stops at the first one
+    for (uint32_t index = leafOf_[primitive]; index != none && !dirty_[index]; index = parents_[index]) {
+        dirty_[index] = 1;
+        dirtyNodes_.push_back(index);
+    }
+}
+
+void FlatBVH::update(const Hittable* primitive) {
+    if (indices_.empty()) {
+        for (uint32_t i = 0; i < primitives.size(); i++) {
+            indices_[primitives[i].get()] = i;
+        }
+    }
+    auto it = indices_.find(primitive);
+    if (it != indices_.end()) {
+        update(it->second);
+    }
+}
+
+FlatBVH::Refit FlatBVH::refit() {
+    if (dirtyNodes_.empty() || primitives.empty()) {
+        return Refit::None;
+    }
+    PROFILE_ZONE("refit BVH");
+    revision_++;
+
+    // children always follow their parent, so descending indices refit bottom-up
+    std::sort(dirtyNodes_.begin(), dirtyNodes_.end(), std::greater<uint32_t>());
+    for (uint32_t index : dirtyNodes_) {
+        recompute(index);
+    }
+
+    // topmost refitted subtrees that degraded too far, ascending indices visit parents first
+    std::vector<uint32_t> degraded;
+    for (auto it = dirtyNodes_.rbegin(); it != dirtyNodes_.rend(); ++it) {
+        uint32_t index = *it;
+        uint32_t parent = parents_[index];
+        if (parent != none && dirty_[parent] == 2) {
+            dirty_[index] = 2;
+        } else if (nodes[index].count == 0 && built_[index] > 0.0f && cost_[index] > partialThreshold * built_[index]) {
+            degraded.push_back(index);
+            dirty_[index] = 2;
+        }
+    }
+    for (uint32_t index : dirtyNodes_) {
+        dirty_[index] = 0;
+    }
+    dirtyNodes_.clear();
+    aabb = AABB(nodes[0].min, nodes[0].max);
+
+    if (degradation() > rebuildThreshold || (!degraded.empty() && degraded.front() == 0)) {
+        rebuild();
+        return Refit::Rebuild;
+    }
+    if (degraded.empty()) {
+        return Refit::Refitted;
+    }
+
+    // a splice only moves the nodes after it, so higher subtrees go first
+    for (auto it = degraded.rbegin(); it != degraded.rend(); ++it) {
+        rebuild(*it);
+    }
+    link();
+    for (size_t i = 0; i < built_.size(); i++) {
+        if (built_[i] < 0.0f) {
+            built_[i] = cost_[i];
+        }
+    }
+    indices_.clear();
+    return Refit::PartialRebuild;
+}
+
+void FlatBVH::rebuild() {
+    if (primitives.empty()) {
+        return;
+    }
+    PROFILE_ZONE("rebuild BVH");
+    revision_++;
+    std::vector<AABB> boxes;
+    boxes.reserve(primitives.size());
+    for (const auto& primitive : primitives) {
+        boxes.push_back(primitive->aabb);
+    }
+
+    std::vector<uint32_t> order;
+    nodes = build(boxes, order, leafSize_, method);
+
+    std::vector<std::shared_ptr<Hittable>> reordered;
+    reordered.reserve(order.size());
+    for (uint32_t i : order) {
+        reordered.push_back(std::move(primitives[i]));
+    }
+    primitives = std::move(reordered);
+
+    link();
+    built_ = cost_;
+    dirtyNodes_.clear();
+    indices_.clear();
+    aabb = AABB(nodes[0].min, nodes[0].max);
+}
+
+// the subtree at `index` covers nodes [index, end) and primitives [first, last), both contiguous
+void FlatBVH::rebuild(uint32_t index) {
+    uint32_t node = index;
+    while (nodes[node].count == 0) {
+        node = node + 1;
+    }
+    uint32_t first = nodes[node].offset;
+
+    node = index;
+    while (nodes[node].count == 0) {
+        node = nodes[node].offset;
+    }
+    uint32_t last = nodes[node].offset + nodes[node].count;
+    uint32_t end = node + 1;
+
+    std::vector<AABB> boxes;
+    boxes.reserve(last - first);
+    for (uint32_t i = first; i < last; i++) {
+        boxes.push_back(primitives[i]->aabb);
+    }
+    std::vector<uint32_t> order;
+    std::vector<FlatNode> subtree = build(boxes, order, leafSize_, method);
+    for (auto& child : subtree) {
+        child.offset += child.count > 0 ? first : index;
+    }
+
+    std::vector<std::shared_ptr<Hittable>> reordered;
+    reordered.reserve(order.size());
+    for (uint32_t i : order) {
+        reordered.push_back(std::move(primitives[first + i]));
+    }
+    std::move(reordered.begin(), reordered.end(), primitives.begin() + first);
+
+    int64_t delta = (int64_t)subtree.size() - (int64_t)(end - index);
+    for (uint32_t i = 0; i < nodes.size(); i++) {
+        if ((i < index || i >= end) && nodes[i].count == 0 && nodes[i].offset >= end) {
+            nodes[i].offset += delta;
+        }
+    }
+    nodes.erase(nodes.begin() + index, nodes.begin() + end);
+    nodes.insert(nodes.begin() + index, subtree.begin(), subtree.end());
+    built_.erase(built_.begin() + index, built_.begin() + end);
+    built_.insert(built_.begin() + index, subtree.size(), -1.0f);
+}
+
+void FlatBVH::link() {
+    if (primitives.empty()) {
+        return;
+    }
+    parents_.assign(nodes.size(), none);
+    leafOf_.assign(primitives.size(), none);
+    dirty_.assign(nodes.size(), 0);
+    cost_.assign(nodes.size(), 0.0f);
+    for (uint32_t i = 0; i < nodes.size(); i++) {
+        const auto& node = nodes[i];
+        if (node.count == 0) {
+            parents_[i + 1] = i;
+            parents_[node.offset] = i;
+        } else {
+            std::fill(leafOf_.begin() + node.offset, leafOf_.begin() + node.offset + node.count, i);
+        }
+    }
+    for (uint32_t i = nodes.size(); i-- > 0;) {
+        const auto& node = nodes[i];
+        Bounds box = {node.min, node.max};
+        cost_[i] = node.count > 0 ? box.area() * node.count : box.area() + cost_[i + 1] + cost_[node.offset];
+    }
+}
+
+void FlatBVH::recompute(uint32_t index) {
+    auto& node = nodes[index];
+    Bounds box;
+    if (node.count > 0) {
+        for (uint32_t i = node.offset; i < node.offset + node.count; i++) {
+            box.grow(bounds(primitives[i]->aabb));
+        }
+        cost_[index] = box.area() * node.count;
+    } else {
+        const auto& left = nodes[index + 1];
+        const auto& right = nodes[node.offset];
+        box.grow(Bounds{left.min, left.max});
+        box.grow(Bounds{right.min, right.max});
+        cost_[index] = box.area() + cost_[index + 1] + cost_[node.offset];
+    }
+    node.min = box.min;
+    node.max = box.max;
+}
+
+size_t FlatBVH::memory() const {
+    return nodes.capacity() * sizeof(FlatNode) + primitives.capacity() * sizeof(std::shared_ptr<Hittable>);
+}
\ No newline at end of file
@@ -0,0 +1,143 @@
+#include "hittable/grid.hpp"
+#include "hittable/accelerator.hpp"
+#include "tools/counters.hpp"
+
+Grid::Grid(const std::shared_ptr<HittableList>& list, float density) : primitives(list->hittables) {
+    aabb = list->aabb;
+
+    std::vector<uint32_t> bounded;
+    glm::vec3 min(infinity), max(-infinity);
+    for (uint32_t i = 0; i < primitives.size(); i++) {
+        const auto& box = primitives[i]->aabb;
+        if (!::bounded(box)) {
+            unbounded_.push_back(i);
+            continue;
+        }
+        bounded.push_back(i);
+        min = glm::min(min, glm::vec3(box.x.min, box.y.min, box.z.min));
+        max = glm::max(max, glm::vec3(box.x.max, box.y.max, box.z.max));
+    }
+    if (bounded.empty()) {
+        offsets_.assign(2, 0);
+        return;
+    }
+
+    // cells as close to cubes as the bounds allow, flat axes get one cell
+    glm::vec3 extent = max - min;
+    float largest = glm::max(extent.x, glm::max(extent.y, extent.z));
+    extent = glm::max(extent, glm::vec3(largest * 1e-3f + 1e-6f));
+    float cellsPerUnit = glm::pow(density * bounded.size() / (extent.x * extent.y * extent.z), 1.0f / 3.0f);
+    for (int axis = 0; axis < 3; axis++) {
+        resolution_[axis] = glm::clamp(int(extent[axis] * cellsPerUnit), 1, maxResolution);
+    }
+    while ((size_t)resolution_.x * resolution_.y * resolution_.z > maxCells) {
+        resolution_ = glm::max(resolution_ / 2, glm::ivec3(1));
+    }
+    min_ = min;
+    max_ = min + extent;
+    cellSize_ = extent / glm::vec3(resolution_);
+
+    // counting pass, prefix sum, then the same loops fill the entries
+    size_t cells = (size_t)resolution_.x * resolution_.y * resolution_.z;
+    offsets_.assign(cells + 1, 0);
+    auto overlap = [&](uint32_t primitive, auto&& visit) {
+        const auto& box = primitives[primitive]->aabb;
+        glm::ivec3 lo = cell(glm::vec3(box.x.min, box.y.min, box.z.min));
+        glm::ivec3 hi = cell(glm::vec3(box.x.max, box.y.max, box.z.max));
+        for (int z = lo.z; z <= hi.z; z++) {
+            for (int y = lo.y; y <= hi.y; y++) {
+                for (int x = lo.x; x <= hi.x; x++) {
+                    visit(((size_t)z * resolution_.y + y) * resolution_.x + x);
+                }
+            }
+        }
+    };
+    for (uint32_t i : bounded) {
+        overlap(i, [&](size_t c) { offsets_[c + 1]++; });
+    }
+    for (size_t c = 0; c < cells; c++) {
+        offsets_[c + 1] += offsets_[c];
+    }
+    entries_.resize(offsets_[cells]);
+    std::vector<uint32_t> fill(offsets_.begin(), offsets_.end() - 1);
+    for (uint32_t i : bounded) {
+        overlap(i, [&](size_t c) { entries_[fill[c]++] = i; });
+    }
+}
+
+glm::ivec3 Grid::cell(const glm::vec3& point) const {
+    return glm::clamp(glm::ivec3((point - min_) / cellSize_), glm::ivec3(0), resolution_ - 1);
+}
+
+bool Grid::hit(const Ray& ray, Interval t, HitRecord& hitRecord) const {
+    bool hitted = false;
+    for (uint32_t i : unbounded_) {
+        if (primitives[i]->hit(ray, t, hitRecord)) {
+            hitted = true;
+            t.max = hitRecord.t;
+        }
+    }
+    if (entries_.empty()) {
+        return hitted;
+    }
+
+    // clip against the grid bounds
+    glm::vec3 invDirection = 1.0f / ray.direction;
+    float enter, exit;
+    if (!clip(ray, invDirection, min_, max_, t, enter, exit)) {
+        return hitted;
+    }
+
+    glm::ivec3 index = cell(ray.hitPoint(enter));
+    glm::ivec3 step, end;
+    glm::vec3 next, delta;
+    for (int axis = 0; axis < 3; axis++) {
+        if (ray.direction[axis] > 0.0f) {
+            step[axis] = 1;
+            end[axis] = resolution_[axis];
+            next[axis] = (min_[axis] + (index[axis] + 1) * cellSize_[axis] - ray.origin[axis]) * invDirection[axis];
+            delta[axis] = cellSize_[axis] * invDirection[axis];
+        } else if (ray.direction[axis] < 0.0f) {
+            step[axis] = -1;
+            end[axis] = -1;
+            next[axis] = (min_[axis] + index[axis] * cellSize_[axis] - ray.origin[axis]) * invDirection[axis];
+            delta[axis] = -cellSize_[axis] * invDirection[axis];
+        } else {
+            step[axis] = 0;
+            end[axis] = -1;
+            next[axis] = infinity;
+            delta[axis] = infinity;
+        }
+    }
+
+    uint32_t visited = 0;
+    while (true) {
+        visited++;
+        size_t c = ((size_t)index.z * resolution_.y + index.y) * resolution_.x + index.x;
+        for (uint32_t e = offsets_[c]; e < offsets_[c + 1]; e++) {
+            if (primitives[entries_[e]]->hit(ray, t, hitRecord)) {
+                hitted = true;
+                t.max = hitRecord.t;
+            }
+        }
+
+        // a hit inside this cell cannot be beaten by a later one, a hit beyond it still can
+        int axis = next.x < next.y ? (next.x < next.z ? 0 : 2) : (next.y < next.z ? 1 : 2);
+        if (t.max <= next[axis] || next[axis] > exit) {
+            break;
+        }
+        index[axis] += step[axis];
+        if (index[axis] == end[axis]) {
+            break;
+        }
+        next[axis] += delta[axis];
+    }
+
+    Counters::add(Counter::BoxTests, visited);
+    return hitted;
+}
+
+size_t Grid::memory() const {
+    return offsets_.capacity() * sizeof(uint32_t) + entries_.capacity() * sizeof(uint32_t) +
+           unbounded_.capacity() * sizeof(uint32_t) + primitives.capacity() * sizeof(std::shared_ptr<Hittable>);
+}
\ No newline at end of file
@@ -0,0 +1,209 @@
+#include "hittable/kd_tree.hpp"
+#include "hittable/accelerator.hpp"
+#include "tools/counters.hpp"
+#include <cassert>
+
+namespace {
+
+float area(const glm::vec3& extent) {
+    return 2.0f * (extent.x * extent.y + extent.y * extent.z + extent.z * extent.x);
+}
+
+glm::vec3 lower(const AABB& box) {
+    return glm::vec3(box.x.min, box.y.min, box.z.min);
+}
+
+glm::vec3 upper(const AABB& box) {
+    return glm::vec3(box.x.max, box.y.max, box.z.max);
+}
+
+} // namespace
+
+KDTree::KDTree(const std::shared_ptr<HittableList>& list, uint32_t leafSize)
+    : primitives(list->hittables), leafSize_(leafSize) {
+    aabb = list->aabb;
+
+    std::vector<AABB> boxes;
+    std::vector<uint32_t> items;
+    boxes.reserve(primitives.size());
+    for (uint32_t i = 0; i < primitives.size(); i++) {
+        boxes.push_back(primitives[i]->aabb);
+        if (!bounded(boxes.back())) {
+            unbounded_.push_back(i);
+            continue;
+        }
+        items.push_back(i);
+        bounds_ = AABB(bounds_, boxes.back());
+    }
+
+    // the usual 8 + 1.3 log2(n) bound on the depth keeps duplication in check
+    maxDepth_ = glm::min(depthLimit, 8 + uint32_t(1.3f * glm::log2(glm::max(1.0f, (float)items.size()))));
+    build(bounds_, items, boxes, 0);
+}
+
+void KDTree::leaf(const std::vector<uint32_t>& items) {
+    KDNode node;
+    node.split = 0.0f;
+    node.axis = 3;
+    node.offset = indices.size();
+    node.count = items.size();
+    nodes.push_back(node);
+    indices.insert(indices.end(), items.begin(), items.end());
+}
+
+void KDTree::build(const AABB& bounds, std::vector<uint32_t>& items, const std::vector<AABB>& boxes, uint32_t depth) {
+    if (items.size() <= leafSize_ || depth >= maxDepth_) {
+        leaf(items);
+        return;
+    }
+
+    glm::vec3 min = lower(bounds), max = upper(bounds);
+    glm::vec3 extent = max - min;
+    float invArea = 1.0f / glm::max(area(extent), 1e-12f);
+    float bestCost = intersectionCost * items.size();
+    int bestAxis = -1;
+    float bestSplit = 0.0f;
+
+    // starts[b]: boxes whose lower edge falls in bin b, ends[b]: boxes whose upper edge does
+    for (int axis = 0; axis < 3; axis++) {
+        if (extent[axis] <= 0.0f) {
+            continue;
+        }
+        uint32_t starts[bins] = {}, ends[bins] = {};
+        float scale = bins / extent[axis];
+        for (uint32_t i : items) {
+            const auto& interval = boxes[i].axis(axis);
+            starts[glm::clamp(int((interval.min - min[axis]) * scale), 0, int(bins) - 1)]++;
+            ends[glm::clamp(int((interval.max - min[axis]) * scale), 0, int(bins) - 1)]++;
+        }
+
+        uint32_t below = 0, above = items.size();
+        for (uint32_t b = 1; b < bins; b++) {
+            below += starts[b - 1];
+            above -= ends[b - 1];
+            float split = min[axis] + extent[axis] * b / bins;
+
+            glm::vec3 belowExtent = extent, aboveExtent = extent;
+            belowExtent[axis] = split - min[axis];
+            aboveExtent[axis] = max[axis] - split;
+            float bonus = below == 0 || above == 0 ? emptyBonus : 0.0f;
+            float cost = traversalCost + intersectionCost * (1.0f - bonus) *
+                         (area(belowExtent) * below + area(aboveExtent) * above) * invArea;
+            if (cost < bestCost) {
+                bestCost = cost;
+                bestAxis = axis;
+                bestSplit = split;
+            }
+        }
+    }
+    if (bestAxis < 0) {
+        leaf(items);
+        return;
+    }
+
+    std::vector<uint32_t> belowItems, aboveItems;
+    for (uint32_t i : items) {
+        const auto& interval = boxes[i].axis(bestAxis);
+        if (interval.min < bestSplit || (interval.min == bestSplit && interval.max == bestSplit)) {
+            belowItems.push_back(i);
+        }
+        if (interval.max > bestSplit) {
+            aboveItems.push_back(i);
+        }
+    }
+    items.clear();
+    items.shrink_to_fit();
+
+    glm::vec3 belowMax = max, aboveMin = min;
+    belowMax[bestAxis] = bestSplit;
+    aboveMin[bestAxis] = bestSplit;
+
+    uint32_t index = nodes.size();
+    KDNode node;
+    node.split = bestSplit;
+    node.axis = bestAxis;
+    node.offset = 0;
+    node.count = 0;
+    nodes.push_back(node);
+    build(AABB(min, belowMax), belowItems, boxes, depth + 1);
+    nodes[index].offset = nodes.size();
+    build(AABB(aboveMin, max), aboveItems, boxes, depth + 1);
+}
+
+bool KDTree::hit(const Ray& ray, Interval t, HitRecord& hitRecord) const {
+    bool hitted = false;
+    for (uint32_t i : unbounded_) {
+        if (primitives[i]->hit(ray, t, hitRecord)) {
+            hitted = true;
+            t.max = hitRecord.t;
+        }
+    }
+    if (indices.empty()) {
+        return hitted;
+    }
+
+    glm::vec3 invDirection = 1.0f / ray.direction;
+    float enter, exit;
+    if (!clip(ray, invDirection, lower(bounds_), upper(bounds_), t, enter, exit)) {
+        return hitted;
+    }
+
+    struct Entry {
+        uint32_t node;
+        float enter, exit;
+    };
+    Entry stack[depthLimit];
+    uint32_t top = 0;
+    uint32_t index = 0;
+    uint32_t visited = 0;
+
+    while (true) {
+        // every leaf still queued lies beyond the closest hit
+        if (t.max < enter) {
+            break;
+        }
+        const auto& node = nodes[index];
+        visited++;
+        if (node.axis != 3) {
+            float origin = ray.origin[node.axis];
+            float plane = (node.split - origin) * invDirection[node.axis];
+            bool belowFirst = origin < node.split || (origin == node.split && ray.direction[node.axis] <= 0.0f);
+            uint32_t first = belowFirst ? index + 1 : node.offset;
+            uint32_t second = belowFirst ? node.offset : index + 1;
+
+            if (plane > exit || plane <= 0.0f || plane != plane) {
+                index = first;
+            } else if (plane < enter) {
+                index = second;
+            } else {
+                assert(top < maxDepth_ && "kd-tree deeper than its depth limit");
+                stack[top++] = {second, plane, exit};
+                index = first;
+                exit = plane;
+            }
+            continue;
+        }
+
+        for (uint32_t i = node.offset; i < node.offset + node.count; i++) {
+            if (primitives[indices[i]]->hit(ray, t, hitRecord)) {
+                hitted = true;
+                t.max = hitRecord.t;
+            }
+        }
+        if (top == 0 || t.max <= exit) {
+            break;
+        }
+        top--;
+        index = stack[top].node;
+        enter = stack[top].enter;
+        exit = stack[top].exit;
+    }
+
+    Counters::add(Counter::BoxTests, visited);
+    return hitted;
+}
+
+size_t KDTree::memory() const {
+    return nodes.capacity() * sizeof(KDNode) + indices.capacity() * sizeof(uint32_t) +
+           unbounded_.capacity() * sizeof(uint32_t) + primitives.capacity() * sizeof(std::shared_ptr<Hittable>);
+}
\ No newline at end of file
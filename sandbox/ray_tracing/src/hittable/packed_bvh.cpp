@@ -0,0 +1,271 @@
+#include "hittable/packed_bvh.hpp"
+#include "hittable/bvh.hpp"
+#include "hittable/sphere.hpp"
+#include "hittable/quad.hpp"
+#include "tools/counters.hpp"
+#include "tools/simd.hpp"
+
+namespace {
+
+constexpr uint32_t lanes = simd::width;
+constexpr uint32_t none = UINT32_MAX;
+
+void flatten(const std::shared_ptr<Hittable>& hittable, std::vector<std::shared_ptr<Hittable>>& primitives) {
+    if (auto list = std::dynamic_pointer_cast<HittableList>(hittable)) {
+        for (const auto& child : list->hittables) {
+            flatten(child, primitives);
+        }
+    } else if (auto bvh = std::dynamic_pointer_cast<BVH>(hittable)) {
+        flatten(bvh->left, primitives);
+        if (bvh->right != bvh->left) {
+            flatten(bvh->right, primitives);
+        }
+    } else {
+        primitives.push_back(hittable);
+    }
+}
+
+// the lanes compute every root of the block at once, this scalar pass picks the closest
+uint32_t closest(const float roots[lanes], uint32_t count, uint32_t base, float& tHit) {
+    uint32_t index = none;
+    for (uint32_t i = 0; i < count; i++) {
+        if (roots[i] < tHit) {
+            tHit = roots[i];
+            index = base + i;
+        }
+    }
+    return index;
+}
+
+} // namespace
+
+void PackedSpheres::add(const Sphere& sphere) {
+    x.push_back(sphere.position.x);
+    y.push_back(sphere.position.y);
+    z.push_back(sphere.position.z);
+    radius.push_back(sphere.radius);
+    materials.push_back(sphere.material);
+}
+
+void PackedSpheres::pad() {
+    for (auto* array : {&x, &y, &z, &radius}) {
+        array->resize(materials.size() + lanes - 1, 0.0f);
+    }
+}
+
+uint32_t PackedSpheres::closest(uint32_t begin, uint32_t end, const Ray& ray, Interval t, float& tHit) const {
+    using namespace simd;
+    Float ox = broadcast(ray.origin.x), oy = broadcast(ray.origin.y), oz = broadcast(ray.origin.z);
+    Float dx = broadcast(ray.direction.x), dy = broadcast(ray.direction.y), dz = broadcast(ray.direction.z);
+    Float a = broadcast(glm::dot(ray.direction, ray.direction));
+    Float tMin = broadcast(t.min), tMax = broadcast(t.max), zero = broadcast(0.0f), miss = broadcast(infinity);
+
+    uint32_t index = none;
+    tHit = t.max;
+    for (uint32_t base = begin; base < end; base += lanes) {
+        uint32_t count = glm::min(lanes, end - base);
+
+        // lanes past the end of the leaf read the next leaf or the padding and are masked out
+        Float cx = load(x.data() + base) - ox, cy = load(y.data() + base) - oy, cz = load(z.data() + base) - oz;
+        Float r = load(radius.data() + base);
+        Float h = dx * cx + dy * cy + dz * cz;
+        Float c = cx * cx + cy * cy + cz * cz - r * r;
+        Float discriminant = h * h - a * c;
+        Float sqrtd = sqrt(max(discriminant, zero));
+        Float near = (h - sqrtd) / a;
+        Float far = (h + sqrtd) / a;
+        Float root = select((tMin < near) & (near < tMax), near, far);
+        Mask inside = (zero <= discriminant) & (tMin < root) & (root < tMax) & (simd::index() < broadcast(float(count)));
+        float roots[lanes];
+        store(roots, select(inside, root, miss));
+
+        uint32_t hit = ::closest(roots, count, base, tHit);
+        index = hit != none ? hit : index;
+    }
+
+    return index;
+}
+
+void PackedSpheres::record(uint32_t index, const Ray& ray, float t, HitRecord& hitRecord) const {
+    glm::vec3 center(x[index], y[index], z[index]);
+    hitRecord.t = t;
+    hitRecord.point = ray.hitPoint(t);
+    glm::vec3 normal = (hitRecord.point - center) / radius[index];
+    hitRecord.setNormal(ray, normal);
+    hitRecord.material = materials[index];
+    Sphere::uv(normal, hitRecord.u, hitRecord.v);
+}
+
+void PackedQuads::add(const Quad& quad) {
+    qx.push_back(quad.Q.x), qy.push_back(quad.Q.y), qz.push_back(quad.Q.z);
+    ux.push_back(quad.u.x), uy.push_back(quad.u.y), uz.push_back(quad.u.z);
+    vx.push_back(quad.v.x), vy.push_back(quad.v.y), vz.push_back(quad.v.z);
+    nx.push_back(quad.normal.x), ny.push_back(quad.normal.y), nz.push_back(quad.normal.z);
+    d.push_back(quad.D);
+    wx.push_back(quad.w.x), wy.push_back(quad.w.y), wz.push_back(quad.w.z);
+    materials.push_back(quad.material);
+}
+
+void PackedQuads::pad() {
+    for (auto* array : {&qx, &qy, &qz, &ux, &uy, &uz, &vx, &vy, &vz, &nx, &ny, &nz, &d, &wx, &wy, &wz}) {
+        array->resize(materials.size() + lanes - 1, 0.0f);
+    }
+}
+
+uint32_t PackedQuads::closest(uint32_t begin, uint32_t end, const Ray& ray, Interval t, float& tHit) const {
+    using namespace simd;
+    Float ox = broadcast(ray.origin.x), oy = broadcast(ray.origin.y), oz = broadcast(ray.origin.z);
+    Float dx = broadcast(ray.direction.x), dy = broadcast(ray.direction.y), dz = broadcast(ray.direction.z);
+    Float tMin = broadcast(t.min), tMax = broadcast(t.max), zero = broadcast(0.0f), one = broadcast(1.0f);
+    Float epsilon = broadcast(1e-8f), miss = broadcast(infinity);
+
+    uint32_t index = none;
+    tHit = t.max;
+    for (uint32_t base = begin; base < end; base += lanes) {
+        uint32_t count = glm::min(lanes, end - base);
+
+        Float nX = load(nx.data() + base), nY = load(ny.data() + base), nZ = load(nz.data() + base);
+        Float vX = load(vx.data() + base), vY = load(vy.data() + base), vZ = load(vz.data() + base);
+        Float uX = load(ux.data() + base), uY = load(uy.data() + base), uZ = load(uz.data() + base);
+        Float wX = load(wx.data() + base), wY = load(wy.data() + base), wZ = load(wz.data() + base);
+        Float denominator = nX * dx + nY * dy + nZ * dz;
+        Float root = (load(d.data() + base) - (nX * ox + nY * oy + nZ * oz)) / denominator;
+
+        Float px = ox + root * dx - load(qx.data() + base);
+        Float py = oy + root * dy - load(qy.data() + base);
+        Float pz = oz + root * dz - load(qz.data() + base);
+        Float alpha = wX * (py * vZ - pz * vY) + wY * (pz * vX - px * vZ) + wZ * (px * vY - py * vX);
+        Float beta = wX * (uY * pz - uZ * py) + wY * (uZ * px - uX * pz) + wZ * (uX * py - uY * px);
+
+        Mask inside = (epsilon <= abs(denominator)) & (tMin <= root) & (root <= tMax) &
+                   (zero <= alpha) & (alpha <= one) & (zero <= beta) & (beta <= one) &
+                   (simd::index() < broadcast(float(count)));
+        float roots[lanes];
+        store(roots, select(inside, root, miss));
+
+        uint32_t hit = ::closest(roots, count, base, tHit);
+        index = hit != none ? hit : index;
+    }
+
+    return index;
+}
+
+void PackedQuads::record(uint32_t index, const Ray& ray, float t, HitRecord& hitRecord) const {
+    glm::vec3 Q(qx[index], qy[index], qz[index]);
+    glm::vec3 u(ux[index], uy[index], uz[index]);
+    glm::vec3 v(vx[index], vy[index], vz[index]);
+    glm::vec3 w(wx[index], wy[index], wz[index]);
+
+    hitRecord.t = t;
+    hitRecord.point = ray.hitPoint(t);
+    glm::vec3 p = hitRecord.point - Q;
+    hitRecord.u = glm::dot(w, glm::cross(p, v));
+    hitRecord.v = glm::dot(w, glm::cross(u, p));
+    hitRecord.setNormal(ray, glm::vec3(nx[index], ny[index], nz[index]));
+    hitRecord.material = materials[index];
+}
+
+PackedBVH::PackedBVH(const std::shared_ptr<HittableList>& list, uint32_t leafSize) {
+    std::vector<std::shared_ptr<Hittable>> primitives;
+    flatten(list, primitives);
+
+    std::vector<AABB> boxes;
+    boxes.reserve(primitives.size());
+    for (const auto& primitive : primitives) {
+        boxes.push_back(primitive->aabb);
+        aabb = AABB(aabb, primitive->aabb);
+    }
+
+    std::vector<uint32_t> order;
+    nodes = FlatBVH::build(boxes, order, leafSize);
+
+    // leaves are re-pointed from the primitive permutation to their own runs in the packed arrays
+    for (auto& node : nodes) {
+        if (node.count == 0) {
+            continue;
+        }
+
+        PackedLeaf leaf;
+        leaf.sphereBegin = spheres.size();
+        leaf.quadBegin = quads.size();
+        leaf.otherBegin = others.size();
+        for (uint32_t i = node.offset; i < node.offset + node.count; i++) {
+            const auto& primitive = primitives[order[i]];
+            auto sphere = std::dynamic_pointer_cast<Sphere>(primitive);
+            auto quad = std::dynamic_pointer_cast<Quad>(primitive);
+            if (sphere && !sphere->moving) {
+                spheres.add(*sphere);
+            } else if (quad) {
+                quads.add(*quad);
+            } else {
+                others.push_back(primitive);
+            }
+        }
+        leaf.sphereEnd = spheres.size();
+        leaf.quadEnd = quads.size();
+        leaf.otherEnd = others.size();
+
+        node.offset = leaves.size();
+        node.count = 1;
+        leaves.push_back(leaf);
+    }
+    spheres.pad();
+    quads.pad();
+}
+
+bool PackedBVH::hit(const Ray& ray, Interval t, HitRecord& hitRecord) const {
+    enum class Kind { Sphere, Quad, Other } kind = Kind::Other;
+    uint32_t index = 0;
+
+    bool hitted = FlatBVH::traverse(nodes, ray, t, [&](uint32_t i, Interval& range) {
+        const auto& leaf = leaves[i];
+        bool any = false;
+        float tHit;
+        Counters::add(Counter::PrimitiveTests, (leaf.sphereEnd - leaf.sphereBegin) + (leaf.quadEnd - leaf.quadBegin));
+
+        uint32_t sphere = spheres.closest(leaf.sphereBegin, leaf.sphereEnd, ray, range, tHit);
+        if (sphere != none) {
+            range.max = tHit;
+            kind = Kind::Sphere;
+            index = sphere;
+            any = true;
+        }
+
+        uint32_t quad = quads.closest(leaf.quadBegin, leaf.quadEnd, ray, range, tHit);
+        if (quad != none) {
+            range.max = tHit;
+            kind = Kind::Quad;
+            index = quad;
+            any = true;
+        }
+
+        for (uint32_t j = leaf.otherBegin; j < leaf.otherEnd; j++) {
+            if (others[j]->hit(ray, range, hitRecord)) {
+                range.max = hitRecord.t;
+                kind = Kind::Other;
+                any = true;
+            }
+        }
+
+        if (any) {
+            hitRecord.t = range.max;
+        }
+        return any;
+    });
+
+    if (hitted) {
+        if (kind == Kind::Sphere) {
+            spheres.record(index, ray, hitRecord.t, hitRecord);
+        } else if (kind == Kind::Quad) {
+            quads.record(index, ray, hitRecord.t, hitRecord);
+        }
+    }
+    return hitted;
+}
+
+size_t PackedBVH::memory() const {
+    return nodes.capacity() * sizeof(FlatNode) + leaves.capacity() * sizeof(PackedLeaf) +
+           spheres.size() * (4 * sizeof(float) + sizeof(std::shared_ptr<Material>)) +
+           quads.size() * (16 * sizeof(float) + sizeof(std::shared_ptr<Material>)) +
+           others.capacity() * sizeof(std::shared_ptr<Hittable>);
+}
\ No newline at end of file
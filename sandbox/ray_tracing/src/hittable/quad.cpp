@@ -1,4 +1,5 @@
 #include "hittable/quad.hpp"
+#include "tools/counters.hpp"
 
 Quad::Quad(const glm::vec3& Q, const glm::vec3& u, const glm::vec3& v, const std::shared_ptr<Material>& material) {
     this->Q = Q;
@@ -14,6 +15,7 @@ Quad::Quad(const glm::vec3& Q, const glm::vec3& u, const glm::vec3& v, const std
 }
 
 bool Quad::hit(const Ray& ray, Interval t, HitRecord& hitRecord) const {
+    Counters::add(Counter::PrimitiveTests);
     auto denominator = glm::dot(normal, ray.direction);
     if (glm::abs(denominator) < 1e-8) {
         return false;
@@ -62,4 +64,13 @@ float Quad::pdfValue(const glm::vec3& origin, const glm::vec3& direction) const
 
 glm::vec3 Quad::random(const glm::vec3& origin) const {
     return Q + u * Random::Float() + v * Random::Float() - origin;
+}
+
+float Quad::surfaceArea() const {
+    return area;
+}
+
+glm::vec3 Quad::randomPoint(glm::vec3& normal) const {
+    normal = this->normal;
+    return Q + u * Random::Float() + v * Random::Float();
 }
\ No newline at end of file
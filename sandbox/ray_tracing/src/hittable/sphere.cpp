@@ -1,5 +1,6 @@
 #include "hittable/sphere.hpp"
 #include "tools/onb.hpp"
+#include "tools/counters.hpp"
 #include <glm/ext/scalar_constants.hpp>
 
 Sphere::Sphere(const glm::vec3& position, float radius, const std::shared_ptr<Material>& material) {
@@ -22,7 +23,17 @@ Sphere::Sphere(const glm::vec3& src, const glm::vec3& dst, float radius, const s
     aabb = AABB(box1, box2);
 }
 
+void Sphere::moveTo(const glm::vec3& position) {
+    this->position = position;
+    glm::vec3 rvec = glm::vec3(radius);
+    aabb = AABB(position - rvec, position + rvec);
+    if (moving) {
+        aabb = AABB(aabb, AABB(position + direction - rvec, position + direction + rvec));
+    }
+}
+
 bool Sphere::hit(const Ray& ray, Interval t, HitRecord& hitRecord) const {
+    Counters::add(Counter::PrimitiveTests);
     glm::vec3 center = moving ? position + direction * ray.time : position;
     glm::vec3 origin = center - ray.origin;
 
@@ -72,6 +83,15 @@ glm::vec3 Sphere::random(const glm::vec3& origin) const {
     return uvw.local(random_(radius, distance2));
 }
 
+float Sphere::surfaceArea() const {
+    return 4.0f * glm::pi<float>() * radius * radius;
+}
+
+glm::vec3 Sphere::randomPoint(glm::vec3& normal) const {
+    normal = Random::UnitSphere();
+    return position + radius * normal;
+}
+
 void Sphere::uv(const glm::vec3& point, float& u, float& v) {
     float theta = acos(-point.y);
     float phi = atan2(-point.z, point.x) + glm::pi<float>();
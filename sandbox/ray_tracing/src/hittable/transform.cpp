@@ -5,6 +5,11 @@ Translate::Translate(const std::shared_ptr<Hittable>& hittable, const glm::vec3&
     aabb = hittable->aabb + offset_;
 }
 
+void Translate::setOffset(const glm::vec3& offset) {
+    offset_ = offset;
+    aabb = hittable_->aabb + offset_;
+}
+
 bool Translate::hit(const Ray& ray, Interval t, HitRecord& hitRecord) const {
     Ray rayOffset(ray.origin - offset_, ray.direction, ray.time);
 
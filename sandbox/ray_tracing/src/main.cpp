@@ -1,6 +1,42 @@
 #include "ray_tracing.hpp"
 
-int main() {
+int main(int argc, char** argv) {
+    Options options;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--resume" && i + 1 < argc) {
+            options.resume = argv[++i];
+        } else if (arg == "--environment" && i + 1 < argc) {
+            options.environment = argv[++i];
+        } else if (arg == "--scene" && i + 1 < argc) {
+            options.scene = std::atoi(argv[++i]);
+        } else if (arg == "--headless") {
+            options.headless = true;
+        } else if (arg == "--frames" && i + 1 < argc) {
+            options.frames = std::atoi(argv[++i]);
+        } else if (arg == "--size" && i + 1 < argc) {
+            std::sscanf(argv[++i], "%ux%u", &options.width, &options.height);
+        } else if (arg == "--crop" && i + 1 < argc) {
+            uint32_t x, y, w, h;
+            if (std::sscanf(argv[++i], "%u,%u,%u,%u", &x, &y, &w, &h) == 4) {
+                options.crop = Region{x, y, x + w, y + h};
+            }
+        } else if (arg == "--output" && i + 1 < argc) {
+            options.output = argv[++i];
+        } else if (arg == "--accelerator" && i + 1 < argc) {
+            if (!parseAccelerator(argv[++i], options.accelerator)) {
+                std::cerr << "unknown accelerator " << argv[i] << "\n";
+                return 1;
+            }
+        } else if (arg == "--benchmark") {
+            options.benchmark = true;
+        } else if (arg == "--gpu") {
+            options.gpu = true;
+        } else if (arg == "--compare") {
+            options.compare = true;
+        }
+    }
+
     wen::initialize();
 
     wen::settings->windowInfo = {"RayTracing", 1600, 900};
@@ -9,13 +45,29 @@ int main() {
     wen::settings->defaultFont = "./sandbox/resources/fonts/JetBrainsMonoNLNerdFontMono-Bold.ttf";
     wen::logger->setLevel(wen::Logger::Level::info);
 
-    auto app = new Application();
-    app->pushLayer<RayTracing>();
-    app->init();
-    app->run();
-    delete app;
+    // the compute tracer runs on wen's context without a window, next to the viewport's own device
+    bool offline = options.benchmark || options.compare || options.headless;
+    bool tracer = !offline || options.gpu || options.compare;
+    if (tracer) {
+        wen::settings->headless = true;
+        wen::initializeRenderer();
+    }
+
+    int code = 0;
+    if (offline) {
+        code = options.benchmark ? runBenchmark(options) : options.compare ? compareDevices(options) : renderHeadless(options);
+    } else {
+        auto app = new Application();
+        app->pushLayer<RayTracing>(options);
+        app->init();
+        app->run();
+        delete app;
+    }
 
+    if (tracer) {
+        wen::destroyRenderer();
+    }
     wen::destroy();
 
-    return 0;
+    return code;
 }
\ No newline at end of file
@@ -0,0 +1,187 @@
+#include "photon/photon_map.hpp"
+#include "resources/material.hpp"
+#include "tools/counters.hpp"
+#include "tools/simd.hpp"
+#include <numeric>
+#include <execution>
+
+// the lights list only carries geometry, so look up the emitter sitting at the sampled point
+static glm::vec3 emission(const HittableList& world, const glm::vec3& point, glm::vec3& normal) {
+    float offset = 1e-3f * (1.0f + glm::length(point));
+    for (int side = 0; side < 2; side++) {
+        glm::vec3 n = side == 0 ? normal : -normal;
+        HitRecord hitRecord;
+        if (!world.hit(Ray(point + n * offset, -n), Interval(0.0f, 2.0f * offset), hitRecord)) {
+            continue;
+        }
+        glm::vec3 radiance = hitRecord.material->emitted(hitRecord);
+        if (radiance.r + radiance.g + radiance.b > 0.0f) {
+            normal = n;
+            return radiance;
+        }
+    }
+    return glm::vec3(0.0f);
+}
+
+void PhotonMap::emit(const HittableList& world, const HittableList& lights, uint32_t count, int depth) {
+    photons_.clear();
+    if (lights.hittables.empty() || count == 0) {
+        return;
+    }
+
+    const uint32_t chunks = 256;
+    std::vector<std::vector<Photon>> buffers(chunks);
+    std::vector<uint32_t> indices(chunks);
+    std::iota(indices.begin(), indices.end(), 0);
+
+    uint32_t lightCount = lights.hittables.size();
+    float scale = (float)lightCount / (float)count;
+
+    std::for_each(std::execution::par, indices.begin(), indices.end(), [&](uint32_t chunk) {
+        uint32_t n = count / chunks + (chunk < count % chunks ? 1 : 0);
+        for (uint32_t i = 0; i < n; i++) {
+            const auto& light = lights.hittables[Random::UInt(0, lightCount - 1)];
+            glm::vec3 normal;
+            glm::vec3 point = light->randomPoint(normal);
+            glm::vec3 radiance = emission(world, point, normal);
+            if (radiance.r + radiance.g + radiance.b <= 0.0f) {
+                continue;
+            }
+
+            glm::vec3 direction = CosinePDF(normal).generate();
+            glm::vec3 power = radiance * glm::pi<float>() * light->surfaceArea() * scale;
+            trace(world, Ray(point, direction, Random::Float()), power, depth, buffers[chunk]);
+        }
+    });
+
+    for (auto& buffer : buffers) {
+        photons_.insert(photons_.end(), buffer.begin(), buffer.end());
+    }
+}
+
+void PhotonMap::trace(const HittableList& world, Ray ray, glm::vec3 power, int depth, std::vector<Photon>& photons) const {
+    bool specular = false;
+    for (int bounce = 0; bounce < depth; bounce++) {
+        HitRecord hitRecord;
+        Counters::add(Counter::PhotonRays);
+        if (!world.hit(ray, Interval(0.001f, infinity), hitRecord)) {
+            return;
+        }
+
+        ScatterRecord scatterRecord;
+        Counters::add(Counter::MaterialEvaluations);
+        if (!hitRecord.material->scatter(ray, hitRecord, scatterRecord)) {
+            return;
+        }
+
+        if (scatterRecord.pdf) {
+            if (specular) {
+                photons.push_back({hitRecord.point, hitRecord.normal, power});
+            }
+            return;
+        }
+
+        specular = true;
+        power *= scatterRecord.attenuation;
+        ray = scatterRecord.rayOut;
+    }
+}
+
+glm::ivec3 PhotonMap::cell(const glm::vec3& point) const {
+    return glm::ivec3(glm::floor(point / cellSize_));
+}
+
+uint32_t PhotonMap::hash(const glm::ivec3& cell) const {
+    uint32_t h = (uint32_t)cell.x * 73856093u ^ (uint32_t)cell.y * 19349663u ^ (uint32_t)cell.z * 83492791u;
+    return h & mask_;
+}
+
+void PhotonMap::build(float radius) {
+    radius_ = radius;
+    cellSize_ = 2.0f * radius;
+
+    uint32_t count = photons_.size();
+    uint32_t table = 1;
+    while (table < 2 * count) {
+        table <<= 1;
+    }
+    mask_ = table - 1;
+
+    std::vector<uint32_t> keys(count);
+    std::transform(std::execution::par, photons_.begin(), photons_.end(), keys.begin(), [&](const Photon& photon) {
+        return hash(cell(photon.position));
+    });
+
+    begin_.assign(table + 1, 0);
+    for (uint32_t key : keys) {
+        begin_[key + 1]++;
+    }
+    std::partial_sum(begin_.begin(), begin_.end(), begin_.begin());
+
+    for (auto* array : {&x_, &y_, &z_, &nx_, &ny_, &nz_, &r_, &g_, &b_}) {
+        array->assign(count + simd::width - 1, 0.0f);
+    }
+
+    std::vector<uint32_t> cursor(begin_.begin(), begin_.end() - 1);
+    for (uint32_t i = 0; i < count; i++) {
+        const auto& photon = photons_[i];
+        uint32_t j = cursor[keys[i]]++;
+        x_[j] = photon.position.x;
+        y_[j] = photon.position.y;
+        z_[j] = photon.position.z;
+        nx_[j] = photon.normal.x;
+        ny_[j] = photon.normal.y;
+        nz_[j] = photon.normal.z;
+        r_[j] = photon.power.r;
+        g_[j] = photon.power.g;
+        b_[j] = photon.power.b;
+    }
+
+    photons_.clear();
+}
+
+glm::vec3 PhotonMap::estimate(const glm::vec3& point, const glm::vec3& normal) const {
+    if (size() == 0) {
+        return glm::vec3(0.0f);
+    }
+
+    using namespace simd;
+    float r2 = radius_ * radius_;
+    Float px = broadcast(point.x), py = broadcast(point.y), pz = broadcast(point.z);
+    Float nx = broadcast(normal.x), ny = broadcast(normal.y), nz = broadcast(normal.z);
+    Float radius2 = broadcast(r2), threshold = broadcast(0.9f), zero = broadcast(0.0f);
+    Float r = zero, g = zero, b = zero;
+    glm::ivec3 base = cell(point - glm::vec3(radius_));
+
+    uint32_t visited[8];
+    int count = 0;
+    for (int i = 0; i < 8; i++) {
+        uint32_t h = hash(base + glm::ivec3(i & 1, (i >> 1) & 1, i >> 2));
+        if (std::find(visited, visited + count, h) != visited + count) {
+            continue;
+        }
+        visited[count++] = h;
+
+        // lanes past the end of the cell read the next cell or the padding and are masked out
+        uint32_t end = begin_[h + 1];
+        for (uint32_t j = begin_[h]; j < end; j += width) {
+            Float dx = load(x_.data() + j) - px, dy = load(y_.data() + j) - py, dz = load(z_.data() + j) - pz;
+            Float d2 = dx * dx + dy * dy + dz * dz;
+            Float cosine = load(nx_.data() + j) * nx + load(ny_.data() + j) * ny + load(nz_.data() + j) * nz;
+            Mask inside = (d2 <= radius2) & (threshold < cosine) & (simd::index() < broadcast(float(end - j)));
+            r = r + select(inside, load(r_.data() + j), zero);
+            g = g + select(inside, load(g_.data() + j), zero);
+            b = b + select(inside, load(b_.data() + j), zero);
+        }
+    }
+
+    float sums[3][width];
+    store(sums[0], r);
+    store(sums[1], g);
+    store(sums[2], b);
+    glm::vec3 power(0.0f);
+    for (uint32_t lane = 0; lane < width; lane++) {
+        power += glm::vec3(sums[0][lane], sums[1][lane], sums[2][lane]);
+    }
+    return power / (glm::pi<float>() * r2);
+}
\ No newline at end of file
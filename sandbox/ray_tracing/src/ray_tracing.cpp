@@ -2,16 +2,22 @@
 #include "resources/material.hpp"
 #include "hittable/sphere.hpp"
 #include "hittable/bvh.hpp"
+#include "hittable/packed_bvh.hpp"
+#include "hittable/compressed_bvh.hpp"
 #include "hittable/quad.hpp"
 #include "hittable/transform.hpp"
 #include "hittable/constant_medium.hpp"
+#include "hittable/bvh_report.hpp"
+#include "tools/profiler.hpp"
 #include <imgui.h>
 #include <glm/gtc/type_ptr.hpp>
+#include <filesystem>
+#include <cfloat>
 
 #define STB_IMAGE_WRITE_IMPLEMENTATION
 #include "stb_image_write.h"
 
-void RandomSpheres(Scene& scene) {
+void RandomSpheres(Scene& scene, Accelerator accelerator, BuildStats* stats) {
     std::shared_ptr<HittableList> world = std::make_shared<HittableList>();
 
     auto ground = std::make_shared<Lambertian>(
@@ -69,8 +75,7 @@ void RandomSpheres(Scene& scene) {
         }
     }
 
-    // scene.world = std::move(world);
-    scene.world = std::move(std::make_shared<HittableList>(std::move(std::make_shared<BVH>(world))));
+    scene.world = std::make_shared<HittableList>(accelerate(world, accelerator, stats));
 }
 
 void CornellBox(Scene& scene) {
@@ -141,7 +146,7 @@ void CornellBox(Scene& scene) {
     scene.world = std::move(world);
 }
 
-void FinalScene(Scene& scene) {
+void FinalScene(Scene& scene, Accelerator accelerator, BuildStats* stats) {
     std::shared_ptr<HittableList> world = std::make_shared<HittableList>();
 
     // bottom
@@ -159,7 +164,7 @@ void FinalScene(Scene& scene) {
             bottom->add(box(glm::vec3(x0, y0, z0), glm::vec3(x1, y1, z1), ground));
         }
     }
-    world->add(std::make_shared<BVH>(std::move(bottom)));
+    world->add(accelerate(bottom, accelerator, stats));
 
     // light
     world->add(std::make_shared<Quad>(
@@ -168,6 +173,8 @@ void FinalScene(Scene& scene) {
         glm::vec3(0.0f, 0.0f, 265.0f),
         std::make_shared<DiffuseLight>(glm::vec3(7.0f, 7.0f, 7.0f))
     ));
+    std::shared_ptr<HittableList> lights = std::make_shared<HittableList>();
+    lights->add(std::make_shared<Quad>(glm::vec3(123.0f, 554.0f, 147.0f), glm::vec3(300.0f, 0.0f, 0.0f), glm::vec3(0.0f, 0.0f, 265.0f), std::shared_ptr<Material>()));
 
     // spheres
     std::shared_ptr<Material> material;
@@ -179,6 +186,8 @@ void FinalScene(Scene& scene) {
     world->add(std::make_shared<Sphere>(center1, center2, 50.0f, material));
     material = std::make_shared<Metal>(glm::vec3(0.8f, 0.8f, 0.9f), 1.0f);
     world->add(std::make_shared<Sphere>(glm::vec3(0.0f, 150.0f, 145.0f), 50.0f, material));
+    material = std::make_shared<Conductor>(glm::vec3(0.95f, 0.64f, 0.54f), 0.4f);
+    world->add(std::make_shared<Sphere>(glm::vec3(120.0f, 180.0f, 0.0f), 50.0f, material));
 
     // boundary
     material = std::make_shared<Dielectric>(1.5);
@@ -205,13 +214,14 @@ void FinalScene(Scene& scene) {
     world->add(
         std::make_shared<Translate>(
             std::make_shared<Rotate>(
-                std::make_shared<BVH>(boxes), 15.0f
+                accelerate(boxes, accelerator, stats), 15.0f
             ),
             glm::vec3(-100.0f, 270.0f, 395.0f)
         )
     );
 
     scene.world = std::move(world);
+    scene.lights = std::move(lights);
 }
 
 void Life(Scene& scene) {
@@ -252,74 +262,493 @@ void Life(Scene& scene) {
     scene.lights = std::move(lights);
 }
 
-RayTracing::RayTracing() : camera_(45.0f, 0.1f, 100.0f) {
-    switch (4) {
+// dense, evenly spread particles, the workload uniform grids are meant for
+void SphereCloud(Scene& scene, Accelerator accelerator, BuildStats* stats) {
+    std::shared_ptr<HittableList> world = std::make_shared<HittableList>();
+    std::shared_ptr<HittableList> cloud = std::make_shared<HittableList>();
+
+    std::vector<std::shared_ptr<Material>> materials;
+    for (int i = 0; i < 8; i++) {
+        materials.push_back(std::make_shared<Lambertian>(Random::Vec3(0.2f, 0.9f)));
+    }
+    materials.push_back(std::make_shared<Metal>(glm::vec3(0.8f, 0.85f, 0.88f), 0.1f));
+    materials.push_back(std::make_shared<Dielectric>(1.5f));
+
+    for (int i = 0; i < 20000; i++) {
+        glm::vec3 center = Random::Vec3(-5.0f, 5.0f) + glm::vec3(0.0f, 5.5f, 0.0f);
+        auto material = materials[Random::UInt(0, materials.size() - 1)];
+        cloud->add(std::make_shared<Sphere>(center, Random::Float(0.04f, 0.1f), material));
+    }
+    world->add(accelerate(cloud, accelerator, stats));
+
+    auto floor = std::make_shared<Lambertian>(
+        std::make_shared<ChessboardTexture>(0.5f, glm::vec3(0.2f, 0.3f, 0.1f), glm::vec3(0.9f, 0.9f, 0.9f))
+    );
+    world->add(std::make_shared<Quad>(glm::vec3(-20.0f, 0.0f, -20.0f), glm::vec3(40.0f, 0.0f, 0.0f), glm::vec3(0.0f, 0.0f, 40.0f), floor));
+    world->add(std::make_shared<Quad>(glm::vec3(-3.0f, 14.0f, -3.0f), glm::vec3(6.0f, 0.0f, 0.0f), glm::vec3(0.0f, 0.0f, 6.0f),
+                                      std::make_shared<DiffuseLight>(glm::vec3(8.0f, 8.0f, 8.0f))));
+
+    scene.world = std::move(world);
+}
+
+// every acceleration structure reachable from `hittable`, named by its path through the graph
+static void collectReports(const std::shared_ptr<Hittable>& hittable, const std::string& path,
+                           std::vector<std::pair<std::string, BVHReport>>& reports) {
+    if (auto bvh = std::dynamic_pointer_cast<BVH>(hittable)) {
+        reports.emplace_back(path + "/BVH", BVHReport::build(*bvh));
+    } else if (auto bvh = std::dynamic_pointer_cast<FlatBVH>(hittable)) {
+        reports.emplace_back(path + "/FlatBVH", BVHReport::build(*bvh));
+    } else if (auto bvh = std::dynamic_pointer_cast<PackedBVH>(hittable)) {
+        reports.emplace_back(path + "/PackedBVH", BVHReport::build(*bvh));
+    } else if (auto bvh = std::dynamic_pointer_cast<CompressedBVH>(hittable)) {
+        reports.emplace_back(path + "/CompressedBVH", BVHReport::build(*bvh));
+    } else if (auto list = std::dynamic_pointer_cast<HittableList>(hittable)) {
+        for (size_t i = 0; i < list->hittables.size(); i++) {
+            collectReports(list->hittables[i], path + "/" + std::to_string(i), reports);
+        }
+    } else if (auto translate = std::dynamic_pointer_cast<Translate>(hittable)) {
+        collectReports(translate->hittable(), path + "/Translate", reports);
+    } else if (auto rotate = std::dynamic_pointer_cast<Rotate>(hittable)) {
+        collectReports(rotate->hittable(), path + "/Rotate", reports);
+    } else if (auto medium = std::dynamic_pointer_cast<ConstantMedium>(hittable)) {
+        collectReports(medium->boundary(), path + "/ConstantMedium", reports);
+    }
+}
+
+void buildScene(int index, Scene& scene, Camera& camera, RenderSettings& settings, Accelerator accelerator, BuildStats* stats) {
+    switch (index) {
         case 1: {
-            RandomSpheres(scene_);
+            RandomSpheres(scene, accelerator, stats);
             auto direction = glm::normalize(glm::vec3(-13.0f, -2.0f, -3.0f));
-            setCamera(glm::vec3(13.0f, 2.0f, 3.0f), direction);
-            renderer_.samples = 4;
-            renderer_.background = glm::vec3(0.7f, 0.8f, 1.0f);
+            camera.set(glm::vec3(13.0f, 2.0f, 3.0f), direction);
+            settings.samples = 4;
+            settings.background = glm::vec3(0.7f, 0.8f, 1.0f);
             break;
         }
         case 2: {
-            CornellBox(scene_);
+            CornellBox(scene);
             auto direction = glm::normalize(glm::vec3(0.0f, 0.0f, 800.0f));
-            setCamera(glm::vec3(278.0f, 278.0f, -800.0f), direction);
-            renderer_.samples = 4;
+            camera.set(glm::vec3(278.0f, 278.0f, -800.0f), direction);
+            settings.samples = 4;
             break;
         }
         case 3: {
-            FinalScene(scene_);
+            FinalScene(scene, accelerator, stats);
             auto direction = glm::normalize(glm::vec3(-200.0f, 0.0f, 600.0f));
-            setCamera(glm::vec3(478.0f, 278.0f, -600.0f), direction);
-            renderer_.samples = 4;
+            camera.set(glm::vec3(478.0f, 278.0f, -600.0f), direction);
+            settings.samples = 4;
             break;
         }
         case 4: {
-            Life(scene_);
+            Life(scene);
             auto direction = glm::normalize(glm::vec3(0.0f, 0.0f, 800.0f));
-            setCamera(glm::vec3(278, 278, -800), direction);
-            renderer_.samples = 1;
+            camera.set(glm::vec3(278, 278, -800), direction);
+            settings.samples = 1;
+            break;
+        }
+        case 5: {
+            SphereCloud(scene, accelerator, stats);
+            auto direction = glm::normalize(glm::vec3(-14.0f, -1.0f, -14.0f));
+            camera.set(glm::vec3(14.0f, 6.5f, 14.0f), direction);
+            settings.samples = 2;
+            settings.background = glm::vec3(0.1f, 0.12f, 0.16f);
             break;
         }
     }
 }
 
-RayTracing::~RayTracing() {}
+RayTracing::RayTracing(const Options& options)
+    : camera_(45.0f, 0.1f, 100.0f), renderThread_(renderer_, scene_, camera_), resume_(options.resume) {
+    buildScene(options.scene, scene_, camera_, renderer_, options.accelerator);
+    if (!options.environment.empty()) {
+        auto environment = std::make_shared<Environment>(options.environment);
+        if (environment->valid()) {
+            scene_.environment = environment_ = environment;
+        }
+    }
+    settings_ = renderer_;
+    renderThread_.start();
+}
+
+// the render thread is joined before the scene it renders goes away
+RayTracing::~RayTracing() {
+    renderThread_.stop();
+}
 
 void RayTracing::update(float ts) {
-    if (camera_.update(ts)) {
-        renderer_.reset();
+    moved_ |= camera_.update(ts);
+
+    // a slow pass coalesces the steps queued behind it into one, the animation runs on the time it has reached
+    if (animate_ && dynamicStatus().dynamic) {
+        time_ += ts;
+        if (!animating_.exchange(true)) {
+            renderThread_.submit([this, time = time_] {
+                animating_ = false;
+                animate(time);
+            });
+        }
+    }
+}
+
+void RayTracing::sync() {
+    renderThread_.update(camera_, settings_, width_, height_, moved_);
+    moved_ = false;
+}
+
+// the top level of the world goes into one FlatBVH that is refitted instead of rebuilt when it changes
+void RayTracing::makeDynamic() {
+    if (dynamic_) {
+        return;
     }
+    dynamic_ = std::make_shared<FlatBVH>(scene_.world);
+    dynamic_->dynamic = true;
+    for (const auto& primitive : dynamic_->primitives) {
+        if (auto sphere = std::dynamic_pointer_cast<Sphere>(primitive)) {
+            animated_.emplace_back(sphere, sphere->position);
+        } else if (auto translate = std::dynamic_pointer_cast<Translate>(primitive)) {
+            instances_.push_back(translate);
+        }
+    }
+    scene_.world = std::make_shared<HittableList>(dynamic_);
+    renderer_.reset();
+    publishStatus();
+}
+
+void RayTracing::animate(float time) {
+    for (size_t i = 0; i < animated_.size(); i++) {
+        auto& [sphere, base] = animated_[i];
+        sphere->moveTo(base + glm::vec3(0.0f, sphere->radius * glm::sin(2.0f * time + (float)i), 0.0f));
+        dynamic_->update(sphere.get());
+    }
+    refit();
+}
+
+void RayTracing::refit() {
+    auto begin = std::chrono::steady_clock::now();
+    lastRefit_ = dynamic_->refit();
+    refitTime_ = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - begin).count();
+    renderer_.reset();
+    publishStatus();
+}
+
+void RayTracing::publishStatus() {
+    std::lock_guard lock(statusMutex_);
+    status_.dynamic = dynamic_ != nullptr;
+    status_.offsets.resize(instances_.size());
+    for (size_t i = 0; i < instances_.size(); i++) {
+        status_.offsets[i] = instances_[i]->offset();
+    }
+    status_.method = dynamic_->method;
+    status_.lastRefit = lastRefit_;
+    status_.refitTime = refitTime_;
+    status_.degradation = dynamic_->degradation();
+}
+
+RayTracing::DynamicStatus RayTracing::dynamicStatus() {
+    std::lock_guard lock(statusMutex_);
+    return status_;
 }
 
 void RayTracing::render() {
+    renderThread_.present();
+    const Frame& frame = renderThread_.frame();
+    DynamicStatus status = dynamicStatus();
+
+    if (reporting_.valid() && reporting_.wait_for(std::chrono::seconds(0)) == std::future_status::ready) {
+        reports_ = reporting_.get();
+        for (const auto& [name, report] : reports_) {
+            WEN_INFO("{}\n{}", name, report.summary())
+        }
+    }
+    if (loading_.valid() && loading_.wait_for(std::chrono::seconds(0)) == std::future_status::ready) {
+        environment_ = loading_.get();
+    }
+    if (streaming_.valid() && streaming_.wait_for(std::chrono::seconds(0)) == std::future_status::ready) {
+        streamed_ = streaming_.get();
+    }
+    if (snapshot_.valid() && snapshot_.wait_for(std::chrono::seconds(0)) == std::future_status::ready) {
+        checkpointWriter_.save(snapshot_.get(), snapshotFile_);
+    }
+
     ImGui::Begin("Scene");
     ImGui::SeparatorText("Camera");
     ImGui::DragFloat3("position", glm::value_ptr(camera_.position), 0.1f);
     ImGui::DragFloat3("direction", glm::value_ptr(camera_.direction), 0.1f);
     ImGui::Separator();
     ImGui::SeparatorText("Renderer");
-    ImGui::SliderInt("samples", &renderer_.samples, 1, 9);
-    ImGui::ColorEdit3("background", glm::value_ptr(renderer_.background));
+    ImGui::SliderInt("samples", &settings_.samples, 1, 9);
+    ImGui::ColorEdit3("background", glm::value_ptr(settings_.background));
+    ImGui::InputText("environment", environmentFile_, 1024);
+    if (ImGui::Button("load environment") && !loading_.valid()) {
+        loading_ = renderThread_.submit([this, filename = std::string(environmentFile_), intensity = environmentIntensity_] {
+            auto environment = std::make_shared<Environment>(filename, intensity);
+            if (!environment->valid()) {
+                return scene_.environment;
+            }
+            scene_.environment = environment;
+            renderer_.reset();
+            return environment;
+        });
+    }
+    if (environment_) {
+        ImGui::SameLine();
+        if (ImGui::Button("clear environment")) {
+            environment_ = nullptr;
+            renderThread_.submit([this] {
+                scene_.environment = nullptr;
+                renderer_.reset();
+            });
+        }
+    }
+    if (environment_) {
+        ImGui::Text("%s, %.2f MB", environment_->filename().c_str(), environment_->memory() / (1024.0f * 1024.0f));
+        if (ImGui::SliderFloat("intensity", &environmentIntensity_, 0.0f, 10.0f)) {
+            renderThread_.submit([this, intensity = environmentIntensity_] {
+                if (scene_.environment) {
+                    scene_.environment->intensity = intensity;
+                    renderer_.reset();
+                }
+            });
+        }
+    }
+    ImGui::Checkbox("path guiding", &settings_.guiding);
+    if (frame.guiding) {
+        ImGui::Text("iteration: %u", frame.guidingIteration);
+        ImGui::Text("spatial leaves: %zu", frame.guidingLeaves);
+        ImGui::Text("memory: %.2f MB", frame.guidingMemory / (1024.0f * 1024.0f));
+    }
+    ImGui::Checkbox("photon caustics", &settings_.photonMapping);
+    if (settings_.photonMapping) {
+        ImGui::DragInt("photons", &settings_.photons, 1000.0f, 1000, 10000000);
+        ImGui::DragFloat("radius (0 = auto)", &settings_.photonRadius, 0.1f, 0.0f, 100.0f);
+        ImGui::Text("stored: %zu, radius: %.3f", frame.photons, frame.photonRadius);
+    }
+    ImGui::Checkbox("compiled scene", &settings_.compiled);
+    if (frame.compiled) {
+        ImGui::Text("primitives: %zu (%zu virtual)", frame.primitives, frame.virtuals);
+        ImGui::Text("materials: %zu, textures: %zu", frame.materials, frame.textures);
+    }
+    if (ImGui::Checkbox("GPU compute", &settings_.gpu)) {
+        renderThread_.submit([this] { renderer_.reset(); });
+    }
+    if (settings_.gpu) {
+        if (frame.gpuDevice.empty()) {
+            ImGui::Text("no compute device, tracing on the CPU");
+        } else {
+            ImGui::Text("%s: %.2f ms per pass", frame.gpuDevice.c_str(), frame.gpuKernelTime * 1000.0f);
+        }
+    }
+    ImGui::SeparatorText("Debug");
+    const char* aovs[] = {"beauty", "BVH nodes visited", "primitives tested", "bounces", "time (us)"};
+    int aov = (int)settings_.aov;
+    if (ImGui::Combo("AOV", &aov, aovs, IM_ARRAYSIZE(aovs))) {
+        settings_.aov = (AOV)aov;
+        renderThread_.submit([this] { renderer_.reset(); });
+    }
+    if (settings_.aov != AOV::Beauty) {
+        ImGui::Text("scale: 0 - %.1f per sample", frame.aovScale);
+    }
+    if (ImGui::Button("BVH report") && !reporting_.valid()) {
+        reporting_ = renderThread_.submit([this] {
+            std::vector<std::pair<std::string, BVHReport>> reports;
+            collectReports(scene_.world, "world", reports);
+            return reports;
+        });
+    }
+    for (const auto& [name, report] : reports_) {
+        if (!ImGui::TreeNode(name.c_str())) {
+            continue;
+        }
+        ImGui::Text("nodes: %zu, leaves: %zu, primitives: %zu", report.nodes, report.leaves, report.primitives);
+        ImGui::Text("SAH cost: %.2f", report.sahCost);
+        ImGui::Text("sibling overlap: %.1f%% (cost %.2f)", report.overlap * 100.0f, report.overlapCost);
+        ImGui::Text("max depth: %u, mean leaf size: %.2f", report.maxDepth, report.meanLeafSize);
+        std::vector<float> depths(report.depths.begin(), report.depths.end());
+        std::vector<float> sizes(report.leafSizes.begin(), report.leafSizes.end());
+        ImGui::PlotHistogram("leaves per depth", depths.data(), depths.size(), 0, nullptr, 0.0f, FLT_MAX, ImVec2(0, 60));
+        ImGui::PlotHistogram("leaves per size", sizes.data(), sizes.size(), 0, nullptr, 0.0f, FLT_MAX, ImVec2(0, 60));
+        ImGui::TreePop();
+    }
+    ImGui::SeparatorText("Dynamic");
+    if (!status.dynamic && ImGui::Button("make world dynamic")) {
+        renderThread_.submit([this] { makeDynamic(); });
+    }
+    if (status.dynamic) {
+        ImGui::Checkbox("animate spheres", &animate_);
+        std::vector<std::pair<size_t, glm::vec3>> edits;
+        for (size_t i = 0; i < status.offsets.size(); i++) {
+            glm::vec3 offset = status.offsets[i];
+            ImGui::PushID((int)i);
+            if (ImGui::DragFloat3("instance", glm::value_ptr(offset), 1.0f)) {
+                edits.emplace_back(i, offset);
+            }
+            ImGui::PopID();
+        }
+        if (!edits.empty()) {
+            renderThread_.submit([this, edits] {
+                for (const auto& [i, offset] : edits) {
+                    instances_[i]->setOffset(offset);
+                    dynamic_->update(instances_[i].get());
+                }
+                refit();
+            });
+        }
+        int method = (int)status.method;
+        const char* methods[] = {"SAH", "LBVH"};
+        if (ImGui::Combo("rebuild with", &method, methods, IM_ARRAYSIZE(methods))) {
+            renderThread_.submit([this, method] {
+                dynamic_->method = (FlatBVH::Build)method;
+                publishStatus();
+            });
+        }
+        if (ImGui::Button("rebuild")) {
+            renderThread_.submit([this] {
+                auto begin = std::chrono::steady_clock::now();
+                dynamic_->rebuild();
+                lastRefit_ = FlatBVH::Refit::Rebuild;
+                refitTime_ = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - begin).count();
+                renderer_.reset();
+                publishStatus();
+            });
+        }
+        const char* refits[] = {"none", "refit", "partial rebuild", "rebuild"};
+        ImGui::Text("last update: %s, %.3f ms", refits[(int)status.lastRefit], status.refitTime);
+        ImGui::Text("SAH degradation: %.3f", status.degradation);
+    }
+    ImGui::SeparatorText("Streaming");
+    if (ImGui::DragInt("budget (MB)", &streamingBudget_, 1.0f, 1, 16384) && streamed_) {
+        renderThread_.submit([streamed = streamed_, budget = size_t(streamingBudget_) << 20] { streamed->budget = budget; });
+    }
+    if (!streamed_ && !streaming_.valid() && ImGui::Button("stream geometry out-of-core")) {
+        streaming_ = renderThread_.submit([this, budget = size_t(streamingBudget_) << 20] {
+            auto filename = "sandbox/ray_tracing/resources/cache/world.ooc";
+            auto streamed = StreamedGeometry::stream(scene_.world, filename, budget);
+            renderer_.reset();
+            return streamed;
+        });
+    }
+    if (streamed_) {
+        auto stats = streamed_->stats();
+        ImGui::Text("resident: %zu / %zu chunks, %.2f MB", stats.residentChunks, stats.chunks, stats.residentBytes / (1024.0f * 1024.0f));
+        ImGui::Text("page ins: %llu, page outs: %llu", (unsigned long long)stats.pageIns, (unsigned long long)stats.pageOuts);
+        ImGui::Text("hit rate: %.2f%%", stats.hitRate() * 100.0f);
+    }
+    ImGui::End();
+
+    ImGui::Begin("Statistics");
+    const auto& counters = frame.counters;
+    float frameTime = frame.time;
+    ImGui::Text("frame: %.2f ms", frameTime * 1000.0f);
+    if (ImGui::BeginTable("counters", 3, ImGuiTableFlags_RowBg)) {
+        ImGui::TableSetupColumn("counter");
+        ImGui::TableSetupColumn("per frame");
+        ImGui::TableSetupColumn("per second");
+        ImGui::TableHeadersRow();
+        for (uint32_t i = 0; i < (uint32_t)Counter::Count; i++) {
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn();
+            ImGui::TextUnformatted(Counters::name((Counter)i));
+            ImGui::TableNextColumn();
+            ImGui::Text("%llu", (unsigned long long)counters[(Counter)i]);
+            ImGui::TableNextColumn();
+            ImGui::Text("%.3g", frameTime > 0.0f ? counters[(Counter)i] / frameTime : 0.0f);
+        }
+        ImGui::EndTable();
+    }
+    if (ImGui::Button("dump counters")) {
+        auto filename = "sandbox/ray_tracing/resources/profile/counters.json";
+        std::filesystem::create_directories(std::filesystem::path(filename).parent_path());
+        std::ofstream file(filename, std::ios::trunc);
+        file << "{\"frame_seconds\": " << frameTime << ", \"frame\": " << counters.json()
+             << ", \"total\": " << Counters::total().json() << "}\n";
+    }
+    ImGui::Separator();
+    bool recording = Profiler::recording();
+    if (ImGui::Checkbox("record trace", &recording)) {
+        Profiler::record(recording);
+    }
+    ImGui::SameLine();
+    ImGui::Text("%zu zones", Profiler::events());
+    if (ImGui::Button("save trace")) {
+        auto filename = "sandbox/ray_tracing/resources/profile/trace.json";
+        if (Profiler::save(filename)) {
+            WEN_INFO("Chrome trace written to {}", filename)
+        } else {
+            WEN_ERROR("Failed to write {}", filename)
+        }
+        Profiler::clear();
+    }
     ImGui::End();
 
     ImGui::Begin("Settings");
     ImGui::Text("fps: %.2f", ImGui::GetIO().Framerate);
-    ImGui::Checkbox("accumulate", &renderer_.accumulated());
-    ImGui::Text("frame index: %d", renderer_.index());
+    ImGui::Checkbox("accumulate", &settings_.accumulate);
+    ImGui::Checkbox("reproject on camera motion", &settings_.reprojection);
+    if (settings_.reprojection) {
+        ImGui::SliderInt("history limit", &settings_.historyLimit, 1, 64);
+    }
+    ImGui::Checkbox("dynamic resolution", &settings_.interactive);
+    if (settings_.interactive) {
+        ImGui::SliderFloat("target fps", &settings_.targetFPS, 5.0f, 120.0f);
+        ImGui::Text("preview stride: %u", frame.stride);
+    }
+    ImGui::Text("frame index: %d", frame.index);
+    int regionMode = (int)regionMode_;
+    const char* regionModes[] = {"off", "priority", "crop"};
+    if (ImGui::Combo("region", &regionMode, regionModes, IM_ARRAYSIZE(regionModes))) {
+        regionMode_ = (RegionMode)regionMode;
+    }
+    if (regionMode_ != RegionMode::Off) {
+        ImGui::Checkbox("follow cursor", &followCursor_);
+        if (followCursor_) {
+            ImGui::SliderInt("cursor radius", &cursorRadius_, 4, 256);
+        } else {
+            ImGui::Text("drag on the image to draw the region");
+        }
+        if (regionMode_ == RegionMode::Priority) {
+            ImGui::SliderFloat("priority share", &settings_.priorityShare, 0.5f, 0.99f);
+        }
+    }
     if (ImGui::Button("reset frame index")) {
-        renderer_.reset();
+        renderThread_.submit([this] { renderer_.reset(); });
+    }
+    ImGui::Separator();
+    ImGui::InputText("checkpoint", checkpoint_, 1024);
+    ImGui::Checkbox("checkpoint every", &checkpointing_);
+    ImGui::SameLine();
+    ImGui::SliderInt("minutes", &checkpointMinutes_, 1, 120);
+    if (ImGui::Button("save checkpoint")) {
+        saveCheckpoint();
+    }
+    ImGui::SameLine();
+    if (ImGui::Button("resume")) {
+        resume("sandbox/ray_tracing/resources/checkpoints/" + std::string(checkpoint_));
+    }
+    if (snapshot_.valid() || checkpointWriter_.busy()) {
+        ImGui::Text("writing checkpoint...");
+    } else if (!checkpointWriter_.succeeded()) {
+        ImGui::Text("last checkpoint failed");
     }
     ImGui::Separator();
     ImGui::InputText("filename", filename_, 1024);
-    if (ImGui::Button("save image")) {
-        auto image = renderer_.image();
-        auto data = renderer_.data();
+    if (ImGui::Button("save image") && !frame.pixels.empty()) {
         auto filename = "sandbox/ray_tracing/resources/images/" + std::string(filename_);
         stbi_flip_vertically_on_write(true);
-        stbi_write_png(filename.c_str(), image->width(), image->height(), 4, data, 0);
+        stbi_write_png(filename.c_str(), frame.width, frame.height, 4, frame.pixels.data(), 0);
+    }
+    if (ImGui::Button("save AOVs")) {
+        auto stem = "sandbox/ray_tracing/resources/images/" + std::filesystem::path(filename_).stem().string();
+        renderThread_.submit([this, stem] {
+            std::vector<uint32_t> pixels((size_t)renderer_.width() * renderer_.height());
+            const char* names[] = {"nodes", "primitives", "bounces", "time"};
+            stbi_flip_vertically_on_write(true);
+            for (int i = 0; i < 4; i++) {
+                float scale = renderer_.resolve(AOV(i + 1), pixels.data());
+                auto filename = stem + "_" + names[i] + ".png";
+                stbi_write_png(filename.c_str(), renderer_.width(), renderer_.height(), 4, pixels.data(), 0);
+                WEN_INFO("{}: 0 - {} per sample", filename, scale)
+            }
+        });
     }
     ImGui::End();
 
@@ -327,22 +756,104 @@ void RayTracing::render() {
     ImGui::Begin("RayTracing");
     width_ = ImGui::GetContentRegionAvail().x;
     height_ = ImGui::GetContentRegionAvail().y;
-    auto image = renderer_.image();
+    auto image = renderThread_.image();
     if (image) {
         auto id = image->id();
         float w = image->width();
         float h = image->height();
         ImGui::Image(id, {w, h}, ImVec2(0, 1), ImVec2(1, 0));
+        selectRegion(*image);
     }
     ImGui::End();
     ImGui::PopStyleVar();
+    settings_.priority = regionMode_ == RegionMode::Priority ? region_ : Region{};
+    settings_.crop = regionMode_ == RegionMode::Crop ? region_ : Region{};
 
     camera_.resize(width_, height_);
-    renderer_.resize(width_, height_);
-    renderer_.render(camera_, scene_);
+    sync();
+    if (!resume_.empty()) {
+        resume(resume_);
+        resume_.clear();
+    }
+
+    auto interval = std::chrono::minutes(checkpointMinutes_);
+    if (checkpointing_ && std::chrono::steady_clock::now() - lastCheckpoint_ >= interval) {
+        saveCheckpoint();
+    }
+}
+
+// called right after the viewport image, the image is drawn flipped so rows count from its bottom edge
+void RayTracing::selectRegion(const Image& image) {
+    if (!ImGui::IsMouseDown(0)) {
+        dragging_ = false;
+    }
+    if (regionMode_ == RegionMode::Off) {
+        return;
+    }
+
+    int width = image.width(), height = image.height();
+    ImVec2 origin = ImGui::GetItemRectMin();
+    if (ImGui::IsItemHovered()) {
+        ImVec2 mouse = ImGui::GetIO().MousePos;
+        glm::ivec2 pixel = glm::clamp(glm::ivec2(int(mouse.x - origin.x), height - 1 - int(mouse.y - origin.y)),
+                                      glm::ivec2(0), glm::ivec2(width - 1, height - 1));
+        glm::ivec2 min = pixel, max = pixel;
+        if (followCursor_) {
+            min = pixel - cursorRadius_;
+            max = pixel + cursorRadius_;
+        } else if (ImGui::IsMouseClicked(0)) {
+            dragStart_ = pixel;
+            dragging_ = true;
+        }
+        if (dragging_) {
+            min = glm::min(dragStart_, pixel);
+            max = glm::max(dragStart_, pixel);
+        }
+        if (followCursor_ || dragging_) {
+            min = glm::max(min, glm::ivec2(0));
+            max = glm::min(max + 1, glm::ivec2(width, height));
+            region_ = Region{(uint32_t)min.x, (uint32_t)min.y, (uint32_t)max.x, (uint32_t)max.y};
+        }
+    }
+
+    if (!region_.empty()) {
+        ImVec2 topLeft(origin.x + region_.x0, origin.y + height - region_.y1);
+        ImVec2 bottomRight(origin.x + region_.x1, origin.y + height - region_.y0);
+        ImGui::GetWindowDrawList()->AddRect(topLeft, bottomRight, IM_COL32(255, 200, 0, 255));
+    }
 }
 
 void RayTracing::setCamera(const glm::vec3& position, const glm::vec3& direction) {
-    camera_.position = position;
-    camera_.direction = direction;
-}
\ No newline at end of file
+    camera_.set(position, direction);
+}
+
+// the snapshot is a copy taken by the render thread between passes, the disk write runs in the background
+void RayTracing::saveCheckpoint() {
+    if (snapshot_.valid() || checkpointWriter_.busy()) {
+        return;
+    }
+    snapshotFile_ = "sandbox/ray_tracing/resources/checkpoints/" + std::string(checkpoint_);
+    snapshot_ = renderThread_.submit([this] { return renderer_.checkpoint(); });
+    lastCheckpoint_ = std::chrono::steady_clock::now();
+}
+
+// the view and the settings of the checkpoint reach the render thread before the command that restores it
+void RayTracing::resume(const std::string& filename) {
+    Checkpoint checkpoint;
+    if (!checkpoint.read(filename)) {
+        WEN_ERROR("Failed to read checkpoint {}", filename)
+        return;
+    }
+    setCamera(checkpoint.position, checkpoint.direction);
+    settings_.samples = checkpoint.samples;
+    settings_.guiding |= !checkpoint.guiding.empty();
+    sync();
+    renderThread_.submit([this, checkpoint = std::move(checkpoint), filename] {
+        if (!renderer_.resume(checkpoint)) {
+            WEN_ERROR("Checkpoint {} is {}x{}, the viewport is {}x{}", filename, checkpoint.width, checkpoint.height,
+                      renderer_.width(), renderer_.height())
+            return;
+        }
+        WEN_INFO("Resumed {} at frame {}", filename, checkpoint.index)
+    });
+}
@@ -0,0 +1,138 @@
+#include "render_thread.hpp"
+#include "gpu/compute_tracer.hpp"
+#include "tools/profiler.hpp"
+
+RenderThread::RenderThread(Renderer& renderer, const Scene& scene, const Camera& camera)
+    : renderer_(renderer), scene_(scene), camera_(camera), view_(camera), settings_(renderer) {}
+
+RenderThread::~RenderThread() {
+    stop();
+}
+
+void RenderThread::start() {
+    if (thread_.joinable()) {
+        return;
+    }
+    running_ = true;
+    thread_ = std::thread(&RenderThread::run, this);
+}
+
+// the pass in flight finishes first, commands still queued are dropped
+void RenderThread::stop() {
+    {
+        std::lock_guard lock(mutex_);
+        running_ = false;
+    }
+    wake_.notify_one();
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+}
+
+void RenderThread::update(const Camera& camera, const RenderSettings& settings, uint32_t width, uint32_t height, bool moved) {
+    {
+        std::lock_guard lock(mutex_);
+        view_ = camera;
+        settings_ = settings;
+        width_ = width;
+        height_ = height;
+        moved_ |= moved;
+    }
+    wake_.notify_one();
+}
+
+void RenderThread::run() {
+    while (true) {
+        std::vector<std::function<void()>> commands;
+        uint32_t width, height;
+        bool moved;
+        {
+            std::unique_lock lock(mutex_);
+            wake_.wait(lock, [this] { return !running_ || !commands_.empty() || (width_ > 0 && height_ > 0); });
+            if (!running_) {
+                break;
+            }
+            commands.swap(commands_);
+            camera_ = view_;
+            static_cast<RenderSettings&>(renderer_) = settings_;
+            width = width_;
+            height = height_;
+            moved = moved_;
+            moved_ = false;
+        }
+
+        // commands see the renderer at the size of the pass they precede
+        if (width > 0 && height > 0) {
+            renderer_.resize(width, height);
+        }
+        for (auto& command : commands) {
+            command();
+        }
+        if (moved) {
+            renderer_.cameraMoved();
+        }
+        if (width == 0 || height == 0) {
+            continue;
+        }
+
+        renderer_.render(camera_, scene_);
+        publish();
+    }
+}
+
+void RenderThread::publish() {
+    PROFILE_ZONE("publish");
+    back_.width = renderer_.width();
+    back_.height = renderer_.height();
+    back_.pixels.assign(renderer_.data(), renderer_.data() + (size_t)back_.width * back_.height);
+
+    back_.index = renderer_.index();
+    back_.stride = renderer_.previewStride();
+    back_.aovScale = renderer_.aovScale();
+    back_.counters = renderer_.frameCounters();
+    back_.time = renderer_.frameTime();
+
+    auto sdTree = renderer_.sdTree();
+    back_.guiding = sdTree != nullptr;
+    back_.guidingIteration = renderer_.guidingIteration();
+    back_.guidingLeaves = sdTree ? sdTree->leaves() : 0;
+    back_.guidingMemory = sdTree ? sdTree->memory() : 0;
+
+    back_.photons = renderer_.photonMap().size();
+    back_.photonRadius = renderer_.photonMap().radius();
+
+    auto compiled = renderer_.compiledScene();
+    back_.compiled = compiled != nullptr;
+    back_.primitives = compiled ? compiled->primitives() : 0;
+    back_.virtuals = compiled ? compiled->virtuals() : 0;
+    back_.materials = compiled ? compiled->materials() : 0;
+    back_.textures = compiled ? compiled->textures() : 0;
+
+    auto tracer = renderer_.computeTracer();
+    back_.gpuDevice = tracer && tracer->valid() ? tracer->deviceName() : "";
+    back_.gpuKernelTime = tracer ? tracer->kernelTime() : 0.0f;
+
+    std::lock_guard lock(mutex_);
+    std::swap(back_, ready_);
+    published_ = true;
+}
+
+bool RenderThread::present() {
+    {
+        std::lock_guard lock(mutex_);
+        if (!published_) {
+            return false;
+        }
+        std::swap(ready_, front_);
+        published_ = false;
+    }
+
+    PROFILE_ZONE("upload");
+    if (!image_) {
+        image_ = std::make_shared<Image>(front_.width, front_.height, ImageFormat::RGBA);
+    } else if (image_->width() != front_.width || image_->height() != front_.height) {
+        image_->resize(front_.width, front_.height);
+    }
+    image_->set(front_.pixels.data());
+    return true;
+}
\ No newline at end of file
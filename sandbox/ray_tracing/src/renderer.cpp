@@ -1,8 +1,13 @@
 #include "renderer.hpp"
 #include "tools/random.hpp"
+#include "tools/counters.hpp"
+#include "tools/profiler.hpp"
 #include "resources/material.hpp"
+#include "gpu/compute_tracer.hpp"
+#include <wen.hpp>
 #include <numeric>
 #include <execution>
+#include <chrono>
 #include <glm/glm.hpp>
 
 static uint32_t convert(glm::vec4 color) {
@@ -19,16 +24,43 @@ static uint32_t convert(glm::vec4 color) {
     return result;
 }
 
+// polynomial fit of the Turbo colour map, t in [0, 1]
+static uint32_t falseColor(float t) {
+    const glm::vec4 red4(0.13572138f, 4.61539260f, -42.66032258f, 132.13108234f);
+    const glm::vec4 green4(0.09140261f, 2.19418839f, 4.84296658f, -14.18503333f);
+    const glm::vec4 blue4(0.10667330f, 12.64194608f, -60.58204836f, 110.36276771f);
+    const glm::vec2 red2(-152.94239396f, 59.28637943f);
+    const glm::vec2 green2(4.27729857f, 2.82956604f);
+    const glm::vec2 blue2(-89.90310912f, 27.34824973f);
+
+    t = glm::clamp(t, 0.0f, 1.0f);
+    glm::vec4 v4(1.0f, t, t * t, t * t * t);
+    glm::vec2 v2 = glm::vec2(v4.z, v4.w) * v4.z;
+    glm::vec3 color(
+        glm::dot(v4, red4) + glm::dot(v2, red2),
+        glm::dot(v4, green4) + glm::dot(v2, green2),
+        glm::dot(v4, blue4) + glm::dot(v2, blue2)
+    );
+    color = glm::clamp(color, glm::vec3(0.0f), glm::vec3(0.999f));
+    uint8_t r = static_cast<uint8_t>(color.r * 255.0f);
+    uint8_t g = static_cast<uint8_t>(color.g * 255.0f);
+    uint8_t b = static_cast<uint8_t>(color.b * 255.0f);
+    return 255u << 24 | b << 16 | g << 8 | r;
+}
+
+static float luminance(const glm::vec3& color) {
+    return glm::dot(color, glm::vec3(0.2126f, 0.7152f, 0.0722f));
+}
+
+Renderer::Renderer() = default;
+Renderer::~Renderer() = default;
+
 void Renderer::resize(uint32_t width, uint32_t height) {
-    if (image_ && image_->width() == width && image_->height() == height) {
+    if (data_ && width_ == width && height_ == height) {
         return;
     }
-
-    if (image_) {
-        image_->resize(width, height);
-    } else {
-        image_ = std::make_shared<Image>(width, height, ImageFormat::RGBA);
-    }
+    width_ = width;
+    height_ = height;
 
     delete[] data_;
     data_ = new uint32_t[width * height];
@@ -36,6 +68,27 @@ void Renderer::resize(uint32_t width, uint32_t height) {
     delete[] accumulation_;
     accumulation_ = new glm::vec4[width * height];
 
+    delete[] statistics_;
+    statistics_ = new glm::vec4[width * height];
+
+    delete[] history_;
+    history_ = new float[width * height];
+
+    delete[] surfaces_;
+    surfaces_ = new Surface[width * height];
+    delete[] previousSurfaces_;
+    previousSurfaces_ = new Surface[width * height];
+    delete[] reprojected_;
+    reprojected_ = new glm::vec4[width * height];
+    delete[] reprojectedHistory_;
+    reprojectedHistory_ = new float[width * height];
+    surfacesValid_ = false;
+
+    delete[] preview_;
+    preview_ = new glm::vec3[width * height];
+    stride_ = 1;
+    previewValid_ = false;
+
     horizontal_.resize(width);
     vertical_.resize(height);
     std::iota(std::begin(horizontal_), std::end(horizontal_), 0);
@@ -43,111 +96,700 @@ void Renderer::resize(uint32_t width, uint32_t height) {
 }
 
 void Renderer::render(const Camera& camera, const Scene& scene) {
+    PROFILE_ZONE("frame");
+    auto frameBegin = std::chrono::steady_clock::now();
+    CounterValues countersBegin = Counters::total();
+
     camera_ = &camera;
     scene_ = &scene;
 
-    if (index_ == 1) {
-        memset(accumulation_, 0, image_->width() * image_->height() * sizeof(glm::vec4));
+    sqrt_spp = int(glm::sqrt(samples)); 
+
+    if (!guiding) {
+        sdTree_.reset();
+    } else if (!sdTree_) {
+        sdTree_ = std::make_unique<SDTree>(scene.world->aabb);
+        guidingIteration_ = 0;
+        guidingPasses_ = 0;
     }
 
-    sqrt_spp = int(glm::sqrt(samples)); 
+    // the authored scene is compiled once and again whenever the world or the lights are swapped,
+    // the compute kernel only knows the compiled form
+    if (!compiled && !gpu) {
+        compiledScene_.reset();
+        gpuSceneValid_ = false;
+    } else if (!compiledScene_ || compiledScene_->world() != scene.world || compiledScene_->lights() != scene.lights) {
+        PROFILE_ZONE("build compiled scene");
+        compiledScene_ = std::make_unique<CompiledScene>(scene.world, scene.lights);
+        gpuSceneValid_ = false;
+    } else if (compiledScene_->refresh()) {
+        // animations, refits and instance edits move what the kernel has uploaded
+        gpuSceneValid_ = false;
+    }
+
+    bool moving = moving_;
+    moving_ = false;
+    if (interactive && accumulate && aov == AOV::Beauty && preview(moving)) {
+        frameCounters_ = Counters::total() - countersBegin;
+        frameTime_ = std::chrono::duration<float>(std::chrono::steady_clock::now() - frameBegin).count();
+        return;
+    }
+
+    size_t pixels = (size_t)width_ * height_;
+    // AOV statistics are not reprojected, their per-pixel means need history and statistics to match
+    if (reproject_ && reprojection && accumulate && aov == AOV::Beauty && surfacesValid_) {
+        reproject();
+        memset(statistics_, 0, pixels * sizeof(glm::vec4));
+    } else if (index_ == 1) {
+        memset(accumulation_, 0, pixels * sizeof(glm::vec4));
+        memset(statistics_, 0, pixels * sizeof(glm::vec4));
+        memset(history_, 0, pixels * sizeof(float));
+        surfacesValid_ = false;
+        if (reprojection && accumulate) {
+            traceSurfaces();
+        }
+    }
+    reproject_ = false;
+
+    emitPhotons(scene);
+    schedule();
 
 #define MT 1
+    if (gpu && aov == AOV::Beauty && traceGPU()) {
+        // traced and accumulated
+    } else {
+        PROFILE_ZONE("trace");
 #if MT
-    std::for_each(std::execution::par, vertical_.begin(), vertical_.end(), [&](uint32_t y) {
-        std::for_each(std::execution::par, horizontal_.begin(), horizontal_.end(), [&](uint32_t x) {
-            for (int si = 0; si < sqrt_spp; si++) {
-                for (int sj = 0; sj < sqrt_spp; sj++) {
-                    Ray ray = pixel(x, y, si, sj);
-                    glm::vec4 color = glm::vec4(traceRay(ray, 50), 1.0f) / (float)samples;
-                    accumulation_[y * image_->width() + x] += color;
-                    color = accumulation_[y * image_->width() + x];
-                    color /= (float)index_;
-                    data_[y * image_->width() + x] = convert(color);
+        std::for_each(std::execution::par, vertical_.begin() + region_.y0, vertical_.begin() + region_.y1, [&](uint32_t y) {
+            PROFILE_ZONE("trace row");
+            std::for_each(std::execution::par, horizontal_.begin() + region_.x0, horizontal_.begin() + region_.x1, [&](uint32_t x) {
+                if (scheduled(x, y)) {
+                    renderPixel(x, y);
                 }
-            } 
-         });
-    });
+            });
+        });
 #else
-    auto w = image_->width(), h = image_->height();
-    for (uint32_t y = 0; y < h; y++) {
-        for (uint32_t x = 0; x < w; x++) {
-            for (int si = 0; si < sqrt_spp; si++) {
-                for (int sj = 0; sj < sqrt_spp; sj++) {
-                    Ray ray = pixel(x, y, si, sj);
-                    glm::vec4 color = glm::vec4(traceRay(ray, 50), 1.0f) / (float)samples;
-                    accumulation_[y * image_->width() + x] += color;
-                    color = accumulation_[y * image_->width() + x];
-                    color /= (float)index_;
-                    data_[y * image_->width() + x] = convert(color);
+        for (uint32_t y = region_.y0; y < region_.y1; y++) {
+            for (uint32_t x = region_.x0; x < region_.x1; x++) {
+                if (scheduled(x, y)) {
+                    renderPixel(x, y);
                 }
-            } 
+            }
         }
-    }
 #endif
+    }
 
-    image_->set(data_);
+    if (aov != AOV::Beauty) {
+        PROFILE_ZONE("resolve");
+        aovScale_ = resolve(aov, data_);
+    }
 
-    if (accumulated_) {
+    // iteration k spans 2^k passes, the tree learned so far drives sampling of the next one
+    if (sdTree_ && ++guidingPasses_ >= (1u << glm::min(guidingIteration_, 16u))) {
+        PROFILE_ZONE("build guiding tree");
+        sdTree_->refine(guidingIteration_++);
+        guidingPasses_ = 0;
+    }
+
+    frameCounters_ = Counters::total() - countersBegin;
+    frameTime_ = std::chrono::duration<float>(std::chrono::steady_clock::now() - frameBegin).count();
+
+    if (accumulate) {
         index_++;
     } else {
         index_ = 1;
     }
 }
 
+bool Renderer::traceGPU() {
+    if (!computeTracer_) {
+        computeTracer_ = std::make_unique<ComputeTracer>();
+        gpuSceneValid_ = false;
+    }
+    if (!computeTracer_->valid() || !compiledScene_) {
+        return false;
+    }
+    if (!gpuSceneValid_ || gpuEnvironment_ != scene_->environment.get()) {
+        PROFILE_ZONE("upload GPU scene");
+        GPUScene scene(*compiledScene_, scene_->environment != nullptr);
+        if (scene.skipped > 0 || scene.approximated > 0) {
+            WEN_WARN("GPU scene: {} primitives, lights or environment maps skipped, {} textures or materials approximated",
+                     scene.skipped, scene.approximated)
+        }
+        computeTracer_->upload(scene);
+        gpuSceneValid_ = true;
+        gpuEnvironment_ = scene_->environment.get();
+    }
+
+    ComputeTracer::Pass pass;
+    pass.width = width_;
+    pass.height = height_;
+    pass.sqrtSpp = sqrt_spp;
+    pass.samples = samples;
+    pass.seed = seed;
+    pass.index = index_;
+    pass.maxDepth = maxDepth;
+    pass.background = background;
+    gpuRadiance_.resize((size_t)width_ * height_);
+    {
+        PROFILE_ZONE("trace GPU");
+        if (!computeTracer_->trace(*camera_, pass, gpuRadiance_.data())) {
+            return false;
+        }
+    }
+
+    // the kernel traces every pixel, only the scheduled ones are kept so crop and priority behave as on the CPU
+    PROFILE_ZONE("accumulate GPU");
+    uint32_t width = width_;
+    std::for_each(std::execution::par, vertical_.begin() + region_.y0, vertical_.begin() + region_.y1, [&](uint32_t y) {
+        uint64_t traced = 0;
+        for (uint32_t x = region_.x0; x < region_.x1; x++) {
+            if (scheduled(x, y)) {
+                uint32_t i = y * width + x;
+                accumulation_[i] += gpuRadiance_[i];
+                history_[i] += 1.0f;
+                data_[i] = convert(accumulation_[i] / history_[i]);
+                traced++;
+            }
+        }
+        Counters::add(Counter::CameraRays, traced * sqrt_spp * sqrt_spp);
+    });
+    return true;
+}
+
+// With a priority region every pass traces the region, and one in `interval_` rows of the rest, sized
+// so the region gets `priorityShare` of the pixels. Accumulation is per pixel, so the background
+// simply converges over more passes.
+void Renderer::schedule() {
+    region_ = Region{0, 0, width_, height_};
+    if (!crop.empty()) {
+        region_ = crop.clip(region_);
+    }
+    priority_ = priority.clip(region_);
+
+    interval_ = 1;
+    if (!priority_.empty()) {
+        float inside = (float)priority_.area();
+        float outside = (float)(region_.area() - priority_.area());
+        float budget = glm::max(inside * (1.0f - priorityShare) / glm::max(priorityShare, 0.01f), 1.0f);
+        interval_ = glm::clamp((uint32_t)glm::ceil(outside / budget), 1u, glm::max(region_.y1 - region_.y0, 1u));
+    }
+    phase_ = (phase_ + 1) % interval_;
+}
+
+// Dynamic resolution: while the camera moves one path is traced per stride x stride block, with the
+// stride steered so that a frame takes about 1 / targetFPS. Once the camera stops every frame halves
+// the stride and traces only the pixels the coarser grid lacks, until the full renderer takes over.
+bool Renderer::preview(bool moving) {
+    uint32_t coarser = 0;
+    if (moving) {
+        // the traced pixel count, and with it the frame time, falls with the square of the stride
+        float estimate = (float)stride_ * glm::sqrt(frameTime_ * targetFPS);
+        strideEstimate_ = glm::clamp(glm::mix(strideEstimate_, estimate, 0.5f), 1.0f, (float)maxStride);
+        stride_ = 1;
+        while (stride_ < maxStride && 1.5f * stride_ < strideEstimate_) {
+            stride_ *= 2;
+        }
+    } else if (stride_ > 1) {
+        coarser = previewValid_ ? stride_ : 0;
+        stride_ /= 2;
+    }
+    if (stride_ == 1) {
+        return false;
+    }
+
+    PROFILE_ZONE("trace preview");
+    uint32_t width = width_;
+    uint32_t stride = stride_;
+    float centre = pixelCentre();
+    caustics_ = false;
+    std::for_each(std::execution::par, vertical_.begin(), vertical_.end(), [&](uint32_t y) {
+        if (y % stride != 0) {
+            return;
+        }
+        for (uint32_t x = 0; x < width; x += stride) {
+            if (coarser > 0 && x % coarser == 0 && y % coarser == 0) {
+                continue;
+            }
+            Ray ray = primary(glm::vec2(x + centre, y + centre), Random::Float());
+            preview_[y * width + x] = traceRay(ray);
+        }
+    });
+    upscale(stride);
+    previewValid_ = true;
+    return true;
+}
+
+// bilinear between the four traced pixels around every pixel
+void Renderer::upscale(uint32_t stride) {
+    PROFILE_ZONE("upscale");
+    uint32_t width = width_;
+    uint32_t lastX = (width - 1) / stride * stride;
+    uint32_t lastY = (height_ - 1) / stride * stride;
+    std::for_each(std::execution::par, vertical_.begin(), vertical_.end(), [&](uint32_t y) {
+        uint32_t y0 = glm::min(y / stride * stride, lastY);
+        uint32_t y1 = glm::min(y0 + stride, lastY);
+        float fy = y1 > y0 ? (float)(y - y0) / (float)stride : 0.0f;
+        for (uint32_t x = 0; x < width; x++) {
+            uint32_t x0 = glm::min(x / stride * stride, lastX);
+            uint32_t x1 = glm::min(x0 + stride, lastX);
+            float fx = x1 > x0 ? (float)(x - x0) / (float)stride : 0.0f;
+            glm::vec3 top = glm::mix(preview_[y0 * width + x0], preview_[y0 * width + x1], fx);
+            glm::vec3 bottom = glm::mix(preview_[y1 * width + x0], preview_[y1 * width + x1], fx);
+            data_[y * width + x] = convert(glm::vec4(glm::mix(top, bottom, fy), 1.0f));
+        }
+    });
+}
+
+void Renderer::emitPhotons(const Scene& scene) {
+    caustics_ = photonMapping && scene.lights && !scene.lights->hittables.empty();
+    if (!caustics_) {
+        return;
+    }
+
+    // probabilistic progressive photon mapping: r_{i+1}^2 = r_i^2 (i + alpha) / (i + 1)
+    const float alpha = 2.0f / 3.0f;
+    if (index_ == 1) {
+        float radius = photonRadius;
+        if (radius <= 0.0f) {
+            const auto& aabb = scene.world->aabb;
+            radius = 0.005f * glm::length(glm::vec3(aabb.x.size(), aabb.y.size(), aabb.z.size()));
+        }
+        photonRadius2_ = radius * radius;
+    } else {
+        photonRadius2_ *= ((float)index_ - 1.0f + alpha) / (float)index_;
+    }
+
+    {
+        PROFILE_ZONE("trace photons");
+        photonMap_.emit(*scene.world, *scene.lights, photons, 16);
+    }
+    PROFILE_ZONE("build photon map");
+    photonMap_.build(glm::sqrt(photonRadius2_));
+}
+
+void Renderer::renderPixel(uint32_t x, uint32_t y) {
+    uint32_t i = y * width_ + x;
+    bool statistics = aov != AOV::Beauty;
+    auto start = statistics ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point();
+    CounterValues before = Counters::thread();
+    Random::Seed(Random::Hash(i ^ Random::Hash(index_ ^ Random::Hash(seed))));
+
+    for (int si = 0; si < sqrt_spp; si++) {
+        for (int sj = 0; sj < sqrt_spp; sj++) {
+            Ray ray = pixel(x, y, si, sj);
+            glm::vec4 color = glm::vec4(traceRay(ray), 1.0f) / (float)samples;
+            accumulation_[i] += color;
+        }
+    }
+    history_[i] += 1.0f;
+    data_[i] = convert(accumulation_[i] / history_[i]);
+
+    // the counters are thread-local and a pixel never leaves its thread, so the difference is this pixel's work
+    if (statistics) {
+        float time = std::chrono::duration<float, std::micro>(std::chrono::steady_clock::now() - start).count();
+        CounterValues work = Counters::thread() - before;
+        glm::vec4 values((float)work[Counter::BoxTests], (float)work[Counter::PrimitiveTests], (float)work[Counter::BounceRays], time);
+        statistics_[i] += values / (float)(sqrt_spp * sqrt_spp);
+    }
+}
+
+float Renderer::resolve(AOV aov, uint32_t* pixels) const {
+    size_t count = (size_t)width_ * height_;
+    if (aov == AOV::Beauty) {
+        for (size_t i = 0; i < count; i++) {
+            pixels[i] = convert(accumulation_[i] / glm::max(history_[i], 1.0f));
+        }
+        return 1.0f;
+    }
+
+    // the map spans zero to the largest per-pixel mean of the current image, regions leave pixels at different counts
+    int channel = (int)aov - (int)AOV::Nodes;
+    float scale = 0.0f;
+    for (size_t i = 0; i < count; i++) {
+        scale = glm::max(scale, statistics_[i][channel] / glm::max(history_[i], 1.0f));
+    }
+    for (size_t i = 0; i < count; i++) {
+        float mean = statistics_[i][channel] / glm::max(history_[i], 1.0f);
+        pixels[i] = falseColor(scale > 0.0f ? mean / scale : 0.0f);
+    }
+    return scale;
+}
+
+Checkpoint Renderer::checkpoint() const {
+    PROFILE_ZONE("checkpoint");
+    Checkpoint checkpoint;
+    checkpoint.width = width_;
+    checkpoint.height = height_;
+    checkpoint.index = index_;
+    checkpoint.seed = seed;
+    checkpoint.samples = samples;
+    if (camera_) {
+        checkpoint.position = camera_->position;
+        checkpoint.direction = camera_->direction;
+    }
+
+    size_t pixels = (size_t)checkpoint.width * checkpoint.height;
+    checkpoint.accumulation.assign(accumulation_, accumulation_ + pixels);
+    checkpoint.statistics.assign(statistics_, statistics_ + pixels);
+    checkpoint.history.assign(history_, history_ + pixels);
+
+    checkpoint.photonRadius2 = photonRadius2_;
+    if (sdTree_) {
+        std::ostringstream stream;
+        sdTree_->write(stream);
+        checkpoint.guiding = stream.str();
+        checkpoint.guidingIteration = guidingIteration_;
+        checkpoint.guidingPasses = guidingPasses_;
+    }
+    return checkpoint;
+}
+
+bool Renderer::resume(const Checkpoint& checkpoint) {
+    if (!data_ || checkpoint.width != width_ || checkpoint.height != height_) {
+        return false;
+    }
+
+    if (!checkpoint.guiding.empty()) {
+        auto tree = std::make_unique<SDTree>(AABB::empty);
+        std::istringstream stream(checkpoint.guiding);
+        if (!tree->read(stream)) {
+            return false;
+        }
+        sdTree_ = std::move(tree);
+        guiding = true;
+        guidingIteration_ = checkpoint.guidingIteration;
+        guidingPasses_ = checkpoint.guidingPasses;
+    }
+
+    std::copy(checkpoint.accumulation.begin(), checkpoint.accumulation.end(), accumulation_);
+    std::copy(checkpoint.statistics.begin(), checkpoint.statistics.end(), statistics_);
+    std::copy(checkpoint.history.begin(), checkpoint.history.end(), history_);
+    index_ = checkpoint.index;
+    seed = checkpoint.seed;
+    samples = checkpoint.samples;
+    photonRadius2_ = checkpoint.photonRadius2;
+
+    reproject_ = false;
+    moving_ = false;
+    surfacesValid_ = false;
+    previewValid_ = false;
+    stride_ = 1;
+    return true;
+}
+
 Ray Renderer::pixel(uint32_t x, uint32_t y, int si, int sj) {
     glm::vec2 coord = {
-        (float)(x + si * (1.0f / (float)sqrt_spp)) / (float)image_->width(),
-        (float)(y + sj * (1.0f / (float)sqrt_spp)) / (float)image_->height()
+        (float)(x + si * (1.0f / (float)sqrt_spp)),
+        (float)(y + sj * (1.0f / (float)sqrt_spp))
     };
+    return primary(coord, Random::Float());
+}
+
+// `coord` in pixels, the camera ray through it
+Ray Renderer::primary(glm::vec2 coord, float time) const {
+    coord = coord / glm::vec2(width_, height_);
     coord = coord * 2.0f - 1.0f; // [0, 1] -> [-1, 1]
     glm::vec4 target = glm::inverse(camera_->projection) * glm::vec4(coord.x, coord.y, 1.0f, 1.0f);
 
     Ray ray {
         camera_->position,
         glm::vec3(glm::inverse(camera_->view) * glm::vec4(glm::normalize(glm::vec3(target) / target.w), 0)),
-        Random::Float()
+        time
     };
 
     return ray;
 }
 
-glm::vec3 Renderer::traceRay(const Ray& ray, int depth) {
+// the samples of pixel x sit at x + k / sqrt_spp, their mean is where the pixel is reprojected from
+float Renderer::pixelCentre() const {
+    return 0.5f - 0.5f / (float)sqrt_spp;
+}
+
+void Renderer::traceSurfaces() {
+    PROFILE_ZONE("trace surfaces");
+    uint32_t width = width_;
+    float centre = pixelCentre();
+    std::for_each(std::execution::par, vertical_.begin(), vertical_.end(), [&](uint32_t y) {
+        std::vector<Ray> rays;
+        rays.reserve(width);
+        for (uint32_t x = 0; x < width; x++) {
+            rays.push_back(primary(glm::vec2(x + centre, y + centre), 0.0f));
+        }
+        Counters::add(Counter::CameraRays, width);
+
+        // the graph takes the row as one batch, streamed geometry then pages each chunk in once per row
+        std::vector<HitRecord> hitRecords;
+        std::vector<uint8_t> hitted;
+        if (!compiledScene_) {
+            hitRecords.resize(width);
+            hitted.assign(width, 0);
+            scene_->world->hitBatch(rays, Interval(0.001f, infinity), hitRecords, hitted);
+        }
+
+        for (uint32_t x = 0; x < width; x++) {
+            Surface& surface = surfaces_[y * width + x];
+            if (compiledScene_) {
+                SurfaceHit hit;
+                surface.hit = compiledScene_->hit(rays[x], Interval(0.001f, infinity), hit);
+                surface.point = hit.point;
+                surface.normal = hit.normal;
+            } else {
+                surface.hit = hitted[x] != 0;
+                surface.point = hitRecords[x].point;
+                surface.normal = hitRecords[x].normal;
+            }
+            if (!surface.hit) {
+                surface.point = rays[x].direction;
+            }
+        }
+    });
+    viewProjection_ = camera_->projection * camera_->view;
+    surfacesValid_ = true;
+}
+
+// Backward reprojection: the surface seen through each pixel now is projected into the previous view
+// and the history of the up to four previous pixels around it is blended bilinearly. A previous pixel
+// only contributes when it saw the same surface, which rejects disocclusions and silhouettes.
+void Renderer::reproject() {
+    PROFILE_ZONE("reproject");
+    std::swap(surfaces_, previousSurfaces_);
+    glm::mat4 previous = viewProjection_;
+    traceSurfaces();
+
+    int width = width_;
+    int height = height_;
+    float centre = pixelCentre();
+    std::for_each(std::execution::par, vertical_.begin(), vertical_.end(), [&](uint32_t y) {
+        for (int x = 0; x < width; x++) {
+            uint32_t i = y * width + x;
+            const Surface& surface = surfaces_[i];
+            glm::vec4 color(0.0f);
+            float history = 0.0f;
+            float weight = 0.0f;
+
+            glm::vec4 clip = previous * glm::vec4(surface.point, surface.hit ? 1.0f : 0.0f);
+            if (clip.w > 0.0f) {
+                glm::vec2 coord = (glm::vec2(clip.x, clip.y) / clip.w * 0.5f + 0.5f) * glm::vec2(width, height) - centre;
+                glm::ivec2 base = glm::ivec2(glm::floor(coord));
+                glm::vec2 f = coord - glm::vec2(base);
+                float tolerance = depthTolerance * glm::length(surface.point - camera_->position);
+
+                for (int k = 0; k < 4; k++) {
+                    glm::ivec2 tap = base + glm::ivec2(k & 1, k >> 1);
+                    if (tap.x < 0 || tap.y < 0 || tap.x >= width || tap.y >= height) {
+                        continue;
+                    }
+                    uint32_t j = tap.y * width + tap.x;
+                    const Surface& old = previousSurfaces_[j];
+                    if (old.hit != surface.hit || history_[j] <= 0.0f) {
+                        continue;
+                    }
+                    if (surface.hit && (glm::abs(glm::dot(old.point - surface.point, surface.normal)) > tolerance ||
+                                        glm::dot(old.normal, surface.normal) < normalTolerance)) {
+                        continue;
+                    }
+                    float w = ((k & 1) ? f.x : 1.0f - f.x) * ((k >> 1) ? f.y : 1.0f - f.y);
+                    color += w * accumulation_[j] / history_[j];
+                    history += w * history_[j];
+                    weight += w;
+                }
+            }
+
+            // a capped history lets stale or resampled colour wash out within a few frames of motion
+            if (weight > 0.0f) {
+                history = glm::min(history / weight, (float)historyLimit);
+                reprojected_[i] = color / weight * history;
+                reprojectedHistory_[i] = history;
+            } else {
+                reprojected_[i] = glm::vec4(0.0f);
+                reprojectedHistory_[i] = 0.0f;
+            }
+        }
+    });
+
+    std::swap(accumulation_, reprojected_);
+    std::swap(history_, reprojectedHistory_);
+}
+
+glm::vec3 Renderer::miss(const Ray& ray) const {
+    return scene_->environment ? scene_->environment->radiance(ray.direction) : background;
+}
+
+bool Renderer::hasLights() const {
+    return scene_->lights || scene_->environment;
+}
+
+glm::vec3 Renderer::sampleLights(const glm::vec3& origin) const {
+    const auto& environment = scene_->environment;
+    if (!scene_->lights || (environment && Random::Float() < 0.5f)) {
+        return environment->sample();
+    }
+    return compiledScene_ ? compiledScene_->sampleLight(origin) : scene_->lights->random(origin);
+}
+
+float Renderer::lightsPdf(const glm::vec3& origin, const glm::vec3& direction) const {
+    const auto& environment = scene_->environment;
+    if (!scene_->lights) {
+        return environment->pdf(direction);
+    }
+    float pdf;
+    if (compiledScene_) {
+        pdf = compiledScene_->lightPdf(origin, direction);
+    } else {
+        Counters::add(Counter::ShadowRays);
+        pdf = scene_->lights->pdfValue(origin, direction);
+    }
+    return environment ? 0.5f * (pdf + environment->pdf(direction)) : pdf;
+}
+
+// a vertex of the authored graph, the material answers through its virtual interface
+struct Renderer::GraphVertex {
+    explicit GraphVertex(const Renderer& renderer) : world(*renderer.scene_->world) {}
+
+    bool intersect(const Ray& ray) {
+        rayIn = ray;
+        return world.hit(ray, Interval(0.001f, infinity), hitRecord);
+    }
+
+    const glm::vec3& point() const { return hitRecord.point; }
+    const glm::vec3& normal() const { return hitRecord.normal; }
+    glm::vec3 emitted() const { return hitRecord.material->emitted(hitRecord); }
+    bool scatter() { return hitRecord.material->scatter(rayIn, hitRecord, scatterRecord); }
+
+    // a null pdf marks a specular bounce
+    bool diffuse() const { return scatterRecord.pdf != nullptr; }
+    const glm::vec3& attenuation() const { return scatterRecord.attenuation; }
+    const Ray& rayOut() const { return scatterRecord.rayOut; }
+    float lightFraction() const { return scatterRecord.lightFraction; }
+
+    glm::vec3 sample() const { return scatterRecord.pdf->generate(); }
+    float pdf(const glm::vec3& direction) const { return scatterRecord.pdf->value(direction); }
+    glm::vec3 evaluate(const glm::vec3& direction) const {
+        return hitRecord.material->evaluate(rayIn, hitRecord, scatterRecord, Ray(hitRecord.point, direction, rayIn.time));
+    }
+
+    const Hittable& world;
+    Ray rayIn;
+    HitRecord hitRecord;
+    ScatterRecord scatterRecord;
+};
+
+// a vertex of the compiled scene, every call dispatches on the material type
+struct Renderer::CompiledVertex {
+    explicit CompiledVertex(const Renderer& renderer) : scene(*renderer.compiledScene_) {}
+
+    bool intersect(const Ray& ray) {
+        rayIn = ray;
+        return scene.hit(ray, Interval(0.001f, infinity), hit);
+    }
+
+    const glm::vec3& point() const { return hit.point; }
+    const glm::vec3& normal() const { return hit.normal; }
+    glm::vec3 emitted() const { return scene.emitted(hit); }
+    bool scatter() { return scene.scatter(rayIn, hit, compiled); }
+
+    bool diffuse() const { return compiled.lobe != Lobe::None; }
+    const glm::vec3& attenuation() const { return compiled.attenuation; }
+    const Ray& rayOut() const { return compiled.rayOut; }
+    float lightFraction() const {
+        return compiled.lobe == Lobe::Microfacet ? MicrofacetBSDF::lightFraction(compiled.alpha) : 0.5f;
+    }
+
+    glm::vec3 sample() const { return CompiledScene::sample(compiled, hit.normal); }
+    float pdf(const glm::vec3& direction) const { return CompiledScene::value(compiled, hit.normal, direction); }
+    glm::vec3 evaluate(const glm::vec3& direction) const { return scene.evaluate(hit, compiled, direction); }
+
+    const CompiledScene& scene;
+    Ray rayIn;
+    SurfaceHit hit;
+    CompiledScatter compiled;
+};
+
+template<typename Vertex>
+glm::vec3 Renderer::trace(const Ray& ray, int depth, PathState state) {
     if (depth <= 0) {
         return glm::vec3(0.0f);
     }
 
-    auto& world = scene_->world;
-    HitRecord hitRecord;
-    if (!world->hit(ray, Interval(0.001f, infinity), hitRecord)) {
-        return background;
+    Counters::add(depth == maxDepth ? Counter::CameraRays : Counter::BounceRays);
+
+    Vertex vertex(*this);
+    if (!vertex.intersect(ray)) {
+        return miss(ray);
     }
 
-    glm::vec3 emitted = hitRecord.material->emitted(hitRecord);
+    glm::vec3 emitted(0.0f);
+    if (!caustics_ || state != PathState::Caustic) {
+        emitted = vertex.emitted();
+    }
 
-    ScatterRecord scatterRecord;
-    if (!hitRecord.material->scatter(ray, hitRecord, scatterRecord)) {
+    Counters::add(Counter::MaterialEvaluations);
+    if (!vertex.scatter()) {
         return emitted;
     }
 
-    glm::vec3 scattered;
+    bool diffuse = vertex.diffuse();
+    PathState next = PathState::Diffuse;
+    if (!diffuse) {
+        next = state == PathState::Camera ? PathState::Camera : PathState::Caustic;
+    } else if (caustics_) {
+        emitted += vertex.evaluate(vertex.normal()) * photonMap_.estimate(vertex.point(), vertex.normal());
+    }
 
-    if (!scene_->lights) {
-        scattered = scatterRecord.attenuation * traceRay(scatterRecord.rayOut, depth - 1);
-        return emitted + scattered;
-    } 
+    bool guided = sdTree_ && diffuse;
+    bool lights = hasLights();
+    if (!lights && !guided) {
+        return emitted + vertex.attenuation() * trace<Vertex>(vertex.rayOut(), depth - 1, next);
+    }
 
-    if (!scatterRecord.pdf) {
-        scattered = scatterRecord.attenuation * traceRay(scatterRecord.rayOut, depth - 1);
-        return scattered;
+    if (!diffuse) {
+        return vertex.attenuation() * trace<Vertex>(vertex.rayOut(), depth - 1, next);
     }
 
-    auto light = std::make_shared<HittablePDF>(scene_->lights, hitRecord.point);
-    MixturePDF mixture(light, scatterRecord.pdf);
-    Ray rayOut(hitRecord.point, glm::normalize(mixture.generate()), ray.time);
-    float pdfValue = mixture.value(rayOut.direction);
-    float pdf = hitRecord.material->pdf(hitRecord, rayOut);
-    scattered = (scatterRecord.attenuation * pdf * traceRay(rayOut, depth - 1)) / pdfValue;
+    // one-sample mixture: guiding, then lights against the material lobe
+    DTreeWrapper* guide = guided ? &sdTree_->lookup(vertex.point()) : nullptr;
+    const DTree* tree = guide && guide->sampling.valid() ? &guide->sampling : nullptr;
+    float fraction = tree ? sdTree_->settings.fraction : 0.0f;
+    float lightFraction = vertex.lightFraction();
+
+    glm::vec3 direction;
+    if (tree && Random::Float() < fraction) {
+        direction = tree->sample();
+    } else if (lights && Random::Float() < lightFraction) {
+        direction = sampleLights(vertex.point());
+    } else {
+        direction = vertex.sample();
+    }
 
-    return emitted + scattered;
+    // a microfacet sample may leave the side of the surface it was drawn for, it counts as zero
+    if (direction == glm::vec3(0.0f)) {
+        return emitted;
+    }
+    Ray rayOut(vertex.point(), glm::normalize(direction), ray.time);
+    float pdfValue = vertex.pdf(rayOut.direction);
+    if (lights) {
+        pdfValue = lightFraction * lightsPdf(vertex.point(), rayOut.direction) + (1.0f - lightFraction) * pdfValue;
+    }
+    if (tree) {
+        pdfValue = fraction * tree->pdf(rayOut.direction) + (1.0f - fraction) * pdfValue;
+    }
+    if (!(pdfValue > 0.0f)) {
+        return emitted;
+    }
+
+    glm::vec3 brdf = vertex.evaluate(rayOut.direction);
+    glm::vec3 incoming = trace<Vertex>(rayOut, depth - 1, next);
+    if (guide) {
+        guide->record(rayOut.direction, luminance(incoming) / pdfValue);
+    }
+
+    return emitted + (brdf * incoming) / pdfValue;
+}
+
+glm::vec3 Renderer::traceRay(const Ray& ray) {
+    if (compiledScene_) {
+        return trace<CompiledVertex>(ray, maxDepth, PathState::Camera);
+    }
+    return trace<GraphVertex>(ray, maxDepth, PathState::Camera);
 }
\ No newline at end of file
@@ -0,0 +1,90 @@
+#include "resources/environment.hpp"
+#include "tools/random.hpp"
+#include <glm/ext/scalar_constants.hpp>
+#include <stb_image.h>
+#include <wen.hpp>
+
+Environment::Environment(const std::string& filename, float intensity) : intensity(intensity), filename_(filename) {
+    int channels;
+    float* data = stbi_loadf(filename.c_str(), &width_, &height_, &channels, STBI_rgb);
+    if (!data) {
+        WEN_ERROR("Failed to load environment {}", filename)
+        width_ = height_ = 0;
+        return;
+    }
+    pixels_.resize((size_t)width_ * height_);
+    for (size_t i = 0; i < pixels_.size(); i++) {
+        pixels_[i] = glm::vec3(data[3 * i], data[3 * i + 1], data[3 * i + 2]);
+    }
+    stbi_image_free(data);
+
+    // the sin(theta) factor undoes the stretching of the rows near the poles
+    weights_.resize(pixels_.size());
+    std::vector<float> rowWeights(height_);
+    columns_.reserve(height_);
+    for (int y = 0; y < height_; y++) {
+        float sinTheta = glm::sin(glm::pi<float>() * (y + 0.5f) / height_);
+        std::vector<float> row(width_);
+        for (int x = 0; x < width_; x++) {
+            const auto& color = pixels_[(size_t)y * width_ + x];
+            row[x] = glm::dot(color, glm::vec3(0.2126f, 0.7152f, 0.0722f)) * sinTheta;
+            rowWeights[y] += row[x];
+        }
+        columns_.emplace_back(row);
+    }
+    rows_ = AliasTable(rowWeights);
+
+    for (int y = 0; y < height_; y++) {
+        for (int x = 0; x < width_; x++) {
+            weights_[(size_t)y * width_ + x] = rows_.probability(y) * columns_[y].probability(x);
+        }
+    }
+}
+
+// theta from +y down, phi around y with the seam at -x, as for the uv of a sphere
+uint32_t Environment::pixel(const glm::vec3& direction) const {
+    glm::vec3 d = glm::normalize(direction);
+    float theta = glm::acos(glm::clamp(d.y, -1.0f, 1.0f));
+    float phi = glm::atan(-d.z, d.x) + glm::pi<float>();
+    int x = glm::clamp(int(phi / (2.0f * glm::pi<float>()) * width_), 0, width_ - 1);
+    int y = glm::clamp(int(theta / glm::pi<float>() * height_), 0, height_ - 1);
+    return y * width_ + x;
+}
+
+glm::vec3 Environment::radiance(const glm::vec3& direction) const {
+    if (!valid()) {
+        return glm::vec3(0.0f);
+    }
+    return intensity * pixels_[pixel(direction)];
+}
+
+glm::vec3 Environment::sample() const {
+    uint32_t y = rows_.sample(Random::Float());
+    uint32_t x = columns_[y].sample(Random::Float());
+    float theta = glm::pi<float>() * (y + Random::Float()) / height_;
+    float phi = 2.0f * glm::pi<float>() * (x + Random::Float()) / width_;
+    float sinTheta = glm::sin(theta);
+    return glm::vec3(-sinTheta * glm::cos(phi), glm::cos(theta), sinTheta * glm::sin(phi));
+}
+
+// the image-space density is constant per pixel, dividing by 2 pi^2 sin(theta) turns it into solid angle
+float Environment::pdf(const glm::vec3& direction) const {
+    if (!valid()) {
+        return 0.0f;
+    }
+    glm::vec3 d = glm::normalize(direction);
+    float sinTheta = glm::sqrt(glm::max(0.0f, 1.0f - d.y * d.y));
+    if (sinTheta <= 0.0f) {
+        return 0.0f;
+    }
+    float density = weights_[pixel(d)] * width_ * height_;
+    return density / (2.0f * glm::pi<float>() * glm::pi<float>() * sinTheta);
+}
+
+size_t Environment::memory() const {
+    size_t bytes = pixels_.capacity() * sizeof(glm::vec3) + weights_.capacity() * sizeof(float) + rows_.memory();
+    for (const auto& columns : columns_) {
+        bytes += columns.memory();
+    }
+    return bytes;
+}
\ No newline at end of file
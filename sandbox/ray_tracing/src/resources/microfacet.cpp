@@ -0,0 +1,142 @@
+#include "resources/microfacet.hpp"
+#include "tools/random.hpp"
+#include <glm/ext/scalar_constants.hpp>
+
+// GGX
+GGX::GGX(const glm::vec3& normal, float alpha) : alpha_(alpha) {
+    uvw_.build(normal);
+}
+
+float GGX::D(const glm::vec3& m) const {
+    float cosTheta = glm::dot(m, uvw_.w());
+    if (cosTheta <= 0.0f) {
+        return 0.0f;
+    }
+    float a2 = alpha_ * alpha_;
+    float d = cosTheta * cosTheta * (a2 - 1.0f) + 1.0f;
+    return a2 / (glm::pi<float>() * d * d);
+}
+
+float GGX::G1(const glm::vec3& v) const {
+    float cosTheta = glm::abs(glm::dot(v, uvw_.w()));
+    float a2 = alpha_ * alpha_;
+    return 2.0f * cosTheta / (cosTheta + glm::sqrt(a2 + (1.0f - a2) * cosTheta * cosTheta));
+}
+
+glm::vec3 GGX::sampleVisible(const glm::vec3& wo) const {
+    // the hemisphere configuration: stretch wo, sample the projected disk, unstretch the normal
+    glm::vec3 v = glm::normalize(glm::vec3(alpha_ * glm::dot(wo, uvw_.u()), alpha_ * glm::dot(wo, uvw_.v()), glm::dot(wo, uvw_.w())));
+    float length2 = v.x * v.x + v.y * v.y;
+    glm::vec3 t1 = length2 > 0.0f ? glm::vec3(-v.y, v.x, 0.0f) / glm::sqrt(length2) : glm::vec3(1.0f, 0.0f, 0.0f);
+    glm::vec3 t2 = glm::cross(v, t1);
+
+    float r = glm::sqrt(Random::Float());
+    float phi = 2.0f * glm::pi<float>() * Random::Float();
+    float p1 = r * glm::cos(phi);
+    float p2 = r * glm::sin(phi);
+    float s = 0.5f * (1.0f + v.z);
+    p2 = (1.0f - s) * glm::sqrt(1.0f - p1 * p1) + s * p2;
+
+    glm::vec3 n = p1 * t1 + p2 * t2 + glm::sqrt(glm::max(0.0f, 1.0f - p1 * p1 - p2 * p2)) * v;
+    return glm::normalize(uvw_.local(alpha_ * n.x, alpha_ * n.y, glm::max(0.0f, n.z)));
+}
+
+float GGX::visiblePdf(const glm::vec3& wo, const glm::vec3& m) const {
+    float cosTheta = glm::dot(wo, uvw_.w());
+    if (cosTheta <= 0.0f) {
+        return 0.0f;
+    }
+    return G1(wo) * glm::max(0.0f, glm::dot(wo, m)) * D(m) / cosTheta;
+}
+
+// MicrofacetBSDF
+MicrofacetBSDF::MicrofacetBSDF(const glm::vec3& normal, const glm::vec3& wo, float alpha, float eta, const glm::vec3& f0)
+    : ggx_(normal, alpha), normal_(normal), wo_(wo), eta_(eta), f0_(f0) {}
+
+float MicrofacetBSDF::fresnel(float cosTheta, float eta) {
+    float sin2 = (1.0f - cosTheta * cosTheta) / (eta * eta);
+    if (sin2 >= 1.0f) {
+        return 1.0f;
+    }
+    float cosT = glm::sqrt(1.0f - sin2);
+    float parallel = (eta * cosTheta - cosT) / (eta * cosTheta + cosT);
+    float perpendicular = (cosTheta - eta * cosT) / (cosTheta + eta * cosT);
+    return 0.5f * (parallel * parallel + perpendicular * perpendicular);
+}
+
+glm::vec3 MicrofacetBSDF::sample() const {
+    glm::vec3 m = ggx_.sampleVisible(wo_);
+    if (conductor() || Random::Float() < fresnel(glm::dot(wo_, m), eta_)) {
+        glm::vec3 wi = glm::reflect(-wo_, m);
+        return glm::dot(wi, normal_) > 0.0f ? wi : glm::vec3(0.0f);
+    }
+    glm::vec3 wi = glm::refract(-wo_, m, 1.0f / eta_);
+    return glm::dot(wi, normal_) < 0.0f ? wi : glm::vec3(0.0f);
+}
+
+glm::vec3 MicrofacetBSDF::sample(glm::vec3& weight) const {
+    glm::vec3 wi = sample();
+    float pdf = wi == glm::vec3(0.0f) ? 0.0f : this->pdf(wi);
+    if (!(pdf > 0.0f)) {
+        weight = glm::vec3(0.0f);
+        return normal_;
+    }
+    weight = evaluate(wi) / pdf;
+    return wi;
+}
+
+bool MicrofacetBSDF::half(const glm::vec3& wi, glm::vec3& m) const {
+    float cosI = glm::dot(wi, normal_);
+    if (cosI > 0.0f) {
+        m = glm::normalize(wo_ + wi);
+        return glm::dot(wo_, m) > 0.0f;
+    }
+    if (conductor() || cosI == 0.0f) {
+        return false;
+    }
+    // the generalized half vector of a refraction, on the side of the normal
+    m = wo_ + eta_ * wi;
+    if (glm::dot(m, m) == 0.0f) {
+        return false;
+    }
+    m = glm::normalize(m);
+    if (glm::dot(m, normal_) < 0.0f) {
+        m = -m;
+    }
+    return glm::dot(wo_, m) > 0.0f && glm::dot(wi, m) < 0.0f;
+}
+
+float MicrofacetBSDF::pdf(const glm::vec3& wi) const {
+    glm::vec3 direction = glm::normalize(wi);
+    glm::vec3 m;
+    if (!half(direction, m)) {
+        return 0.0f;
+    }
+    float pdf = ggx_.visiblePdf(wo_, m);
+    float cosO = glm::dot(wo_, m);
+    float cosI = glm::dot(direction, m);
+    if (glm::dot(direction, normal_) > 0.0f) {
+        return pdf / (4.0f * cosO) * (conductor() ? 1.0f : fresnel(cosO, eta_));
+    }
+    float denominator = cosI + cosO / eta_;
+    return pdf * glm::abs(cosI) / (denominator * denominator) * (1.0f - fresnel(cosO, eta_));
+}
+
+glm::vec3 MicrofacetBSDF::evaluate(const glm::vec3& wi) const {
+    glm::vec3 direction = glm::normalize(wi);
+    glm::vec3 m;
+    float cosN = glm::dot(wo_, normal_);
+    if (cosN <= 0.0f || !half(direction, m)) {
+        return glm::vec3(0.0f);
+    }
+    float cosO = glm::dot(wo_, m);
+    float cosI = glm::dot(direction, m);
+    float DG = ggx_.D(m) * ggx_.G1(wo_) * ggx_.G1(direction);
+    if (glm::dot(direction, normal_) > 0.0f) {
+        glm::vec3 F = conductor() ? f0_ + (1.0f - f0_) * glm::pow(1.0f - cosO, 5.0f) : glm::vec3(fresnel(cosO, eta_));
+        return F * DG / (4.0f * cosN);
+    }
+    float denominator = cosI + cosO / eta_;
+    float T = 1.0f - fresnel(cosO, eta_);
+    return glm::vec3(T * DG * glm::abs(cosI) * cosO / (denominator * denominator * cosN));
+}
\ No newline at end of file
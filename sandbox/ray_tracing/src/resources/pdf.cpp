@@ -1,5 +1,7 @@
 #include "resources/pdf.hpp"
 #include "tools/random.hpp"
+#include "tools/counters.hpp"
+#include "guiding/sd_tree.hpp"
 #include <glm/ext/scalar_constants.hpp>
 
 // CosinePDF
@@ -26,6 +28,17 @@ glm::vec3 CosinePDF::CosineDirection() {
     return glm::vec3(x, y, z);
 }
 
+// MicrofacetPDF
+MicrofacetPDF::MicrofacetPDF(const MicrofacetBSDF& bsdf) : bsdf_(bsdf) {}
+
+float MicrofacetPDF::value(const glm::vec3& direction) const {
+    return bsdf_.pdf(direction);
+}
+
+glm::vec3 MicrofacetPDF::generate() const {
+    return bsdf_.sample();
+}
+
 // SpherePDF
 float SpherePDF::value(const glm::vec3& direction) const {
     return 1.0f / (4.0f * glm::pi<float>());
@@ -40,6 +53,7 @@ HittablePDF::HittablePDF(const std::shared_ptr<Hittable>& hittable, const glm::v
     : hittable_(hittable), origin_(origin) {}
 
 float HittablePDF::value(const glm::vec3& direction) const {
+    Counters::add(Counter::ShadowRays);
     return hittable_->pdfValue(origin_, direction);
 }
 
@@ -48,19 +62,29 @@ glm::vec3 HittablePDF::generate() const {
 }
 
 // MixturePDF
-MixturePDF::MixturePDF(std::shared_ptr<PDF> p0, std::shared_ptr<PDF> p1) {
+MixturePDF::MixturePDF(std::shared_ptr<PDF> p0, std::shared_ptr<PDF> p1, float weight) : weight_(weight) {
     p_[0] = p0;
     p_[1] = p1;
 }
 
 float MixturePDF::value(const glm::vec3& direction) const {
-    return 0.5f * p_[0]->value(direction) + 0.5f * p_[1]->value(direction);
+    return weight_ * p_[0]->value(direction) + (1.0f - weight_) * p_[1]->value(direction);
 }
 
 glm::vec3 MixturePDF::generate() const {
-    if (Random::Float() < 0.5f) {
+    if (Random::Float() < weight_) {
         return p_[0]->generate();
     } else {
         return p_[1]->generate();
     }
+}
+// GuidingPDF
+GuidingPDF::GuidingPDF(const DTree& tree) : tree_(tree) {}
+
+float GuidingPDF::value(const glm::vec3& direction) const {
+    return tree_.pdf(glm::normalize(direction));
+}
+
+glm::vec3 GuidingPDF::generate() const {
+    return tree_.sample();
 }
\ No newline at end of file
@@ -0,0 +1,484 @@
+#include "streaming/streamed_geometry.hpp"
+#include "hittable/bvh.hpp"
+#include "hittable/sphere.hpp"
+#include "hittable/quad.hpp"
+#include <wen.hpp>
+#include <filesystem>
+#include <numeric>
+#include <algorithm>
+#include <cstring>
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+struct FileHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t chunkCount;
+    uint32_t reserved;
+    uint64_t tableOffset;
+};
+
+constexpr char magic[4] = {'W', 'O', 'O', 'C'};
+constexpr uint32_t version = 2;
+
+void collect(const std::shared_ptr<Hittable>& hittable, std::unordered_set<const Hittable*>& visited,
+             std::vector<std::shared_ptr<Hittable>>& streamed, HittableList& residual) {
+    if (!visited.insert(hittable.get()).second) {
+        return;
+    }
+
+    if (auto list = std::dynamic_pointer_cast<HittableList>(hittable)) {
+        for (const auto& child : list->hittables) {
+            collect(child, visited, streamed, residual);
+        }
+    } else if (auto bvh = std::dynamic_pointer_cast<BVH>(hittable)) {
+        collect(bvh->left, visited, streamed, residual);
+        collect(bvh->right, visited, streamed, residual);
+    } else if (std::dynamic_pointer_cast<Sphere>(hittable) || std::dynamic_pointer_cast<Quad>(hittable)) {
+        streamed.push_back(hittable);
+    } else {
+        residual.add(hittable);
+    }
+}
+
+glm::vec3 centroid(const AABB& aabb) {
+    return glm::vec3(aabb.x.min + aabb.x.max, aabb.y.min + aabb.y.max, aabb.z.min + aabb.z.max) * 0.5f;
+}
+
+// spatial median splits until every chunk holds at most `size` primitives
+void partition(std::vector<std::shared_ptr<Hittable>>& primitives, size_t begin, size_t end, size_t size,
+               std::vector<std::pair<size_t, size_t>>& chunks) {
+    if (end - begin <= size) {
+        chunks.emplace_back(begin, end);
+        return;
+    }
+
+    AABB bounds = AABB::empty;
+    for (size_t i = begin; i < end; i++) {
+        bounds = AABB(bounds, primitives[i]->aabb);
+    }
+    int axis = bounds.longestAxis();
+    size_t mid = begin + (end - begin) / 2;
+    std::nth_element(primitives.begin() + begin, primitives.begin() + mid, primitives.begin() + end,
+                     [axis](const std::shared_ptr<Hittable>& a, const std::shared_ptr<Hittable>& b) {
+                         return centroid(a->aabb)[axis] < centroid(b->aabb)[axis];
+                     });
+    partition(primitives, begin, mid, size, chunks);
+    partition(primitives, mid, end, size, chunks);
+}
+
+PrimitiveRecord record(const std::shared_ptr<Hittable>& hittable, uint32_t material) {
+    PrimitiveRecord record = {};
+    record.material = material;
+    if (auto sphere = std::dynamic_pointer_cast<Sphere>(hittable)) {
+        glm::vec3 direction = sphere->moving ? sphere->direction : glm::vec3(0.0f);
+        record.type = PrimitiveRecord::Sphere;
+        float data[] = {sphere->position.x, sphere->position.y, sphere->position.z,
+                        direction.x, direction.y, direction.z, sphere->radius, sphere->moving ? 1.0f : 0.0f};
+        std::copy(std::begin(data), std::end(data), record.data);
+    } else {
+        auto quad = std::static_pointer_cast<Quad>(hittable);
+        record.type = PrimitiveRecord::Quad;
+        float data[] = {quad->Q.x, quad->Q.y, quad->Q.z, quad->u.x, quad->u.y, quad->u.z, quad->v.x, quad->v.y, quad->v.z,
+                        quad->normal.x, quad->normal.y, quad->normal.z, quad->D, quad->w.x, quad->w.y, quad->w.z};
+        std::copy(std::begin(data), std::end(data), record.data);
+    }
+    return record;
+}
+
+std::shared_ptr<Material> material(const std::shared_ptr<Hittable>& hittable) {
+    if (auto sphere = std::dynamic_pointer_cast<Sphere>(hittable)) {
+        return sphere->material;
+    }
+    return std::static_pointer_cast<Quad>(hittable)->material;
+}
+
+} // namespace
+
+std::shared_ptr<StreamedGeometry> StreamedGeometry::stream(std::shared_ptr<HittableList>& world, const std::string& filename,
+                                                           size_t budget, uint32_t chunkPrimitives) {
+    std::unordered_set<const Hittable*> visited;
+    std::vector<std::shared_ptr<Hittable>> primitives;
+    auto residual = std::make_shared<HittableList>();
+    collect(world, visited, primitives, *residual);
+    if (primitives.empty()) {
+        return nullptr;
+    }
+
+    std::vector<std::shared_ptr<Material>> materials;
+    std::unordered_map<const Material*, uint32_t> materialIndices;
+    for (const auto& primitive : primitives) {
+        auto m = material(primitive);
+        if (materialIndices.emplace(m.get(), materials.size()).second) {
+            materials.push_back(m);
+        }
+    }
+
+    std::vector<std::pair<size_t, size_t>> ranges;
+    partition(primitives, 0, primitives.size(), glm::max(chunkPrimitives, 1u), ranges);
+
+    std::filesystem::path path(filename);
+    if (path.has_parent_path()) {
+        std::filesystem::create_directories(path.parent_path());
+    }
+    std::ofstream file(filename, std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) {
+        WEN_ERROR("Failed to open {} for writing", filename)
+        return nullptr;
+    }
+
+    FileHeader header = {};
+    std::copy(std::begin(magic), std::end(magic), header.magic);
+    header.version = version;
+    header.chunkCount = ranges.size();
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    std::vector<ChunkEntry> entries;
+    for (auto [begin, end] : ranges) {
+        std::vector<AABB> boxes;
+        for (size_t i = begin; i < end; i++) {
+            boxes.push_back(primitives[i]->aabb);
+        }
+        std::vector<uint32_t> order;
+        std::vector<FlatNode> nodes = FlatBVH::build(boxes, order, 4);
+
+        std::vector<PrimitiveRecord> records;
+        records.reserve(order.size());
+        for (uint32_t i : order) {
+            const auto& primitive = primitives[begin + i];
+            records.push_back(record(primitive, materialIndices[material(primitive).get()]));
+        }
+
+        ChunkEntry entry;
+        entry.offset = (uint64_t)file.tellp();
+        entry.nodeCount = nodes.size();
+        entry.primitiveCount = records.size();
+        entry.min = nodes[0].min;
+        entry.max = nodes[0].max;
+        entries.push_back(entry);
+
+        file.write(reinterpret_cast<const char*>(nodes.data()), nodes.size() * sizeof(FlatNode));
+        file.write(reinterpret_cast<const char*>(records.data()), records.size() * sizeof(PrimitiveRecord));
+    }
+
+    header.tableOffset = (uint64_t)file.tellp();
+    file.write(reinterpret_cast<const char*>(entries.data()), entries.size() * sizeof(ChunkEntry));
+    file.seekp(0);
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.close();
+
+    auto streamed = std::make_shared<StreamedGeometry>(filename, materials, budget);
+    residual->add(streamed);
+    world = residual;
+    return streamed;
+}
+
+StreamedGeometry::StreamedGeometry(const std::string& filename, const std::vector<std::shared_ptr<Material>>& materials, size_t budget)
+    : budget(budget), filename_(filename), materials_(materials) {
+    FileHeader header = {};
+    bool valid = map(filename) && mappedSize_ >= sizeof(FileHeader);
+    if (valid) {
+        memcpy(&header, mapped_, sizeof(header));
+        valid = std::equal(std::begin(magic), std::end(magic), header.magic) && header.version == version &&
+                header.tableOffset + uint64_t(header.chunkCount) * sizeof(ChunkEntry) <= mappedSize_;
+    }
+    std::vector<ChunkEntry> entries(valid ? header.chunkCount : 0);
+    if (valid) {
+        memcpy(entries.data(), mapped_ + header.tableOffset, entries.size() * sizeof(ChunkEntry));
+        for (const auto& entry : entries) {
+            uint64_t bytes = uint64_t(entry.nodeCount) * sizeof(FlatNode) + uint64_t(entry.primitiveCount) * sizeof(PrimitiveRecord);
+            valid &= entry.nodeCount > 0 && entry.offset + bytes <= mappedSize_;
+        }
+    }
+    if (!valid || entries.empty()) {
+        WEN_ERROR("Invalid out-of-core geometry file {}", filename)
+        topLevel_.push_back({glm::vec3(infinity), 0, glm::vec3(-infinity), 0, 0});
+        return;
+    }
+
+    std::vector<AABB> boxes;
+    for (const auto& entry : entries) {
+        boxes.push_back(AABB(entry.min, entry.max));
+        aabb = AABB(aabb, boxes.back());
+    }
+    std::vector<uint32_t> order;
+    topLevel_ = FlatBVH::build(boxes, order, 1);
+    for (uint32_t i : order) {
+        entries_.push_back(entries[i]);
+    }
+
+    resident_ = std::make_unique<std::atomic<bool>[]>(entries_.size());
+    lastUse_ = std::make_unique<std::atomic<uint64_t>[]>(entries_.size());
+    for (size_t i = 0; i < entries_.size(); i++) {
+        resident_[i] = false;
+        lastUse_[i] = 0;
+    }
+}
+
+StreamedGeometry::~StreamedGeometry() {
+#ifdef _WIN32
+    if (mapped_ != nullptr) {
+        UnmapViewOfFile(mapped_);
+    }
+    if (mapping_ != nullptr) {
+        CloseHandle(mapping_);
+    }
+    if (file_ != nullptr) {
+        CloseHandle(file_);
+    }
+#else
+    if (mapped_ != nullptr) {
+        munmap(const_cast<uint8_t*>(mapped_), mappedSize_);
+    }
+#endif
+}
+
+bool StreamedGeometry::map(const std::string& filename) {
+#ifdef _WIN32
+    HANDLE file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+    file_ = file;
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size) || size.QuadPart == 0) {
+        return false;
+    }
+    mapping_ = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mapping_ == nullptr) {
+        return false;
+    }
+    mapped_ = static_cast<const uint8_t*>(MapViewOfFile(mapping_, FILE_MAP_READ, 0, 0, 0));
+    mappedSize_ = mapped_ != nullptr ? size_t(size.QuadPart) : 0;
+#else
+    int fd = open(filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size == 0) {
+        close(fd);
+        return false;
+    }
+    // the mapping stays valid once the descriptor is closed
+    void* mapped = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapped == MAP_FAILED) {
+        return false;
+    }
+    mapped_ = static_cast<const uint8_t*>(mapped);
+    mappedSize_ = info.st_size;
+#endif
+    return mapped_ != nullptr;
+}
+
+// hints the pages of a chunk in or out, its contents stay readable either way so a thread still tracing
+// an evicted chunk only faults its pages back in
+void StreamedGeometry::advise(uint32_t index, bool resident) const {
+    const auto& entry = entries_[index];
+    size_t bytes = entry.nodeCount * sizeof(FlatNode) + entry.primitiveCount * sizeof(PrimitiveRecord);
+#ifdef _WIN32
+    if (resident) {
+        WIN32_MEMORY_RANGE_ENTRY range = {const_cast<uint8_t*>(mapped_ + entry.offset), bytes};
+        PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+    }
+#else
+    // madvise wants page aligned ranges, released ranges are shrunk to the pages only this chunk uses
+    uintptr_t page = sysconf(_SC_PAGESIZE);
+    uintptr_t begin = reinterpret_cast<uintptr_t>(mapped_ + entry.offset);
+    uintptr_t end = begin + bytes;
+    if (resident) {
+        begin &= ~(page - 1);
+        madvise(reinterpret_cast<void*>(begin), end - begin, MADV_WILLNEED);
+    } else {
+        begin = (begin + page - 1) & ~(page - 1);
+        end &= ~(page - 1);
+        if (begin < end) {
+            madvise(reinterpret_cast<void*>(begin), end - begin, MADV_DONTNEED);
+        }
+    }
+#endif
+}
+
+StreamedGeometry::Chunk StreamedGeometry::acquire(uint32_t index) const {
+    const auto& entry = entries_[index];
+    Chunk chunk = {
+        reinterpret_cast<const FlatNode*>(mapped_ + entry.offset),
+        reinterpret_cast<const PrimitiveRecord*>(mapped_ + entry.offset + entry.nodeCount * sizeof(FlatNode)),
+    };
+
+    lookups_.fetch_add(1, std::memory_order_relaxed);
+    lastUse_[index].store(clock_.fetch_add(1, std::memory_order_relaxed), std::memory_order_relaxed);
+    if (resident_[index].load(std::memory_order_acquire) || resident_[index].exchange(true)) {
+        hits_.fetch_add(1, std::memory_order_relaxed);
+        return chunk;
+    }
+
+    // this thread made the chunk resident
+    advise(index, true);
+    pageIns_.fetch_add(1, std::memory_order_relaxed);
+    Counters::add(Counter::Allocations);
+    residentBytes_ += entry.nodeCount * sizeof(FlatNode) + entry.primitiveCount * sizeof(PrimitiveRecord);
+    if (residentBytes_ > budget) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        evict(index);
+    }
+    return chunk;
+}
+
+// exact LRU on the last-use stamps, called with the mutex held
+void StreamedGeometry::evict(uint32_t keep) const {
+    while (residentBytes_ > budget) {
+        int64_t victim = -1;
+        uint64_t oldest = UINT64_MAX;
+        for (size_t i = 0; i < entries_.size(); i++) {
+            uint64_t stamp = lastUse_[i].load(std::memory_order_relaxed);
+            if (i != keep && stamp < oldest && resident_[i].load(std::memory_order_relaxed)) {
+                oldest = stamp;
+                victim = i;
+            }
+        }
+        if (victim < 0 || !resident_[victim].exchange(false)) {
+            break;
+        }
+
+        const auto& entry = entries_[victim];
+        advise(victim, false);
+        residentBytes_ -= entry.nodeCount * sizeof(FlatNode) + entry.primitiveCount * sizeof(PrimitiveRecord);
+        pageOuts_.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+bool StreamedGeometry::hit(const Chunk& chunk, const Ray& ray, Interval& t, HitRecord& hitRecord) const {
+    bool hitted = FlatBVH::traverse(chunk.nodes, ray, t, [&](uint32_t i, Interval& range) {
+        Counters::add(Counter::PrimitiveTests);
+        const auto& record = chunk.primitives[i];
+        const float* d = record.data;
+        if (record.type == PrimitiveRecord::Sphere) {
+            glm::vec3 center(d[0], d[1], d[2]);
+            if (d[7] != 0.0f) {
+                center += glm::vec3(d[3], d[4], d[5]) * ray.time;
+            }
+            float radius = d[6];
+            glm::vec3 origin = center - ray.origin;
+            float a = glm::dot(ray.direction, ray.direction);
+            float h = glm::dot(ray.direction, origin);
+            float c = glm::dot(origin, origin) - radius * radius;
+            float discriminant = h * h - a * c;
+            if (discriminant < 0.0f) {
+                return false;
+            }
+            float sqtrd = glm::sqrt(discriminant);
+            float root = (h - sqtrd) / a;
+            if (!range.inside(root)) {
+                root = (h + sqtrd) / a;
+                if (!range.inside(root)) {
+                    return false;
+                }
+            }
+            hitRecord.t = root;
+            hitRecord.point = ray.hitPoint(root);
+            glm::vec3 normal = (hitRecord.point - center) / radius;
+            hitRecord.setNormal(ray, normal);
+            Sphere::uv(normal, hitRecord.u, hitRecord.v);
+        } else {
+            glm::vec3 Q(d[0], d[1], d[2]), u(d[3], d[4], d[5]), v(d[6], d[7], d[8]);
+            glm::vec3 normal(d[9], d[10], d[11]), w(d[13], d[14], d[15]);
+            float denominator = glm::dot(normal, ray.direction);
+            if (glm::abs(denominator) < 1e-8) {
+                return false;
+            }
+            float root = (d[12] - glm::dot(normal, ray.origin)) / denominator;
+            if (!range.contains(root)) {
+                return false;
+            }
+            glm::vec3 point = ray.hitPoint(root);
+            glm::vec3 p = point - Q;
+            float alpha = glm::dot(w, glm::cross(p, v));
+            float beta = glm::dot(w, glm::cross(u, p));
+            if (alpha < 0.0f || alpha > 1.0f || beta < 0.0f || beta > 1.0f) {
+                return false;
+            }
+            hitRecord.t = root;
+            hitRecord.point = point;
+            hitRecord.setNormal(ray, normal);
+            hitRecord.u = alpha;
+            hitRecord.v = beta;
+        }
+        hitRecord.material = materials_[record.material];
+        range.max = hitRecord.t;
+        return true;
+    });
+    if (hitted) {
+        t.max = hitRecord.t;
+    }
+    return hitted;
+}
+
+bool StreamedGeometry::hit(const Ray& ray, Interval t, HitRecord& hitRecord) const {
+    if (entries_.empty()) {
+        return false;
+    }
+    return FlatBVH::traverse(topLevel_, ray, t, [&](uint32_t i, Interval& range) {
+        return hit(acquire(i), ray, range, hitRecord);
+    });
+}
+
+void StreamedGeometry::hitBatch(const std::vector<Ray>& rays, Interval t, std::vector<HitRecord>& hitRecords, std::vector<uint8_t>& hitted) const {
+    if (entries_.empty()) {
+        return;
+    }
+
+    // (chunk, ray) for every chunk whose bounds a ray crosses before its closest hit so far
+    std::vector<std::pair<uint32_t, uint32_t>> queue;
+    for (uint32_t i = 0; i < rays.size(); i++) {
+        Interval range(t.min, hitted[i] ? hitRecords[i].t : t.max);
+        FlatBVH::traverse(topLevel_, rays[i], range, [&](uint32_t chunk, Interval&) {
+            queue.emplace_back(chunk, i);
+            return false;
+        });
+    }
+    std::sort(queue.begin(), queue.end());
+
+    HitRecord temp;
+    for (size_t begin = 0; begin < queue.size();) {
+        uint32_t index = queue[begin].first;
+        Chunk chunk = acquire(index);
+        size_t end = begin;
+        for (; end < queue.size() && queue[end].first == index; end++) {
+            uint32_t i = queue[end].second;
+            Interval range(t.min, hitted[i] ? hitRecords[i].t : t.max);
+            if (hit(chunk, rays[i], range, temp)) {
+                hitRecords[i] = temp;
+                hitted[i] = 1;
+            }
+        }
+        begin = end;
+    }
+}
+
+StreamingStats StreamedGeometry::stats() const {
+    size_t resident = 0;
+    for (size_t i = 0; i < entries_.size(); i++) {
+        resident += resident_[i].load(std::memory_order_relaxed) ? 1 : 0;
+    }
+    return {
+        residentBytes_.load(),
+        resident,
+        entries_.size(),
+        pageIns_.load(),
+        pageOuts_.load(),
+        lookups_.load(),
+        hits_.load(),
+    };
+}
\ No newline at end of file
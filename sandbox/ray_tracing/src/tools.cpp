@@ -1,8 +1,7 @@
 #include "tools/random.hpp"
 #include "tools/interval.hpp"
 
-thread_local std::mt19937 Random::randomEngine = std::mt19937(std::random_device()());
-std::uniform_int_distribution<std::mt19937::result_type> Random::distribution;
+thread_local uint32_t Random::state = std::random_device()();
 
 const Interval Interval::empty = Interval(+infinity, -infinity);
 const Interval Interval::universe = Interval(-infinity, +infinity);
\ No newline at end of file
@@ -0,0 +1,43 @@
+#include "tools/alias_table.hpp"
+#include <numeric>
+
+AliasTable::AliasTable(const std::vector<float>& weights) : bins_(weights.size()), probabilities_(weights.size()) {
+    size_t n = weights.size();
+    if (n == 0) {
+        return;
+    }
+    total_ = std::accumulate(weights.begin(), weights.end(), 0.0f);
+
+    // scaled so the mean is 1, bins under 1 are topped up from bins over it
+    std::vector<float> scaled(n);
+    std::vector<uint32_t> small, large;
+    for (size_t i = 0; i < n; i++) {
+        probabilities_[i] = total_ > 0.0f ? weights[i] / total_ : 1.0f / n;
+        scaled[i] = probabilities_[i] * n;
+        (scaled[i] < 1.0f ? small : large).push_back(i);
+    }
+    while (!small.empty() && !large.empty()) {
+        uint32_t less = small.back();
+        small.pop_back();
+        uint32_t more = large.back();
+        bins_[less] = {scaled[less], more};
+        scaled[more] -= 1.0f - scaled[less];
+        if (scaled[more] < 1.0f) {
+            large.pop_back();
+            small.push_back(more);
+        }
+    }
+    // whatever is left is 1 up to rounding
+    for (uint32_t i : large) {
+        bins_[i] = {1.0f, i};
+    }
+    for (uint32_t i : small) {
+        bins_[i] = {1.0f, i};
+    }
+}
+
+uint32_t AliasTable::sample(float u) const {
+    float scaled = u * bins_.size();
+    uint32_t index = glm::min((uint32_t)scaled, (uint32_t)bins_.size() - 1);
+    return scaled - index < bins_[index].threshold ? index : bins_[index].alias;
+}
\ No newline at end of file
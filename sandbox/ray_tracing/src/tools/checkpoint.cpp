@@ -0,0 +1,157 @@
+#include "tools/checkpoint.hpp"
+#include <filesystem>
+
+namespace {
+
+struct FileHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t width, height;
+    uint32_t index;
+    uint32_t seed;
+    int32_t samples;
+    glm::vec3 position;
+    glm::vec3 direction;
+    float photonRadius2;
+    uint32_t guidingIteration;
+    uint32_t guidingPasses;
+    uint64_t guidingBytes;
+};
+
+constexpr char magic[4] = {'W', 'C', 'K', 'P'};
+constexpr uint32_t version = 2;
+
+template<typename T>
+void writeArray(std::ofstream& file, const std::vector<T>& values) {
+    file.write(reinterpret_cast<const char*>(values.data()), values.size() * sizeof(T));
+}
+
+template<typename T>
+void readArray(std::ifstream& file, std::vector<T>& values, size_t count) {
+    values.resize(count);
+    file.read(reinterpret_cast<char*>(values.data()), count * sizeof(T));
+}
+
+} // namespace
+
+size_t Checkpoint::bytes() const {
+    return sizeof(FileHeader) + accumulation.size() * sizeof(glm::vec4) + statistics.size() * sizeof(glm::vec4) +
+           history.size() * sizeof(float) + guiding.size();
+}
+
+bool Checkpoint::write(const std::string& filename) const {
+    // runs on the writer thread, so report failures instead of throwing
+    std::error_code error;
+    std::filesystem::path path(filename);
+    if (path.has_parent_path()) {
+        std::filesystem::create_directories(path.parent_path(), error);
+    }
+    std::filesystem::path temporary = path;
+    temporary += ".tmp";
+
+    {
+        std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+        if (!file.is_open()) {
+            return false;
+        }
+
+        FileHeader header = {};
+        std::copy(std::begin(magic), std::end(magic), header.magic);
+        header.version = version;
+        header.width = width;
+        header.height = height;
+        header.index = index;
+        header.seed = seed;
+        header.samples = samples;
+        header.position = position;
+        header.direction = direction;
+        header.photonRadius2 = photonRadius2;
+        header.guidingIteration = guidingIteration;
+        header.guidingPasses = guidingPasses;
+        header.guidingBytes = guiding.size();
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+        writeArray(file, accumulation);
+        writeArray(file, statistics);
+        writeArray(file, history);
+        file.write(guiding.data(), guiding.size());
+        if (!file) {
+            return false;
+        }
+    }
+
+    std::filesystem::rename(temporary, path, error);
+    return !error;
+}
+
+bool Checkpoint::read(const std::string& filename) {
+    std::ifstream file(filename, std::ios::binary);
+    if (!file.is_open()) {
+        return false;
+    }
+
+    FileHeader header;
+    file.read(reinterpret_cast<char*>(&header), sizeof(header));
+    if (!file || !std::equal(std::begin(magic), std::end(magic), header.magic) || header.version != version) {
+        return false;
+    }
+
+    // the arrays are sized from the header, so it has to account for the whole file first
+    std::error_code error;
+    uintmax_t size = std::filesystem::file_size(filename, error);
+    size_t pixelBytes = 2 * sizeof(glm::vec4) + sizeof(float);
+    size_t pixels = (size_t)header.width * header.height;
+    if (error || size < sizeof(header)) {
+        return false;
+    }
+    uintmax_t remaining = size - sizeof(header);
+    if (pixels > remaining / pixelBytes || header.guidingBytes != remaining - pixels * pixelBytes) {
+        return false;
+    }
+
+    width = header.width;
+    height = header.height;
+    index = header.index;
+    seed = header.seed;
+    samples = header.samples;
+    position = header.position;
+    direction = header.direction;
+    photonRadius2 = header.photonRadius2;
+    guidingIteration = header.guidingIteration;
+    guidingPasses = header.guidingPasses;
+
+    readArray(file, accumulation, pixels);
+    readArray(file, statistics, pixels);
+    readArray(file, history, pixels);
+    guiding.resize(header.guidingBytes);
+    file.read(guiding.data(), guiding.size());
+    return bool(file);
+}
+
+CheckpointWriter::~CheckpointWriter() {
+    if (pending_.valid()) {
+        pending_.wait();
+    }
+}
+
+bool CheckpointWriter::save(Checkpoint checkpoint, const std::string& filename) {
+    if (busy()) {
+        return false;
+    }
+    succeeded();
+    pending_ = std::async(std::launch::async, [checkpoint = std::move(checkpoint), filename] {
+        return checkpoint.write(filename);
+    });
+    return true;
+}
+
+bool CheckpointWriter::busy() const {
+    return pending_.valid() && pending_.wait_for(std::chrono::seconds(0)) != std::future_status::ready;
+}
+
+bool CheckpointWriter::succeeded() {
+    if (pending_.valid() && !busy()) {
+        succeeded_ = pending_.get();
+    }
+    return succeeded_;
+}
\ No newline at end of file
@@ -0,0 +1,98 @@
+#include "tools/counters.hpp"
+#include <deque>
+#include <mutex>
+#include <sstream>
+#include <vector>
+
+namespace {
+
+// one slot per live thread, a thread that exits folds its counts into `retired` and frees its slot
+// for the next one. Never destroyed, worker threads may still exit after static destruction
+struct Registry {
+    std::mutex mutex;
+    std::deque<Counters> slots;
+    std::vector<Counters*> free;
+    CounterValues retired;
+};
+
+Registry& registry() {
+    static Registry* registry = new Registry();
+    return *registry;
+}
+
+const char* names[] = {
+    "camera_rays",
+    "bounce_rays",
+    "shadow_rays",
+    "photon_rays",
+    "box_tests",
+    "primitive_tests",
+    "material_evaluations",
+    "allocations",
+};
+static_assert(sizeof(names) / sizeof(names[0]) == (size_t)Counter::Count);
+
+} // namespace
+
+CounterValues CounterValues::operator-(const CounterValues& other) const {
+    CounterValues result;
+    for (size_t i = 0; i < values.size(); i++) {
+        result.values[i] = values[i] - other.values[i];
+    }
+    return result;
+}
+
+std::string CounterValues::json() const {
+    std::ostringstream out;
+    out << "{";
+    for (size_t i = 0; i < values.size(); i++) {
+        out << (i > 0 ? ", " : "") << "\"" << Counters::name((Counter)i) << "\": " << values[i];
+    }
+    out << "}";
+    return out.str();
+}
+
+Counters::Slot::Slot() {
+    auto& registry = ::registry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    if (registry.free.empty()) {
+        counters = &registry.slots.emplace_back();
+    } else {
+        counters = registry.free.back();
+        registry.free.pop_back();
+    }
+}
+
+Counters::Slot::~Slot() {
+    auto& registry = ::registry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    for (size_t i = 0; i < registry.retired.values.size(); i++) {
+        registry.retired.values[i] += counters->values_[i].exchange(0, std::memory_order_relaxed);
+    }
+    registry.free.push_back(counters);
+}
+
+CounterValues Counters::thread() {
+    CounterValues result;
+    const auto& values = local().values_;
+    for (size_t i = 0; i < values.size(); i++) {
+        result.values[i] = values[i].load(std::memory_order_relaxed);
+    }
+    return result;
+}
+
+CounterValues Counters::total() {
+    auto& registry = ::registry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    CounterValues result = registry.retired;
+    for (const auto& slot : registry.slots) {
+        for (size_t i = 0; i < result.values.size(); i++) {
+            result.values[i] += slot.values_[i].load(std::memory_order_relaxed);
+        }
+    }
+    return result;
+}
+
+const char* Counters::name(Counter counter) {
+    return names[(size_t)counter];
+}
\ No newline at end of file
@@ -0,0 +1,86 @@
+#include "tools/profiler.hpp"
+#include <filesystem>
+#include <iomanip>
+#include <mutex>
+
+namespace {
+
+struct Event {
+    const char* name;
+    Profiler::Clock::time_point begin, end;
+};
+
+struct ThreadEvents {
+    uint32_t id;
+    std::vector<Event> events;
+};
+
+std::mutex mutex;
+std::vector<std::unique_ptr<ThreadEvents>> threads;
+const Profiler::Clock::time_point epoch = Profiler::Clock::now();
+
+// the lock is only taken the first time a thread records, zones themselves never lock
+ThreadEvents& local() {
+    thread_local ThreadEvents* events = [] {
+        std::lock_guard lock(mutex);
+        threads.push_back(std::make_unique<ThreadEvents>());
+        threads.back()->id = threads.size() - 1;
+        return threads.back().get();
+    }();
+    return *events;
+}
+
+double microseconds(Profiler::Clock::time_point time) {
+    return std::chrono::duration<double, std::micro>(time - epoch).count();
+}
+
+} // namespace
+
+std::atomic<bool> Profiler::recording_ = false;
+
+void Profiler::zone(const char* name, Clock::time_point begin, Clock::time_point end) {
+    local().events.push_back({name, begin, end});
+}
+
+bool Profiler::save(const std::string& filename) {
+    std::filesystem::path path(filename);
+    if (path.has_parent_path()) {
+        std::filesystem::create_directories(path.parent_path());
+    }
+    std::ofstream file(filename, std::ios::trunc);
+    if (!file.is_open()) {
+        return false;
+    }
+
+    std::lock_guard lock(mutex);
+    file << std::fixed << std::setprecision(3);
+    file << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n";
+    bool first = true;
+    for (const auto& thread : threads) {
+        file << (first ? "" : ",\n") << "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 0, \"tid\": " << thread->id
+             << ", \"args\": {\"name\": \"thread " << thread->id << "\"}}";
+        first = false;
+        for (const auto& event : thread->events) {
+            file << ",\n{\"name\": \"" << event.name << "\", \"cat\": \"renderer\", \"ph\": \"X\", \"pid\": 0, \"tid\": " << thread->id
+                 << ", \"ts\": " << microseconds(event.begin) << ", \"dur\": " << microseconds(event.end) - microseconds(event.begin) << "}";
+        }
+    }
+    file << "\n]}\n";
+    return true;
+}
+
+void Profiler::clear() {
+    std::lock_guard lock(mutex);
+    for (const auto& thread : threads) {
+        thread->events.clear();
+    }
+}
+
+size_t Profiler::events() {
+    std::lock_guard lock(mutex);
+    size_t count = 0;
+    for (const auto& thread : threads) {
+        count += thread->events.size();
+    }
+    return count;
+}
\ No newline at end of file
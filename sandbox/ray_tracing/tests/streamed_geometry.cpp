@@ -0,0 +1,85 @@
+#include "streaming/streamed_geometry.hpp"
+#include "hittable/sphere.hpp"
+#include "resources/material.hpp"
+#include <wen.hpp>
+#include <filesystem>
+#include <iostream>
+
+// A row of spheres streamed in chunks of four, traced as one batch: every chunk the batch crosses has to
+// be looked up and faulted in exactly once, also when the budget only keeps one chunk resident.
+namespace {
+
+int failures = 0;
+
+void check(bool condition, const std::string& what) {
+    if (!condition) {
+        std::cerr << "FAILED: " << what << "\n";
+        failures++;
+    }
+}
+
+constexpr int count = 64;
+constexpr uint32_t chunkPrimitives = 4;
+constexpr uint32_t chunks = count / chunkPrimitives;
+
+std::vector<Ray> rays() {
+    std::vector<Ray> rays;
+    // each sphere twice from the front, one chunk per ray
+    for (int k = 0; k < 2; k++) {
+        for (int i = 0; i < count; i++) {
+            rays.emplace_back(glm::vec3(i * 3.0f, 0.0f, 10.0f), glm::vec3(0.0f, 0.0f, -1.0f), 0.0f);
+        }
+    }
+    // along the row, crossing every chunk, the closest is the first sphere
+    rays.emplace_back(glm::vec3(-10.0f, 0.0f, 0.0f), glm::vec3(1.0f, 0.0f, 0.0f), 0.0f);
+    return rays;
+}
+
+void traceBatch(const StreamedGeometry& streamed, const std::string& name) {
+    auto batch = rays();
+    std::vector<HitRecord> hitRecords(batch.size());
+    std::vector<uint8_t> hitted(batch.size(), 0);
+    auto before = streamed.stats();
+    streamed.hitBatch(batch, Interval(0.001f, infinity), hitRecords, hitted);
+    auto after = streamed.stats();
+
+    check(after.lookups - before.lookups == chunks, name + ": every chunk is looked up once per batch");
+    check(after.pageIns - before.pageIns == chunks, name + ": every chunk is faulted in once per batch");
+    for (size_t i = 0; i < batch.size(); i++) {
+        HitRecord expected;
+        bool hit = streamed.hit(batch[i], Interval(0.001f, infinity), expected);
+        check(hitted[i] != 0 && hit, name + ": ray " + std::to_string(i) + " hits");
+        check(glm::abs(hitRecords[i].t - expected.t) < 1e-4f, name + ": ray " + std::to_string(i) + " finds the closest hit");
+    }
+    check(glm::abs(hitRecords.back().t - 9.0f) < 1e-4f, name + ": the ray along the row stops at the first sphere");
+}
+
+} // namespace
+
+int main() {
+    wen::initialize();
+
+    auto material = std::make_shared<Lambertian>(glm::vec3(0.5f));
+    auto world = std::make_shared<HittableList>();
+    for (int i = 0; i < count; i++) {
+        world->add(std::make_shared<Sphere>(glm::vec3(i * 3.0f, 0.0f, 0.0f), 1.0f, material));
+    }
+    auto filename = (std::filesystem::temp_directory_path() / "streamed_geometry_test.bin").string();
+    auto streamed = StreamedGeometry::stream(world, filename, SIZE_MAX, chunkPrimitives);
+    check(streamed != nullptr && streamed->stats().chunks == chunks, "the spheres are streamed into 16 chunks");
+
+    if (streamed) {
+        traceBatch(*streamed, "unbounded budget");
+        // a budget below one chunk evicts everything but the chunk being traced
+        StreamedGeometry evicting(filename, {material}, 1);
+        traceBatch(evicting, "one resident chunk");
+    }
+    streamed.reset();
+    std::filesystem::remove(filename);
+
+    wen::destroy();
+    if (failures == 0) {
+        std::cout << "streamed geometry: all checks passed\n";
+    }
+    return failures == 0 ? 0 : 1;
+}
\ No newline at end of file
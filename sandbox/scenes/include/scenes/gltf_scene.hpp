@@ -19,9 +19,11 @@ private:
 
     std::shared_ptr<wen::DescriptorSet> descriptorSet_;
     std::shared_ptr<wen::VertexInput> vertexInput_;
+    std::shared_ptr<wen::PushConstants> pushConstants_;
     std::shared_ptr<wen::GraphicsShaderProgram> shaderProgram_;
     std::shared_ptr<wen::GraphicsRenderPipeline> renderPipeline_;
 
     std::shared_ptr<wen::VertexBuffer> vertexBuffer_;
+    std::shared_ptr<wen::VertexBuffer> uvBuffer_;
     std::shared_ptr<wen::IndexBuffer> indexBuffer_;
 };
\ No newline at end of file
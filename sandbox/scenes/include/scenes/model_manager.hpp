@@ -10,7 +10,6 @@ struct ModelInfo {
     };
 
     std::shared_ptr<wen::Model> model;
-    std::shared_ptr<wen::VertexBuffer> vertexBuffer;
     std::vector<InnerInfo> innerInfos;
     std::map<std::string, bool> meshNameVisible;
 };
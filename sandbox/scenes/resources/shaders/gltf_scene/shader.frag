@@ -1,10 +1,32 @@
 #version 450
+#extension GL_GOOGLE_include_directive : require
+
+#include <RayTracing>
+#include <Bindless>
 
 layout(location = 0) in vec3 fragNormal;
 layout(location = 1) in vec4 fragColor;
+layout(location = 2) in vec2 fragUV;
 
 layout(location = 0) out vec4 outColor;
 
+layout(push_constant) uniform PushConstants {
+    uint material;
+    uint materialBuffer;
+    uint sampler;
+} pc;
+
+BINDLESS_BUFFER(GLTFMaterial, materials);
+
 void main() {
-    outColor = vec4(fragNormal / 800 * 0.5, 1);
+    // primitives without a material keep the debug color
+    if (pc.material == 0xffffffffu) {
+        outColor = vec4(fragNormal / 800 * 0.5, 1);
+        return;
+    }
+    GLTFMaterial material = materials[pc.materialBuffer].data[pc.material];
+    outColor = material.baseColorFactor;
+    if (material.baseColorTexture >= 0) {
+        outColor *= bindlessTexture(uint(material.baseColorTexture), pc.sampler, fragUV);
+    }
 }
\ No newline at end of file
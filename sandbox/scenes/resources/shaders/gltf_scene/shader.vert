@@ -1,6 +1,7 @@
 #version 450
 
 layout(location = 0) in vec3 inPosition;
+layout(location = 1) in vec2 inUV;
 
 layout(binding = 0) uniform Camera {
     vec3 position;
@@ -10,9 +11,11 @@ layout(binding = 0) uniform Camera {
 
 layout(location = 0) out vec3 fragNormal;
 layout(location = 1) out vec4 fragColor;
+layout(location = 2) out vec2 fragUV;
 
 void main() {
     fragNormal = inPosition;
     fragColor = vec4(1.0);
+    fragUV = inUV;
     gl_Position = camera.project * camera.view * vec4(inPosition / 400, 1.0);
 }
\ No newline at end of file
@@ -14,7 +14,7 @@ void GLTFScene::initialize() {
     renderer = interface->createRenderer(std::move(renderPass));
     imguiLayer = interface->createImGuiLayer(renderer);
 
-    scene_ = interface->loadGLTFScene("Sponza/glTF/Sponza.gltf");
+    scene_ = interface->loadGLTFScene("Sponza/glTF/Sponza.gltf", {"TEXCOORD_0"});
     auto as = interface->createAccelerationStructure();
     as->addScene(scene_);
     as->build(false, false);
@@ -22,7 +22,7 @@ void GLTFScene::initialize() {
 
     descriptorSet_ = interface->createDescriptorSet();
     descriptorSet_->addDescriptors({
-        {0, wen::DescriptorType::eUniform, wen::ShaderStage::eVertex}, // camera
+        {0, wen::DescriptorType::eDynamicUniform, wen::ShaderStage::eVertex}, // camera
     }).build();
 
     camera_ = std::make_unique<wen::Camera>();
@@ -38,9 +38,29 @@ void GLTFScene::initialize() {
             .formats = {
                 wen::VertexType::eFloat3,
             }
-         }
+         },
+        {
+            .binding = 1,
+            .inputRate = wen::InputRate::eVertex,
+            .formats = {
+                wen::VertexType::eFloat2,
+            }
+        }
     });
 
+    // the material of each primitive is read from the bindless heap
+    pushConstants_ = interface->createPushConstants(
+        wen::ShaderStage::eFragment,
+        {
+            {"material", wen::ConstantType::eUint32},
+            {"material buffer", wen::ConstantType::eUint32},
+            {"sampler", wen::ConstantType::eUint32},
+        }
+    );
+    uint32_t materialBuffer = scene_->getMaterialBufferHandle(), sampler = scene_->getSamplerHandle();
+    pushConstants_->pushConstant("material buffer", &materialBuffer);
+    pushConstants_->pushConstant("sampler", &sampler);
+
     auto vertShader = interface->compileShader("gltf_scene/shader.vert", wen::ShaderStage::eVertex);
     auto fragShader = interface->compileShader("gltf_scene/shader.frag", wen::ShaderStage::eFragment);
     shaderProgram_ = interface->createGraphicsShaderProgram();
@@ -50,6 +70,8 @@ void GLTFScene::initialize() {
     renderPipeline_ = interface->createGraphicsRenderPipeline(renderer, shaderProgram_, "main subpass");
     renderPipeline_->setVertexInput(vertexInput_);
     renderPipeline_->setDescriptorSet(descriptorSet_);
+    renderPipeline_->setDescriptorSet(wen::manager->bindlessHeap->descriptorSet, 1);
+    renderPipeline_->setPushConstants(pushConstants_);
     renderPipeline_->compile({
         .cullMode = wen::CullMode::eBack,
         .frontFace = wen::FrontFace::eCounterClockwise,
@@ -59,6 +81,9 @@ void GLTFScene::initialize() {
 
     vertexBuffer_ = interface->createVertexBuffer(sizeof(glm::vec3), scene_->vertices.size());
     vertexBuffer_->upload(scene_->vertices);
+    const auto& uvs = scene_->attrDatas().at("TEXCOORD_0");
+    uvBuffer_ = interface->createVertexBuffer(sizeof(glm::vec2), uvs.size() / sizeof(glm::vec2));
+    uvBuffer_->upload(uvs);
     indexBuffer_ = interface->createIndexBuffer(wen::IndexType::eUint32, scene_->indices.size());
     indexBuffer_->upload(scene_->indices);
 }
@@ -75,10 +100,12 @@ void GLTFScene::render() {
     renderer->bindResources(renderPipeline_);
     renderer->setScissor(0, 0, w, h);
     renderer->setViewport(0, h, w, -h);
-    renderer->bindVertexBuffer(vertexBuffer_);
+    renderer->bindVertexBuffers({vertexBuffer_, uvBuffer_});
     renderer->bindIndexBuffer(indexBuffer_);
     for (auto* node : scene_->nodesPtr()) {
         for (auto& primitive : node->getMesh()->primitives) {
+            pushConstants_->pushConstant("material", &primitive->data().materialIndex);
+            renderer->pushConstants(renderPipeline_);
             renderer->drawIndexed(primitive->indexCount, 1, primitive->data().firstIndex, primitive->data().firstVertex, 0);
         }
     }
@@ -42,10 +42,11 @@ void ModelManager::initialize() {
 
     auto descriptorSet = interface->createDescriptorSet();
     descriptorSet->addDescriptors({
-        {0, wen::DescriptorType::eUniform, wen::ShaderStage::eVertex}
+        {0, wen::DescriptorType::eDynamicUniform, wen::ShaderStage::eVertex}
     }).build();
 
-    vertexBuffer_ = interface->createVertexBuffer(sizeof(wen::VertexType), 4096000);
+    // models are loaded into it one after another, only the range each one fills is written
+    vertexBuffer_ = interface->createVertexBuffer(sizeof(wen::VertexType), 4096000, {}, true);
     indexBuffer_ = interface->createIndexBuffer(wen::IndexType::eUint32, 4096000);
 
     camera_ = std::make_unique<wen::Camera>();
@@ -80,8 +81,11 @@ void ModelManager::render() {
     renderer->bindVertexBuffer(vertexBuffer_);
     renderer->bindIndexBuffer(indexBuffer_);
     for (auto& [filename, info] : models_) {
-        info.vertexBuffer->upload(info.innerInfos);
-        renderer->bindVertexBuffer(info.vertexBuffer, 1);
+        // rewritten every frame, so the instances go through the frame allocator rather than a staged buffer
+        auto size = info.innerInfos.size() * sizeof(ModelInfo::InnerInfo);
+        auto instances = wen::manager->frameAllocator->allocate(size);
+        memcpy(instances.data, info.innerInfos.data(), size);
+        renderer->bindVertexBuffer(instances, 1);
         for (auto& [meshName, visable] : info.meshNameVisible) {
             if (!visable) {
                 continue;
@@ -117,7 +121,6 @@ void ModelManager::imgui() {
                 filename,
                 ModelInfo {
                     model,
-                    interface->createVertexBuffer(sizeof(ModelInfo::InnerInfo), 512),
                     {},
                     {}
                 }
@@ -81,12 +81,12 @@ void ModelScene::initialize() {
     // descriptor set
     auto mainDescriptorSet = interface->createDescriptorSet();
     mainDescriptorSet->addDescriptors({
-        {0, wen::DescriptorType::eUniform, wen::ShaderStage::eVertex}, // camera
+        {0, wen::DescriptorType::eDynamicUniform, wen::ShaderStage::eVertex}, // camera
     }).build();
     auto postDescriptorSet = interface->createDescriptorSet();
     postDescriptorSet->addDescriptors({
         {0, wen::DescriptorType::eInputAttachment, 3, wen::ShaderStage::eFragment}, // input attachment
-        {1, wen::DescriptorType::eUniform, wen::ShaderStage::eFragment}, // camera
+        {1, wen::DescriptorType::eDynamicUniform, wen::ShaderStage::eFragment}, // camera
         {2, wen::DescriptorType::eUniform, wen::ShaderStage::eFragment}, // light
     }).build();
 
@@ -63,7 +63,7 @@ void PBRScene::initialize() {
     // descriptor set
     auto descriptorSet = interface->createDescriptorSet();
     descriptorSet->addDescriptors({
-        {0, wen::DescriptorType::eUniform, wen::ShaderStage::eVertex|wen::ShaderStage::eFragment}, // camera
+        {0, wen::DescriptorType::eDynamicUniform, wen::ShaderStage::eVertex|wen::ShaderStage::eFragment}, // camera
         {1, wen::DescriptorType::eUniform, wen::ShaderStage::eFragment}, // material
         {2, wen::DescriptorType::eUniform, wen::ShaderStage::eFragment}, // light
     }).build();
@@ -28,7 +28,7 @@ void RayMarching::initialize() {
 
     auto descriptorSet = interface->createDescriptorSet();
     descriptorSet->addDescriptors({
-        {0, wen::DescriptorType::eUniform, wen::ShaderStage::eFragment}, // camera
+        {0, wen::DescriptorType::eDynamicUniform, wen::ShaderStage::eFragment}, // camera
         {1, wen::DescriptorType::eUniform, wen::ShaderStage::eFragment}, // ray marching info
     }).build();
 
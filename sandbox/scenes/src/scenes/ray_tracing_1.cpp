@@ -22,7 +22,7 @@ void RayTracing::initialize() {
     shaderDescriptorSet_ = interface->createDescriptorSet();
     shaderDescriptorSet_->addDescriptors({
         {0, wen::DescriptorType::eUniform, wen::ShaderStage::eFragment | wen::ShaderStage::eMiss}, // info
-        {1, wen::DescriptorType::eUniform, wen::ShaderStage::eVertex | wen::ShaderStage::eRaygen}, // camera
+        {1, wen::DescriptorType::eDynamicUniform, wen::ShaderStage::eVertex | wen::ShaderStage::eRaygen}, // camera
     }).build();
 
     // info
@@ -50,10 +50,13 @@ void RayTracing::initialize() {
     pointLightPosition_ = glm::vec3(2.0f, 2.0f, 2.0f);
 
     // ray tracing
-    auto rgen = interface->compileShader("ray_tracing_1/raytrace.rgen", wen::ShaderStage::eRaygen);
-    auto miss = interface->compileShader("ray_tracing_1/raytrace.miss", wen::ShaderStage::eMiss);
-    auto closest = interface->compileShader("ray_tracing_1/raytrace.rchit", wen::ShaderStage::eClosestHit);
-    auto shadow = interface->compileShader("ray_tracing_1/shadow.miss", wen::ShaderStage::eMiss);
+    auto shaders = interface->compileShaders({
+        {"ray_tracing_1/raytrace.rgen", wen::ShaderStage::eRaygen},
+        {"ray_tracing_1/raytrace.miss", wen::ShaderStage::eMiss},
+        {"ray_tracing_1/raytrace.rchit", wen::ShaderStage::eClosestHit},
+        {"ray_tracing_1/shadow.miss", wen::ShaderStage::eMiss},
+    });
+    auto rgen = shaders[0], miss = shaders[1], closest = shaders[2], shadow = shaders[3];
     rayTracingDescriptorSet_ = interface->createDescriptorSet();
     rayTracingDescriptorSet_->addDescriptors({
         {0, wen::DescriptorType::eAccelerationStructure, wen::ShaderStage::eRaygen|wen::ShaderStage::eClosestHit},